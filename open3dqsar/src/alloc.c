@@ -287,18 +287,43 @@ IntMat *alloc_int_matrix(IntMat *old_int_mat, int m, int n)
 }
 
 
+/*
+when tasks are being dispatched to worker processes,
+one thread is needed for each connected worker
+*/
+static int get_n_threads(O3Data *od)
+{
+  return (od->workers.dispatch ? od->workers.n_workers : od->n_proc);
+}
+
+
+/*
+ThreadInfo structures are kept across commands together with the
+PLS workspace of each thread, which is only resized when needed;
+they are freed by free_threads() when the program exits
+*/
 int alloc_threads(O3Data *od)
 {
   int i;
 
 
-  memset(od->mel.thread_info, 0, MAX_THREADS * sizeof(ThreadInfo *));
-  for (i = 0; i < od->n_proc; ++i) {
+  for (i = 0; i < get_n_threads(od); ++i) {
+    if (od->mel.thread_info[i]) {
+      continue;
+    }
     od->mel.thread_info[i] = (ThreadInfo *)malloc(sizeof(ThreadInfo));
     if (!(od->mel.thread_info[i])) {
       return OUT_OF_MEMORY;
     }
     memset(od->mel.thread_info[i], 0, sizeof(ThreadInfo));
+    if (!i) {
+      continue;
+    }
+    od->mel.thread_info[i]->workspace = (O3Data *)malloc(sizeof(O3Data));
+    if (!(od->mel.thread_info[i]->workspace)) {
+      return OUT_OF_MEMORY;
+    }
+    memset(od->mel.thread_info[i]->workspace, 0, sizeof(O3Data));
   }
   #ifndef WIN32
   od->mel.mutex = (pthread_mutex_t *)realloc
@@ -310,6 +335,9 @@ int alloc_threads(O3Data *od)
   if (!(od->mel.mutex)) {
     return OUT_OF_MEMORY;
   }
+  if (alloc_thread_pool(od)) {
+    return OUT_OF_MEMORY;
+  }
 
   return 0;
 }
@@ -447,6 +475,26 @@ int alloc_x_var_array(O3Data *od, int num_fields)
   for (i = 0; i < num_fields; ++i) {
     od->mel.field_attr[od->field_num + i] = ACTIVE_BIT;
   }
+  /*
+  new fields do not derive from any field
+  present in the journal base
+  */
+  od->mel.journal_origin = (int *)realloc
+    (od->mel.journal_origin,
+    (od->field_num + num_fields) * sizeof(int));
+  if (!(od->mel.journal_origin)) {
+    return OUT_OF_MEMORY;
+  }
+  od->mel.journal_dirty = (unsigned char *)realloc
+    (od->mel.journal_dirty,
+    (od->field_num + num_fields) * sizeof(unsigned char));
+  if (!(od->mel.journal_dirty)) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < num_fields; ++i) {
+    od->mel.journal_origin[od->field_num + i] = -1;
+    od->mel.journal_dirty[od->field_num + i] = 0;
+  }
   od->mel.x_data = (XData *)realloc(od->mel.x_data,
     (od->field_num + num_fields) * sizeof(XData));
   if (!(od->mel.x_data)) {
@@ -651,11 +699,21 @@ int fill_thread_info(O3Data *od, int n_tasks)
 
 
   ti = od->mel.thread_info;
-  n_calc_per_thread = n_tasks / od->n_proc;
-  exceeding = n_tasks % od->n_proc;
-  n_threads = ((n_tasks < od->n_proc) ? n_tasks : od->n_proc);
+  n_threads = get_n_threads(od);
+  n_calc_per_thread = n_tasks / n_threads;
+  exceeding = n_tasks % n_threads;
+  n_threads = ((n_tasks < n_threads) ? n_tasks : n_threads);
   for (i = 0; i < n_threads; ++i) {
     memcpy(&(ti[i]->od), od, sizeof(O3Data));
+    if (ti[i]->workspace) {
+      /*
+      thread 0 works on the main PLS workspace,
+      the others on their own
+      */
+      copy_pls_workspace(&(ti[i]->od), ti[i]->workspace);
+    }
+    ti[i]->cannot_write_temp_file = 0;
+    ti[i]->out_of_memory = 0;
     ti[i]->thread_num = i;
     ti[i]->n_calc = n_calc_per_thread;
     if (exceeding) {
@@ -713,6 +771,20 @@ int alloc_average_mat(O3Data *od, int model_type,
     memset(od->mal.large_f_mat_ave->base, 0,
       od->mal.large_f_mat_ave->m * od->mal.large_f_mat_ave->n * sizeof(double));
   }
+  /*
+  full column sums are computed once; the average of each
+  CV model is then obtained by subtracting left-out objects
+  */
+  if (calc_large_mat_sum(od, od->mal.large_e_mat,
+    &(od->mal.large_e_mat_sum))) {
+    return OUT_OF_MEMORY;
+  }
+  if (model_type != SCRAMBLE_CV_MODEL) {
+    if (calc_large_mat_sum(od, od->mal.large_f_mat,
+      &(od->mal.large_f_mat_sum))) {
+      return OUT_OF_MEMORY;
+    }
+  }
   run_count = 0;
   switch (cv_type) {
     case LEAVE_ONE_OUT:
@@ -736,10 +808,10 @@ int alloc_average_mat(O3Data *od, int model_type,
         and large_f_mat, one for each LOO CV model
         */
         calc_large_mat_ave(od, od->mal.large_e_mat,
-          od->mal.large_e_mat_ave, run_count);
+          od->mal.large_e_mat_sum, od->mal.large_e_mat_ave, run_count);
         if (model_type != SCRAMBLE_CV_MODEL) {
           calc_large_mat_ave(od, od->mal.large_f_mat,
-            od->mal.large_f_mat_ave, run_count);
+            od->mal.large_f_mat_sum, od->mal.large_f_mat_ave, run_count);
         }
         ++run_count;
       }
@@ -780,10 +852,10 @@ int alloc_average_mat(O3Data *od, int model_type,
             and large_f_mat, one for each LTO CV model
             */
             calc_large_mat_ave(od, od->mal.large_e_mat,
-              od->mal.large_e_mat_ave, run_count);
+              od->mal.large_e_mat_sum, od->mal.large_e_mat_ave, run_count);
             if (model_type != SCRAMBLE_CV_MODEL) {
               calc_large_mat_ave(od, od->mal.large_f_mat,
-                od->mal.large_f_mat_ave, run_count);
+                od->mal.large_f_mat_sum, od->mal.large_f_mat_ave, run_count);
             }
             ++run_count;
           }
@@ -794,6 +866,9 @@ int alloc_average_mat(O3Data *od, int model_type,
 
     case LEAVE_MANY_OUT:
     for (i = 0; i < runs; ++i) {
+      if (fill_group_composition(od, i)) {
+        return OUT_OF_MEMORY;
+      }
       for (group_num = 0; group_num < groups; ++group_num) {
         /*
         initialize the left-out objects vector before PLS
@@ -813,10 +888,10 @@ int alloc_average_mat(O3Data *od, int model_type,
         and large_f_mat, one for each LMO CV model
         */
         calc_large_mat_ave(od, od->mal.large_e_mat,
-          od->mal.large_e_mat_ave, run_count);
+          od->mal.large_e_mat_sum, od->mal.large_e_mat_ave, run_count);
         if (model_type != SCRAMBLE_CV_MODEL) {
           calc_large_mat_ave(od, od->mal.large_f_mat,
-            od->mal.large_f_mat_ave, run_count);
+            od->mal.large_f_mat_sum, od->mal.large_f_mat_ave, run_count);
         }
         ++run_count;
       }
@@ -884,10 +959,27 @@ int alloc_pls(O3Data *od, int x_vars, int pc_num, int model_type)
     && (!(od->uvepls.ive))) {
     coeff_size = 2;
   }
-  od->mal.e_mat = double_mat_resize(od->mal.e_mat,
-    od->object_num, x_vars * coeff_size);
-  if (!(od->mal.e_mat)) {
-    return OUT_OF_MEMORY;
+  /*
+  out-of-core models never hold E in memory; in
+  implicit-deflation CV the training rows are read
+  from the shared large_e_mat, and in single-precision
+  CV they are stored in the float E matrix, so E only
+  needs to hold the left-out rows (see implicit_cv.c
+  and pls_sp.c)
+  */
+  if ((od->cv.implicit_cv || od->cv.sp_cv) && (model_type & CV_MODEL)) {
+    od->mal.e_mat = double_mat_resize(od->mal.e_mat,
+      1, x_vars * coeff_size);
+    if (!(od->mal.e_mat)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  else if (!(model_type & OUT_OF_CORE_MODEL)) {
+    od->mal.e_mat = double_mat_resize(od->mal.e_mat,
+      od->object_num, x_vars * coeff_size);
+    if (!(od->mal.e_mat)) {
+      return OUT_OF_MEMORY;
+    }
   }
   od->vel.e_mat_ave = double_vec_resize
     (od->vel.e_mat_ave, x_vars * coeff_size);
@@ -970,10 +1062,211 @@ int alloc_pls(O3Data *od, int x_vars, int pc_num, int model_type)
   if (!(od->vel.v_new)) {
     return OUT_OF_MEMORY;
   }
+  if (od->pls_precision == PLS_SINGLE_PRECISION) {
+    od->mal.e_mat_sp = float_mat_resize(od->mal.e_mat_sp,
+      od->object_num, x_vars * coeff_size);
+    if (!(od->mal.e_mat_sp)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.f_mat_sp = float_mat_resize(od->mal.f_mat_sp,
+      od->object_num, od->y_vars);
+    if (!(od->mal.f_mat_sp)) {
+      return OUT_OF_MEMORY;
+    }
+    /*
+    c, u, b, d, v and v_new vectors
+    */
+    od->mal.pls_sp_work = float_mat_resize(od->mal.pls_sp_work,
+      ((od->object_num > x_vars * coeff_size)
+      ? od->object_num : x_vars * coeff_size) + od->y_vars, 6);
+    if (!(od->mal.pls_sp_work)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if (od->pls_algorithm == IMPLICIT_PLS) {
+    od->vel.deflation_coeff = double_vec_resize
+      (od->vel.deflation_coeff, pc_num + 1);
+    if (!(od->vel.deflation_coeff)) {
+      return OUT_OF_MEMORY;
+    }
+    od->vel.implicit_work = double_vec_resize
+      (od->vel.implicit_work, od->object_num);
+    if (!(od->vel.implicit_work)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if (od->pls_y_mode == PLS1_Y_MODE) {
+    /*
+    K, plus u, Ku and t for each y variable and PC, the dual
+    coefficients and the coefficients for each y variable and
+    number of PCs; in kernel CV variables are training objects
+    */
+    od->mal.kernel_mat = double_mat_resize
+      (od->mal.kernel_mat, od->object_num, od->object_num);
+    if (!(od->mal.kernel_mat)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls1_u = double_mat_resize(od->mal.pls1_u,
+      od->object_num, od->y_vars * (pc_num + 1));
+    if (!(od->mal.pls1_u)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls1_w = double_mat_resize(od->mal.pls1_w,
+      od->object_num, od->y_vars * (pc_num + 1));
+    if (!(od->mal.pls1_w)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls1_t = double_mat_resize(od->mal.pls1_t,
+      od->object_num, od->y_vars * (pc_num + 1));
+    if (!(od->mal.pls1_t)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls1_dual = double_mat_resize(od->mal.pls1_dual,
+      od->object_num, od->y_vars * (pc_num + 1));
+    if (!(od->mal.pls1_dual)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls1_coeff = double_mat_resize(od->mal.pls1_coeff,
+      ((od->object_num > x_vars * coeff_size)
+      ? od->object_num : x_vars * coeff_size),
+      od->y_vars * (pc_num + 1));
+    if (!(od->mal.pls1_coeff)) {
+      return OUT_OF_MEMORY;
+    }
+    od->vel.pls1_z = double_vec_resize(od->vel.pls1_z, pc_num + 1);
+    if (!(od->vel.pls1_z)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if ((od->pls_y_mode == PLS2_Y_MODE) && (od->y_vars > 1)
+    && (model_type & CV_MODEL)) {
+    /*
+    S = E'F, M = S'S, G = F'F and the y variable
+    space vectors used by pls2_block()
+    */
+    od->mal.pls2_s = double_mat_resize(od->mal.pls2_s,
+      x_vars * coeff_size, od->y_vars);
+    if (!(od->mal.pls2_s)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls2_m = double_mat_resize(od->mal.pls2_m,
+      od->y_vars, od->y_vars);
+    if (!(od->mal.pls2_m)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls2_g = double_mat_resize(od->mal.pls2_g,
+      od->y_vars, od->y_vars);
+    if (!(od->mal.pls2_g)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.pls2_work = double_mat_resize(od->mal.pls2_work,
+      od->y_vars, 5);
+    if (!(od->mal.pls2_work)) {
+      return OUT_OF_MEMORY;
+    }
+    od->vel.pls2_z = double_vec_resize(od->vel.pls2_z, pc_num + 1);
+    if (!(od->vel.pls2_z)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if ((od->pls_algorithm == KERNEL_PLS)
+    || (model_type & OUT_OF_CORE_MODEL)) {
+    od->mal.kernel_mat = double_mat_resize
+      (od->mal.kernel_mat, od->object_num, od->object_num);
+    if (!(od->mal.kernel_mat)) {
+      return OUT_OF_MEMORY;
+    }
+    od->mal.kernel_u = double_mat_resize
+      (od->mal.kernel_u, od->object_num, pc_num + 1);
+    if (!(od->mal.kernel_u)) {
+      return OUT_OF_MEMORY;
+    }
+    od->vel.kernel_t = double_vec_resize(od->vel.kernel_t, od->object_num);
+    if (!(od->vel.kernel_t)) {
+      return OUT_OF_MEMORY;
+    }
+    od->vel.kernel_w = double_vec_resize(od->vel.kernel_w, od->object_num);
+    if (!(od->vel.kernel_w)) {
+      return OUT_OF_MEMORY;
+    }
+    od->vel.kernel_g = double_vec_resize(od->vel.kernel_g, od->object_num);
+    if (!(od->vel.kernel_g)) {
+      return OUT_OF_MEMORY;
+    }
+    od->pel.kernel_rows = int_perm_resize(od->pel.kernel_rows, od->object_num);
+    if (!(od->pel.kernel_rows)) {
+      return OUT_OF_MEMORY;
+    }
+    /*
+    in kernel CV training objects take the place of variables,
+    so matrices indexed by variable must be able to hold
+    object_num rows; grow them, then restore their logical size
+    */
+    if ((od->object_num > x_vars * coeff_size)
+      && (!(model_type & OUT_OF_CORE_MODEL))) {
+      if (!double_mat_resize(od->mal.e_mat,
+        od->object_num, od->object_num)) {
+        return OUT_OF_MEMORY;
+      }
+      double_mat_resize(od->mal.e_mat,
+        od->object_num, x_vars * coeff_size);
+      if (!double_mat_resize(od->mal.x_weights,
+        od->object_num, pc_num + 1)) {
+        return OUT_OF_MEMORY;
+      }
+      double_mat_resize(od->mal.x_weights,
+        x_vars * coeff_size, pc_num + 1);
+      if (!double_mat_resize(od->mal.x_weights_star,
+        od->object_num, pc_num + 1)) {
+        return OUT_OF_MEMORY;
+      }
+      double_mat_resize(od->mal.x_weights_star,
+        x_vars * coeff_size, pc_num + 1);
+      if (!double_mat_resize(od->mal.x_loadings,
+        od->object_num, pc_num + 1)) {
+        return OUT_OF_MEMORY;
+      }
+      double_mat_resize(od->mal.x_loadings,
+        x_vars * coeff_size, pc_num + 1);
+      if (od->y_vars) {
+        if (!double_mat_resize(od->mal.b_coefficients,
+          od->object_num, od->y_vars)) {
+          return OUT_OF_MEMORY;
+        }
+        double_mat_resize(od->mal.b_coefficients,
+          x_vars * coeff_size, od->y_vars);
+      }
+    }
+  }
   od->vel.ro = double_vec_resize(od->vel.ro, pc_num + 1);
   if (!(od->vel.ro)) {
     return OUT_OF_MEMORY;
   }
+  od->pel.fold_train_rows = int_perm_resize
+    (od->pel.fold_train_rows, od->object_num);
+  if (!(od->pel.fold_train_rows)) {
+    return OUT_OF_MEMORY;
+  }
+  od->pel.fold_out_rows = int_perm_resize
+    (od->pel.fold_out_rows, od->object_num);
+  if (!(od->pel.fold_out_rows)) {
+    return OUT_OF_MEMORY;
+  }
+  od->vel.fold_train_weight = double_vec_resize
+    (od->vel.fold_train_weight, od->object_num);
+  if (!(od->vel.fold_train_weight)) {
+    return OUT_OF_MEMORY;
+  }
+  od->vel.fold_train_sqrt_weight = double_vec_resize
+    (od->vel.fold_train_sqrt_weight, od->object_num);
+  if (!(od->vel.fold_train_sqrt_weight)) {
+    return OUT_OF_MEMORY;
+  }
+  od->vel.fold_out_weight = double_vec_resize
+    (od->vel.fold_out_weight, od->object_num);
+  if (!(od->vel.fold_out_weight)) {
+    return OUT_OF_MEMORY;
+  }
   od->vel.explained_s2_x = double_vec_resize(od->vel.explained_s2_x, pc_num + 1);
   if (!(od->vel.explained_s2_x)) {
     return OUT_OF_MEMORY;
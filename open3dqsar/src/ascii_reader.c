@@ -0,0 +1,446 @@
+/*
+
+ascii_reader.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+exact powers of ten which can be represented
+as doubles without any rounding error
+*/
+static const double exact_pow10[] = {
+  1.0e00, 1.0e01, 1.0e02, 1.0e03, 1.0e04, 1.0e05,
+  1.0e06, 1.0e07, 1.0e08, 1.0e09, 1.0e10, 1.0e11,
+  1.0e12, 1.0e13, 1.0e14, 1.0e15, 1.0e16, 1.0e17,
+  1.0e18, 1.0e19, 1.0e20, 1.0e21, 1.0e22
+};
+
+
+static int is_ascii_separator(int c)
+{
+  switch (c) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case ',':
+    case ';':
+    case '\0':
+    return 1;
+  }
+  
+  return 0;
+}
+
+
+static double slow_strtod(char *start, int len)
+{
+  char local_buf[BUF_LEN];
+  char *buf = local_buf;
+  char *decimal_point;
+  int i;
+  int j;
+  int dp_len;
+  double value;
+  
+  
+  /*
+  strtod() honours the current locale, so the
+  '.' decimal separator is replaced with the
+  locale-specific one before conversion
+  */
+  decimal_point = localeconv()->decimal_point;
+  dp_len = ((decimal_point && decimal_point[0]) ? strlen(decimal_point) : 1);
+  if ((len * dp_len) >= BUF_LEN) {
+    buf = malloc(len * dp_len + 1);
+    if (!buf) {
+      return strtod(start, NULL);
+    }
+  }
+  for (i = 0, j = 0; i < len; ++i) {
+    if ((start[i] == '.') && decimal_point && decimal_point[0]) {
+      memcpy(&buf[j], decimal_point, dp_len);
+      j += dp_len;
+    }
+    else {
+      buf[j] = start[i];
+      ++j;
+    }
+  }
+  buf[j] = '\0';
+  value = strtod(buf, NULL);
+  if (buf != local_buf) {
+    free(buf);
+  }
+  
+  return value;
+}
+
+
+double fast_strtod(char *str, char **endptr)
+{
+  char *ptr = str;
+  char *start;
+  char *exp_ptr;
+  int negative = 0;
+  int exp_negative = 0;
+  int has_digits = 0;
+  int truncated = 0;
+  int n_digits = 0;
+  int exp10 = 0;
+  int exp_value = 0;
+  uint64_t mantissa = 0;
+  double value;
+  
+  
+  /*
+  decimal numbers are always parsed with '.' as decimal
+  separator, irrespective of the current locale; up to 19
+  significant digits are accumulated in a 64-bit integer
+  */
+  while (isspace((int)(unsigned char)(*ptr))) {
+    ++ptr;
+  }
+  start = ptr;
+  if (*ptr == '-') {
+    negative = 1;
+    ++ptr;
+  }
+  else if (*ptr == '+') {
+    ++ptr;
+  }
+  while (isdigit((int)(unsigned char)(*ptr))) {
+    has_digits = 1;
+    if (n_digits < 19) {
+      mantissa = mantissa * 10 + (uint64_t)(*ptr - '0');
+      if (mantissa) {
+        ++n_digits;
+      }
+    }
+    else {
+      ++exp10;
+      if (*ptr != '0') {
+        truncated = 1;
+      }
+    }
+    ++ptr;
+  }
+  if (*ptr == '.') {
+    ++ptr;
+    while (isdigit((int)(unsigned char)(*ptr))) {
+      has_digits = 1;
+      if (n_digits < 19) {
+        mantissa = mantissa * 10 + (uint64_t)(*ptr - '0');
+        if (mantissa) {
+          ++n_digits;
+        }
+        --exp10;
+      }
+      else if (*ptr != '0') {
+        truncated = 1;
+      }
+      ++ptr;
+    }
+  }
+  if (!has_digits) {
+    /*
+    inf, nan or no conversion at all:
+    leave it to the C library
+    */
+    return strtod(str, endptr);
+  }
+  if ((*ptr == 'e') || (*ptr == 'E')) {
+    exp_ptr = ptr + 1;
+    if (*exp_ptr == '-') {
+      exp_negative = 1;
+      ++exp_ptr;
+    }
+    else if (*exp_ptr == '+') {
+      ++exp_ptr;
+    }
+    if (isdigit((int)(unsigned char)(*exp_ptr))) {
+      while (isdigit((int)(unsigned char)(*exp_ptr))) {
+        if (exp_value < 100000) {
+          exp_value = exp_value * 10 + (*exp_ptr - '0');
+        }
+        ++exp_ptr;
+      }
+      exp10 += (exp_negative ? -exp_value : exp_value);
+      ptr = exp_ptr;
+    }
+  }
+  if (endptr) {
+    *endptr = ptr;
+  }
+  if (!mantissa) {
+    return (negative ? -0.0 : 0.0);
+  }
+  /*
+  if both the mantissa and the power of ten are exactly
+  representable as doubles, a single IEEE multiplication
+  or division yields the correctly rounded result;
+  otherwise fall back to strtod()
+  */
+  if ((!truncated) && (mantissa <= ((uint64_t)1 << 53))
+    && (exp10 >= -22) && (exp10 <= 22)) {
+    value = (double)mantissa;
+    value = ((exp10 < 0) ? value / exact_pow10[-exp10]
+      : value * exact_pow10[exp10]);
+    return (negative ? -value : value);
+  }
+  
+  return slow_strtod(start, (int)(ptr - start));
+}
+
+
+AsciiReader *open_ascii_reader(FILE *handle, fzPtr *fz_handle)
+{
+  AsciiReader *ar;
+  
+  
+  /*
+  reading starts at the current position
+  of either handle
+  */
+  ar = (AsciiReader *)malloc(sizeof(AsciiReader));
+  if (!ar) {
+    return NULL;
+  }
+  memset(ar, 0, sizeof(AsciiReader));
+  ar->buf = (char *)malloc(ASCII_READER_BUF_LEN + 1);
+  if (!(ar->buf)) {
+    free(ar);
+    return NULL;
+  }
+  ar->buf[0] = '\0';
+  ar->size = ASCII_READER_BUF_LEN;
+  ar->handle = handle;
+  ar->fz_handle = fz_handle;
+  
+  return ar;
+}
+
+
+void close_ascii_reader(AsciiReader *ar)
+{
+  if (!ar) {
+    return;
+  }
+  /*
+  give back to a plain file handle what
+  has been read ahead but not consumed
+  */
+  if (ar->handle && (ar->len > ar->pos)) {
+    fseek(ar->handle, -(long)(ar->len - ar->pos), SEEK_CUR);
+  }
+  if (ar->buf) {
+    free(ar->buf);
+  }
+  free(ar);
+}
+
+
+static int fill_ascii_reader(AsciiReader *ar)
+{
+  int actual_len = 0;
+  
+  
+  if (ar->eof) {
+    return 0;
+  }
+  if (ar->pos) {
+    memmove(ar->buf, &(ar->buf[ar->pos]), ar->len - ar->pos);
+    ar->len -= ar->pos;
+    ar->pos = 0;
+  }
+  if (ar->len < ar->size) {
+    actual_len = (ar->fz_handle
+      ? fzread(&(ar->buf[ar->len]), 1, ar->size - ar->len, ar->fz_handle)
+      : (int)fread(&(ar->buf[ar->len]), 1, ar->size - ar->len, ar->handle));
+    if (actual_len <= 0) {
+      actual_len = 0;
+      ar->eof = 1;
+    }
+    ar->len += actual_len;
+  }
+  ar->buf[ar->len] = '\0';
+  
+  return actual_len;
+}
+
+
+char *ascii_reader_gets(char *data, int len, AsciiReader *ar)
+{
+  char *newline = NULL;
+  int n = 0;
+  int avail;
+  
+  
+  /*
+  same semantics as fgets()
+  */
+  while ((!newline) && (n < (len - 1))) {
+    if ((ar->pos == ar->len) && (!fill_ascii_reader(ar))) {
+      break;
+    }
+    avail = ar->len - ar->pos;
+    if (avail > (len - 1 - n)) {
+      avail = len - 1 - n;
+    }
+    newline = memchr(&(ar->buf[ar->pos]), '\n', avail);
+    if (newline) {
+      avail = (int)(newline - &(ar->buf[ar->pos])) + 1;
+    }
+    memcpy(&data[n], &(ar->buf[ar->pos]), avail);
+    n += avail;
+    ar->pos += avail;
+  }
+  if (!n) {
+    return NULL;
+  }
+  data[n] = '\0';
+  
+  return data;
+}
+
+
+int ascii_reader_get_token(AsciiReader *ar, char **token)
+{
+  int i;
+  
+  
+  /*
+  skip separators
+  */
+  while (1) {
+    while ((ar->pos < ar->len) && is_ascii_separator((int)(ar->buf[ar->pos]))) {
+      ++(ar->pos);
+    }
+    if (ar->pos < ar->len) {
+      break;
+    }
+    if (!fill_ascii_reader(ar)) {
+      return EOF_FOUND;
+    }
+  }
+  /*
+  find the end of the token; if it is truncated
+  at the end of the buffer, top the buffer up
+  */
+  i = ar->pos;
+  while (1) {
+    while ((i < ar->len) && (!is_ascii_separator((int)(ar->buf[i])))) {
+      ++i;
+    }
+    if ((i < ar->len) || ar->eof || ((!(ar->pos)) && (ar->len == ar->size))) {
+      break;
+    }
+    i -= ar->pos;
+    if (!fill_ascii_reader(ar)) {
+      i = ar->len;
+      break;
+    }
+  }
+  /*
+  the token is NULL-terminated in place and
+  remains valid until the next call
+  */
+  *token = &(ar->buf[ar->pos]);
+  ar->pos = ((i < ar->len) ? i + 1 : i);
+  ar->buf[i] = '\0';
+  
+  return 0;
+}
+
+
+int ascii_reader_get_double(AsciiReader *ar, double *value)
+{
+  char *token;
+  char *end;
+  int result;
+  double temp;
+  
+  
+  /*
+  as with sscanf(), value is left unchanged
+  if the token is not a number
+  */
+  result = ascii_reader_get_token(ar, &token);
+  if (result) {
+    return result;
+  }
+  temp = fast_strtod(token, &end);
+  if (end != token) {
+    *value = temp;
+  }
+  
+  return 0;
+}
+
+
+int ascii_reader_count_lines(AsciiReader *ar)
+{
+  char *ptr;
+  char *end;
+  int n_lines = 0;
+  int newline_last = 1;
+  
+  
+  while ((ar->pos < ar->len) || fill_ascii_reader(ar)) {
+    ptr = &(ar->buf[ar->pos]);
+    end = &(ar->buf[ar->len]);
+    while ((ptr = memchr(ptr, '\n', end - ptr))) {
+      ++n_lines;
+      ++ptr;
+    }
+    newline_last = (ar->buf[ar->len - 1] == '\n');
+    ar->pos = ar->len;
+  }
+  if (!newline_last) {
+    /*
+    last line is not terminated by a newline
+    */
+    ++n_lines;
+  }
+  
+  return n_lines;
+}
@@ -0,0 +1,163 @@
+/*
+
+blas_threads.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+#ifndef WIN32
+#include <dlfcn.h>
+#endif
+
+
+/*
+BLAS libraries whose number of threads can be changed
+at run time; the setters are looked up among the symbols
+which are already loaded, so that they are found also when
+e.g. OpenBLAS is installed as the system libblas
+*/
+#ifndef WIN32
+static char *blas_library_name[] = {
+  "OpenBLAS",
+  "BLIS",
+  "Intel MKL",
+  NULL
+};
+static char *blas_setter_name[] = {
+  "openblas_set_num_threads",
+  "bli_thread_set_num_threads",
+  "MKL_Set_Num_Threads",
+  NULL
+};
+#endif
+
+
+void init_blas_threads(O3Data *od)
+{
+  #ifndef WIN32
+  int i = 0;
+  void *dl_handle;
+  #endif
+  
+  
+  od->blas.library = NULL;
+  od->blas.set_num_threads = NULL;
+  od->blas.n_threads = 0;
+  #ifndef WIN32
+  if ((dl_handle = dlopen(NULL, RTLD_NOW))) {
+    while ((!(od->blas.set_num_threads)) && blas_setter_name[i]) {
+      if ((od->blas.set_num_threads = (void (*)(int))
+        dlsym(dl_handle, blas_setter_name[i]))) {
+        od->blas.library = blas_library_name[i];
+      }
+      else {
+        ++i;
+      }
+    }
+    dlclose(dl_handle);
+  }
+  #elif (defined HAVE_LIBMKL) && (defined HAVE_MKL_H)
+  od->blas.set_num_threads = MKL_Set_Num_Threads;
+  od->blas.library = "Intel MKL";
+  #endif
+  set_blas_threads(od, 1);
+}
+
+
+/*
+each of the n_workers threads which are about to call
+BLAS gets an equal share of the available CPUs, so that
+a single model fit uses all of them while parallel
+cross-validation runs single-threaded BLAS on each worker
+*/
+int get_blas_threads(O3Data *od, int n_workers)
+{
+  int n_threads;
+  
+  
+  if (n_workers < 1) {
+    n_workers = 1;
+  }
+  n_threads = od->n_proc / n_workers;
+  if (od->blas.max_threads && (n_threads > od->blas.max_threads)) {
+    n_threads = od->blas.max_threads;
+  }
+  if (n_threads < 1) {
+    n_threads = 1;
+  }
+  
+  return n_threads;
+}
+
+
+void set_blas_threads(O3Data *od, int n_workers)
+{
+  int n_threads;
+  
+  
+  n_threads = get_blas_threads(od, n_workers);
+  if (od->blas.set_num_threads && (n_threads != od->blas.n_threads)) {
+    od->blas.set_num_threads(n_threads);
+    od->blas.n_threads = n_threads;
+  }
+}
+
+
+void print_blas_threads(O3Data *od)
+{
+  int n_workers;
+  
+  
+  if (!(od->blas.set_num_threads)) {
+    tee_printf(od, "The number of threads used by the BLAS library "
+      "cannot be changed at run time.\n\n");
+    return;
+  }
+  tee_printf(od, "The %s library will use %d thread%s "
+    "for single model fits.\n", od->blas.library,
+    get_blas_threads(od, 1), (get_blas_threads(od, 1) > 1) ? "s" : "");
+  if (od->n_proc > 1) {
+    n_workers = od->n_proc;
+    tee_printf(od, "Parallel jobs running on %d threads will "
+      "use %d BLAS thread%s each.\n", n_workers,
+      get_blas_threads(od, n_workers),
+      (get_blas_threads(od, n_workers) > 1) ? "s" : "");
+  }
+  tee_printf(od, "\n");
+}
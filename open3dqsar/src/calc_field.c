@@ -57,9 +57,7 @@ int calc_field(O3Data *od, void *thread_func, int prep_or_calc)
   char buffer2[BUF_LEN];
   int i;
   int n_threads;
-  #ifndef WIN32
-  pthread_attr_t thread_attr;
-  #endif
+  int result;
   ThreadInfo **ti;
 
 
@@ -96,8 +94,6 @@ int calc_field(O3Data *od, void *thread_func, int prep_or_calc)
   }
   #ifndef WIN32
   pthread_mutex_init(od->mel.mutex, NULL);
-  pthread_attr_init(&thread_attr);
-  pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
   #else
   if (!(*(od->mel.mutex) = CreateMutex(NULL, FALSE, NULL))) {
     return CANNOT_CREATE_THREAD;
@@ -107,50 +103,19 @@ int calc_field(O3Data *od, void *thread_func, int prep_or_calc)
   for (i = 0; i < n_threads; ++i) {
     memcpy(&(ti[i]->od), od, sizeof(O3Data));
     ti[i]->model_type = prep_or_calc;
-    /*
-    create the i-th thread
-    */
-    #ifndef WIN32
-    od->error_code = pthread_create(&(od->thread_id[i]),
-      &thread_attr, (void *(*)(void *))thread_func, ti[i]);
-    if (od->error_code) {
-      return CANNOT_CREATE_THREAD;
-    }
-    #else
-    od->hThreadArray[i] = CreateThread(NULL, 0,
-      (LPTHREAD_START_ROUTINE)thread_func,
-      ti[i], 0, &(od->dwThreadIdArray[i]));
-    if (!(od->hThreadArray[i])) {
-      return CANNOT_CREATE_THREAD;
-    }
-    #endif
   }
-  #ifndef WIN32
-  /*
-  free the pthread attribute memory
-  */
-  pthread_attr_destroy(&thread_attr);
   /*
-  wait for all threads to have finished
+  hand the job over to the worker pool
+  and wait for all threads to have finished
   */
-  for (i = 0; i < n_threads; ++i) {
-    od->error_code = pthread_join(od->thread_id[i],
-      &(od->thread_result[i]));
-    if (od->error_code) {
-      return CANNOT_JOIN_THREAD;
-    }
-  }
+  result = run_thread_pool(od, (void *)thread_func, n_threads);
+  #ifndef WIN32
   pthread_mutex_destroy(od->mel.mutex);
   #else
-  WaitForMultipleObjects(n_threads, od->hThreadArray, TRUE, INFINITE);
-  for (i = 0; i < n_threads; ++i) {
-    CloseHandle(od->hThreadArray[i]);
-  }
   CloseHandle(*(od->mel.mutex));
   #endif
-  free_threads(od);
   
-  return 0;
+  return result;
 }
 
 
@@ -187,7 +152,7 @@ DWORD calc_cosmo_thread(void *pointer)
       ti->od.al.task_list[object_num]->code = FL_OUT_OF_MEMORY;
     }
     #ifndef WIN32
-    pthread_exit(pointer);
+    return pointer;
     #else
     return 0;
     #endif
@@ -300,7 +265,7 @@ DWORD calc_cosmo_thread(void *pointer)
     }
   }
   #ifndef WIN32
-  pthread_exit(pointer);
+  return pointer;
   #else
   return 0;
   #endif
@@ -406,7 +371,7 @@ DWORD calc_qm_thread(void *pointer)
       ti->od.al.task_list[object_num]->code = FL_OUT_OF_MEMORY;
     }
     #ifndef WIN32
-    pthread_exit(pointer);
+    return pointer;
     #else
     return 0;
     #endif
@@ -844,7 +809,7 @@ DWORD calc_qm_thread(void *pointer)
     free_proc_env(prog_exe_info.proc_env);
   }
   #ifndef WIN32
-  pthread_exit(pointer);
+  return pointer;
   #else
   return 0;
   #endif
@@ -901,7 +866,7 @@ DWORD calc_mm_thread(void *pointer)
       ti->od.al.task_list[object_num]->code = FL_OUT_OF_MEMORY;
     }
     #ifndef WIN32
-    pthread_exit(pointer);
+    return pointer;
     #else
     return 0;
     #endif
@@ -1030,7 +995,7 @@ DWORD calc_mm_thread(void *pointer)
   free_array(atom);
 
   #ifndef WIN32
-  pthread_exit(pointer);
+  return pointer;
   #else
   return 0;
   #endif
@@ -1075,7 +1040,7 @@ DWORD calc_md_grid_thread(void *pointer)
       ti->od.al.task_list[object_num]->code = FL_OUT_OF_MEMORY;
     }
     #ifndef WIN32
-    pthread_exit(pointer);
+    return pointer;
     #else
     return 0;
     #endif
@@ -1230,7 +1195,7 @@ DWORD calc_md_grid_thread(void *pointer)
   free_array(atom);
 
   #ifndef WIN32
-  pthread_exit(pointer);
+  return pointer;
   #else
   return 0;
   #endif
@@ -42,55 +42,108 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
-void calc_large_mat_ave(O3Data *od, DoubleMat *large_mat, DoubleMat *large_mat_ave, int run)
+int calc_large_mat_sum(O3Data *od, DoubleMat *large_mat, DoubleMat **large_mat_sum)
 {
   int y;
   int x;
-  int n;
   int object_num;
-  int struct_num;
-  int conf_num;
-  int n_conf;
   double value;
-  double sumweight;
+  double weight;
   
   
   /*
-  calculate averages from columns of large_(e,f)_mat,
-  and store them into large_(e,f)_mat_ave
+  weighted column sums of large_(e,f)_mat over all active
+  objects: row 0 holds the sum of weighted values, row 1
+  the sum of weights and row 2 the number of non-missing
+  values; CV fold averages are then obtained by subtracting
+  only the contribution of left-out objects
   */
+  *large_mat_sum = double_mat_resize(*large_mat_sum, 3, large_mat->n);
+  if (!(*large_mat_sum)) {
+    return OUT_OF_MEMORY;
+  }
   for (x = 0; x < large_mat->n; ++x) {
-    n = 0;
-    object_num = 0;
-    y = 0;
-    sumweight = 0.0;
-    while (object_num < od->object_num) {
-      struct_num = od->al.mol_info[object_num]->struct_num;
-      conf_num = 1;
-      if (n < od->pel.out_structs->size) {
-        if (struct_num == od->pel.out_structs->pe[n]) {
-          ++n;
-          object_num += conf_num;
-          y += conf_num;
-          continue;
+    M_POKE(*large_mat_sum, 0, x, 0.0);
+    M_POKE(*large_mat_sum, 1, x, 0.0);
+    M_POKE(*large_mat_sum, 2, x, 0.0);
+    for (object_num = 0, y = 0; object_num < od->object_num; ++object_num) {
+      if (get_object_attr(od, object_num, ACTIVE_BIT)) {
+        value = M_PEEK(large_mat, y, x);
+        if (!MISSING(value)) {
+          weight = od->mel.object_weight[object_num];
+          M_POKE(*large_mat_sum, 0, x,
+            M_PEEK(*large_mat_sum, 0, x) + value * weight);
+          M_POKE(*large_mat_sum, 1, x,
+            M_PEEK(*large_mat_sum, 1, x) + weight);
+          M_POKE(*large_mat_sum, 2, x,
+            M_PEEK(*large_mat_sum, 2, x) + 1.0);
         }
+        ++y;
       }
-      for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num) {
-        if (get_object_attr(od, object_num, ACTIVE_BIT)) {
-          value = M_PEEK(large_mat, y, x);
-          if (!MISSING(value)) {
-            M_POKE(large_mat_ave, run, x,
-              M_PEEK(large_mat_ave, run, x)
-              + value * od->mel.object_weight[object_num]);
-            sumweight += od->mel.object_weight[object_num];
-          }
-          ++y;
-        }
+    }
+  }
+  
+  return 0;
+}
+
+
+double calc_fold_column_ave(O3Data *od, DoubleMat *large_mat,
+  DoubleMat *large_mat_sum, int x)
+{
+  int i;
+  double value;
+  double sum = 0.0;
+  double sumweight = 0.0;
+  double count = 0.0;
+  
+  
+  /*
+  weighted average of column x over the training objects
+  of the current fold, as set by fill_fold_rows();
+  if full column sums are available only left-out
+  objects need to be visited
+  */
+  if (large_mat_sum) {
+    sum = M_PEEK(large_mat_sum, 0, x);
+    sumweight = M_PEEK(large_mat_sum, 1, x);
+    count = M_PEEK(large_mat_sum, 2, x);
+    for (i = 0; i < od->pel.fold_out_rows->size; ++i) {
+      value = M_PEEK(large_mat, od->pel.fold_out_rows->pe[i], x);
+      if (!MISSING(value)) {
+        sum -= (value * od->vel.fold_out_weight->ve[i]);
+        sumweight -= od->vel.fold_out_weight->ve[i];
+        count -= 1.0;
       }
     }
-    if (sumweight > 0.0) {
-      M_POKE(large_mat_ave, run, x,
-        M_PEEK(large_mat_ave, run, x) / sumweight);
+  }
+  else {
+    for (i = 0; i < od->pel.fold_train_rows->size; ++i) {
+      value = M_PEEK(large_mat, od->pel.fold_train_rows->pe[i], x);
+      if (!MISSING(value)) {
+        sum += (value * od->vel.fold_train_weight->ve[i]);
+        sumweight += od->vel.fold_train_weight->ve[i];
+        count += 1.0;
+      }
     }
   }
+  
+  return (((count > 0.5) && (sumweight > 0.0)) ? sum / sumweight : 0.0);
+}
+
+
+void calc_large_mat_ave(O3Data *od, DoubleMat *large_mat,
+  DoubleMat *large_mat_sum, DoubleMat *large_mat_ave, int run)
+{
+  int x;
+  
+  
+  /*
+  calculate averages from columns of large_(e,f)_mat,
+  and store them into large_(e,f)_mat_ave
+  */
+  fill_fold_rows(od);
+  for (x = 0; x < large_mat->n; ++x) {
+    M_POKE(large_mat_ave, run, x,
+      calc_fold_column_ave(od, large_mat, large_mat_sum, x));
+  }
 }
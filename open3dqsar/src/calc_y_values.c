@@ -280,6 +280,7 @@ int calc_y_values(O3Data *od, int options)
       od->mal.y_loadings->max_m, 0.0,
       od->mal.b_coefficients->base,
       od->mal.b_coefficients->max_m);
+    cache_pls_coefficients(od, i);
     
     double_mat_resize(od->mal.x_scores, y_max, i);
     cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
@@ -333,6 +334,7 @@ int calc_y_values(O3Data *od, int options)
       }
     }
   }
+  od->model.valid = 1;
   if (options & CALC_LEVERAGE_BIT) {
     od->mal.hat_temp1_mat = double_mat_alloc
       (od->mal.e_mat->m, od->mal.e_mat->n);
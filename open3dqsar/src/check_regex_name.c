@@ -553,9 +553,7 @@ int match_objects_with_datafile(O3Data *od, char *file_pattern, int datafile_typ
   }
   for (object_num = 0; object_num < od->object_num; ++object_num) {
     rewind(od->file[TEMP_OBJECT_MATCH]->handle);
-    sprintf(mol_fd.name, "%s%c%04d.mol", od->field.mol_dir,
-      SEPARATOR, od->al.mol_info[object_num]->object_id);
-    if (!(mol_fd.handle = fopen(mol_fd.name, "rb"))) {
+    if (open_mol_record(od, &mol_fd, object_num)) {
       O3_ERROR_LOCATE(&(od->task));
       O3_ERROR_STRING(&(od->task), mol_fd.name);
       return CANNOT_READ_ORIGINAL_SDF;
@@ -0,0 +1,159 @@
+/*
+
+compare_cv_precision.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+int compare_cv_precision(O3Data *od, int pc_num,
+  int cv_type, int groups, int runs)
+{
+  char sp_pred_name[BUF_LEN];
+  int i;
+  int result;
+  int auto_runs;
+  CVPredStore sp_pred;
+  DoubleVec *sp_sdep;
+  DoubleVec *sp_q2;
+  
+  
+  /*
+  keep the single precision statistics, then repeat
+  the same CV (same seed, hence same LMO groups)
+  in double precision without printing it
+  */
+  sp_sdep = double_vec_alloc(od->pc_num + 1);
+  sp_q2 = double_vec_alloc(od->pc_num + 1);
+  if (!(sp_sdep && sp_q2)) {
+    if (sp_sdep) {
+      double_vec_free(sp_sdep);
+    }
+    if (sp_q2) {
+      double_vec_free(sp_q2);
+    }
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i <= od->pc_num; ++i) {
+    sp_sdep->ve[i] = od->vel.ave_sdep->ve[i];
+    sp_q2->ve[i] = od->vel.q2->ve[i];
+  }
+  od->pls_precision = PLS_DOUBLE_PRECISION;
+  od->cv.sp_cv = 0;
+  memset(od->mal.press->base, 0,
+    od->mal.press->m * od->mal.press->n * sizeof(double));
+  memset(od->mal.ave_press->base, 0,
+    od->mal.ave_press->m * od->mal.ave_press->n * sizeof(double));
+  /*
+  with runs=AUTO, the double precision CV
+  is carried out on the same runs
+  */
+  auto_runs = od->cv.auto_runs;
+  if ((cv_type == LEAVE_MANY_OUT) && auto_runs) {
+    runs = od->cv.runs_done;
+    od->cv.auto_runs = 0;
+  }
+  /*
+  the single precision predictions, either in memory
+  or in the TEMP_PRED file, are set aside so that the
+  double precision CV does not overwrite them
+  */
+  memcpy(&sp_pred, &(od->cv_pred), sizeof(CVPredStore));
+  memset(&(od->cv_pred), 0, sizeof(CVPredStore));
+  memcpy(sp_pred_name, od->file[TEMP_PRED]->name, BUF_LEN);
+  memset(od->file[TEMP_PRED]->name, 0, BUF_LEN);
+  set_random_seed(od, od->random_seed);
+  result = prepare_cv(od, pc_num, cv_type, groups, runs);
+  if (!result) {
+    result = alloc_cv_pred(od, pc_num, cv_type);
+  }
+  if (!result) {
+    if ((!(od->cv_pred.active))
+      && open_temp_file(od, od->file[TEMP_PRED], "pred_y")) {
+      result = CANNOT_WRITE_TEMP_FILE;
+    }
+    else {
+      result = cv(od, pc_num, CV_MODEL | SILENT_PLS,
+        cv_type, groups, runs);
+      if (od->file[TEMP_PRED]->handle) {
+        fclose(od->file[TEMP_PRED]->handle);
+        od->file[TEMP_PRED]->handle = NULL;
+      }
+    }
+    if (cv_type == LEAVE_MANY_OUT) {
+      free_cv_groups(od, runs);
+    }
+  }
+  free_cv_pred(od);
+  memcpy(&(od->cv_pred), &sp_pred, sizeof(CVPredStore));
+  if (od->file[TEMP_PRED]->name[0]) {
+    remove(od->file[TEMP_PRED]->name);
+  }
+  memcpy(od->file[TEMP_PRED]->name, sp_pred_name, BUF_LEN);
+  od->pls_precision = PLS_SINGLE_PRECISION;
+  od->cv.auto_runs = auto_runs;
+  if (!result) {
+    tee_printf(od, "\nSingle vs. double precision CV\n\n"
+      "PC%12s%12s%12s%12s%12s%12s\n",
+      "SDEP (SP)", "SDEP (DP)", "Diff. SDEP",
+      "q2 (SP)", "q2 (DP)", "Diff. q2");
+    tee_printf(od, "--------------------------------------"
+      "------------------------------------\n");
+    for (i = 0; i <= od->pc_num; ++i) {
+      tee_printf(od, "%2d%12.4lf%12.4lf%12.2le%12.4lf%12.4lf%12.2le\n",
+        i, sp_sdep->ve[i], od->vel.ave_sdep->ve[i],
+        sp_sdep->ve[i] - od->vel.ave_sdep->ve[i],
+        sp_q2->ve[i], od->vel.q2->ve[i],
+        sp_q2->ve[i] - od->vel.q2->ve[i]);
+    }
+    tee_printf(od, "\n");
+    /*
+    the statistics of the CV requested by the user
+    are the single precision ones
+    */
+    for (i = 0; i <= od->pc_num; ++i) {
+      od->vel.ave_sdep->ve[i] = sp_sdep->ve[i];
+      od->vel.q2->ve[i] = sp_q2->ve[i];
+    }
+  }
+  double_vec_free(sp_sdep);
+  double_vec_free(sp_q2);
+  
+  return result;
+}
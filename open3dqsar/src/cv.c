@@ -62,14 +62,21 @@ int cv(O3Data *od, int suggested_pc_num,
   int conf_num2 = 0;
   int n_conf;
   int result;
+  int verbose;
   IntMat *group_composition;
   double sumweight = 0.0;
   double cum_press;
   double sd_sdep;
   double temp;
+  double tss;
   
 
   result = 0;
+  /*
+  SILENT_PLS runs (e.g. the double precision reference
+  of check_precision) do not print anything
+  */
+  verbose = ((model_type & CV_MODEL) && (!(model_type & SILENT_PLS)));
   od->cv.overall_cv_runs = 0;
   switch (cv_type) {
     case LEAVE_ONE_OUT:
@@ -103,15 +110,28 @@ int cv(O3Data *od, int suggested_pc_num,
           trim_mean_center_x_matrix_hp(od,
             model_type, od->active_object_num - y,
             od->cv.overall_cv_runs);
-          trim_mean_center_matrix(od, od->mal.large_f_mat,
+          trim_mean_center_matrix(od, od->mal.large_f_mat, NULL,
             &(od->mal.f_mat), &(od->vel.f_mat_ave),
             model_type, od->active_object_num - y);
         }
         else {
-          trim_mean_center_matrix(od, od->mal.large_e_mat,
-            &(od->mal.e_mat), &(od->vel.e_mat_ave),
-            model_type, od->active_object_num - y);
+          if (od->cv.kernel_cv) {
+            kernel_cv_fold(od, od->active_object_num - y);
+          }
+          else if (od->cv.implicit_cv) {
+            implicit_cv_fold(od);
+          }
+          else if (od->cv.sp_cv) {
+            sp_cv_fold(od);
+          }
+          else {
+            trim_mean_center_matrix(od, od->mal.large_e_mat,
+              od->mal.large_e_mat_sum,
+              &(od->mal.e_mat), &(od->vel.e_mat_ave),
+              model_type, od->active_object_num - y);
+          }
           trim_mean_center_matrix(od, od->mal.large_f_mat,
+            od->mal.large_f_mat_sum,
             &(od->mal.f_mat), &(od->vel.f_mat_ave),
             model_type, od->active_object_num - y);
         }
@@ -124,7 +144,7 @@ int cv(O3Data *od, int suggested_pc_num,
         }
       }
     }
-    if (model_type & CV_MODEL) {
+    if (verbose) {
       result = print_pred_values(od);
       if (result) {
         return result;
@@ -146,7 +166,7 @@ int cv(O3Data *od, int suggested_pc_num,
           sqrt(cum_press / (od->y_vars
           * ((double)(od->cv.num_predictions) - i - 1)));
       }
-      if (model_type & CV_MODEL) {
+      if (verbose) {
         tee_printf(od, "%2d%12.4lf%12.4lf\n", i,
           od->vel.ave_sdep->ve[i],
           od->vel.q2->ve[i]);
@@ -199,15 +219,28 @@ int cv(O3Data *od, int suggested_pc_num,
               trim_mean_center_x_matrix_hp(od,
                 model_type, od->active_object_num - (y + y2),
                 od->cv.overall_cv_runs);
-              trim_mean_center_matrix(od, od->mal.large_f_mat,
+              trim_mean_center_matrix(od, od->mal.large_f_mat, NULL,
                 &(od->mal.f_mat), &(od->vel.f_mat_ave),
                 model_type, od->active_object_num - (y + y2));
             }
             else {
-              trim_mean_center_matrix(od, od->mal.large_e_mat,
-                &(od->mal.e_mat), &(od->vel.e_mat_ave),
-                model_type, od->active_object_num - (y + y2));
+              if (od->cv.kernel_cv) {
+                kernel_cv_fold(od, od->active_object_num - (y + y2));
+              }
+              else if (od->cv.implicit_cv) {
+                implicit_cv_fold(od);
+              }
+              else if (od->cv.sp_cv) {
+                sp_cv_fold(od);
+              }
+              else {
+                trim_mean_center_matrix(od, od->mal.large_e_mat,
+                  od->mal.large_e_mat_sum,
+                  &(od->mal.e_mat), &(od->vel.e_mat_ave),
+                  model_type, od->active_object_num - (y + y2));
+              }
               trim_mean_center_matrix(od, od->mal.large_f_mat,
+                od->mal.large_f_mat_sum,
                 &(od->mal.f_mat), &(od->vel.f_mat_ave),
                 model_type, od->active_object_num - (y + y2));
             }
@@ -222,7 +255,7 @@ int cv(O3Data *od, int suggested_pc_num,
         }
       }
     }
-    if (model_type & CV_MODEL) {
+    if (verbose) {
       result = print_pred_values(od);
       if (result) {
         return result;
@@ -244,7 +277,7 @@ int cv(O3Data *od, int suggested_pc_num,
           sqrt(cum_press / (od->y_vars
           * ((double)(od->cv.num_predictions) - i - 1)));
       }
-      if (model_type & CV_MODEL) {
+      if (verbose) {
         tee_printf(od, "%2d%12.4lf%12.4lf\n", i,
           od->vel.ave_sdep->ve[i],
           od->vel.q2->ve[i]);
@@ -257,6 +290,9 @@ int cv(O3Data *od, int suggested_pc_num,
       memset(od->mal.press->base, 0,
         od->mal.press->m * od->mal.press->n * sizeof(double));
       od->cv.num_predictions = 0;
+      if (fill_group_composition(od, i)) {
+        return OUT_OF_MEMORY;
+      }
       group_composition = od->cimal.group_composition_list[i];
       for (group_num = 0; group_num < groups; ++group_num) {
         /*
@@ -285,15 +321,28 @@ int cv(O3Data *od, int suggested_pc_num,
           trim_mean_center_x_matrix_hp(od, model_type,
             od->active_object_num - object_count,
             od->cv.overall_cv_runs);
-          trim_mean_center_matrix(od, od->mal.large_f_mat,
+          trim_mean_center_matrix(od, od->mal.large_f_mat, NULL,
             &(od->mal.f_mat), &(od->vel.f_mat_ave),
             model_type, od->active_object_num - object_count);
         }
         else {
-          trim_mean_center_matrix(od, od->mal.large_e_mat,
-            &(od->mal.e_mat), &(od->vel.e_mat_ave),
-            model_type, od->active_object_num - object_count);
+          if (od->cv.kernel_cv) {
+            kernel_cv_fold(od, od->active_object_num - object_count);
+          }
+          else if (od->cv.implicit_cv) {
+            implicit_cv_fold(od);
+          }
+          else if (od->cv.sp_cv) {
+            sp_cv_fold(od);
+          }
+          else {
+            trim_mean_center_matrix(od, od->mal.large_e_mat,
+              od->mal.large_e_mat_sum,
+              &(od->mal.e_mat), &(od->vel.e_mat_ave),
+              model_type, od->active_object_num - object_count);
+          }
           trim_mean_center_matrix(od, od->mal.large_f_mat,
+            od->mal.large_f_mat_sum,
             &(od->mal.f_mat), &(od->vel.f_mat_ave),
             model_type, od->active_object_num - object_count);
         }
@@ -319,13 +368,32 @@ int cv(O3Data *od, int suggested_pc_num,
         M_POKE(od->mal.sdep_mat, i, j,
           sqrt(cum_press / (double)(od->cv.num_predictions)));
       }
+      /*
+      with runs=AUTO, stop as soon as average q2
+      is known with the required confidence
+      */
+      if (od->cv.auto_runs
+        && check_lmo_convergence(od, i + 1, suggested_pc_num)) {
+        runs = i + 1;
+      }
     }
     od->cv.num_predictions *= runs;
-    if (model_type & CV_MODEL) {
+    od->cv.runs_done = runs;
+    /*
+    tss was computed for all the runs planned in prepare_cv()
+    */
+    tss = od->cv.tss;
+    if (runs < od->cv.runs) {
+      tss *= ((double)runs / (double)(od->cv.runs));
+    }
+    if (verbose) {
       result = print_pred_values(od);
       if (result) {
         return result;
       }
+      if (od->cv.auto_runs) {
+        print_lmo_convergence(od, runs);
+      }
       tee_printf(od, "\nPC%12s%12s%12s\n",
         "SDEP", "SD on SDEP", "Average q2");
       tee_printf(od, "--------------------------------------\n");
@@ -357,13 +425,13 @@ int cv(O3Data *od, int suggested_pc_num,
       for (x = 0; x < od->y_vars; ++x) {
         cum_press += M_PEEK(od->mal.ave_press, j, x);
       }
-      od->vel.q2->ve[j] = 1.0 - cum_press / od->cv.tss;
+      od->vel.q2->ve[j] = 1.0 - cum_press / tss;
       if (model_type & SCRAMBLE_CV_MODEL) {
         od->vel.secv->ve[j] =
           sqrt(cum_press / (od->y_vars
           * ((double)(od->cv.num_predictions) - j - 1)));
       }
-      if (model_type & CV_MODEL) {
+      if (verbose) {
         tee_printf(od, "%2d%12.4lf%12.4lf%12.4lf\n", j,
           od->vel.ave_sdep->ve[j],
           sd_sdep, od->vel.q2->ve[j]);
@@ -0,0 +1,172 @@
+/*
+
+cv_pred.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+CV predictions are stored in memory in one block per CV run
+(one left-out structure for LOO, two for LTO, one group for
+LMO); each block has room for the largest group, so the slots
+filled by each CV run are known in advance and threads can
+write their own blocks without locking. With O3_SAVE_RAM=YES
+predictions are spilled to temporary files instead
+*/
+int alloc_cv_pred(O3Data *od, int pc_num, int cv_type)
+{
+  int n_slots;
+  size_t n_values;
+  double *value;
+  CVPredStore *store;
+  
+  
+  store = &(od->cv_pred);
+  store->active = 0;
+  store->indexed = 0;
+  if (od->save_ram) {
+    return 0;
+  }
+  switch (cv_type) {
+    case LEAVE_ONE_OUT:
+    store->block_size = 1;
+    break;
+    
+    case LEAVE_TWO_OUT:
+    store->block_size = 2;
+    break;
+    
+    case LEAVE_MANY_OUT:
+    store->block_size = od->mel.struct_per_group[0];
+    break;
+  }
+  store->n_blocks = od->cv.overall_cv_runs;
+  store->pc_num = pc_num;
+  store->y_vars = od->y_vars;
+  store->object_num = od->object_num;
+  n_slots = store->n_blocks * store->block_size;
+  store->block_len = alloc_int_array(store->block_len, store->n_blocks);
+  store->block_pc = alloc_int_array(store->block_pc, store->n_blocks);
+  store->object_list = alloc_int_array(store->object_list, n_slots);
+  store->next_slot = alloc_int_array(store->next_slot, n_slots);
+  store->first_slot = alloc_int_array(store->first_slot, od->object_num);
+  if (!(store->block_len) || !(store->block_pc) || !(store->object_list)
+    || !(store->next_slot) || !(store->first_slot)) {
+    return OUT_OF_MEMORY;
+  }
+  n_values = (size_t)n_slots * od->y_vars * (pc_num + 1);
+  if (n_values > store->max_values) {
+    value = (double *)realloc(store->value, n_values * sizeof(double));
+    if (!value) {
+      return OUT_OF_MEMORY;
+    }
+    store->value = value;
+    store->max_values = n_values;
+  }
+  store->active = 1;
+  
+  return 0;
+}
+
+
+/*
+chain together the slots where each object was predicted,
+in CV run order
+*/
+static void index_cv_pred(CVPredStore *store)
+{
+  int i;
+  int n;
+  int slot;
+  int object_num;
+  
+  
+  for (i = 0; i < store->object_num; ++i) {
+    store->first_slot[i] = -1;
+  }
+  for (i = store->n_blocks - 1; i >= 0; --i) {
+    for (n = store->block_len[i] - 1; n >= 0; --n) {
+      slot = i * store->block_size + n;
+      object_num = store->object_list[slot];
+      store->next_slot[slot] = store->first_slot[object_num];
+      store->first_slot[object_num] = slot;
+    }
+  }
+  store->indexed = 1;
+}
+
+
+/*
+adds to sum[0..pc_num] the values predicted for the x-th
+dependent variable of object_num in all CV runs which left
+it out; returns the number of such runs
+*/
+int get_cv_pred_sum(O3Data *od, int object_num, int x, int pc_num, double *sum)
+{
+  int j;
+  int slot;
+  int block_pc;
+  int num_values;
+  CVPredStore *store;
+  
+  
+  store = &(od->cv_pred);
+  if (!(store->indexed)) {
+    index_cv_pred(store);
+  }
+  if ((object_num >= store->object_num) || (x >= store->y_vars)) {
+    return 0;
+  }
+  num_values = 0;
+  for (slot = store->first_slot[object_num]; slot != -1;
+    slot = store->next_slot[slot]) {
+    block_pc = store->block_pc[slot / store->block_size];
+    if (block_pc > pc_num) {
+      block_pc = pc_num;
+    }
+    for (j = 0; j <= block_pc; ++j) {
+      sum[j] += CV_PRED_VALUE(store, slot, x, j);
+    }
+    ++num_values;
+  }
+  
+  return num_values;
+}
@@ -46,14 +46,55 @@ E-mail: paolo.tosco@unito.it
 #endif
 
 
-#ifndef WIN32
-void *lmo_cv_thread(void *pointer)
-#else
-DWORD lmo_cv_thread(void *pointer)
-#endif
+/*
+PRESS partials are not accumulated into shared
+matrices under a lock; each thread works on its own
+press matrix, which is zeroed before each CV run
+and then stored into the column of od->mal.task_press
+belonging to that run. parallel_cv() merges the
+columns in run order after all threads have finished,
+so the result does not depend on the number of threads
+nor on which thread carried out which run
+*/
+static void clear_thread_press(ThreadInfo *ti)
+{
+  int i;
+  int x;
+  
+  
+  for (x = 0; x < ti->od.y_vars; ++x) {
+    for (i = 0; i <= ti->pc_num; ++i) {
+      M_POKE(ti->od.mal.press, i, x, 0.0);
+    }
+  }
+}
+
+
+static void store_task_press(ThreadInfo *ti, int task)
+{
+  int i;
+  int x;
+  
+  
+  for (x = 0; x < ti->od.y_vars; ++x) {
+    for (i = 0; i <= ti->pc_num; ++i) {
+      M_POKE(ti->od.mal.task_press, x * (ti->pc_num + 1) + i, task,
+        M_PEEK(ti->od.mal.press, i, x));
+    }
+  }
+}
+
+
+/*
+CV runs are carried out by the functions below, which
+are shared by local threads and by worker processes
+(see run_worker()); results go into the run's own column
+of task_press, row of sdep_mat and block of the
+in-memory prediction store
+*/
+void lmo_cv_task(ThreadInfo *ti, int j)
 {
   int i;
-  int j;
   int x;
   int num_predictions;
   int group_num;
@@ -61,97 +102,176 @@ DWORD lmo_cv_thread(void *pointer)
   int struct_count;
   int result;
   double cum_press;
-  ThreadInfo *ti;
 
 
-  ti = (ThreadInfo *)pointer;
-  for (j = ti->start; j <= ti->end; ++j) {
-    memset(ti->od.mal.press->base, 0,
-      ti->od.mal.press->m
-      * ti->od.mal.press->n
-      * sizeof(double));
-    num_predictions = 0;
-    for (group_num = 0; group_num < ti->groups; ++group_num) {
-      /*
-      initialize the left-out objects vector before PLS
-      */
-      int_perm_resize(ti->od.pel.out_structs,
-        ti->od.mel.struct_per_group[group_num]);
-      for (struct_count = 0, object_count = 0;
-        struct_count < ti->od.mel.struct_per_group[group_num];
-        ++struct_count) {
-        ti->od.pel.out_structs->pe[struct_count] =
-          ti->od.cimal.group_composition_list[j]
-          ->me[group_num][struct_count];
-        ++object_count;
+  clear_thread_press(ti);
+  if (fill_group_composition(&(ti->od), j)) {
+    ti->out_of_memory = 1;
+    return;
+  }
+  num_predictions = 0;
+  for (group_num = 0; group_num < ti->groups; ++group_num) {
+    /*
+    initialize the left-out objects vector before PLS
+    */
+    int_perm_resize(ti->od.pel.out_structs,
+      ti->od.mel.struct_per_group[group_num]);
+    for (struct_count = 0, object_count = 0;
+      struct_count < ti->od.mel.struct_per_group[group_num];
+      ++struct_count) {
+      ti->od.pel.out_structs->pe[struct_count] =
+        ti->od.cimal.group_composition_list[j]
+        ->me[group_num][struct_count];
+      ++object_count;
+    }
+    qsort(ti->od.pel.out_structs->pe,
+      ti->od.pel.out_structs->size, sizeof(int), compare_integers);
+    if (ti->model_type & UVEPLS_CV_MODEL) {
+      trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
+        ti->od.active_object_num - object_count,
+        j * ti->groups + group_num);
+      trim_mean_center_y_matrix_hp(&(ti->od),
+        ti->od.active_object_num - object_count,
+        j * ti->groups + group_num);
+    }
+    else if (ti->model_type & SCRAMBLE_CV_MODEL) {
+      trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
+        ti->od.active_object_num - object_count,
+        j * ti->groups + group_num);
+      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat, NULL,
+        &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+        ti->model_type, ti->od.active_object_num - object_count);
+    }
+    else {
+      if (ti->od.cv.kernel_cv) {
+        kernel_cv_fold(&(ti->od), ti->od.active_object_num - object_count);
       }
-      qsort(ti->od.pel.out_structs->pe,
-        ti->od.pel.out_structs->size, sizeof(int), compare_integers);
-      if (ti->model_type & UVEPLS_CV_MODEL) {
-        trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
-          ti->od.active_object_num - object_count,
-          j * ti->groups + group_num);
-        trim_mean_center_y_matrix_hp(&(ti->od),
-          ti->od.active_object_num - object_count,
-          j * ti->groups + group_num);
+      else if (ti->od.cv.implicit_cv) {
+        implicit_cv_fold(&(ti->od));
       }
-      else if (ti->model_type & SCRAMBLE_CV_MODEL) {
-        trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
-          ti->od.active_object_num - object_count,
-          j * ti->groups + group_num);
-        trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
-          &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
-          ti->model_type, ti->od.active_object_num - object_count);
+      else if (ti->od.cv.sp_cv) {
+        sp_cv_fold(&(ti->od));
       }
       else {
         trim_mean_center_matrix(&(ti->od), ti->od.mal.large_e_mat,
+          ti->od.mal.large_e_mat_sum,
           &(ti->od.mal.e_mat), &(ti->od.vel.e_mat_ave),
           ti->model_type, ti->od.active_object_num - object_count);
-        trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
-          &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
-          ti->model_type, ti->od.active_object_num - object_count);
-      }
-      pls(&(ti->od), ti->pc_num, ti->model_type);
-      result = pred_y_values(&(ti->od), ti,
-        ti->od.pc_num, ti->model_type,
-        j * ti->groups + group_num);
-      if (result) {
-        ti->cannot_write_temp_file = 1;
       }
-      num_predictions += (ti->od.y_vars
-        * ti->od.mel.struct_per_group[group_num]);
+      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
+        ti->od.mal.large_f_mat_sum,
+        &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+        ti->model_type, ti->od.active_object_num - object_count);
+    }
+    pls(&(ti->od), ti->pc_num, ti->model_type);
+    result = pred_y_values(&(ti->od), ti,
+      ti->od.pc_num, ti->model_type,
+      j * ti->groups + group_num);
+    if (result) {
+      ti->cannot_write_temp_file = 1;
+    }
+    num_predictions += (ti->od.y_vars
+      * ti->od.mel.struct_per_group[group_num]);
+  }
+  /*
+  each run owns row j of sdep_mat, so no lock is needed;
+  ave_press is summed up by parallel_cv()
+  */
+  store_task_press(ti, j);
+  for (i = 0; i <= ti->od.pc_num; ++i) {
+    cum_press = (double)0;
+    for (x = 0; x < ti->od.y_vars; ++x) {
+      cum_press += M_PEEK(ti->od.mal.press, i, x);
     }
-    for (i = 0; i <= ti->od.pc_num; ++i) {
-      cum_press = (double)0;
-      #ifndef WIN32
-      pthread_mutex_lock(ti->od.mel.mutex);
-      #else
-      WaitForSingleObject(ti->od.mel.mutex, INFINITE);
-      #endif
-      for (x = 0; x < ti->od.y_vars; ++x) {
-        M_POKE(ti->od.mal.ave_press, i, x,
-          M_PEEK(ti->od.mal.ave_press, i, x)
-          + M_PEEK(ti->od.mal.press, i, x));
-        cum_press += M_PEEK(ti->od.mal.press, i, x);
+    M_POKE(ti->od.mal.sdep_mat, j, i,
+      sqrt(cum_press / (double)num_predictions));
+  }
+}
 
-      }
-      M_POKE(ti->od.mal.sdep_mat, j, i,
-        sqrt(cum_press / (double)num_predictions));
-      #ifndef WIN32
-      pthread_mutex_unlock(ti->od.mel.mutex);
-      #else
-      ReleaseMutex(ti->od.mel.mutex);
-      #endif
+
+#ifndef WIN32
+void *lmo_cv_thread(void *pointer)
+#else
+DWORD lmo_cv_thread(void *pointer)
+#endif
+{
+  int j;
+  ThreadInfo *ti;
+
+
+  ti = (ThreadInfo *)pointer;
+  while ((j = get_next_task(ti)) != -1) {
+    lmo_cv_task(ti, j);
+    if (ti->od.cv.auto_runs && (!(ti->out_of_memory))) {
+      complete_task(ti, j);
     }
   }
   #ifndef WIN32
-  pthread_exit(pointer);
+  return pointer;
   #else
   return 0;
   #endif
 }
 
 
+void loo_cv_task(ThreadInfo *ti, int i)
+{
+  int object_count;
+  int result;
+
+
+  clear_thread_press(ti);
+  /*
+  initialize the left-out objects vector before PLS
+  */
+  int_perm_resize(ti->od.pel.out_structs, 1);
+  ti->od.pel.out_structs->pe[0] =
+    ti->od.mel.struct_list[i];
+  object_count = 1;
+  if (ti->model_type & UVEPLS_CV_MODEL) {
+    trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
+      ti->od.active_object_num - object_count, i);
+    trim_mean_center_y_matrix_hp(&(ti->od),
+      ti->od.active_object_num - object_count, i);
+  }
+  else if (ti->model_type & SCRAMBLE_CV_MODEL) {
+    trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
+      ti->od.active_object_num - object_count, i);
+    trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat, NULL,
+      &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+      ti->model_type, ti->od.active_object_num - object_count);
+  }
+  else {
+    if (ti->od.cv.kernel_cv) {
+      kernel_cv_fold(&(ti->od), ti->od.active_object_num - object_count);
+    }
+    else if (ti->od.cv.implicit_cv) {
+      implicit_cv_fold(&(ti->od));
+    }
+    else if (ti->od.cv.sp_cv) {
+      sp_cv_fold(&(ti->od));
+    }
+    else {
+      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_e_mat,
+        ti->od.mal.large_e_mat_sum,
+        &(ti->od.mal.e_mat), &(ti->od.vel.e_mat_ave),
+        ti->model_type, ti->od.active_object_num - object_count);
+    }
+    trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
+      ti->od.mal.large_f_mat_sum,
+      &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+      ti->model_type, ti->od.active_object_num - object_count);
+  }
+  pls(&(ti->od), ti->pc_num, ti->model_type);
+  result = pred_y_values(&(ti->od), ti,
+    ti->od.pc_num, ti->model_type, i);
+  if (result) {
+    ti->cannot_write_temp_file = 1;
+  }
+  store_task_press(ti, i);
+}
+
+
 #ifndef WIN32
 void *loo_cv_thread(void *pointer)
 #else
@@ -159,53 +279,79 @@ DWORD loo_cv_thread(void *pointer)
 #endif
 {
   int i;
-  int object_count;
-  int result;
   ThreadInfo *ti;
 
 
   ti = (ThreadInfo *)pointer;
-  for (i = ti->start; i <= ti->end; ++i) {
-    /*
-    initialize the left-out objects vector before PLS
-    */
-    int_perm_resize(ti->od.pel.out_structs, 1);
-    ti->od.pel.out_structs->pe[0] =
-      ti->od.mel.struct_list[i];
-    object_count = 1;
-    if (ti->model_type & UVEPLS_CV_MODEL) {
-      trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
-        ti->od.active_object_num - object_count, i);
-      trim_mean_center_y_matrix_hp(&(ti->od),
-        ti->od.active_object_num - object_count, i);
+  while ((i = get_next_task(ti)) != -1) {
+    loo_cv_task(ti, i);
+  }
+  #ifndef WIN32
+  return pointer;
+  #else
+  return 0;
+  #endif
+}
+
+
+void lto_cv_task(ThreadInfo *ti, int i)
+{
+  int object_count;
+  int result;
+
+
+  i *= 2;
+  clear_thread_press(ti);
+  /*
+  initialize the left-out objects vector before PLS
+  */
+  int_perm_resize(ti->od.pel.out_structs, 2);
+  ti->od.pel.out_structs->pe[0] =
+    ti->od.mel.struct_list[i];
+  ti->od.pel.out_structs->pe[1] =
+    ti->od.mel.struct_list[i + 1];
+  object_count = 2;
+  if (ti->model_type & UVEPLS_CV_MODEL) {
+    trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
+      ti->od.active_object_num - object_count, i / 2);
+    trim_mean_center_y_matrix_hp(&(ti->od),
+      ti->od.active_object_num - object_count, i / 2);
+  }
+  else if (ti->model_type & SCRAMBLE_CV_MODEL) {
+    trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
+      ti->od.active_object_num - object_count, i / 2);
+    trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat, NULL,
+      &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+      ti->model_type, ti->od.active_object_num - object_count);
+  }
+  else {
+    if (ti->od.cv.kernel_cv) {
+      kernel_cv_fold(&(ti->od), ti->od.active_object_num - object_count);
     }
-    else if (ti->model_type & SCRAMBLE_CV_MODEL) {
-      trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
-        ti->od.active_object_num - object_count, i);
-      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
-        &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
-        ti->model_type, ti->od.active_object_num - object_count);
+    else if (ti->od.cv.implicit_cv) {
+      implicit_cv_fold(&(ti->od));
+    }
+    else if (ti->od.cv.sp_cv) {
+      sp_cv_fold(&(ti->od));
     }
     else {
       trim_mean_center_matrix(&(ti->od), ti->od.mal.large_e_mat,
+        ti->od.mal.large_e_mat_sum,
         &(ti->od.mal.e_mat), &(ti->od.vel.e_mat_ave),
         ti->model_type, ti->od.active_object_num - object_count);
-      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
-        &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
-        ti->model_type, ti->od.active_object_num - object_count);
-    }
-    pls(&(ti->od), ti->pc_num, ti->model_type);
-    result = pred_y_values(&(ti->od), ti,
-      ti->od.pc_num, ti->model_type, i);
-    if (result) {
-      ti->cannot_write_temp_file = 1;
     }
+    trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
+      ti->od.mal.large_f_mat_sum,
+      &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+      ti->model_type, ti->od.active_object_num - object_count);
   }
-  #ifndef WIN32
-  pthread_exit(pointer);
-  #else
-  return 0;
-  #endif
+  pls(&(ti->od), ti->pc_num, ti->model_type);
+  result = pred_y_values(&(ti->od), ti,
+    ti->od.pc_num, ti->model_type, i / 2);
+  if (result) {
+    ti->cannot_write_temp_file = 1;
+  }
+  store_task_press(ti, i / 2);
 }
 
 
@@ -216,52 +362,15 @@ DWORD lto_cv_thread(void *pointer)
 #endif
 {
   int i;
-  int object_count;
-  int result;
   ThreadInfo *ti;
 
 
   ti = (ThreadInfo *)pointer;
-  for (i = (ti->start * 2); i <= (ti->end * 2); i += 2) {
-    /*
-    initialize the left-out objects vector before PLS
-    */
-    int_perm_resize(ti->od.pel.out_structs, 2);
-    ti->od.pel.out_structs->pe[0] =
-      ti->od.mel.struct_list[i];
-    ti->od.pel.out_structs->pe[1] =
-      ti->od.mel.struct_list[i + 1];
-    object_count = 2;
-    if (ti->model_type & UVEPLS_CV_MODEL) {
-      trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
-        ti->od.active_object_num - object_count, i / 2);
-      trim_mean_center_y_matrix_hp(&(ti->od),
-        ti->od.active_object_num - object_count, i / 2);
-    }
-    if (ti->model_type & SCRAMBLE_CV_MODEL) {
-      trim_mean_center_x_matrix_hp(&(ti->od), ti->model_type,
-        ti->od.active_object_num - object_count, i / 2);
-      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
-        &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
-        ti->model_type, ti->od.active_object_num - object_count);
-    }
-    else {
-      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_e_mat,
-        &(ti->od.mal.e_mat), &(ti->od.vel.e_mat_ave),
-        ti->model_type, ti->od.active_object_num - object_count);
-      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
-        &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
-        ti->model_type, ti->od.active_object_num - object_count);
-    }
-    pls(&(ti->od), ti->pc_num, ti->model_type);
-    result = pred_y_values(&(ti->od), ti,
-      ti->od.pc_num, ti->model_type, i / 2);
-    if (result) {
-      ti->cannot_write_temp_file = 1;
-    }
+  while ((i = get_next_task(ti)) != -1) {
+    lto_cv_task(ti, i);
   }
   #ifndef WIN32
-  pthread_exit(pointer);
+  return pointer;
   #else
   return 0;
   #endif
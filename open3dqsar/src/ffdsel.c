@@ -45,6 +45,32 @@ E-mail: paolo.tosco@unito.it
 #endif
 
 
+/*
+builds and validates the model for design row i, whose
+variables have already been picked by prepare_design_model();
+shared by local threads and by worker processes
+*/
+void ffdsel_task(ThreadInfo *ti, int i)
+{
+  if (ti->od.ffdsel.cv_type == EXTERNAL_PREDICTION) {
+    trim_mean_center_matrix(&(ti->od), ti->od.mal.large_e_mat, NULL,
+      &(ti->od.mal.e_mat), &(ti->od.vel.e_mat_ave),
+      FFDSEL_FULL_MODEL, ti->od.active_object_num);
+    trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat, NULL,
+      &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+      FFDSEL_FULL_MODEL, ti->od.active_object_num);
+    pls(&(ti->od), ti->pc_num, FFDSEL_FULL_MODEL);
+    pred_ext_y_values(&(ti->od), ti->pc_num, FFDSEL_FULL_MODEL);
+  }
+  else {
+    cv(&(ti->od), ti->pc_num, FFDSEL_CV_MODEL,
+      ti->od.ffdsel.cv_type, ti->od.ffdsel.groups, ti->od.ffdsel.runs);
+  }
+  double_vec_sort(ti->od.vel.ave_sdep, ti->od.pel.sdep_rank);
+  ti->od.vel.best_sdep->ve[i] = ti->od.vel.ave_sdep->ve[0];
+}
+
+
 #ifndef WIN32
 void *ffdsel_thread(void *pointer)
 #else
@@ -56,27 +82,12 @@ DWORD ffdsel_thread(void *pointer)
 
 
   ti = (ThreadInfo *)pointer;
-  for (i = ti->start; i <= ti->end; ++i) {
+  while ((i = get_next_task(ti)) != -1) {
     prepare_design_model(&(ti->od), i);
-    if (ti->od.ffdsel.cv_type == EXTERNAL_PREDICTION) {
-      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_e_mat,
-        &(ti->od.mal.e_mat), &(ti->od.vel.e_mat_ave),
-        FFDSEL_FULL_MODEL, ti->od.active_object_num);
-      trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
-        &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
-        FFDSEL_FULL_MODEL, ti->od.active_object_num);
-      pls(&(ti->od), ti->pc_num, FFDSEL_FULL_MODEL);
-      pred_ext_y_values(&(ti->od), ti->pc_num, FFDSEL_FULL_MODEL);
-    }
-    else {
-      cv(&(ti->od), ti->pc_num, FFDSEL_CV_MODEL,
-        ti->od.ffdsel.cv_type, ti->od.ffdsel.groups, ti->od.ffdsel.runs);
-    }
-    double_vec_sort(ti->od.vel.ave_sdep, ti->od.pel.sdep_rank);
-    ti->od.vel.best_sdep->ve[i] = ti->od.vel.ave_sdep->ve[0];
+    ffdsel_task(ti, i);
   }
   #ifndef WIN32
-  pthread_exit(pointer);
+  return pointer;
   #else
   return 0;
   #endif
@@ -188,6 +199,7 @@ int ffdsel(O3Data *od, int pc_num)
   int which;
   int status;
   int n_threads;
+  int dispatch;
   double ref_value;
   double df;
   double p;
@@ -195,9 +207,6 @@ int ffdsel(O3Data *od, int pc_num)
   double t;
   double bound;
   ThreadInfo **ti;
-  #ifndef WIN32
-  pthread_attr_t thread_attr;
-  #endif
   
   
   ti = od->mel.thread_info;
@@ -445,22 +454,39 @@ int ffdsel(O3Data *od, int pc_num)
     return OUT_OF_MEMORY;
   }
   /*
-  allocate structures which will be passed to each computational thread
+  if worker processes are connected, models are
+  sent to them by one local thread per worker
   */
-  alloc_threads(od);
-  #ifndef WIN32
+  accept_workers(od);
+  dispatch = use_workers(od, FFDSEL_CV_MODEL);
+  od->workers.dispatch = dispatch;
+  if (dispatch) {
+    result = pack_worker_job(od, od->ffdsel.ffdsel_included_vars,
+      FFDSEL_CV_MODEL, od->ffdsel.cv_type, pc_num, od->ffdsel.groups,
+      od->ffdsel.runs, od->ffdsel.design_y);
+    if (result) {
+      od->workers.dispatch = 0;
+      return result;
+    }
+  }
   /*
-  set pthread attributes
+  allocate structures which will be passed to each computational thread
   */
-  pthread_attr_init(&thread_attr);
-  pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
-  #endif
+  if (alloc_threads(od)) {
+    od->workers.dispatch = 0;
+    return OUT_OF_MEMORY;
+  }
   /*
   duplicate the main od structure for each ti structure
   also allocate a new array describing the SRD group/variable composition
   of each model for each thread
   */
   n_threads = fill_thread_info(od, od->ffdsel.design_y);
+  od->workers.dispatch = 0;
+  result = init_task_queue(od, ti, n_threads, od->ffdsel.design_y);
+  if (result) {
+    return result;
+  }
   for (i = 0; i < n_threads; ++i) {
     ti[i]->od.mel.ffdsel_included =
       malloc(od->ffdsel.ffdsel_included_vars);
@@ -471,22 +497,19 @@ int ffdsel(O3Data *od, int pc_num)
     it is not necessary to reallocate data structures for thread 0,
     since they are already allocated
     */
-    if (i) {
+    if (i && (!dispatch)) {
       init_cv_sdep(&(ti[i]->od));
       result = alloc_cv_sdep(&(ti[i]->od), pc_num, od->ffdsel.runs);
       if (result) {
         return OUT_OF_MEMORY;
       }
       /*
-      this function sets to NULL all data structures
-      which need to be reallocated
+      the PLS data structures left in the thread workspace
+      by the previous command are only grown when too small
       */
-      init_pls(&(ti[i]->od));
-      /*
-      this function allocates new data structures
-      */
-      ti[i]->od.mal.press =
-        double_mat_alloc(pc_num + 1, od->y_vars);
+      ti[i]->workspace->mal.press = double_mat_resize
+        (ti[i]->workspace->mal.press, pc_num + 1, od->y_vars);
+      ti[i]->od.mal.press = ti[i]->workspace->mal.press;
       if (!(ti[i]->od.mal.press)) {
         return OUT_OF_MEMORY;
       }
@@ -497,50 +520,30 @@ int ffdsel(O3Data *od, int pc_num)
       result = alloc_pls(&(ti[i]->od),
         od->ffdsel.ffdsel_included_vars,
         pc_num, FFDSEL_CV_MODEL);
+      copy_pls_workspace(ti[i]->workspace, &(ti[i]->od));
       if (result) {
         return OUT_OF_MEMORY;
       }
     }
     ti[i]->pc_num = pc_num;
-    /*
-    create the i-th thread
-    */
-    #ifndef WIN32
-    od->error_code = pthread_create(&(od->thread_id[i]), &thread_attr,
-      ffdsel_thread, (void *)ti[i]);
-    if (od->error_code) {
-      return CANNOT_CREATE_THREAD;
-    }
-    #else
-    od->hThreadArray[i] = CreateThread(NULL, 0,
-      (LPTHREAD_START_ROUTINE)ffdsel_thread,
-      ti[i], 0, &(od->dwThreadIdArray[i]));
-    if (!(od->hThreadArray[i])) {
-      return CANNOT_CREATE_THREAD;
-    }
-    #endif
   }
-  #ifndef WIN32
   /*
-  free the pthread attribute memory
+  hand the job over to the worker pool
+  and wait for all threads to have finished
   */
-  pthread_attr_destroy(&thread_attr);
-  /*
-  wait for all threads to have finished
-  */
-  for (i = 0; i < n_threads; ++i) {
-    od->error_code = pthread_join(od->thread_id[i],
-      &(od->thread_result[i]));
-    if (od->error_code) {
-      return CANNOT_JOIN_THREAD;
+  if (dispatch) {
+    result = run_thread_pool(od, (void *)worker_proxy_thread, n_threads);
+    if (!result) {
+      result = finish_worker_tasks(od, (void *)ffdsel_thread, n_threads);
     }
   }
-  #else
-  WaitForMultipleObjects(n_threads, od->hThreadArray, TRUE, INFINITE);
-  for (i = 0; i < n_threads; ++i) {
-    CloseHandle(od->hThreadArray[i]);
+  else {
+    result = run_thread_pool(od, (void *)ffdsel_thread, n_threads);
   }
-  #endif
+  if (result) {
+    return result;
+  }
+  close_task_queue(od, ti, n_threads);
   for (i = 0; i < n_threads; ++i) {
     /*
     free all duplicate structures
@@ -549,19 +552,14 @@ int ffdsel(O3Data *od, int pc_num)
       free(ti[i]->od.mel.ffdsel_included);
       ti[i]->od.mel.ffdsel_included = NULL;
     }
-    if (i) {
+    if (i && (!dispatch)) {
       free_cv_sdep(&(ti[i]->od));
-      if (ti[i]->od.mal.press) {
-        double_mat_free(ti[i]->od.mal.press);
-        ti[i]->od.mal.press = NULL;
-      }
-      free_pls(&(ti[i]->od));
+      copy_pls_workspace(ti[i]->workspace, &(ti[i]->od));
     }
   }
   if (od->ffdsel.cv_type == LEAVE_MANY_OUT) {
     free_cv_groups(od, od->ffdsel.runs);
   }
-  free_threads(od);
 
   /*
   if the user requested extensive printout of all SDEPs
@@ -769,6 +767,7 @@ int ffdsel(O3Data *od, int pc_num)
     double_mat_free(od->mal.large_e_mat_ave);
     od->mal.large_e_mat_ave = NULL;
   }
+  free_large_mat_sum(od);
   if (od->mal.large_f_mat_ave) {
     double_mat_free(od->mal.large_f_mat_ave);
     od->mal.large_f_mat_ave = NULL;
@@ -0,0 +1,102 @@
+/*
+
+fill_fold_rows.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+void fill_fold_rows(O3Data *od)
+{
+  int y;
+  int n;
+  int n_train;
+  int n_out;
+  int object_num;
+  int struct_num;
+  int conf_num;
+  int n_conf;
+  double weight;
+  
+  
+  /*
+  walk objects once for the current CV fold, recording
+  which rows of large_(e,f)_mat are used for training
+  (with their weights) and which are left out, so that
+  column loops need not go through mol_info again
+  */
+  n = 0;
+  n_train = 0;
+  n_out = 0;
+  object_num = 0;
+  y = 0;
+  while (object_num < od->object_num) {
+    struct_num = od->al.mol_info[object_num]->struct_num;
+    conf_num = 1;
+    if (n < od->pel.out_structs->size) {
+      if (struct_num == od->pel.out_structs->pe[n]) {
+        ++n;
+        for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num, ++y) {
+          if (get_object_attr(od, object_num, ACTIVE_BIT)) {
+            od->pel.fold_out_rows->pe[n_out] = y;
+            od->vel.fold_out_weight->ve[n_out] =
+              od->mel.object_weight[object_num];
+            ++n_out;
+          }
+        }
+        continue;
+      }
+    }
+    for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num) {
+      if (get_object_attr(od, object_num, ACTIVE_BIT)) {
+        weight = od->mel.object_weight[object_num];
+        od->pel.fold_train_rows->pe[n_train] = y;
+        od->vel.fold_train_weight->ve[n_train] = weight;
+        od->vel.fold_train_sqrt_weight->ve[n_train] = sqrt(weight);
+        ++n_train;
+        ++y;
+      }
+    }
+  }
+  int_perm_resize(od->pel.fold_train_rows, n_train);
+  double_vec_resize(od->vel.fold_train_weight, n_train);
+  double_vec_resize(od->vel.fold_train_sqrt_weight, n_train);
+  int_perm_resize(od->pel.fold_out_rows, n_out);
+  double_vec_resize(od->vel.fold_out_weight, n_out);
+}
@@ -65,6 +65,11 @@ int fill_x_matrix(O3Data *od, int model_type, int use_srd_groups)
   if (model_type & (FFDSEL_FULL_MODEL | FFDSEL_CV_MODEL
     | UVEPLS_FULL_MODEL | UVEPLS_CV_MODEL)) {
     x_max_x = od->mal.large_e_mat->n;
+    /*
+    the large-E matrix will not match the
+    cached PLS model any longer
+    */
+    ++(od->attr_generation);
   }
   else if (model_type & CV_MODEL) {
     x_max_x = od->overall_active_x_vars;
@@ -371,16 +376,14 @@ int fill_x_matrix_scrambled(O3Data *od)
   int struct_num;
   int conf_num;
   int n_conf;
-  int active_struct_num;
   int active_struct_count;
-  int actual_len;
   int found;
   int result;
   double value;
   double sumweight;
   
   
-  get_attr_struct_ave(od, 0, ACTIVE_BIT, &active_struct_num, NULL);
+  ++(od->attr_generation);
   x_max_x = od->overall_active_x_vars;
   y_max = od->active_object_num + od->ext_pred_object_num;
   /*
@@ -412,16 +415,11 @@ int fill_x_matrix_scrambled(O3Data *od)
   memset(od->vel.e_mat_full_ave->ve, 0,
     od->vel.e_mat_full_ave->size * sizeof(double));
   /*
-  read the permutation order of objects
-  when they are sorted according to decreasing
-  y value (average y value if there are multiple y's)
+  prepare_scrambling() stored in scrambling_order
+  the permutation order of objects when they are sorted
+  according to decreasing y value (average y value
+  if there are multiple y's)
   */
-  actual_len = fread(od->pel.scrambling_order->pe,
-    sizeof(int), active_struct_num,
-    od->file[TEMP_SCRAMBLE]->handle);
-  if (actual_len != active_struct_num) {
-    return CANNOT_READ_TEMP_FILE;
-  }
   /*
   copy values from active fields, objects, x_vars
   mean-center them and store them into a matrix
@@ -508,7 +506,7 @@ int fill_x_matrix_scrambled(O3Data *od)
 }
 
 
-int fill_y_matrix_scrambled(O3Data *od)
+int fill_y_matrix_scrambled(O3Data *od, int scramble_run)
 {
   int j;
   int k;
@@ -520,11 +518,11 @@ int fill_y_matrix_scrambled(O3Data *od)
   int n_conf;
   int active_struct_count;
   int y_max;
-  int actual_len;
   int found;
   double sumweight;
   
   
+  ++(od->attr_generation);
   y_max = od->active_object_num + od->ext_pred_object_num;
   /*
   allocate a y_max * od->y_vars large-F matrix
@@ -555,11 +553,7 @@ int fill_y_matrix_scrambled(O3Data *od)
   }
   memset(od->vel.f_mat_full_ave->ve, 0,
     od->vel.f_mat_full_ave->size * sizeof(double));
-  actual_len = fread(od->pel.scrambling_temp->pe, sizeof(int),
-    od->active_object_num, od->file[TEMP_SCRAMBLE]->handle);
-  if (actual_len != od->active_object_num) {
-    return CANNOT_READ_TEMP_FILE;
-  }
+  get_scrambling_order(od, scramble_run);
   /*
   copy values from active objects, y_vars
   and store them in the scrambled order in
@@ -637,6 +631,7 @@ int fill_x_matrix_pca(O3Data *od)
   double value;
   
   
+  ++(od->attr_generation);
   /*
   FULL_MODEL
   */
@@ -0,0 +1,79 @@
+/*
+
+float_mat.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+FloatMat *float_mat_resize(FloatMat *float_mat, int m, int n)
+{
+  if (!float_mat) {
+    float_mat = (FloatMat *)malloc(sizeof(FloatMat));
+    if (!float_mat) {
+      return NULL;
+    }
+    memset(float_mat, 0, sizeof(FloatMat));
+  }
+  if ((m > float_mat->max_m) || (n > float_mat->max_n)) {
+    float_mat->base = (float *)realloc(float_mat->base,
+      m * n * sizeof(float));
+    if (!(float_mat->base)) {
+      return NULL;
+    }
+    memset(float_mat->base, 0, m * n * sizeof(float));
+    float_mat->max_m = m;
+    float_mat->max_n = n;
+  }
+  float_mat->m = m;
+  float_mat->n = n;
+  
+  return float_mat;
+}
+
+
+void float_mat_free(FloatMat *float_mat)
+{
+  if (float_mat) {
+    if (float_mat->base) {
+      free(float_mat->base);
+    }
+    free(float_mat);
+  }
+}
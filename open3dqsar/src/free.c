@@ -108,6 +108,14 @@ void free_mem(O3Data *od)
   
   
   free_x_var_array(od);
+  free_model_cache(od);
+  free_gram_cache(od);
+  free_cv_pred(od);
+  free_sweep(od);
+  free_task_queue(od);
+  free_thread_pool(od);
+  close_workers(od);
+  free_threads(od);
   thread_od = od;
   for (n = od->n_proc - 1; n >= 0; --n) {
     if (n) {
@@ -179,8 +187,18 @@ void free_threads(O3Data *od)
   int i;
 
   
-  for (i = 0; i < od->n_proc; ++i) {
+  for (i = 0; i < MAX_THREADS; ++i) {
     if (od->mel.thread_info[i]) {
+      if (od->mel.thread_info[i]->workspace) {
+        free_pls(od->mel.thread_info[i]->workspace);
+        if (od->mel.thread_info[i]->workspace->mal.press) {
+          double_mat_free(od->mel.thread_info[i]->workspace->mal.press);
+        }
+        if (od->mel.thread_info[i]->workspace->mal.inner_press) {
+          double_mat_free(od->mel.thread_info[i]->workspace->mal.inner_press);
+        }
+        free(od->mel.thread_info[i]->workspace);
+      }
       free(od->mel.thread_info[i]);
       od->mel.thread_info[i] = NULL;
     }
@@ -262,6 +280,14 @@ void free_cv_groups(O3Data *od, int runs)
     free(od->mel.struct_per_group);
     od->mel.struct_per_group = NULL;
   }
+  if (od->mel.active_struct_list) {
+    free(od->mel.active_struct_list);
+    od->mel.active_struct_list = NULL;
+  }
+  if (od->mel.group_ready) {
+    free(od->mel.group_ready);
+    od->mel.group_ready = NULL;
+  }
   if (od->cimal.group_composition_list) {
     for (i = 0; i < runs; ++i) {
       if (od->cimal.group_composition_list[i]) {
@@ -317,6 +343,141 @@ void free_cv_sdep(O3Data *od)
 }
 
 
+void free_kernel_cv(O3Data *od)
+{
+  if (od->mal.kernel_gram) {
+    double_mat_free(od->mal.kernel_gram);
+    od->mal.kernel_gram = NULL;
+  }
+  od->cv.kernel_cv = 0;
+}
+
+
+void free_model_cache(O3Data *od)
+{
+  if (od->model.x_weights) {
+    free(od->model.x_weights);
+    od->model.x_weights = NULL;
+  }
+  if (od->model.x_loadings) {
+    free(od->model.x_loadings);
+    od->model.x_loadings = NULL;
+  }
+  if (od->model.y_loadings) {
+    free(od->model.y_loadings);
+    od->model.y_loadings = NULL;
+  }
+  if (od->model.x_scores) {
+    free(od->model.x_scores);
+    od->model.x_scores = NULL;
+  }
+  if (od->model.y_scores) {
+    free(od->model.y_scores);
+    od->model.y_scores = NULL;
+  }
+  if (od->model.b_coefficients) {
+    free(od->model.b_coefficients);
+    od->model.b_coefficients = NULL;
+  }
+  if (od->model.e_mat_ave) {
+    free(od->model.e_mat_ave);
+    od->model.e_mat_ave = NULL;
+  }
+  if (od->model.f_mat_ave) {
+    free(od->model.f_mat_ave);
+    od->model.f_mat_ave = NULL;
+  }
+  od->model.valid = 0;
+}
+
+
+void free_gram_cache(O3Data *od)
+{
+  if (od->gram.gram) {
+    double_mat_free(od->gram.gram);
+    od->gram.gram = NULL;
+  }
+  if (od->gram.shift) {
+    double_vec_free(od->gram.shift);
+    od->gram.shift = NULL;
+  }
+  if (od->gram.row_key) {
+    free(od->gram.row_key);
+    od->gram.row_key = NULL;
+  }
+  if (od->gram.var_list) {
+    free(od->gram.var_list);
+    od->gram.var_list = NULL;
+  }
+  od->gram.valid = 0;
+}
+
+
+void free_cv_pred(O3Data *od)
+{
+  if (od->cv_pred.block_len) {
+    free(od->cv_pred.block_len);
+    od->cv_pred.block_len = NULL;
+  }
+  if (od->cv_pred.block_pc) {
+    free(od->cv_pred.block_pc);
+    od->cv_pred.block_pc = NULL;
+  }
+  if (od->cv_pred.object_list) {
+    free(od->cv_pred.object_list);
+    od->cv_pred.object_list = NULL;
+  }
+  if (od->cv_pred.first_slot) {
+    free(od->cv_pred.first_slot);
+    od->cv_pred.first_slot = NULL;
+  }
+  if (od->cv_pred.next_slot) {
+    free(od->cv_pred.next_slot);
+    od->cv_pred.next_slot = NULL;
+  }
+  if (od->cv_pred.value) {
+    free(od->cv_pred.value);
+    od->cv_pred.value = NULL;
+  }
+  od->cv_pred.max_values = 0;
+  od->cv_pred.active = 0;
+}
+
+
+void free_task_queue(O3Data *od)
+{
+  if (od->queue.thread_num) {
+    free(od->queue.thread_num);
+    od->queue.thread_num = NULL;
+  }
+  if (od->queue.slot) {
+    free(od->queue.slot);
+    od->queue.slot = NULL;
+  }
+  if (od->queue.done) {
+    free(od->queue.done);
+    od->queue.done = NULL;
+  }
+  if (od->queue.requeued) {
+    free(od->queue.requeued);
+    od->queue.requeued = NULL;
+  }
+}
+
+
+void free_large_mat_sum(O3Data *od)
+{
+  if (od->mal.large_e_mat_sum) {
+    double_mat_free(od->mal.large_e_mat_sum);
+    od->mal.large_e_mat_sum = NULL;
+  }
+  if (od->mal.large_f_mat_sum) {
+    double_mat_free(od->mal.large_f_mat_sum);
+    od->mal.large_f_mat_sum = NULL;
+  }
+}
+
+
 void free_parallel_cv(O3Data *od, ThreadInfo **thread_info,
   int model_type, int cv_type, int runs)
 {
@@ -336,16 +497,6 @@ void free_parallel_cv(O3Data *od, ThreadInfo **thread_info,
       remove(thread_info[i]->temp_cv_coeff.name);
       thread_info[i]->temp_cv_coeff.name[0] = '\0';
     }
-    /*
-    free all duplicate structures
-    */
-    free_pls(&(thread_info[i]->od));
-    if (cv_type == LEAVE_MANY_OUT) {
-      if (thread_info[i]->od.mal.press) {
-        double_mat_free(thread_info[i]->od.mal.press);
-        thread_info[i]->od.mal.press = NULL;
-      }
-    }
   }
   if (cv_type == LEAVE_MANY_OUT) {
     free_cv_groups(od, runs);
@@ -360,7 +511,10 @@ void free_parallel_cv(O3Data *od, ThreadInfo **thread_info,
     thread_info[0]->temp_cv_coeff.handle = NULL;
     od->file[TEMP_CV_COEFF]->handle = NULL;
   }
-  free_threads(od);
+  /*
+  per-thread PLS workspaces are kept for the next parallel run
+  */
+  od->cv.n_threads = 0;
 }
 
 
@@ -398,10 +552,118 @@ void free_pls(O3Data *od)
     double_vec_free(od->vel.v_new);
     od->vel.v_new = NULL;
   }
+  if (od->mal.kernel_mat) {
+    double_mat_free(od->mal.kernel_mat);
+    od->mal.kernel_mat = NULL;
+  }
+  if (od->mal.kernel_u) {
+    double_mat_free(od->mal.kernel_u);
+    od->mal.kernel_u = NULL;
+  }
+  if (od->vel.kernel_t) {
+    double_vec_free(od->vel.kernel_t);
+    od->vel.kernel_t = NULL;
+  }
+  if (od->vel.kernel_w) {
+    double_vec_free(od->vel.kernel_w);
+    od->vel.kernel_w = NULL;
+  }
+  if (od->vel.kernel_g) {
+    double_vec_free(od->vel.kernel_g);
+    od->vel.kernel_g = NULL;
+  }
+  if (od->vel.deflation_coeff) {
+    double_vec_free(od->vel.deflation_coeff);
+    od->vel.deflation_coeff = NULL;
+  }
+  if (od->vel.implicit_work) {
+    double_vec_free(od->vel.implicit_work);
+    od->vel.implicit_work = NULL;
+  }
+  if (od->mal.e_mat_sp) {
+    float_mat_free(od->mal.e_mat_sp);
+    od->mal.e_mat_sp = NULL;
+  }
+  if (od->mal.f_mat_sp) {
+    float_mat_free(od->mal.f_mat_sp);
+    od->mal.f_mat_sp = NULL;
+  }
+  if (od->mal.pls_sp_work) {
+    float_mat_free(od->mal.pls_sp_work);
+    od->mal.pls_sp_work = NULL;
+  }
+  if (od->mal.pls1_u) {
+    double_mat_free(od->mal.pls1_u);
+    od->mal.pls1_u = NULL;
+  }
+  if (od->mal.pls1_w) {
+    double_mat_free(od->mal.pls1_w);
+    od->mal.pls1_w = NULL;
+  }
+  if (od->mal.pls1_t) {
+    double_mat_free(od->mal.pls1_t);
+    od->mal.pls1_t = NULL;
+  }
+  if (od->mal.pls1_dual) {
+    double_mat_free(od->mal.pls1_dual);
+    od->mal.pls1_dual = NULL;
+  }
+  if (od->mal.pls1_coeff) {
+    double_mat_free(od->mal.pls1_coeff);
+    od->mal.pls1_coeff = NULL;
+  }
+  if (od->vel.pls1_z) {
+    double_vec_free(od->vel.pls1_z);
+    od->vel.pls1_z = NULL;
+  }
+  if (od->mal.pls2_s) {
+    double_mat_free(od->mal.pls2_s);
+    od->mal.pls2_s = NULL;
+  }
+  if (od->mal.pls2_m) {
+    double_mat_free(od->mal.pls2_m);
+    od->mal.pls2_m = NULL;
+  }
+  if (od->mal.pls2_g) {
+    double_mat_free(od->mal.pls2_g);
+    od->mal.pls2_g = NULL;
+  }
+  if (od->mal.pls2_work) {
+    double_mat_free(od->mal.pls2_work);
+    od->mal.pls2_work = NULL;
+  }
+  if (od->vel.pls2_z) {
+    double_vec_free(od->vel.pls2_z);
+    od->vel.pls2_z = NULL;
+  }
+  if (od->pel.kernel_rows) {
+    int_perm_free(od->pel.kernel_rows);
+    od->pel.kernel_rows = NULL;
+  }
   if (od->vel.ro) {
     double_vec_free(od->vel.ro);
     od->vel.ro = NULL;
   }
+  if (od->vel.fold_train_weight) {
+    double_vec_free(od->vel.fold_train_weight);
+    od->vel.fold_train_weight = NULL;
+  }
+  if (od->vel.fold_train_sqrt_weight) {
+    double_vec_free(od->vel.fold_train_sqrt_weight);
+    od->vel.fold_train_sqrt_weight = NULL;
+  }
+  if (od->vel.fold_out_weight) {
+    double_vec_free(od->vel.fold_out_weight);
+    od->vel.fold_out_weight = NULL;
+  }
+  if (od->pel.fold_train_rows) {
+    int_perm_free(od->pel.fold_train_rows);
+    od->pel.fold_train_rows = NULL;
+  }
+  if (od->pel.fold_out_rows) {
+    int_perm_free(od->pel.fold_out_rows);
+    od->pel.fold_out_rows = NULL;
+  }
   if (od->vel.explained_s2_x) {
     double_vec_free(od->vel.explained_s2_x);
     od->vel.explained_s2_x = NULL;
@@ -465,7 +727,39 @@ void free_pls(O3Data *od)
   }
   #endif
   if (od->pel.out_structs) {
-    free(od->pel.out_structs);
+    int_perm_free(od->pel.out_structs);
     od->pel.out_structs = NULL;
   }
 }
+
+
+void free_sweep(O3Data *od)
+{
+  int i;
+  
+  
+  for (i = 0; i < SWEEP_STAGES; ++i) {
+    if (od->sweep.type[i]) {
+      free(od->sweep.type[i]);
+      od->sweep.type[i] = NULL;
+    }
+    if (od->sweep.level[i]) {
+      free(od->sweep.level[i]);
+      od->sweep.level[i] = NULL;
+    }
+    if (od->sweep.x_values[i]) {
+      free(od->sweep.x_values[i]);
+      od->sweep.x_values[i] = NULL;
+    }
+    if (od->sweep.x_data[i]) {
+      free(od->sweep.x_data[i]);
+      od->sweep.x_data[i] = NULL;
+    }
+    od->sweep.n_settings[i] = 0;
+    od->sweep.has_values[i] = 0;
+  }
+  if (od->sweep.journal_dirty) {
+    free(od->sweep.journal_dirty);
+    od->sweep.journal_dirty = NULL;
+  }
+}
@@ -0,0 +1,546 @@
+/*
+
+gram_cache.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+static uint64_t mix_key(uint64_t key, const void *data, size_t size)
+{
+  size_t i;
+  const unsigned char *byte = (const unsigned char *)data;
+  
+  
+  for (i = 0; i < size; ++i) {
+    key ^= (uint64_t)byte[i];
+    key *= GRAM_KEY_PRIME;
+  }
+  
+  return key;
+}
+
+
+static int compare_gram_rows(const void *a, const void *b)
+{
+  const GramRow *ra = (const GramRow *)a;
+  const GramRow *rb = (const GramRow *)b;
+  
+  
+  if (ra->key < rb->key) {
+    return -1;
+  }
+  if (ra->key > rb->key) {
+    return 1;
+  }
+  
+  return 0;
+}
+
+
+/*
+value of column c for the y-th active object: current
+variables are taken from the large-E matrix, variables
+which are no longer active are read from field storage
+as fill_x_matrix() would
+*/
+static int get_column_value(O3Data *od, GramColumns *col,
+  int c, int object_num, int y, double *value)
+{
+  int result;
+  
+  
+  if (col->pos[c] >= 0) {
+    *value = M_PEEK(od->mal.large_e_mat, y, col->pos[c]);
+    return 0;
+  }
+  result = get_x_value(od, col->field[c], object_num,
+    col->var[c], value, 0);
+  if ((!result) && (!MISSING(*value))) {
+    result = get_x_value(od, col->field[c], object_num,
+      col->var[c], value, CUTOFF_BIT | WEIGHT_BIT);
+  }
+  
+  return result;
+}
+
+
+/*
+out += sign * Z Z[fresh]' (or sign * ZZ' if fresh is NULL),
+where Z holds the shifted values of count columns starting
+from first (through list, if not NULL) for all active objects
+*/
+static int accumulate_gram(O3Data *od, GramColumns *col,
+  int *list, int first, int count, int *object,
+  int *fresh, int fresh_num, double sign, DoubleMat *out)
+{
+  int i;
+  int j;
+  int c;
+  int x;
+  int m;
+  int n_block;
+  int result = 0;
+  double value;
+  DoubleMat *z_mat;
+  DoubleMat *z_fresh = NULL;
+  
+  
+  m = od->active_object_num;
+  z_mat = double_mat_alloc(m, KERNEL_CV_BLOCK_SIZE);
+  if (fresh) {
+    z_fresh = double_mat_alloc(fresh_num, KERNEL_CV_BLOCK_SIZE);
+  }
+  if (!z_mat || (fresh && (!z_fresh))) {
+    result = OUT_OF_MEMORY;
+  }
+  for (x = 0; (!result) && (x < count); x += n_block) {
+    n_block = count - x;
+    if (n_block > KERNEL_CV_BLOCK_SIZE) {
+      n_block = KERNEL_CV_BLOCK_SIZE;
+    }
+    for (j = 0; (!result) && (j < n_block); ++j) {
+      c = (list ? list[first + x + j] : first + x + j);
+      for (i = 0; (!result) && (i < m); ++i) {
+        result = get_column_value(od, col, c, object[i], i, &value);
+        M_POKE(z_mat, i, j, value - col->shift[c]);
+      }
+      for (i = 0; fresh && (i < fresh_num); ++i) {
+        M_POKE(z_fresh, i, j, M_PEEK(z_mat, fresh[i], j));
+      }
+    }
+    if (!result) {
+      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+        m, (fresh ? fresh_num : m), n_block, sign,
+        z_mat->base, z_mat->max_m,
+        (fresh ? z_fresh->base : z_mat->base),
+        (fresh ? z_fresh->max_m : z_mat->max_m), 1.0,
+        out->base, out->max_m);
+    }
+  }
+  if (z_mat) {
+    double_mat_free(z_mat);
+  }
+  if (z_fresh) {
+    double_mat_free(z_fresh);
+  }
+  
+  return result;
+}
+
+
+/*
+the Gram matrix G = ZZ' of the active objects, where z = x - shift,
+is kept across commands together with the list of variables it was
+computed on and a key for each of its rows, obtained from the values
+of that object on those variables (weights and cutoffs included).
+When it is updated:
+1) objects whose key is found reuse their cached entries, so that only
+   the rows of appended or modified objects are computed, at a cost of
+   O(kmn) rather than O(m^2n) for k new objects; rows of removed objects
+   are simply dropped
+2) variables which are no longer active are downdated from G and newly
+   active ones are added, at a cost of O(m^2) per variable; the shift
+   of a new variable is its plain average over the current objects
+Rows of the updated G follow the active objects as they are laid out
+in the large-E matrix. The cache is not used if missing values are
+present, for the same reason as in prepare_kernel_cv(); it is rebuilt
+from scratch if a variable to be downdated has missing values
+*/
+static int refresh_gram(O3Data *od, GramColumns *col, int n_old,
+  int *object, int *new_list, int *dropped, int *fresh,
+  uint64_t *row_key, int *old_row, GramRow *sorted, DoubleMat *gram)
+{
+  int i;
+  int j;
+  int a;
+  int b;
+  int m;
+  int n;
+  int n_added;
+  int n_dropped;
+  int fresh_num;
+  int old_rows;
+  int result;
+  double value;
+  DoubleMat *cross;
+  DoubleVec *shift;
+  GramRow probe;
+  GramRow *found;
+  
+  
+  m = od->active_object_num;
+  n = od->mal.large_e_mat->n;
+  for (i = 0, j = 0; i < od->object_num; ++i) {
+    if (get_object_attr(od, i, ACTIVE_BIT)) {
+      object[j] = i;
+      ++j;
+    }
+  }
+  for (i = 0, b = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, ACTIVE_BIT)) {
+      continue;
+    }
+    for (j = 0; j < od->x_vars; ++j) {
+      if (get_x_var_attr(od, i, j, ACTIVE_BIT)) {
+        new_list[b * 2] = i;
+        new_list[b * 2 + 1] = j;
+        ++b;
+      }
+    }
+  }
+  /*
+  both variable lists are sorted by field and variable:
+  cached variables come first in the column table,
+  followed by newly active ones
+  */
+  a = 0;
+  b = 0;
+  n_added = 0;
+  n_dropped = 0;
+  while ((a < n_old) || (b < n)) {
+    if ((a < n_old) && (b < n)
+      && (od->gram.var_list[a * 2] == new_list[b * 2])
+      && (od->gram.var_list[a * 2 + 1] == new_list[b * 2 + 1])) {
+      col->field[a] = od->gram.var_list[a * 2];
+      col->var[a] = od->gram.var_list[a * 2 + 1];
+      col->pos[a] = b;
+      col->shift[a] = od->gram.shift->ve[a];
+      ++a;
+      ++b;
+    }
+    else if ((a < n_old) && ((b == n)
+      || (od->gram.var_list[a * 2] < new_list[b * 2])
+      || ((od->gram.var_list[a * 2] == new_list[b * 2])
+      && (od->gram.var_list[a * 2 + 1] < new_list[b * 2 + 1])))) {
+      col->field[a] = od->gram.var_list[a * 2];
+      col->var[a] = od->gram.var_list[a * 2 + 1];
+      col->pos[a] = -1;
+      col->shift[a] = od->gram.shift->ve[a];
+      dropped[n_dropped] = a;
+      ++n_dropped;
+      ++a;
+    }
+    else {
+      col->field[n_old + n_added] = new_list[b * 2];
+      col->var[n_old + n_added] = new_list[b * 2 + 1];
+      col->pos[n_old + n_added] = b;
+      for (i = 0, value = 0.0; i < m; ++i) {
+        value += M_PEEK(od->mal.large_e_mat, i, b);
+      }
+      col->shift[n_old + n_added] = (m ? value / (double)m : 0.0);
+      ++n_added;
+      ++b;
+    }
+  }
+  /*
+  match current objects against cached rows
+  on the cached variables
+  */
+  old_rows = (n_old ? od->gram.gram->m : 0);
+  for (i = 0; i < old_rows; ++i) {
+    sorted[i].key = od->gram.row_key[i];
+    sorted[i].row = i;
+  }
+  qsort(sorted, old_rows, sizeof(GramRow), compare_gram_rows);
+  fresh_num = 0;
+  for (i = 0; i < m; ++i) {
+    probe.key = GRAM_KEY_SEED;
+    for (a = 0; a < n_old; ++a) {
+      result = get_column_value(od, col, a, object[i], i, &value);
+      if (result) {
+        return result;
+      }
+      if (MISSING(value)) {
+        return NOT_ENOUGH_OBJECTS;
+      }
+      probe.key = mix_key(probe.key, &value, sizeof(double));
+    }
+    found = (old_rows ? (GramRow *)bsearch(&probe, sorted, old_rows,
+      sizeof(GramRow), compare_gram_rows) : NULL);
+    old_row[i] = (found ? found->row : -1);
+    if (!found) {
+      fresh[fresh_num] = i;
+      ++fresh_num;
+    }
+  }
+  for (j = 0; j < m; ++j) {
+    for (i = 0; (old_row[j] != -1) && (i < m); ++i) {
+      if (old_row[i] != -1) {
+        M_POKE(gram, i, j, M_PEEK(od->gram.gram, old_row[i], old_row[j]));
+      }
+    }
+  }
+  if (fresh_num && n_old) {
+    cross = double_mat_alloc(m, fresh_num);
+    if (!cross) {
+      return OUT_OF_MEMORY;
+    }
+    result = accumulate_gram(od, col, NULL, 0, n_old, object,
+      fresh, fresh_num, 1.0, cross);
+    for (j = 0; (!result) && (j < fresh_num); ++j) {
+      for (i = 0; i < m; ++i) {
+        M_POKE(gram, i, fresh[j], M_PEEK(cross, i, j));
+        M_POKE(gram, fresh[j], i, M_PEEK(cross, i, j));
+      }
+    }
+    double_mat_free(cross);
+    if (result) {
+      return result;
+    }
+  }
+  if (n_dropped) {
+    result = accumulate_gram(od, col, dropped, 0, n_dropped, object,
+      NULL, 0, -1.0, gram);
+    if (result) {
+      return result;
+    }
+  }
+  if (n_added) {
+    result = accumulate_gram(od, col, NULL, n_old, n_added, object,
+      NULL, 0, 1.0, gram);
+    if (result) {
+      return result;
+    }
+  }
+  /*
+  store the updated G, keyed on the current variables
+  */
+  shift = double_vec_alloc(n ? n : 1);
+  if (!shift) {
+    return OUT_OF_MEMORY;
+  }
+  for (a = 0; a < n_old + n_added; ++a) {
+    if (col->pos[a] >= 0) {
+      shift->ve[col->pos[a]] = col->shift[a];
+    }
+  }
+  for (i = 0; i < m; ++i) {
+    row_key[i] = GRAM_KEY_SEED;
+    for (b = 0; b < n; ++b) {
+      row_key[i] = mix_key(row_key[i],
+        &M_PEEK(od->mal.large_e_mat, i, b), sizeof(double));
+    }
+  }
+  if (od->gram.shift) {
+    double_vec_free(od->gram.shift);
+  }
+  od->gram.shift = shift;
+  od->gram.reused = m - fresh_num;
+  od->gram.computed = fresh_num;
+  od->gram.added_vars = (n_old ? n_added : 0);
+  od->gram.removed_vars = n_dropped;
+  
+  return 0;
+}
+
+
+int update_gram_cache(O3Data *od)
+{
+  int i;
+  int m;
+  int n;
+  int n_old;
+  int result;
+  int *object;
+  int *new_list;
+  int *dropped;
+  int *fresh;
+  int *old_row;
+  uint64_t *row_key;
+  GramRow *sorted;
+  GramColumns col;
+  DoubleMat *gram;
+  
+  
+  m = od->active_object_num;
+  n = od->mal.large_e_mat->n;
+  for (i = 0; i < m * n; ++i) {
+    if (MISSING(M_PEEK(od->mal.large_e_mat, i % m, i / m))) {
+      od->gram.valid = 0;
+      return 0;
+    }
+  }
+  n_old = (od->gram.valid ? od->gram.x_vars : 0);
+  object = alloc_int_array(NULL, m + 1);
+  new_list = alloc_int_array(NULL, n * 2 + 1);
+  dropped = alloc_int_array(NULL, n_old + 1);
+  fresh = alloc_int_array(NULL, m + 1);
+  old_row = alloc_int_array(NULL, m + 1);
+  row_key = (uint64_t *)malloc((m + 1) * sizeof(uint64_t));
+  sorted = (GramRow *)malloc(((n_old ? od->gram.gram->m : 0) + 1)
+    * sizeof(GramRow));
+  col.field = alloc_int_array(NULL, n_old + n + 1);
+  col.var = alloc_int_array(NULL, n_old + n + 1);
+  col.pos = alloc_int_array(NULL, n_old + n + 1);
+  col.shift = (double *)malloc((n_old + n + 1) * sizeof(double));
+  gram = double_mat_alloc(m, m);
+  result = OUT_OF_MEMORY;
+  if (object && new_list && dropped && fresh && old_row && row_key
+    && sorted && col.field && col.var && col.pos && col.shift && gram) {
+    result = refresh_gram(od, &col, n_old, object, new_list,
+      dropped, fresh, row_key, old_row, sorted, gram);
+  }
+  if (!result) {
+    if (od->gram.gram) {
+      double_mat_free(od->gram.gram);
+    }
+    if (od->gram.row_key) {
+      free(od->gram.row_key);
+    }
+    if (od->gram.var_list) {
+      free(od->gram.var_list);
+    }
+    od->gram.gram = gram;
+    od->gram.row_key = row_key;
+    od->gram.var_list = new_list;
+    od->gram.x_vars = n;
+    od->gram.valid = 1;
+    gram = NULL;
+    row_key = NULL;
+    new_list = NULL;
+  }
+  if (object) {
+    free(object);
+  }
+  if (new_list) {
+    free(new_list);
+  }
+  if (dropped) {
+    free(dropped);
+  }
+  if (fresh) {
+    free(fresh);
+  }
+  if (old_row) {
+    free(old_row);
+  }
+  if (row_key) {
+    free(row_key);
+  }
+  if (sorted) {
+    free(sorted);
+  }
+  if (col.field) {
+    free(col.field);
+  }
+  if (col.var) {
+    free(col.var);
+  }
+  if (col.pos) {
+    free(col.pos);
+  }
+  if (col.shift) {
+    free(col.shift);
+  }
+  if (gram) {
+    double_mat_free(gram);
+  }
+  if (result == NOT_ENOUGH_OBJECTS) {
+    /*
+    a variable to be downdated has missing values:
+    start again from scratch
+    */
+    od->gram.valid = 0;
+    return update_gram_cache(od);
+  }
+  
+  return result;
+}
+
+
+/*
+K = W^(1/2) (G - g1' - 1g' + c) W^(1/2) for all active
+objects, with g = Gw / sum(w) and c = w'g / sum(w)
+(see kernel_cv.c)
+*/
+void gram_cache_kernel(O3Data *od, DoubleMat *k_mat)
+{
+  int i;
+  int j;
+  int y;
+  int object_num;
+  double c;
+  double sumweight = 0.0;
+  DoubleMat *gram;
+  DoubleVec *w;
+  DoubleVec *g;
+  
+  
+  gram = od->gram.gram;
+  w = od->vel.kernel_w;
+  g = od->vel.kernel_g;
+  for (object_num = 0, y = 0; object_num < od->object_num; ++object_num) {
+    if (get_object_attr(od, object_num, ACTIVE_BIT)) {
+      w->ve[y] = od->mel.object_weight[object_num];
+      sumweight += w->ve[y];
+      ++y;
+    }
+  }
+  cblas_dgemv(CblasColMajor, CblasNoTrans,
+    gram->m, gram->n,
+    ((sumweight > 0.0) ? 1.0 / sumweight : 0.0),
+    gram->base, gram->max_m,
+    w->ve, 1, 0.0, g->ve, 1);
+  c = ((sumweight > 0.0)
+    ? cblas_ddot(gram->m, w->ve, 1, g->ve, 1) / sumweight : 0.0);
+  for (j = 0; j < gram->n; ++j) {
+    for (i = 0; i < gram->m; ++i) {
+      M_POKE(k_mat, i, j, (M_PEEK(gram, i, j)
+        - g->ve[i] - g->ve[j] + c) * sqrt(w->ve[i] * w->ve[j]));
+    }
+  }
+}
+
+
+void print_gram_cache_update(O3Data *od)
+{
+  if (od->gram.valid) {
+    tee_printf(od, "Incremental update: %d Gram matrix rows were "
+      "reused, %d were computed; %d variables were added, "
+      "%d were removed.\n\n",
+      od->gram.reused, od->gram.computed,
+      od->gram.added_vars, od->gram.removed_vars);
+  }
+  else {
+    tee_printf(od, "Incremental update is not possible since missing "
+      "values are present; the kernel matrix is computed from scratch.\n\n");
+  }
+  tee_flush(od);
+}
@@ -0,0 +1,98 @@
+/*
+
+implicit_cv.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+/*
+implicit-deflation CV engine: NIPALS with implicit deflation
+never writes E, so CV folds can work directly on the shared,
+read-only large_e_mat rather than on a per-thread centered
+copy. The training rows of the fold are listed by
+fill_fold_rows() and the column averages a are downdated
+by calc_fold_column_ave(); since E = W^(1/2)(X[S] - 1a'),
+products with E are computed as
+E'v = X[S]'W^(1/2)v - a(1'W^(1/2)v)
+Ec = W^(1/2)(X[S]c - 1(a'c))
+(see mult_e_mat() in pls.c). Missing values are zeroed
+after centering, which does not commute with the mean
+shift: in this case the regular CV engine is used
+*/
+void prepare_implicit_cv(O3Data *od)
+{
+  int x;
+  
+  
+  od->cv.implicit_cv = 0;
+  if ((od->pls_algorithm != IMPLICIT_PLS)
+    || (od->pls_precision != PLS_DOUBLE_PRECISION)
+    || (od->pls_y_mode != PLS2_Y_MODE)
+    || (!(od->mal.large_e_mat_sum))) {
+    return;
+  }
+  for (x = 0; x < od->mal.large_e_mat->n; ++x) {
+    if (M_PEEK(od->mal.large_e_mat_sum, 2, x)
+      < ((double)(od->active_object_num) - 0.5)) {
+      return;
+    }
+  }
+  od->cv.implicit_cv = 1;
+}
+
+
+void implicit_cv_fold(O3Data *od)
+{
+  int x;
+  
+  
+  fill_fold_rows(od);
+  double_vec_resize(od->vel.e_mat_ave, od->mal.large_e_mat->n);
+  for (x = 0; x < od->mal.large_e_mat->n; ++x) {
+    od->vel.e_mat_ave->ve[x] = calc_fold_column_ave
+      (od, od->mal.large_e_mat, od->mal.large_e_mat_sum, x);
+  }
+  /*
+  E only holds the left-out rows which are filled in
+  by pred_y_values(); it is grown here if needed
+  */
+  od->mal.e_mat = double_mat_resize(od->mal.e_mat,
+    od->pel.fold_out_rows->size, od->mal.large_e_mat->n);
+}
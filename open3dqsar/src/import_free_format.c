@@ -119,79 +119,33 @@ int find_vary_speed(O3Data *od, char *name_list, int **max_vary, int **vary,
 }
 
 
-int get_double_from_ascii_file(FILE *handle, char *read_buffer, int read_buffer_size,
-  char **context, char **ptr, int *back, double *value)
-{
-  int actual_len = 0;
-  int loop = 1;
-  
-  
-  while (loop) {
-    if (!(*context)) {
-      if (*back) {
-        memmove(read_buffer, &read_buffer[read_buffer_size - 1 - (*back)], *back);
-      }
-      if (!(actual_len = fzread(&read_buffer[*back], 1,
-        read_buffer_size - 1 - (*back), (fzPtr *)handle))) {
-        return EOF_FOUND;
-      }
-      if (actual_len == (read_buffer_size - 1 - (*back))) {
-        *back = 0;
-        actual_len = read_buffer_size - 2;
-        while (actual_len && read_buffer[actual_len]
-          && (!strchr("\t ,;\r\n", (int)read_buffer[actual_len]))) {
-          --actual_len;
-          ++(*back);
-        }
-        read_buffer[actual_len] = '\0';
-      }
-      else {
-        read_buffer[actual_len + (*back)] = '\0';
-      }
-      *ptr = strtok_r(read_buffer, "\t ,;\r\n", context);
-    }
-    else {
-      *ptr = strtok_r(NULL, "\t ,;\r\n", context);
-    }
-    if (*ptr) {
-      sscanf(*ptr, "%lf", value);
-      loop = 0;
-    }
-    else {
-      *context = NULL;
-    }
-  }
-  
-  return 0;
-}
-
-
 int import_free_format(O3Data *od, char *name_list, int skip_header, int *n_values)
 {
-  char buffer[LARGE_BUF_LEN];
-  char *context = NULL;
   char *ptr = NULL;
   int i;
   int num_fields;
   int field_num = 0;
   int object_num = 0;
   int result = 0;
-  int back = 0;
   int *vary[MAX_FREE_FORMAT_PARAMETERS + 1];
   int *max_vary[MAX_FREE_FORMAT_PARAMETERS + 1];
   double value;
   VarCoord varcoord;
+  AsciiReader *ar;
   
   
-  memset(buffer, 0, LARGE_BUF_LEN);
   memset(&varcoord, 0, sizeof(VarCoord));
   memset(vary, 0, (MAX_FREE_FORMAT_PARAMETERS + 1) * sizeof(int));
   memset(max_vary, 0, (MAX_FREE_FORMAT_PARAMETERS + 1) * sizeof(int));
   *n_values = 0;
+  ar = open_ascii_reader(NULL, (fzPtr *)(od->file[ASCII_IN]->handle));
+  if (!ar) {
+    O3_ERROR_LOCATE(&(od->task));
+    return OUT_OF_MEMORY;
+  }
   i = skip_header;
   while (!result) {
-    if (!(result = get_double_from_ascii_file(od->file[ASCII_IN]->handle,
-      buffer, LARGE_BUF_LEN, &context, &ptr, &back, &value))) {
+    if (!(result = ascii_reader_get_token(ar, &ptr))) {
       if (i) {
         --i;
       }
@@ -200,6 +154,7 @@ int import_free_format(O3Data *od, char *name_list, int skip_header, int *n_valu
       }
     }
   }
+  close_ascii_reader(ar);
   if (result != EOF_FOUND) {
     O3_ERROR_LOCATE(&(od->task));
     O3_ERROR_STRING(&(od->task), od->file[ASCII_IN]->name);
@@ -217,20 +172,23 @@ int import_free_format(O3Data *od, char *name_list, int skip_header, int *n_valu
   }
   num_fields = *n_values / (od->object_num * od->x_vars);
   fzrewind((fzPtr *)(od->file[ASCII_IN]->handle));
-  ptr = NULL;
-  context = NULL;
   result = alloc_x_var_array(od, num_fields);
   if (result) {
     O3_ERROR_LOCATE(&(od->task));
     return result;
   }
+  ar = open_ascii_reader(NULL, (fzPtr *)(od->file[ASCII_IN]->handle));
+  if (!ar) {
+    O3_ERROR_LOCATE(&(od->task));
+    return OUT_OF_MEMORY;
+  }
   find_vary_speed(od, name_list, max_vary, vary, &field_num, &object_num, &varcoord);
   result = 0;
   i = skip_header;
   while (i) {
-    result = get_double_from_ascii_file(od->file[ASCII_IN]->handle,
-      buffer, LARGE_BUF_LEN, &context, &ptr, &back, &value);
+    result = ascii_reader_get_token(ar, &ptr);
     if (result) {
+      close_ascii_reader(ar);
       return result;
     }
     --i;
@@ -240,8 +198,7 @@ int import_free_format(O3Data *od, char *name_list, int skip_header, int *n_valu
       for (*vary[2] = 0; (!result) && (*vary[2] < *max_vary[2]); ++(*vary[2])) {
         for (*vary[1] = 0; (!result) && (*vary[1] < *max_vary[1]); ++(*vary[1])) {
           for (*vary[0] = 0; (!result) && (*vary[0] < *max_vary[0]); ++(*vary[0])) {
-            result = get_double_from_ascii_file(od->file[ASCII_IN]->handle,
-              buffer, LARGE_BUF_LEN, &context, &ptr, &back, &value);
+            result = ascii_reader_get_double(ar, &value);
             if (!result) {
               result = set_x_value_xyz_unbuffered
                 (od, field_num, object_num, &varcoord, value);
@@ -251,6 +208,7 @@ int import_free_format(O3Data *od, char *name_list, int skip_header, int *n_valu
       }
     }
   }
+  close_ascii_reader(ar);
   if (od->save_ram) {
     sync_field_mmap(od);
   }
@@ -44,6 +44,7 @@ E-mail: paolo.tosco@unito.it
 
 double parse_grid_ascii_line(char *line, char *parsed_line, VarCoord *varcoord)
 {
+  char *ptr;
   int i = 0;
   int j = 0;
   double value;
@@ -57,116 +58,250 @@ double parse_grid_ascii_line(char *line, char *parsed_line, VarCoord *varcoord)
     ++i;
   }
   parsed_line[j] = '\0';
-  sscanf(parsed_line, "%lf %lf %lf %lf", &(varcoord->cart[0]),
-    &(varcoord->cart[1]), &(varcoord->cart[2]), &value);
+  ptr = parsed_line;
+  for (i = 0; i < 3; ++i) {
+    varcoord->cart[i] = fast_strtod(ptr, &ptr);
+  }
+  value = fast_strtod(ptr, &ptr);
     
   return value;
 }
 
 
-int import_grid_ascii(O3Data *od, char *regex_name)
+static int read_grid_ascii_geometry(O3Data *od, AsciiReader *ar)
+{
+  char line[BUF_LEN];
+  char parsed_line[BUF_LEN];
+  int i;
+  int n_lines = 0;
+  double delta;
+  double step;
+  double prev_coord[3];
+  double min_coord[3];
+  double max_coord[3];
+  double min_step[3];
+  VarCoord varcoord;
+  
+  
+  /*
+  deduce the grid geometry from data point coordinates:
+  the grid spacing along each axis is the smallest
+  non-zero coordinate change between consecutive points
+  */
+  memset(&(od->newgrid), 0, sizeof(GridInfo));
+  memset(min_step, 0, 3 * sizeof(double));
+  while (ascii_reader_gets(line, BUF_LEN, ar)) {
+    line[BUF_LEN - 1] = '\0';
+    parse_grid_ascii_line(line, parsed_line, &varcoord);
+    for (i = 0; i < 3; ++i) {
+      if (!n_lines) {
+        min_coord[i] = varcoord.cart[i];
+        max_coord[i] = varcoord.cart[i];
+      }
+      else {
+        if (varcoord.cart[i] < min_coord[i]) {
+          min_coord[i] = varcoord.cart[i];
+        }
+        if (varcoord.cart[i] > max_coord[i]) {
+          max_coord[i] = varcoord.cart[i];
+        }
+        delta = fabs(varcoord.cart[i] - prev_coord[i]);
+        if ((delta > 1.0e-03) && ((min_step[i] == 0.0) || (delta < min_step[i]))) {
+          min_step[i] = delta;
+        }
+      }
+      prev_coord[i] = varcoord.cart[i];
+    }
+    ++n_lines;
+  }
+  if (!n_lines) {
+    return CANNOT_READ_GRID_DATA;
+  }
+  od->newgrid.x_vars = 1;
+  for (i = 0; i < 3; ++i) {
+    step = ((min_step[i] > 0.0) ? min_step[i] : (double)(od->grid.step[i]));
+    od->newgrid.step[i] = (float)(safe_rint(step * 1.0e04) / 1.0e04);
+    od->newgrid.start_coord[i] = (float)(safe_rint(min_coord[i] * 1.0e04) / 1.0e04);
+    od->newgrid.nodes[i] = (int)safe_rint((max_coord[i] - min_coord[i]) / step) + 1;
+    od->newgrid.end_coord[i] = (float)(safe_rint(((double)(od->newgrid.start_coord[i])
+      + (double)(od->newgrid.nodes[i] - 1) * step) * 1.0e04) / 1.0e04);
+    od->newgrid.x_vars *= od->newgrid.nodes[i];
+  }
+  if (od->newgrid.x_vars != n_lines) {
+    od->newgrid.x_vars = n_lines;
+    return GRID_NOT_MATCHING;
+  }
+  
+  return 0;
+}
+
+
+static int read_grid_ascii(O3Data *od, AsciiReader *ar,
+  int object_num, int initial_field_num, float *src_value)
 {
   char line[BUF_LEN];
   char parsed_line[BUF_LEN];
   int i;
   int n_grid_x_vars;
-  int object_num;
+  int x_vars;
   int result;
   double value;
   double node;
   VarCoord varcoord;
-  FileDescriptor inp_fd;
-    
 
-  memset(&inp_fd, 0, sizeof(FileDescriptor));
+
   /*
-  allocate one more field
+  if data are being resampled, data points
+  are checked against the grid defined in the file
   */
-  result = alloc_x_var_array(od, 1);
-  if (result) {
-    return result;
+  x_vars = od->newgrid.x_vars;
+  if (!src_value) {
+    memcpy(&(od->newgrid), &(od->grid), sizeof(GridInfo));
+    x_vars = od->x_vars;
   }
-  /*
-  first, check out that all files contain od->x_vars lines
-  */
-  for (object_num = 0; object_num < od->object_num; ++object_num) {
-    sprintf(inp_fd.name, regex_name, object_num + 1);
-    inp_fd.handle = fopen(inp_fd.name, "rb");
-    if (!(inp_fd.handle)) {
-      return NOT_ENOUGH_OBJECTS;
+  for (n_grid_x_vars = 0; n_grid_x_vars < x_vars; ++n_grid_x_vars) {
+    /*
+    read data points one by one from the object file
+    */
+    if (!ascii_reader_gets(line, BUF_LEN, ar)) {
+      od->newgrid.x_vars = n_grid_x_vars;
+      od->newgrid.object_num = object_num;
+      return CANNOT_READ_GRID_DATA;
     }
-    memcpy(&(od->newgrid), &(od->grid), sizeof(GridInfo));
-    n_grid_x_vars = 0;
-    while (fgets(line, BUF_LEN, inp_fd.handle)) {
-      ++n_grid_x_vars;
+    line[BUF_LEN - 1] = '\0';
+    value = parse_grid_ascii_line(line, parsed_line, &varcoord);
+    result = 0;
+    for (i = 0; i < 3; ++i) {
+      if (((safe_rint(varcoord.cart[i] * 1.0e03) / 1.0e03)
+        < (safe_rint((double)(od->newgrid.start_coord[i]) * 1.0e03) / 1.0e03))
+        || ((safe_rint(varcoord.cart[i] * 1.0e03) / 1.0e03)
+        > (safe_rint((double)(od->newgrid.end_coord[i]) * 1.0e03) / 1.0e03))) {
+        od->newgrid.object_num = object_num;
+        result = GRID_NOT_MATCHING_OUT_OF_BOUNDS;
+      }
+      node = (varcoord.cart[i] - (double)(od->newgrid.start_coord[i]))
+        / (double)(od->newgrid.step[i]);
+      if ((node - safe_rint(node)) > 1.0e-03) {
+        od->newgrid.object_num = object_num;
+        result = GRID_NOT_MATCHING_OFF_CENTER;
+      }
+      if (result) {
+        od->newgrid.start_coord[i] = (float)(varcoord.cart[i]);
+        od->newgrid.x_vars = n_grid_x_vars + 1;
+      }
+      varcoord.node[i] = (int)safe_rint(node);
+    }
+    if (result) {
+      return result;
+    }
+    /*
+    if the current value is a MISSING value,
+    then replace it with MISSING_VALUE
+    */
+    result = set_imported_x_value(od, src_value, initial_field_num,
+      initial_field_num, object_num, &varcoord,
+      (strstr(line, COMFA_MISSING_VALUE) ? MISSING_VALUE : value));
+    if (result) {
+      return result;
+    }
+  }
+  
+  return 0;
+}
+
+
+int import_grid_ascii(O3Data *od, TaskInfo *task,
+  int object_num, int initial_field_num)
+{
+  int n_grid_x_vars;
+  int result;
+  float *src_value = NULL;
+  FILE *grid_in;
+  AsciiReader *ar;
+    
+
+  grid_in = fopen(task->string, "rb");
+  if (!grid_in) {
+    return NOT_ENOUGH_OBJECTS;
+  }
+  ar = open_ascii_reader(grid_in, NULL);
+  if (!ar) {
+    fclose(grid_in);
+    return OUT_OF_MEMORY;
+  }
+  if (task->data[DATA_INTERPOLATE]) {
+    /*
+    if the grid defined in the file does not match
+    od->grid, data are collected and then resampled
+    */
+    result = read_grid_ascii_geometry(od, ar);
+    if ((!result) && (!match_grids(od))) {
+      src_value = alloc_resample_buffer(od, object_num,
+        initial_field_num, 1);
+      if (!src_value) {
+        result = OUT_OF_MEMORY;
+      }
+    }
+    if (result) {
+      close_ascii_reader(ar);
+      fclose(grid_in);
+      od->newgrid.object_num = object_num;
+      return result;
+    }
+    if (!src_value) {
+      close_ascii_reader(ar);
+      rewind(grid_in);
+      ar = open_ascii_reader(grid_in, NULL);
+      if (!ar) {
+        fclose(grid_in);
+        return OUT_OF_MEMORY;
+      }
     }
+  }
+  if (!src_value) {
+    /*
+    first, check out that the file contains od->x_vars lines
+    */
+    n_grid_x_vars = ascii_reader_count_lines(ar);
     if (n_grid_x_vars != od->x_vars) {
+      close_ascii_reader(ar);
+      fclose(grid_in);
+      memcpy(&(od->newgrid), &(od->grid), sizeof(GridInfo));
       od->newgrid.x_vars = n_grid_x_vars;
       od->newgrid.object_num = object_num;
       return GRID_NOT_MATCHING;
     }
-    fclose(inp_fd.handle);
   }
-  for (object_num = 0; object_num < od->object_num; ++object_num) {
-    sprintf(inp_fd.name, regex_name, object_num + 1);
-    inp_fd.handle = fopen(inp_fd.name, "rb");
-    if (!(inp_fd.handle)) {
-      return NOT_ENOUGH_OBJECTS;
-    }
-    for (n_grid_x_vars = 0; n_grid_x_vars < od->x_vars; ++n_grid_x_vars) {
-      /*
-      read data points one by one from each object file
-      */
-      if (fgets(line, BUF_LEN, inp_fd.handle)) {
-        line[BUF_LEN - 1] = '\0';
-        value = parse_grid_ascii_line(line, parsed_line, &varcoord);
-        result = 0;
-        for (i = 0; i < 3; ++i) {
-          if (((safe_rint(varcoord.cart[i] * 1.0e03) / 1.0e03)
-            < (safe_rint((double)(od->newgrid.start_coord[i]) * 1.0e03) / 1.0e03))
-            || ((safe_rint(varcoord.cart[i] * 1.0e03) / 1.0e03)
-            > (safe_rint((double)(od->newgrid.end_coord[i]) * 1.0e03) / 1.0e03))) {
-            od->newgrid.object_num = object_num;
-            result = GRID_NOT_MATCHING_OUT_OF_BOUNDS;
-          }
-          node = (varcoord.cart[i] - (double)(od->newgrid.start_coord[i]))
-            / (double)(od->newgrid.step[i]);
-          if ((node - safe_rint(node)) > 1.0e-03) {
-            od->newgrid.object_num = object_num;
-            result = GRID_NOT_MATCHING_OFF_CENTER;
-          }
-          if (result) {
-            od->newgrid.start_coord[i] = (float)(varcoord.cart[i]);
-            od->newgrid.x_vars = n_grid_x_vars + 1;
-          }
-          varcoord.node[i] = (int)safe_rint(node);
-        }
-        if (result) {
-          fclose(inp_fd.handle);
-          return result;
-        }
-        /*
-        if the current value is a MISSING value,
-        then replace it with MISSING_VALUE
-        */
-        result = set_x_value_xyz(od, od->field_num - 1, object_num, &varcoord,
-          (strstr(line, COMFA_MISSING_VALUE) ? MISSING_VALUE : value));
-        if (result) {
-          fclose(inp_fd.handle);
-          return result;
-        }
-      }
-      else {
-        od->newgrid.x_vars = n_grid_x_vars;
-        od->newgrid.object_num = object_num;
-        return CANNOT_READ_GRID_DATA;
+  close_ascii_reader(ar);
+  rewind(grid_in);
+  result = 0;
+  if (!object_num) {
+    /*
+    allocate one more field
+    */
+    result = alloc_x_var_array(od, 1);
+  }
+  if (!result) {
+    ar = open_ascii_reader(grid_in, NULL);
+    if (!ar) {
+      fclose(grid_in);
+      if (src_value) {
+        free(src_value);
       }
+      return OUT_OF_MEMORY;
     }
-    fclose(inp_fd.handle);
+    result = read_grid_ascii(od, ar, object_num,
+      initial_field_num, src_value);
+    close_ascii_reader(ar);
+  }
+  fclose(grid_in);
+  if (src_value) {
+    if (!result) {
+      result = resample_grid(od, src_value,
+        task->data[DATA_INTERPOLATE], object_num, initial_field_num);
+    }
+    free(src_value);
   }
-  update_field_object_attr(od, VERBOSE_BIT);
-
-  result = calc_active_vars(od, FULL_MODEL);
 
-  return 0;
+  return result;
 }
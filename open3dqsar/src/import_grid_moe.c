@@ -42,7 +42,9 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
-int import_grid_moe(O3Data *od, char *regex_name)
+static int read_moe_grid(O3Data *od, FILE *moe_grid_in,
+  int object_num, int initial_field_num,
+  int interpolate, float **src_value)
 {
   char buffer[MAX_NAME_LEN];
   char header[MAX_NAME_LEN];
@@ -50,154 +52,192 @@ int import_grid_moe(O3Data *od, char *regex_name)
   int n;
   int title_len;
   int actual_len;
-  int object_num;
   int field_num;
-  int initial_field_num;
   int dimensions;
   int n_grids;
   int swap_endianness;
   int result;
   float coord;
+  float first_coord = 0.0;
   double value;
   double node;
   VarCoord varcoord;
-  FILE *moe_grid_in = NULL;
 
 
-  initial_field_num = od->field_num;
   swap_endianness = (int)fabs(machine_type() - O3Q_LITTLE_ENDIAN);
   memset(od->newgrid.start_coord, 0, 3 * sizeof(float));
-  for (object_num = 0; object_num < od->object_num; ++object_num) {
-    sprintf(od->file[BINARY_IN]->name, regex_name, object_num + 1);
-    moe_grid_in = fopen(od->file[BINARY_IN]->name, "rb");
-    if (!moe_grid_in) {
-      return NOT_ENOUGH_OBJECTS;
-    }
-    od->file[BINARY_IN]->handle = moe_grid_in;
-    sprintf(header, "%s%.2f", MOE_ID_TOKEN, MOE_FORMAT_VERSION);
-    actual_len = fread(buffer, sizeof(char), 12, moe_grid_in);
-    if ((actual_len != 12) || strncmp(buffer, header, 12)) {
-      return PREMATURE_DAT_EOF;
-    }
-    /*
-    skip 2 int values
-    */
-    if (fseek(moe_grid_in, 2 * sizeof(int), SEEK_CUR)) {
+  sprintf(header, "%s%.2f", MOE_ID_TOKEN, MOE_FORMAT_VERSION);
+  actual_len = fread(buffer, sizeof(char), 12, moe_grid_in);
+  if ((actual_len != 12) || strncmp(buffer, header, 12)) {
+    return PREMATURE_DAT_EOF;
+  }
+  /*
+  skip 2 int values
+  */
+  if (fseek(moe_grid_in, 2 * sizeof(int), SEEK_CUR)) {
+    return PREMATURE_DAT_EOF;
+  }
+  /*
+  read title length in order to skip it
+  */
+  actual_len = fread(&title_len, sizeof(int), 1, moe_grid_in);
+  if (actual_len != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&title_len, sizeof(int), 1, swap_endianness);
+  if (title_len) {
+    if (fseek(moe_grid_in, title_len, SEEK_CUR)) {
       return PREMATURE_DAT_EOF;
     }
-    /*
-    read title length in order to skip it
-    */
-    actual_len = fread(&title_len, sizeof(int), 1, moe_grid_in);
-    if (actual_len != 1) {
+  }
+  /*
+  there must be 3 dimensions
+  */
+  actual_len = fread(&dimensions, sizeof(int), 1, moe_grid_in);
+  fix_endianness(&dimensions, sizeof(int), 1, swap_endianness);
+  if ((actual_len != 1) || (dimensions != 3)) {
+    return PREMATURE_DAT_EOF;
+  }
+  /*
+  now there should be 3 blocks constituted by:
+  - 1 int or long int (n = number of ticks)
+  - n floats (tick coordinates, we skip them)
+  */
+  for (i = 0; i < 3; ++i) {
+    actual_len = fread(&(od->newgrid.nodes[i]),
+      sizeof(int), 1, moe_grid_in);
+    fix_endianness(&(od->newgrid.nodes[i]),
+      sizeof(int), 1, swap_endianness);
+    if ((actual_len != 1) || (od->newgrid.nodes[i] < 1)
+      || ((!interpolate) && (od->newgrid.nodes[i] != od->grid.nodes[i]))) {
       return PREMATURE_DAT_EOF;
     }
-    fix_endianness(&title_len, sizeof(int), 1, swap_endianness);
-    if (title_len) {
-      if (fseek(moe_grid_in, title_len, SEEK_CUR)) {
+    for (n = 0; n < od->newgrid.nodes[i]; ++n) {
+      actual_len = fread(&coord,
+        sizeof(float), 1, moe_grid_in);
+      if (actual_len != 1) {
         return PREMATURE_DAT_EOF;
       }
+      fix_endianness(&coord, sizeof(float), 1, swap_endianness);
+      if (interpolate) {
+        /*
+        ticks are assumed to be evenly spaced;
+        the grid is checked against od->grid below
+        */
+        if (!n) {
+          first_coord = coord;
+        }
+        od->newgrid.start_coord[i] = first_coord;
+        od->newgrid.end_coord[i] = coord;
+        od->newgrid.step[i] = ((n) ? (coord - first_coord)
+          / (float)n : od->grid.step[i]);
+        continue;
+      }
+      value = (double)coord;
+      node = (value - (double)(od->grid.start_coord[i]))
+        / (double)(od->grid.step[i]);
+      if ((node - safe_rint(node)) > 1.0e-03) {
+        od->newgrid.start_coord[i] = value;
+        od->newgrid.object_num = object_num;
+        return GRID_NOT_MATCHING_OFF_CENTER;
+      }
     }
+  }
+  actual_len = fread(&n_grids, sizeof(int), 1, moe_grid_in);
+  if (actual_len != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&n_grids, sizeof(int), 1, swap_endianness);
+  od->newgrid.x_vars = od->newgrid.nodes[0]
+    * od->newgrid.nodes[1] * od->newgrid.nodes[2];
+  if (interpolate && (!match_grids(od))) {
     /*
-    there must be 3 dimensions
+    data are collected and then resampled onto od->grid
     */
-    actual_len = fread(&dimensions, sizeof(int), 1, moe_grid_in);
-    fix_endianness(&dimensions, sizeof(int), 1, swap_endianness);
-    if ((actual_len != 1) || (dimensions != 3)) {
-      return PREMATURE_DAT_EOF;
+    *src_value = alloc_resample_buffer(od, object_num,
+      initial_field_num, n_grids);
+    if (!(*src_value)) {
+      return OUT_OF_MEMORY;
     }
+  }
+  for (field_num = 0; field_num < n_grids; ++field_num) {
     /*
-    now there should be 3 blocks constituted by:
-    - 1 int or long int (n = number of ticks)
-    - n floats (tick coordinates, we skip them)
+    allocate one more field
     */
-    for (i = 0; i < 3; ++i) {
-      actual_len = fread(&(od->newgrid.nodes[i]),
-        sizeof(int), 1, moe_grid_in);
-      fix_endianness(&(od->newgrid.nodes[i]),
-        sizeof(int), 1, swap_endianness);
-      if ((actual_len != 1)
-        || (od->newgrid.nodes[i] != od->grid.nodes[i])) {
-        return PREMATURE_DAT_EOF;
-      }
-      for (n = 0; n < od->newgrid.nodes[i]; ++n) {
-        actual_len = fread(&coord,
-          sizeof(float), 1, moe_grid_in);
-        if (actual_len != 1) {
-          return PREMATURE_DAT_EOF;
-        }
-        fix_endianness(&(od->newgrid.nodes[i]),
-          sizeof(float), 1, swap_endianness);
-        value = (double)coord;
-        node = (value - (double)(od->grid.start_coord[i]))
-          / (double)(od->grid.step[i]);
-        if ((node - safe_rint(node)) > 1.0e-03) {
-          od->newgrid.start_coord[i] = value;
-          od->newgrid.object_num = object_num;
-          return GRID_NOT_MATCHING_OFF_CENTER;
-        }
+    if (!object_num) {
+      result = alloc_x_var_array(od, 1);
+      if (result) {
+        return result;
       }
     }
-    actual_len = fread(&n_grids, sizeof(int), 1, moe_grid_in);
+    else if ((field_num + initial_field_num) >= od->field_num) {
+      /*
+      this file holds more grids than the first one
+      */
+      return PREMATURE_DAT_EOF;
+    }
+    /*
+    read label length in order to skip it
+    */
+    actual_len = fread(&n, sizeof(int), 1, moe_grid_in);
     if (actual_len != 1) {
       return PREMATURE_DAT_EOF;
     }
-    fix_endianness(&n_grids, sizeof(int), 1, swap_endianness);
-    for (field_num = 0; field_num < n_grids; ++field_num) {
-      /*
-      allocate one more field
-      */
-      if (!object_num) {
-        result = alloc_x_var_array(od, 1);
-        if (result) {
-          return result;
-        }
-      }
-      /*
-      read label length in order to skip it
-      */
-      actual_len = fread(&n, sizeof(int), 1, moe_grid_in);
-      if (actual_len != 1) {
-        return PREMATURE_DAT_EOF;
-      }
-      fix_endianness(&n, sizeof(int), 1, swap_endianness);
-      if (fseek(moe_grid_in, n, SEEK_CUR)) {
-        return PREMATURE_DAT_EOF;
-      }
-      /*
-      now there should be x_nodes * y_nodes arrays,
-      each constituted by z_nodes doubles
-      z: fastest varying coordinate
-      x: slowest varying coordinate
-      */
-      for (varcoord.node[0] = 0; varcoord.node[0] < od->newgrid.nodes[0]; ++varcoord.node[0]) {
-        for (varcoord.node[1] = 0; varcoord.node[1] < od->newgrid.nodes[1]; ++varcoord.node[1]) {
-          for (varcoord.node[2] = 0; varcoord.node[2] < od->newgrid.nodes[2]; ++varcoord.node[2]) {
-            actual_len = fread(&value, sizeof(double), 1, moe_grid_in);
-            if (actual_len != 1) {
-              return PREMATURE_DAT_EOF;
-            }
-            fix_endianness(&value, sizeof(double), 1, swap_endianness);
-            result = set_x_value_xyz(od, field_num + initial_field_num,
-              object_num, &varcoord, value);
-            if (result) {
-              return result;
-            }
+    fix_endianness(&n, sizeof(int), 1, swap_endianness);
+    if (fseek(moe_grid_in, n, SEEK_CUR)) {
+      return PREMATURE_DAT_EOF;
+    }
+    /*
+    now there should be x_nodes * y_nodes arrays,
+    each constituted by z_nodes doubles
+    z: fastest varying coordinate
+    x: slowest varying coordinate
+    */
+    for (varcoord.node[0] = 0; varcoord.node[0] < od->newgrid.nodes[0]; ++varcoord.node[0]) {
+      for (varcoord.node[1] = 0; varcoord.node[1] < od->newgrid.nodes[1]; ++varcoord.node[1]) {
+        for (varcoord.node[2] = 0; varcoord.node[2] < od->newgrid.nodes[2]; ++varcoord.node[2]) {
+          actual_len = fread(&value, sizeof(double), 1, moe_grid_in);
+          if (actual_len != 1) {
+            return PREMATURE_DAT_EOF;
+          }
+          fix_endianness(&value, sizeof(double), 1, swap_endianness);
+          result = set_imported_x_value(od, *src_value,
+            field_num + initial_field_num, initial_field_num,
+            object_num, &varcoord, value);
+          if (result) {
+            return result;
           }
         }
       }
     }
-    if (moe_grid_in) {
-      fclose(moe_grid_in);
-      od->file[BINARY_IN]->handle = NULL;
-    }
-  }
-  if (od->save_ram) {
-    sync_field_mmap(od);
   }
-  update_field_object_attr(od, VERBOSE_BIT);
 
-  result = calc_active_vars(od, FULL_MODEL);
+  return 0;
+}
+
 
+int import_grid_moe(O3Data *od, TaskInfo *task,
+  int object_num, int initial_field_num)
+{
+  int result;
+  float *src_value = NULL;
+  FILE *moe_grid_in;
+
+
+  moe_grid_in = fopen(task->string, "rb");
+  if (!moe_grid_in) {
+    return NOT_ENOUGH_OBJECTS;
+  }
+  result = read_moe_grid(od, moe_grid_in, object_num,
+    initial_field_num, task->data[DATA_INTERPOLATE], &src_value);
+  fclose(moe_grid_in);
+  if (src_value) {
+    if (!result) {
+      result = resample_grid(od, src_value,
+        task->data[DATA_INTERPOLATE], object_num, initial_field_num);
+    }
+    free(src_value);
+  }
+  
   return result;
 }
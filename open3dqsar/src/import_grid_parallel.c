@@ -0,0 +1,252 @@
+/*
+
+import_grid_parallel.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+static int import_grid_object(O3Data *od, int multi_file_type,
+  int object_num, int initial_field_num, int mo)
+{
+  TaskInfo *task;
+  
+  
+  task = od->al.task_list[object_num];
+  switch (multi_file_type) {
+    case FORMATTED_CUBE_INPUT_FILE:
+    return import_grid_formatted_cube(od, task,
+      object_num, initial_field_num, mo);
+
+    case UNFORMATTED_CUBE_INPUT_FILE:
+    return import_grid_unformatted_cube(od, task,
+      object_num, initial_field_num, mo);
+
+    case MOLDEN_INPUT_FILE:
+    return import_grid_molden(od, task, object_num, initial_field_num);
+
+    case MOE_GRID_INPUT_FILE:
+    return import_grid_moe(od, task, object_num, initial_field_num);
+
+    case OPENDX_INPUT_FILE:
+    return import_opendx(od, task, object_num, initial_field_num);
+  }
+  
+  return import_grid_ascii(od, task, object_num, initial_field_num);
+}
+
+
+int import_grid_parallel(O3Data *od, int multi_file_type,
+  char *regex_name, int mo, int interpolate)
+{
+  int i;
+  int n_threads;
+  int object_num;
+  int initial_field_num;
+  int result;
+  ThreadInfo **ti;
+
+
+  ti = od->mel.thread_info;
+  initial_field_num = od->field_num;
+  if (!(od->al.task_list = (TaskInfo **)alloc_array
+    (od->grid.object_num, sizeof(TaskInfo)))) {
+    return OUT_OF_MEMORY;
+  }
+  if (!(od->al.newgrid_list = (GridInfo **)alloc_array
+    (od->grid.object_num, sizeof(GridInfo)))) {
+    return OUT_OF_MEMORY;
+  }
+  /*
+  cube and Molden file names were matched to objects
+  by match_objects_with_datafile() and stored in
+  TEMP_SORTED_MATCH; for other formats they are
+  obtained expanding the regex
+  */
+  if ((multi_file_type == FORMATTED_CUBE_INPUT_FILE)
+    || (multi_file_type == UNFORMATTED_CUBE_INPUT_FILE)
+    || (multi_file_type == MOLDEN_INPUT_FILE)) {
+    rewind(od->file[TEMP_SORTED_MATCH]->handle);
+  }
+  for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
+    if ((multi_file_type == FORMATTED_CUBE_INPUT_FILE)
+      || (multi_file_type == UNFORMATTED_CUBE_INPUT_FILE)
+      || (multi_file_type == MOLDEN_INPUT_FILE)) {
+      if (!fgets(od->al.task_list[object_num]->string, BUF_LEN,
+        od->file[TEMP_SORTED_MATCH]->handle)) {
+        return CANNOT_READ_TEMP_FILE;
+      }
+      remove_newline(od->al.task_list[object_num]->string);
+    }
+    else {
+      sprintf(od->al.task_list[object_num]->string,
+        regex_name, object_num + 1);
+    }
+    /*
+    if interpolate is set, grids which do not
+    match od->grid are resampled rather than rejected
+    */
+    od->al.task_list[object_num]->data[DATA_INTERPOLATE] = interpolate;
+    od->al.mol_info[object_num]->done = 0;
+  }
+  /*
+  the first object is imported in the main thread
+  since it allocates fields and, for OpenDX files,
+  may define the grid; the other objects are
+  then imported in parallel. If the first object
+  fails after its fields were allocated the other
+  objects are still imported, so that all files
+  which cannot be imported are reported at once
+  */
+  od->al.mol_info[0]->done = 1;
+  od->al.task_list[0]->code = import_grid_object(od,
+    multi_file_type, 0, initial_field_num, mo);
+  if (od->al.task_list[0]->code) {
+    memcpy(od->al.newgrid_list[0], &(od->newgrid), sizeof(GridInfo));
+    od->al.newgrid_list[0]->object_num = 0;
+  }
+  if ((od->field_num > initial_field_num) && (od->grid.object_num > 1)) {
+    if (alloc_threads(od)) {
+      return OUT_OF_MEMORY;
+    }
+    #ifndef WIN32
+    pthread_mutex_init(od->mel.mutex, NULL);
+    #else
+    if (!(*(od->mel.mutex) = CreateMutex(NULL, FALSE, NULL))) {
+      return CANNOT_CREATE_THREAD;
+    }
+    #endif
+    n_threads = fill_thread_info(od, od->grid.object_num - 1);
+    for (i = 0; i < n_threads; ++i) {
+      memcpy(&(ti[i]->od), od, sizeof(O3Data));
+      ti[i]->model_type = multi_file_type;
+      ti[i]->data[0] = initial_field_num;
+      ti[i]->data[1] = mo;
+    }
+    /*
+    hand the job over to the worker pool
+    and wait for all threads to have finished
+    */
+    result = run_thread_pool(od, (void *)import_grid_thread, n_threads);
+    #ifndef WIN32
+    pthread_mutex_destroy(od->mel.mutex);
+    #else
+    CloseHandle(*(od->mel.mutex));
+    #endif
+    if (result) {
+      return result;
+    }
+  }
+  if (od->save_ram) {
+    sync_field_mmap(od);
+  }
+  /*
+  all failing objects are listed by the caller through
+  print_import_grid_errors(); the first one is also
+  reported through od->newgrid and the input file names
+  */
+  for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
+    if (od->al.task_list[object_num]->code) {
+      memcpy(&(od->newgrid), od->al.newgrid_list[object_num], sizeof(GridInfo));
+      strcpy(od->file[ASCII_IN]->name, od->al.task_list[object_num]->string);
+      strcpy(od->file[BINARY_IN]->name, od->al.task_list[object_num]->string);
+      return od->al.task_list[object_num]->code;
+    }
+  }
+  update_field_object_attr(od, VERBOSE_BIT);
+  result = calc_active_vars(od, FULL_MODEL);
+
+  return result;
+}
+
+
+#ifndef WIN32
+void *import_grid_thread(void *pointer)
+#else
+DWORD import_grid_thread(void *pointer)
+#endif
+{
+  int object_num;
+  int assigned = 1;
+  ThreadInfo *ti;
+
+
+  ti = (ThreadInfo *)pointer;
+  while (assigned) {
+    object_num = 0;
+    assigned = 0;
+    while ((!assigned) && (object_num < ti->od.grid.object_num)) {
+      if (!(ti->od.al.mol_info[object_num]->done)) {
+        #ifndef WIN32
+        pthread_mutex_lock(ti->od.mel.mutex);
+        #else
+        WaitForSingleObject(*(ti->od.mel.mutex), INFINITE);
+        #endif
+        if (!(ti->od.al.mol_info[object_num]->done)) {
+          ti->od.al.mol_info[object_num]->done = 1;
+          assigned = 1;
+        }
+        #ifndef WIN32
+        pthread_mutex_unlock(ti->od.mel.mutex);
+        #else
+        ReleaseMutex(*(ti->od.mel.mutex));
+        #endif
+      }
+      else {
+        ++object_num;
+      }
+    }
+    if (!assigned) {
+      break;
+    }
+    ti->od.al.task_list[object_num]->code = import_grid_object(&(ti->od),
+      ti->model_type, object_num, ti->data[0], ti->data[1]);
+    if (ti->od.al.task_list[object_num]->code) {
+      memcpy(ti->od.al.newgrid_list[object_num],
+        &(ti->od.newgrid), sizeof(GridInfo));
+      ti->od.al.newgrid_list[object_num]->object_num = object_num;
+    }
+  }
+  #ifndef WIN32
+  return pointer;
+  #else
+  return 0;
+  #endif
+}
@@ -42,15 +42,15 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
-int import_grid_unformatted_cube(O3Data *od, int mo)
+static int read_unformatted_cube(O3Data *od, FILE *gaussian_cube_in,
+  int object_num, int initial_field_num, int mo,
+  int interpolate, float **src_value)
 {
   int i;
   int j;
   int mo_cube = 0;
   int actual_len;
-  int object_num;
   int field_num;
-  int initial_field_num;
   int data_len_start;
   int data_len_end;
   int endianness_switch;
@@ -67,98 +67,122 @@ int import_grid_unformatted_cube(O3Data *od, int mo)
   double origin[3];
   double step[3][3];
   VarCoord varcoord;
-  FILE *gaussian_cube_in = NULL;
-  
 
 
-  initial_field_num = od->field_num;
-  rewind(od->file[TEMP_SORTED_MATCH]->handle);
-  for (object_num = 0; object_num < od->object_num; ++object_num) {
-    if (!fgets(od->file[BINARY_IN]->name, BUF_LEN, od->file[TEMP_SORTED_MATCH]->handle)) {
-      return CANNOT_READ_TEMP_FILE;
-    }
-    remove_newline(od->file[BINARY_IN]->name);
-    gaussian_cube_in = fopen(od->file[BINARY_IN]->name, "rb");
-    if (!gaussian_cube_in) {
-      return NOT_ENOUGH_OBJECTS;
-    }
-    od->file[BINARY_IN]->handle = gaussian_cube_in;
-    /*
-    desume endianness
-    from the first int at the very beginning
-    of the GAUSSIAN cube file
-    also take into consideration
-    the endianness of the machine we are running on
-    */
+  /*
+  desume endianness
+  from the first int at the very beginning
+  of the GAUSSIAN cube file
+  also take into consideration
+  the endianness of the machine we are running on
+  */
 
-    actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
-    if (actual_len != 1) {
-      return PREMATURE_DAT_EOF;
-    }
-    fix_endianness(&data_len_start, sizeof(int), 1, machine_type());
-    if (data_len_start <= 0xFFFF) {
-      endianness_switch = machine_type();
-    }
-    else {
-      endianness_switch = 1 - machine_type();
-    }
-    fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
-    /*
-    at the beginning there are two 80-byte headers
-    that we can skip
-    */
-    if (fseek(gaussian_cube_in, data_len_start, SEEK_CUR)) {
-      return PREMATURE_DAT_EOF;
-    }
-    actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
-    fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
-    if ((actual_len != 1) || (data_len_start != data_len_end)) {
-      return PREMATURE_DAT_EOF;
-    }
-    actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
+  actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
+  if (actual_len != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&data_len_start, sizeof(int), 1, machine_type());
+  if (data_len_start <= 0xFFFF) {
+    endianness_switch = machine_type();
+  }
+  else {
+    endianness_switch = 1 - machine_type();
+  }
+  fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
+  /*
+  at the beginning there are two 80-byte headers
+  that we can skip
+  */
+  if (fseek(gaussian_cube_in, data_len_start, SEEK_CUR)) {
+    return PREMATURE_DAT_EOF;
+  }
+  actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
+  fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
+  if ((actual_len != 1) || (data_len_start != data_len_end)) {
+    return PREMATURE_DAT_EOF;
+  }
+  actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
+  if (actual_len != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
+  if (fseek(gaussian_cube_in, data_len_start, SEEK_CUR)) {
+    return PREMATURE_DAT_EOF;
+  }
+  actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
+  fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
+  if ((actual_len != 1) || (data_len_start != data_len_end)) {
+    return PREMATURE_DAT_EOF;
+  }
+  /*
+  now there should be a block constituted by:
+  - 1 int or long int (number of atoms)
+  - 3 doubles (origin x, y, z)
+  */
+  actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
+  if (actual_len != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
+  data_len_start -= 3 * sizeof(double);
+  if ((data_len_start != sizeof(int))
+    && (data_len_start != sizeof(long int))) {
+    return PREMATURE_DAT_EOF;
+  }
+  cube_word_size = data_len_start;
+  actual_len = fread(&long_n_atoms, cube_word_size, 1, gaussian_cube_in);
+  if (actual_len != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&long_n_atoms, cube_word_size, 1, endianness_switch);
+  n_atoms = (int)long_n_atoms;
+  mo_cube = (n_atoms < 0);
+  n_atoms = absval(n_atoms);
+  for (i = 0; i < 3; ++i) {
+    actual_len = fread(&origin[i], sizeof(double), 1, gaussian_cube_in);
     if (actual_len != 1) {
       return PREMATURE_DAT_EOF;
     }
-    fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
-    if (fseek(gaussian_cube_in, data_len_start, SEEK_CUR)) {
-      return PREMATURE_DAT_EOF;
-    }
-    actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
-    fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
-    if ((actual_len != 1) || (data_len_start != data_len_end)) {
-      return PREMATURE_DAT_EOF;
-    }
-    /*
-    now there should be a block constituted by:
-    - 1 int or long int (number of atoms)
-    - 3 doubles (origin x, y, z)
-    */
+    fix_endianness(&origin[i], sizeof(double), 1, endianness_switch);
+    od->newgrid.start_coord[i] = (float)(safe_rint(origin[i] * BOHR_RADIUS * 1.0e04) / 1.0e04);
+  }
+  actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
+  if (actual_len != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
+  data_len_end -= 3 * sizeof(double);
+  if (data_len_start != data_len_end) {
+    return PREMATURE_DAT_EOF;
+  }
+  /*
+  now there should be 3 blocks constituted by:
+  - 1 int or long int (number of [X,Y,Z]_nodes)
+  - 3 doubles (step size Xn,Yn,Zn)
+  */
+  for (i = 0; i < 3; ++i) {
     actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
     if (actual_len != 1) {
       return PREMATURE_DAT_EOF;
     }
     fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
     data_len_start -= 3 * sizeof(double);
-    if ((data_len_start != sizeof(int))
-      && (data_len_start != sizeof(long int))) {
+    if (data_len_start != cube_word_size) {
       return PREMATURE_DAT_EOF;
     }
-    cube_word_size = data_len_start;
-    actual_len = fread(&long_n_atoms, cube_word_size, 1, gaussian_cube_in);
+    actual_len = fread(&long_node, cube_word_size, 1, gaussian_cube_in);
     if (actual_len != 1) {
       return PREMATURE_DAT_EOF;
     }
-    fix_endianness(&long_n_atoms, cube_word_size, 1, endianness_switch);
-    n_atoms = (int)long_n_atoms;
-    mo_cube = (n_atoms < 0);
-    n_atoms = absval(n_atoms);
-    for (i = 0; i < 3; ++i) {
-      actual_len = fread(&origin[i], sizeof(double), 1, gaussian_cube_in);
+    fix_endianness(&long_node, cube_word_size, 1, endianness_switch);
+    od->newgrid.nodes[i] = (int)long_node;
+    for (j = 0; j < 3; ++j) {
+      actual_len = fread(&step[i][j], sizeof(double), 1, gaussian_cube_in);
       if (actual_len != 1) {
         return PREMATURE_DAT_EOF;
       }
-      fix_endianness(&origin[i], sizeof(double), 1, endianness_switch);
-      od->newgrid.start_coord[i] = (float)(safe_rint(origin[i] * BOHR_RADIUS * 1.0e04) / 1.0e04);
+      fix_endianness(&step[i][j], sizeof(double), 1, endianness_switch);
+      step[i][j] = safe_rint(step[i][j] * BOHR_RADIUS * 1.0e04) / 1.0e04;
     }
     actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
     if (actual_len != 1) {
@@ -169,179 +193,179 @@ int import_grid_unformatted_cube(O3Data *od, int mo)
     if (data_len_start != data_len_end) {
       return PREMATURE_DAT_EOF;
     }
-    /*
-    now there should be 3 blocks constituted by:
-    - 1 int or long int (number of [X,Y,Z]_nodes)
-    - 3 doubles (step size Xn,Yn,Zn)
-    */
-    for (i = 0; i < 3; ++i) {
-      actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
-      if (actual_len != 1) {
-        return PREMATURE_DAT_EOF;
-      }
-      fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
-      data_len_start -= 3 * sizeof(double);
-      if (data_len_start != cube_word_size) {
-        return PREMATURE_DAT_EOF;
-      }
-      actual_len = fread(&long_node, cube_word_size, 1, gaussian_cube_in);
-      if (actual_len != 1) {
-        return PREMATURE_DAT_EOF;
-      }
-      fix_endianness(&long_node, cube_word_size, 1, endianness_switch);
-      od->newgrid.nodes[i] = (int)long_node;
-      for (j = 0; j < 3; ++j) {
-        actual_len = fread(&step[i][j], sizeof(double), 1, gaussian_cube_in);
-        if (actual_len != 1) {
-          return PREMATURE_DAT_EOF;
-        }
-        fix_endianness(&step[i][j], sizeof(double), 1, endianness_switch);
-        step[i][j] = safe_rint(step[i][j] * BOHR_RADIUS * 1.0e04) / 1.0e04;
-      }
-      actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
+  }
+  for (i = 0; i < 3; ++i) {
+    od->newgrid.step[i] = (float)step[i][i];
+    od->newgrid.end_coord[i] = (float)
+      (safe_rint(((double)(od->newgrid.start_coord[i])
+      + (double)(od->newgrid.nodes[i] - 1)
+      * step[i][i]) * 1.0e04) / 1.0e04);
+  }
+  /*
+  now there should be n_atoms blocks constituted by:
+  - 1 int or long int (atom number)
+  - 4 doubles (charge, x_coord, y_coord, z_coord)
+  */
+  actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
+  fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
+  if ((actual_len != 1) || ((data_len_start != (n_atoms * (sizeof(int) + 4 * sizeof(double))))
+    && (data_len_start != (n_atoms * (sizeof(long int) + 4 * sizeof(double)))))) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (fseek(gaussian_cube_in, data_len_start, SEEK_CUR)) {
+    return PREMATURE_DAT_EOF;
+  }
+  actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
+  fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
+  if ((actual_len != 1) || (data_len_start != data_len_end)) {
+    return PREMATURE_DAT_EOF;
+  }
+  od->newgrid.x_vars = od->newgrid.nodes[0]
+    * od->newgrid.nodes[1] * od->newgrid.nodes[2];
+  if ((!match_grids(od)) && (!interpolate)) {
+    return GRID_NOT_MATCHING;
+  }
+  /*
+  now if this is a MO cube file there is the list of MOs
+  */
+  found = -1;
+  n_mo = 1;
+  if (mo_cube) {
+    actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
+    if (actual_len != 1) {
+      return PREMATURE_DAT_EOF;
+    }
+    fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
+    actual_len = fread(&long_n_mo, cube_word_size, 1, gaussian_cube_in);
+    if (actual_len != 1) {
+      return PREMATURE_DAT_EOF;
+    }
+    fix_endianness(&long_n_mo, cube_word_size, 1, endianness_switch);
+    n_mo = (int)long_n_mo;
+    if (data_len_start != ((n_mo + 1) * cube_word_size)) {
+      return PREMATURE_DAT_EOF;
+    }
+    j = 0;
+    found = 0;
+    while (j < n_mo) {
+      actual_len = fread(&long_i, cube_word_size, 1, gaussian_cube_in);
       if (actual_len != 1) {
         return PREMATURE_DAT_EOF;
       }
-      fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
-      data_len_end -= 3 * sizeof(double);
-      if (data_len_start != data_len_end) {
-        return PREMATURE_DAT_EOF;
+      ++j;
+      if ((!found) && (mo == j)) {
+        found = j;
       }
     }
-    for (i = 0; i < 3; ++i) {
-      od->newgrid.step[i] = (float)step[i][i];
-      od->newgrid.end_coord[i] = (float)
-        (safe_rint(((double)(od->newgrid.start_coord[i])
-        + (double)(od->newgrid.nodes[i] - 1)
-        * step[i][i]) * 1.0e04) / 1.0e04);
+    if ((!found) && (!mo)) {
+      found = -1;
     }
-    /*
-    now there should be n_atoms blocks constituted by:
-    - 1 int or long int (atom number)
-    - 4 doubles (charge, x_coord, y_coord, z_coord)
-    */
-    actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
-    fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
-    if ((actual_len != 1) || ((data_len_start != (n_atoms * (sizeof(int) + 4 * sizeof(double))))
-      && (data_len_start != (n_atoms * (sizeof(long int) + 4 * sizeof(double)))))) {
-      return PREMATURE_DAT_EOF;
-    }
-    if (fseek(gaussian_cube_in, data_len_start, SEEK_CUR)) {
-      return PREMATURE_DAT_EOF;
+    if ((!found) || (found > n_mo)) {
+      od->newgrid.object_num = object_num;
+      return CANNOT_FIND_MO;
     }
     actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
     fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
-    if ((actual_len != 1) || (data_len_start != data_len_end)) {
+    if ((actual_len != 1) || (data_len_end != data_len_start)) {
       return PREMATURE_DAT_EOF;
     }
-    if (!match_grids(od)) {
-      return GRID_NOT_MATCHING;
+  }
+  /*
+  if the grid does not match, data are collected
+  and then resampled onto od->grid
+  */
+  if (!match_grids(od)) {
+    *src_value = alloc_resample_buffer(od, object_num,
+      initial_field_num, (found == -1) ? n_mo : 1);
+    if (!(*src_value)) {
+      return OUT_OF_MEMORY;
     }
-    /*
-    now if this is a MO cube file there is the list of MOs
-    */
-    found = -1;
-    n_mo = 1;
-    if (mo_cube) {
+  }
+  /*
+  now there should be x_nodes * y_nodes arrays,
+  each constituted by z_nodes doubles
+  z: fastest varying coordinate
+  x: slowest varying coordinate
+  */
+  for (varcoord.node[0] = 0; varcoord.node[0] < od->newgrid.nodes[0]; ++varcoord.node[0]) {
+    for (varcoord.node[1] = 0; varcoord.node[1] < od->newgrid.nodes[1]; ++varcoord.node[1]) {
       actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
-      if (actual_len != 1) {
-        return PREMATURE_DAT_EOF;
-      }
       fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
-      actual_len = fread(&long_n_mo, cube_word_size, 1, gaussian_cube_in);
-      if (actual_len != 1) {
+      if ((actual_len != 1) || (data_len_start != (od->newgrid.nodes[2] * n_mo * sizeof(double)))) {
         return PREMATURE_DAT_EOF;
       }
-      fix_endianness(&long_n_mo, cube_word_size, 1, endianness_switch);
-      n_mo = (int)long_n_mo;
-      if (data_len_start != ((n_mo + 1) * cube_word_size)) {
-        return PREMATURE_DAT_EOF;
-      }
-      j = 0;
-      found = 0;
-      while (j < n_mo) {
-        actual_len = fread(&long_i, cube_word_size, 1, gaussian_cube_in);
-        if (actual_len != 1) {
-          return PREMATURE_DAT_EOF;
-        }
-        ++j;
-        if ((!found) && (mo == j)) {
-          found = j;
-        }
-      }
-      if ((!found) && (!mo)) {
-        found = -1;
-      }
-      if ((!found) || (found > n_mo)) {
-        od->newgrid.object_num = object_num;
-        return CANNOT_FIND_MO;
-      }
-      actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
-      fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
-      if ((actual_len != 1) || (data_len_end != data_len_start)) {
-        return PREMATURE_DAT_EOF;
-      }
-    }
-    /*
-    now there should be x_nodes * y_nodes arrays,
-    each constituted by z_nodes doubles
-    z: fastest varying coordinate
-    x: slowest varying coordinate
-    */
-    for (varcoord.node[0] = 0; varcoord.node[0] < od->newgrid.nodes[0]; ++varcoord.node[0]) {
-      for (varcoord.node[1] = 0; varcoord.node[1] < od->newgrid.nodes[1]; ++varcoord.node[1]) {
-        actual_len = fread(&data_len_start, sizeof(int), 1, gaussian_cube_in);
-        fix_endianness(&data_len_start, sizeof(int), 1, endianness_switch);
-        if ((actual_len != 1) || (data_len_start != (od->newgrid.nodes[2] * n_mo * sizeof(double)))) {
-          return PREMATURE_DAT_EOF;
-        }
-        for (varcoord.node[2] = 0; varcoord.node[2] < od->newgrid.nodes[2]; ++varcoord.node[2]) {
-          for (j = 1, field_num = initial_field_num; j <= n_mo; ++j) {
-            actual_len = fread(&value, sizeof(double), 1, gaussian_cube_in);
-            if (actual_len != 1) {
-              return PREMATURE_DAT_EOF;
-            }
-            fix_endianness(&value, sizeof(double), 1, endianness_switch);
-            if ((found == -1) || (found == j)) {
-              if ((!object_num) && (!varcoord.node[0])
-                && (!varcoord.node[1]) && (!varcoord.node[2])) {
-                /*
-                allocate one more field
-                */
-                result = alloc_x_var_array(od, 1);
-                if (result) {
-                  return result;
-                }
-              }
-              result = (mo ? set_x_value_xyz(od, field_num,
-                object_num, &varcoord, value)
-                : set_x_value_xyz_unbuffered(od, field_num,
-                object_num, &varcoord, value));
+      for (varcoord.node[2] = 0; varcoord.node[2] < od->newgrid.nodes[2]; ++varcoord.node[2]) {
+        for (j = 1, field_num = initial_field_num; j <= n_mo; ++j) {
+          actual_len = fread(&value, sizeof(double), 1, gaussian_cube_in);
+          if (actual_len != 1) {
+            return PREMATURE_DAT_EOF;
+          }
+          fix_endianness(&value, sizeof(double), 1, endianness_switch);
+          if ((found == -1) || (found == j)) {
+            if ((!object_num) && (!varcoord.node[0])
+              && (!varcoord.node[1]) && (!varcoord.node[2])) {
+              /*
+              allocate one more field
+              */
+              result = alloc_x_var_array(od, 1);
               if (result) {
                 return result;
               }
-              ++field_num;
             }
+            else if (field_num >= od->field_num) {
+              /*
+              this file holds more MOs than the first one
+              */
+              return PREMATURE_DAT_EOF;
+            }
+            result = set_imported_x_value(od, *src_value, field_num,
+              initial_field_num, object_num, &varcoord, value);
+            if (result) {
+              return result;
+            }
+            ++field_num;
           }
-        }  
-        actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
-        fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
-        if ((actual_len != 1) || (data_len_start != data_len_end)) {
-          return PREMATURE_DAT_EOF;
         }
+      }  
+      actual_len = fread(&data_len_end, sizeof(int), 1, gaussian_cube_in);
+      fix_endianness(&data_len_end, sizeof(int), 1, endianness_switch);
+      if ((actual_len != 1) || (data_len_start != data_len_end)) {
+        return PREMATURE_DAT_EOF;
       }
     }
-    if (gaussian_cube_in) {
-      fclose(gaussian_cube_in);
-      od->file[BINARY_IN]->handle = NULL;
-    }
-  }
-  if (od->save_ram) {
-    sync_field_mmap(od);
   }
-  update_field_object_attr(od, VERBOSE_BIT);
 
-  result = calc_active_vars(od, FULL_MODEL);
+  return 0;
+}
+
 
+int import_grid_unformatted_cube(O3Data *od, TaskInfo *task,
+  int object_num, int initial_field_num, int mo)
+{
+  int result;
+  float *src_value = NULL;
+  FILE *gaussian_cube_in;
+  
+  
+  /*
+  import the unformatted cube file task->string
+  as object object_num; fields are allocated
+  while reading the first object
+  */
+  gaussian_cube_in = fopen(task->string, "rb");
+  if (!gaussian_cube_in) {
+    return NOT_ENOUGH_OBJECTS;
+  }
+  result = read_unformatted_cube(od, gaussian_cube_in, object_num,
+    initial_field_num, mo, task->data[DATA_INTERPOLATE], &src_value);
+  fclose(gaussian_cube_in);
+  if (src_value) {
+    if (!result) {
+      result = resample_grid(od, src_value,
+        task->data[DATA_INTERPOLATE], object_num, initial_field_num);
+    }
+    free(src_value);
+  }
+  
   return result;
 }
@@ -42,13 +42,14 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
-int read_dx_header(O3Data *od, FileDescriptor *inp_fd, int object_num)
+int read_dx_header(O3Data *od, AsciiReader *ar, int object_num)
 {
   char line[BUF_LEN];
   char *data_follows;
   char *gridpositions;
   char *origin;
   char *delta;
+  char *ptr;
   float d[3];
   int data_follows_found;
   int delta_found;
@@ -65,7 +66,7 @@ int read_dx_header(O3Data *od, FileDescriptor *inp_fd, int object_num)
   origin_found = 0;
   gridpositions_found = 0;
   while ((!(data_follows_found && delta_found && origin_found
-    && gridpositions_found)) && fgets(line, BUF_LEN, inp_fd->handle)) {
+    && gridpositions_found)) && ascii_reader_gets(line, BUF_LEN, ar)) {
     /*
     skip comments
     */
@@ -96,14 +97,23 @@ int read_dx_header(O3Data *od, FileDescriptor *inp_fd, int object_num)
     origin = strstr(line, "origin");
     if (origin) {
       origin_found = 1;
-      sscanf(origin, "%*s %f %f %f", &(od->newgrid.start_coord[0]),
-        &(od->newgrid.start_coord[1]), &(od->newgrid.start_coord[2]));
+      ptr = origin;
+      while (*ptr && (!isspace((int)(unsigned char)(*ptr)))) {
+        ++ptr;
+      }
+      for (i = 0; i < 3; ++i) {
+        od->newgrid.start_coord[i] = (float)fast_strtod(ptr, &ptr);
+      }
     }
     delta = strstr(line, "delta");
     if (delta) {
       delta_found = 1;
-      sscanf(delta, "%*s %f %f %f", &d[0], &d[1], &d[2]);
+      ptr = delta;
+      while (*ptr && (!isspace((int)(unsigned char)(*ptr)))) {
+        ++ptr;
+      }
       for (i = 0; i < 3; ++i) {
+        d[i] = (float)fast_strtod(ptr, &ptr);
         od->newgrid.step[i] += d[i];
       }
     }
@@ -134,82 +144,102 @@ int read_dx_header(O3Data *od, FileDescriptor *inp_fd, int object_num)
 }
 
 
-int import_opendx(O3Data *od, char *regex_name)
+static int read_opendx(O3Data *od, AsciiReader *ar,
+  int object_num, int initial_field_num,
+  int interpolate, float **src_value)
 {
-  char line[BUF_LEN];
-  char parsed_line[BUF_LEN];
-  char alloc_field = 0;
-  int i;
+  char *token;
+  char *end;
   int n_grid_x_vars;
-  int n_read;
-  int object_num;
+  int x_vars;
   int result;
-  double value[3];
-  double node;
+  double value;
   VarCoord varcoord;
-  FileDescriptor inp_fd;
-    
 
-  memset(&inp_fd, 0, sizeof(FileDescriptor));
-  /*
-  first, check that all files have the correct header
-  and number of data points
-  */
-  for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
-    sprintf(inp_fd.name, regex_name, object_num + 1);
-    inp_fd.handle = fopen(inp_fd.name, "rb");
-    if (!(inp_fd.handle)) {
-      return NOT_ENOUGH_OBJECTS;
+
+  result = read_dx_header(od, ar, object_num);
+  x_vars = od->x_vars;
+  if ((result == GRID_NOT_MATCHING) && interpolate) {
+    /*
+    data are collected and then resampled onto od->grid
+    */
+    x_vars = od->newgrid.x_vars;
+    *src_value = alloc_resample_buffer(od, object_num,
+      initial_field_num, 1);
+    if (!(*src_value)) {
+      return OUT_OF_MEMORY;
     }
-    result = read_dx_header(od, &inp_fd, object_num);
+    result = 0;
+  }
+  if (result) {
+    od->newgrid.object_num = object_num;
+    return result;
+  }
+  if (!object_num) {
+    /*
+    allocate one more field
+    */
+    result = alloc_x_var_array(od, 1);
     if (result) {
-      fclose(inp_fd.handle);
-      od->newgrid.object_num = object_num;
       return result;
     }
-    if (!alloc_field) {
-      /*
-      allocate one more field
-      */
-      result = alloc_x_var_array(od, 1);
-      if (result) {
-        fclose(inp_fd.handle);
-        return result;
-      }
-      alloc_field = 1;
+  }
+  memset(&varcoord, 0, sizeof(VarCoord));
+  for (n_grid_x_vars = 0; (n_grid_x_vars < x_vars)
+    && (!ascii_reader_get_token(ar, &token)); ++n_grid_x_vars) {
+    value = fast_strtod(token, &end);
+    if (end == token) {
+      break;
     }
-    n_grid_x_vars = 0;
-    n_read = 3;
-    memset(&varcoord, 0, sizeof(VarCoord));
-    while ((n_grid_x_vars < od->x_vars) && fgets(line, BUF_LEN, inp_fd.handle)) {
-      n_grid_x_vars += 3;
-      if (n_grid_x_vars > od->x_vars) {
-        n_read -= (n_grid_x_vars - od->x_vars);
-      }
-      sscanf(line, "%lf %lf %lf", &value[0], &value[1], &value[2]);
-      for (i = 0; i < n_read; ++i) {
-        result = set_x_value_xyz(od, od->field_num - 1,
-          object_num, &varcoord, value[i]);
-        if (result) {
-          fclose(inp_fd.handle);
-          return result;
-        }
-        ++varcoord.node[2];
-        if (varcoord.node[2] == od->grid.nodes[2]) {
-          varcoord.node[2] = 0;
-          ++varcoord.node[1];
-          if (varcoord.node[1] == od->grid.nodes[1]) {
-            varcoord.node[1] = 0;
-            ++varcoord.node[0];
-          }
-        }
+    result = set_imported_x_value(od, *src_value, initial_field_num,
+      initial_field_num, object_num, &varcoord, value);
+    if (result) {
+      return result;
+    }
+    ++varcoord.node[2];
+    if (varcoord.node[2] == od->newgrid.nodes[2]) {
+      varcoord.node[2] = 0;
+      ++varcoord.node[1];
+      if (varcoord.node[1] == od->newgrid.nodes[1]) {
+        varcoord.node[1] = 0;
+        ++varcoord.node[0];
       }
     }
-    fclose(inp_fd.handle);
   }
-  update_field_object_attr(od, VERBOSE_BIT);
+  
+  return 0;
+}
 
-  result = calc_active_vars(od, FULL_MODEL);
 
-  return 0;
+int import_opendx(O3Data *od, TaskInfo *task,
+  int object_num, int initial_field_num)
+{
+  int result;
+  float *src_value = NULL;
+  FILE *dx_in;
+  AsciiReader *ar;
+    
+
+  dx_in = fopen(task->string, "rb");
+  if (!dx_in) {
+    return NOT_ENOUGH_OBJECTS;
+  }
+  ar = open_ascii_reader(dx_in, NULL);
+  if (!ar) {
+    fclose(dx_in);
+    return OUT_OF_MEMORY;
+  }
+  result = read_opendx(od, ar, object_num, initial_field_num,
+    task->data[DATA_INTERPOLATE], &src_value);
+  close_ascii_reader(ar);
+  fclose(dx_in);
+  if (src_value) {
+    if (!result) {
+      result = resample_grid(od, src_value,
+        task->data[DATA_INTERPOLATE], object_num, initial_field_num);
+    }
+    free(src_value);
+  }
+
+  return result;
 }
@@ -155,6 +155,10 @@ char E_FILE_CANNOT_BE_OPENED_FOR_READING[] =
 char E_FILE_CORRUPTED_OR_IN_WRONG_FORMAT[] =
   "The %s file \"%s\" appears to be corrupted "
   "or in the wrong format.\n%s";
+char E_JOURNAL_NOT_MATCHING[] =
+  "The journal \"%s\" does not match the base file "
+  "\"%s\", which was probably modified after "
+  "the journal was created.\n%s";
 char E_OBJECTS_NOT_MATCHING[] =
   "None of objects indicated "
   "by the filename pattern \"%s\" "
@@ -384,6 +388,8 @@ char D_OPTIMAL_FAILED[] =
   "D_OPTIMAL failed.\n";
 char SRD_FAILED[] =
   "SRD failed.\n";
+char SWEEP_FAILED[] =
+  "SWEEP failed.\n";
 char PLOT_FAILED[] =
   "PLOT failed.\n";
 char SYSTEM_FAILED[] =
@@ -299,11 +299,13 @@ O3KeywordData keyword_data[] =
           "LOO",
           "LTO",
           "LMO",
+          "NESTED",
           NULL
         }
       }, {
         O3_PARAM_NUMERIC, "runs", {
           "20",
+          "AUTO",
           NULL
         }
       }, {
@@ -311,6 +313,21 @@ O3KeywordData keyword_data[] =
           "5",
           NULL
         }
+      }, {
+        O3_PARAM_NUMERIC, "inner_groups", {
+          "5",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "tolerance", {
+          "0.05",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "max_runs", {
+          "100",
+          NULL
+        }
       }, {
         O3_PARAM_PC, "pc", {
           NULL
@@ -319,6 +336,37 @@ O3KeywordData keyword_data[] =
         O3_PARAM_FILE, "file", {
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "algorithm", {
+          "NIPALS",
+          "KERNEL",
+          "IMPLICIT",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "precision", {
+          "DOUBLE",
+          "SINGLE",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "check_precision", {
+          "NO",
+          "YES",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "y_mode", {
+          "PLS2",
+          "PLS1",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "incremental", {
+          "NO",
+          "YES",
+          NULL
+        }
       }, {  // this is the terminator
         0, NULL, {
           NULL
@@ -391,6 +439,21 @@ O3KeywordData keyword_data[] =
         O3_PARAM_N_CPUS, "n_cpus", {
           NULL
         }
+      }, {
+        O3_PARAM_NUMERIC, "blas_threads", {
+          "AUTO",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "workers", {
+          "LOCAL",
+          "NONE",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "spawn", {
+          NULL
+        }
       }, {
         O3_PARAM_DIRECTORY, "babel_path", {
           NULL
@@ -609,6 +672,7 @@ O3KeywordData keyword_data[] =
       }, {
         O3_PARAM_NUMERIC, "runs", {
           "20",
+          "AUTO",
           NULL
         }
       }, {
@@ -616,6 +680,16 @@ O3KeywordData keyword_data[] =
           "5",
           NULL
         }
+      }, {
+        O3_PARAM_NUMERIC, "tolerance", {
+          "0.05",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "max_runs", {
+          "100",
+          NULL
+        }
       }, {
         O3_PARAM_PC, "pc", {
           NULL
@@ -665,6 +739,19 @@ O3KeywordData keyword_data[] =
           "YES",
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "algorithm", {
+          "NIPALS",
+          "KERNEL",
+          "IMPLICIT",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "precision", {
+          "DOUBLE",
+          "SINGLE",
+          NULL
+        }
       }, {  // this is the terminator
         0, NULL, {
           NULL
@@ -709,6 +796,13 @@ O3KeywordData keyword_data[] =
           "ALL",
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "interpolate", {
+          "NONE",
+          "TRILINEAR",
+          "TRICUBIC",
+          NULL
+        }
       }, {
         O3_PARAM_NUMERIC, "skip_header", {
           NULL
@@ -770,6 +864,17 @@ O3KeywordData keyword_data[] =
           "5",
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "algorithm", {
+          "NIPALS",
+          "RANDOMIZED",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "power_iterations", {
+          "2",
+          NULL
+        }
       }, {
         O3_PARAM_FILE, "file", {
           NULL
@@ -880,6 +985,29 @@ O3KeywordData keyword_data[] =
         O3_PARAM_FILE, "file", {
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "algorithm", {
+          "NIPALS",
+          "KERNEL",
+          "IMPLICIT",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "out_of_core", {
+          "NO",
+          "YES",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "memory", {
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "incremental", {
+          "NO",
+          "YES",
+          NULL
+        }
       }, {  // this is the terminator
         0, NULL, {
           NULL
@@ -1155,6 +1283,12 @@ O3KeywordData keyword_data[] =
         O3_PARAM_FILE, "file", {
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "mode", {
+          "FULL",
+          "INCREMENTAL",
+          NULL
+        }
       }, {  // this is the terminator
         0, NULL, {
           NULL
@@ -1257,6 +1391,7 @@ O3KeywordData keyword_data[] =
       }, {
         O3_PARAM_NUMERIC, "runs", {
           "20",
+          "AUTO",
           NULL
         }
       }, {
@@ -1264,6 +1399,16 @@ O3KeywordData keyword_data[] =
           "5",
           NULL
         }
+      }, {
+        O3_PARAM_NUMERIC, "tolerance", {
+          "0.05",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "max_runs", {
+          "100",
+          NULL
+        }
       }, {
         O3_PARAM_PC, "pc", {
           NULL
@@ -1298,6 +1443,19 @@ O3KeywordData keyword_data[] =
           "YES",
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "algorithm", {
+          "NIPALS",
+          "KERNEL",
+          "IMPLICIT",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "precision", {
+          "DOUBLE",
+          "SINGLE",
+          NULL
+        }
       }, {  // this is the terminator
         0, NULL, {
           NULL
@@ -1403,6 +1561,100 @@ O3KeywordData keyword_data[] =
         }
       }
     }
+  }, {
+    "sweep",
+    {
+      {
+        O3_PARAM_NUMERIC, "cutoff", {
+          "NONE",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "cutoff_type", {
+          "MAX",
+          "MIN",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "zero", {
+          "NONE",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "sdcut", {
+          "NONE",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "scaling", {
+          "NONE",
+          "AUTO",
+          "BUW",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "field_list", {
+          "ALL",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "pc", {
+          "5",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "type", {
+          "LOO",
+          "LTO",
+          "LMO",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "runs", {
+          "20",
+          "AUTO",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "groups", {
+          "5",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "tolerance", {
+          "0.05",
+          NULL
+        }
+      }, {
+        O3_PARAM_NUMERIC, "max_runs", {
+          "100",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "algorithm", {
+          "NIPALS",
+          "KERNEL",
+          "IMPLICIT",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "precision", {
+          "DOUBLE",
+          "SINGLE",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "y_mode", {
+          "PLS2",
+          "PLS1",
+          NULL
+        }
+      }, {  // this is the terminator
+        0, NULL, {
+          NULL
+        }
+      }
+    }
   }, {
     "system",
     {
@@ -1549,6 +1801,19 @@ O3KeywordData keyword_data[] =
           "YES",
           NULL
         }
+      }, {
+        O3_PARAM_STRING, "algorithm", {
+          "NIPALS",
+          "KERNEL",
+          "IMPLICIT",
+          NULL
+        }
+      }, {
+        O3_PARAM_STRING, "precision", {
+          "DOUBLE",
+          "SINGLE",
+          NULL
+        }
       }, {  // this is the terminator
         0, NULL, {
           NULL
@@ -46,6 +46,7 @@ E-mail: paolo.tosco@unito.it
 #include <stdio.h>
 #include <ctype.h>
 #include <errno.h>
+#include <locale.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
@@ -69,9 +70,18 @@ E-mail: paolo.tosco@unito.it
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+typedef int SOCKET;
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET  -1
+#endif
+#ifndef SOCKET_ERROR
+#define SOCKET_ERROR  -1
+#endif
+#define close_socket(sock)  close(sock)
 #else
 #include <windef.h>
 #include <winsock2.h>
+#define close_socket(sock)  closesocket(sock)
 #ifdef _TIMESPEC_DEFINED
 #define HAVE_STRUCT_TIMESPEC 1
 #endif
@@ -139,6 +149,7 @@ E-mail: paolo.tosco@unito.it
 #define rad2angle(x)      ((double)(x) / M_PI * 180.0)
 #define double_mat_alloc(m, n)    double_mat_resize(NULL, m, n)
 #define double_vec_alloc(size)    double_vec_resize(NULL, size)
+#define float_mat_alloc(m, n)    float_mat_resize(NULL, m, n)
 #define int_perm_alloc(size)    int_perm_resize(NULL, size)
 #define set_x_value_xyz(od, field_num, object_num, varcoord, value) \
   set_x_value(od, field_num, object_num, xyz_to_var(od, varcoord), value)
@@ -146,6 +157,7 @@ E-mail: paolo.tosco@unito.it
   set_x_value_unbuffered(od, field_num, object_num, xyz_to_var(od, varcoord), value)
 #define M_POKE(double_mat, m, n, value)  (double_mat)->base[(m) + (n) * ((double_mat)->max_m)] = value
 #define M_PEEK(double_mat, m, n)  ((double_mat)->base[(m) + (n) * ((double_mat)->max_m)])
+#define CV_PRED_VALUE(store, slot, x, pc)  ((store)->value[((size_t)(slot) * (store)->y_vars + (x)) * ((store)->pc_num + 1) + (pc)])
 #define MISSING(x)      (x > 1.0e36)
 #define INACTIVE(x)      (x < -1.0e36)
 #ifdef HAVE_LIBMKL
@@ -172,22 +184,40 @@ E-mail: paolo.tosco@unito.it
 #define BUF_LEN        1024
 #define LARGE_BUF_LEN      8192
 #define FZ_BUF_LEN      65536
+#define ASCII_READER_BUF_LEN      1048576
+#define ASCII_READER_SEPARATORS    "\t ,;\r\n"
 #define TITLE_LEN      60
 #define METADATA_LEN      72
 #define SHORT_PROMPT      "> "
 #define LOCALHOST_IP      "127.0.0.1"
 #define JMOL_FIRST_PORT      49152
 #define JMOL_LAST_PORT      65535
+#define WORKER_MAGIC      0x4f335157
+#define WORKER_PROTOCOL_VERSION    1
+#define WORKER_HELLO      1
+#define WORKER_JOB      2
+#define WORKER_TASK      3
+#define WORKER_RESULT      4
+#define WORKER_CV_JOB      1
+#define WORKER_FFDSEL_JOB    2
+#define WORKER_HANDSHAKE_TIMEOUT  5
+#define WORKER_MAX_JOB_LEN    ((size_t)1 << ((sizeof(size_t) > 4) ? 40 : 30))
 #define MOLDEN_INP_EXT      ".mdninp"
 #define GAMESS_PUNCH_EXT    ".dat"
 #define GAUSSIAN_CUBE_EXT    ".cube"
 #define TURBOMOLE_COSMO_EXT    ".cosmo"
 #define GRUB_FILENAME      "grub.dat"
+#define MOL_STORE_FILENAME    "molecules.mol"
+#define MMFF_STORE_FILENAME    "molecules.mmff"
 #define BABEL_PATH_ENV      "O3_BABEL_PATH"
 #define BABEL_DATADIR_ENV    "BABEL_DATADIR"
 #define BABEL_LIBDIR_ENV    "BABEL_LIBDIR"
 #define TEMP_DIR_ENV      "O3_TEMP_DIR"
 #define DAT_HEADER      "HEADER"
+#define JOURNAL_HEADER      "JOURNAL"
+#define JOURNAL_RECORD      "RECORD"
+#define JOURNAL_COMMIT      "COMMIT"
+#define JOURNAL_EXTENSION    ".jnl"
 #define SDF_DELIMITER      "$$$$"
 #define MOL_DELIMITER      "M  END"
 #define MD_GRID_PDB_FILE_HEADER    "# PDB FILE IN MD GRID FORMAT GENERATED BY "PACKAGE_NAME_UPPERCASE
@@ -262,6 +292,7 @@ E-mail: paolo.tosco@unito.it
 #define CANNOT_READ_GRID_DATA    323
 #define CANNOT_FIND_MO      324
 #define OBJECTS_NOT_MATCHING    330
+#define JOURNAL_NOT_MATCHING    331
 #define TIME_NOT_AVAILABLE    350
 #define CANNOT_CHANGE_DIR    370
 #define QM_ABNORMAL_TERMINATION    400
@@ -299,6 +330,7 @@ E-mail: paolo.tosco@unito.it
 #define OUT_FILE_NOT_EMPTY      590
 #define LOG_FILE_NOT_EMPTY      591
 #define BAD_DX_HEADER      600
+#define WORKER_CONNECTION_ERROR    610
 #define FL_CANNOT_CREATE_CHANNELS  (1<<0)
 #define FL_CANNOT_CREATE_PROCESS  (1<<1)
 #define FL_CANNOT_READ_OUT_FILE    (1<<2)
@@ -331,6 +363,7 @@ E-mail: paolo.tosco@unito.it
 #define DATA_BEST_OBJECT_NUM    1
 #define DATA_N_CONF      0
 #define DATA_N_CONF_OVERALL    1
+#define DATA_INTERPOLATE    0
 #define DELETED_CONF      1
 #define DELETE_CANDIDATE_CONF    2
 #define TEMPLATE_DB      0
@@ -346,6 +379,7 @@ E-mail: paolo.tosco@unito.it
 #define MOVED_CONF_NUM      3
 #define MAX_ATTEMPTS_FILE    10
 #define MAX_ATTEMPTS_JMOL    100
+#define MAX_ATTEMPTS_WORKER    600
 #define O3_MAX_SLOT      10
 #define MS_SLEEP_BEFORE_RETRY    100
 #define CLEAN_UP_SUFFIX      ".CLEAN_UP_DONT_DELETE_ME"
@@ -369,6 +403,7 @@ E-mail: paolo.tosco@unito.it
 #define SCRAMBLE_CV_MODEL    128
 #define EXTERNAL_PREDICTION    256
 #define SILENT_PLS      512
+#define OUT_OF_CORE_MODEL    1024
 #define MAX_FILES      36
 #define BINARY_IN      0
 #define ASCII_IN      1
@@ -404,6 +439,7 @@ E-mail: paolo.tosco@unito.it
 #define TEMP_MOLFILE      TEMP_START + 16
 #define TEMP_PYMOL      TEMP_START + 17
 #define TEMP_BABEL      TEMP_START + 18
+#define TEMP_SWEEP      TEMP_START + 19
 #define TEMP_FIELD_DATA      MAX_FILES
 #ifdef WIN32
 #define NORMAL_INK      BACKGROUND_BLUE | BACKGROUND_GREEN | BACKGROUND_RED | BACKGROUND_INTENSITY | FOREGROUND_BLUE
@@ -528,6 +564,7 @@ E-mail: paolo.tosco@unito.it
 #define MAX_FUNC_LEN      64
 #define MAX_VAR_BUF      2
 #define MAX_THREADS      32
+#define MAX_WORKERS      MAX_THREADS
 #define MAX_BONDS      10
 #define MAX_FF_N      2
 #define MAX_FF_PARM      4
@@ -555,7 +592,34 @@ E-mail: paolo.tosco@unito.it
 #define ALMOST_ZERO      1.0e-12
 #define SMALL_ENERGY_VALUE    1.0e-06
 #define PCA_CONV_THRESHOLD    1.0e-12
+#define NIPALS_PCA      0
+#define RANDOMIZED_PCA      1
+#define RANDOMIZED_PCA_OVERSAMPLING  10
+#define DEFAULT_PCA_POWER_ITERATIONS  2
+#define JACOBI_MAX_SWEEPS    100
 #define PLS_CONV_THRESHOLD    1.0e-04
+#define NIPALS_PLS      0
+#define KERNEL_PLS      1
+#define IMPLICIT_PLS      2
+#define PLS_DOUBLE_PRECISION    0
+#define PLS_SINGLE_PRECISION    1
+#define PLS2_Y_MODE      0
+#define PLS1_Y_MODE      1
+#define PLS_IN_CORE      0
+#define PLS_OUT_OF_CORE    1
+#define KERNEL_CV_BLOCK_SIZE    256
+#define GRAM_KEY_SEED      14695981039346656037ULL
+#define GRAM_KEY_PRIME      1099511628211ULL
+#define DEFAULT_PLS_MEMORY    1024.0
+#define DEFAULT_MAX_AUTO_LMO_RUNS  100
+#define MIN_AUTO_LMO_RUNS    5
+#define DEFAULT_AUTO_LMO_TOLERANCE  0.05
+#define SWEEP_CUTOFF      0
+#define SWEEP_ZERO      1
+#define SWEEP_SDCUT      2
+#define SWEEP_SCALE      3
+#define SWEEP_STAGES      4
+#define SWEEP_NONE      -1
 #define MSD_THRESHOLD      1.0e-07
 #define ENERGY_THRESHOLD    1.0e-12
 #define DEFAULT_MAX_ITER_ALIGN    200
@@ -644,6 +708,7 @@ E-mail: paolo.tosco@unito.it
 #define FOUR_LEVEL_BIT      (1<<12)
 #define SCRAMBLE_BIT      (1<<13)
 #define SDF_BIT        (1<<14)
+#define MODEL_ATTR_MASK      (ACTIVE_BIT | PREDICT_BIT)
 #define CALC_LEVERAGE_BIT      (1<<0)
 #define CALC_FIELD_CONTRIB_BIT      (1<<1)
 #define QMD_KEEP_INITIAL    (1<<0)
@@ -796,6 +861,8 @@ E-mail: paolo.tosco@unito.it
 #define GRID_ASCII_INPUT_FILE    5
 #define OPENDX_INPUT_FILE    6
 #define COSMO_INPUT_FILE    7
+#define TRILINEAR_INTERPOLATION    1
+#define TRICUBIC_INTERPOLATION    2
 #define GAUSSIAN_UNIT_NUMBER    30
 #define DONT_USE_WEIGHTS    0
 #define USE_MMFF_WEIGHTS    1
@@ -832,6 +899,7 @@ typedef struct PyMOLInfo PyMOLInfo;
 typedef struct JmolInfo JmolInfo;
 typedef struct DoubleMat DoubleMat;
 typedef struct DoubleVec DoubleVec;
+typedef struct FloatMat FloatMat;
 typedef struct IntPerm IntPerm;
 typedef struct NodeInfo NodeInfo;
 typedef struct RingInfo RingInfo;
@@ -847,9 +915,23 @@ typedef struct CationList CationList;
 typedef struct FFDSELInfo FFDSELInfo;
 typedef struct UVEPLSInfo UVEPLSInfo;
 typedef struct ScrambleInfo ScrambleInfo;
+typedef struct SweepInfo SweepInfo;
 typedef struct CVInfo CVInfo;
+typedef struct CVPredStore CVPredStore;
+typedef struct RandomStream RandomStream;
+typedef struct ModelInfo ModelInfo;
+typedef struct GramCache GramCache;
+typedef struct GramRow GramRow;
+typedef struct GramColumns GramColumns;
+typedef struct TaskQueue TaskQueue;
+typedef struct ThreadPool ThreadPool;
+typedef struct ThreadPoolWorker ThreadPoolWorker;
 typedef struct GnuplotInfo GnuplotInfo;
 typedef struct fzPtr fzPtr;
+typedef struct AsciiReader AsciiReader;
+typedef struct BlasInfo BlasInfo;
+typedef struct WorkerBuffer WorkerBuffer;
+typedef struct WorkerInfo WorkerInfo;
 #ifdef WIN32
 typedef unsigned __int64 uint64_t;
 #else
@@ -875,6 +957,16 @@ struct fzPtr {
   #endif
 };
 
+struct AsciiReader {
+  char *buf;
+  int size;
+  int len;
+  int pos;
+  int eof;
+  FILE *handle;
+  fzPtr *fz_handle;
+};
+
 struct CationList {
   char **cations;
 };
@@ -889,8 +981,10 @@ struct CLIArgs {
   char prompt;
   int input;
   int output;
+  int worker;
   char input_file[BUF_LEN];
   char output_file[BUF_LEN];
+  char worker_address[BUF_LEN];
 };
 
 struct VarCoord {
@@ -1087,6 +1181,10 @@ struct MolInfo {
   int done;
   int struct_num;
   int conf_num;
+  int mol_len;
+  int mmff_len;
+  long mol_offset;
+  long mmff_offset;
   double score;
   double ln_k;
   double exp_g_minus_ln_k;
@@ -1177,13 +1275,171 @@ struct FFDSELInfo {
   double combination_variable_ratio;
 };
 
+struct RandomStream {
+  int mti; /* mti==MERSENNE_N+1 means mt[MERSENNE_N] is not initialized */
+  unsigned long mt[MERSENNE_N]; /* the array for the state vector  */
+};
+
 struct CVInfo {
   int pc_num;
   int overall_cv_runs;
   int num_predictions;
   int n_threads;
+  int kernel_cv;
+  int implicit_cv;
+  int sp_cv;
+  int groups;
+  int active_struct_num;
+  int runs;
+  int auto_runs;
+  int runs_done;
+  int nested;
+  int inner_groups;
   double tss;
+  double kernel_c;
+  double runs_tolerance;
   void *cv_thread;
+  RandomStream group_stream;
+};
+
+struct CVPredStore {
+  int active;
+  int indexed;
+  int n_blocks;
+  int block_size;
+  int pc_num;
+  int y_vars;
+  int object_num;
+  int *block_len;
+  int *block_pc;
+  int *object_list;
+  int *first_slot;
+  int *next_slot;
+  size_t max_values;
+  double *value;
+};
+
+struct ModelInfo {
+  int valid;
+  int pc_num;
+  int x_vars;
+  int y_vars;
+  int score_rows;
+  unsigned long generation;
+  double *x_weights;
+  double *x_loadings;
+  double *y_loadings;
+  double *x_scores;
+  double *y_scores;
+  double *b_coefficients;
+  double *e_mat_ave;
+  double *f_mat_ave;
+};
+
+struct GramCache {
+  int valid;
+  int x_vars;
+  int reused;
+  int computed;
+  int added_vars;
+  int removed_vars;
+  int *var_list;
+  uint64_t *row_key;
+  DoubleMat *gram;
+  DoubleVec *shift;
+};
+
+struct GramRow {
+  uint64_t key;
+  int row;
+};
+
+struct GramColumns {
+  int *field;
+  int *var;
+  int *pos;
+  double *shift;
+};
+
+struct TaskQueue {
+  int n_tasks;
+  int next_task;
+  int stop_task;
+  int done_tasks;
+  int n_requeued;
+  int *done;
+  int *thread_num;
+  int *slot;
+  int *requeued;
+  struct timeval start;
+  #ifndef WIN32
+  pthread_mutex_t mutex;
+  #else
+  HANDLE mutex;
+  #endif
+};
+
+struct BlasInfo {
+  int max_threads;
+  int n_threads;
+  char *library;
+  void (*set_num_threads)(int);
+};
+
+struct WorkerBuffer {
+  size_t len;
+  size_t max_len;
+  size_t pos;
+  char *data;
+};
+
+struct WorkerInfo {
+  char exe[BUF_LEN];
+  char address[BUF_LEN];
+  int n_workers;
+  int n_spawned;
+  int dispatch;
+  int job_type;
+  int cv_type;
+  int n_tasks;
+  #ifndef WIN32
+  int listen_sock;
+  int sock[MAX_WORKERS];
+  pid_t pid[MAX_WORKERS];
+  #else
+  SOCKET listen_sock;
+  SOCKET sock[MAX_WORKERS];
+  HANDLE process[MAX_WORKERS];
+  #endif
+  WorkerBuffer job;
+};
+
+struct ThreadPoolWorker {
+  int num;
+  int generation;
+  ThreadPool *pool;
+};
+
+struct ThreadPool {
+  int n_workers;
+  int n_jobs;
+  int pending;
+  int generation;
+  int quit;
+  void *job;
+  ThreadInfo **thread_info;
+  ThreadPoolWorker worker[MAX_THREADS];
+  #ifndef WIN32
+  pthread_t thread_id[MAX_THREADS];
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  #else
+  HANDLE thread_handle[MAX_THREADS];
+  CRITICAL_SECTION mutex;
+  CONDITION_VARIABLE wake;
+  CONDITION_VARIABLE done;
+  #endif
 };
 
 struct UVEPLSInfo {
@@ -1213,6 +1469,21 @@ struct ScrambleInfo {
   int fit_order;
   int print_runs;
   double critical_point;
+  RandomStream order_stream;
+};
+
+struct SweepInfo {
+  int cv_type;
+  int groups;
+  int runs;
+  int pc_num;
+  int n_settings[SWEEP_STAGES];
+  int *type[SWEEP_STAGES];
+  int has_values[SWEEP_STAGES];
+  double *level[SWEEP_STAGES];
+  float *x_values[SWEEP_STAGES];
+  XData *x_data[SWEEP_STAGES];
+  unsigned char *journal_dirty;
 };
 
 struct GnuplotInfo {
@@ -1228,6 +1499,14 @@ struct DoubleMat {
   double *base;
 };
 
+struct FloatMat {
+  int m;
+  int n;
+  int max_m;
+  int max_n;
+  float *base;
+};
+
 struct DoubleVec {
   int size;
   int max_size;
@@ -1293,6 +1572,9 @@ struct MemList {
   char *ffdsel_included;
   char *uvepls_included;
   int *struct_per_group;
+  int *active_struct_list;
+  int *group_ready;
+  int *nested_pc;
   int *predicted_object_list;
   int *seed_count;
   int *seed_count_before_collapse;
@@ -1306,12 +1588,15 @@ struct MemList {
   int *candidate_pos;
   int *per_object_template;
   int *per_object_template_temp;
+  int *journal_origin;
+  unsigned char *journal_dirty;
 };
 
 struct ArrayList {
   char **done_objects;
   int **voronoi_composition;
   double **score_matrix;
+  GridInfo **newgrid_list;
   MolInfo **mol_info;
   TemplateInfo **candidate_template_object_list;
   VarCoord **seed_coord;
@@ -1340,6 +1625,7 @@ struct MatList {
   DoubleMat *hat_mat;
   DoubleMat *x_weights;
   DoubleMat *large_e_mat_ave;
+  DoubleMat *large_e_mat_sum;
   DoubleMat *b_coefficients;
   DoubleMat *b_coefficients_ave;
   DoubleMat *b_coefficients_sd;
@@ -1350,6 +1636,7 @@ struct MatList {
   DoubleMat *ordered_f_mat;
   DoubleMat *scrambled_f_mat;
   DoubleMat *large_f_mat_ave;
+  DoubleMat *large_f_mat_sum;
   DoubleMat *x_scores;
   DoubleMat *x_loadings;
   DoubleMat *x_loadings_tr;
@@ -1360,9 +1647,27 @@ struct MatList {
   DoubleMat *sorted_candidates_mat;
   DoubleMat *support_mat;
   DoubleMat *x_weights_star;
+  DoubleMat *kernel_mat;
+  DoubleMat *kernel_u;
+  DoubleMat *kernel_gram;
+  FloatMat *e_mat_sp;
+  FloatMat *f_mat_sp;
+  FloatMat *pls_sp_work;
+  DoubleMat *pls1_u;
+  DoubleMat *pls1_w;
+  DoubleMat *pls1_t;
+  DoubleMat *pls1_dual;
+  DoubleMat *pls1_coeff;
+  DoubleMat *pls2_s;
+  DoubleMat *pls2_m;
+  DoubleMat *pls2_g;
+  DoubleMat *pls2_work;
   DoubleMat *sdep_mat;
   DoubleMat *press;
   DoubleMat *ave_press;
+  DoubleMat *task_press;
+  DoubleMat *inner_press;
+  DoubleMat *nested_press;
   DoubleMat *cum_ave;
   DoubleMat *pos_ave;
   DoubleMat *neg_ave;
@@ -1387,12 +1692,22 @@ struct VecList {
   DoubleVec *v;
   DoubleVec *c;
   DoubleVec *v_new;
+  DoubleVec *kernel_t;
+  DoubleVec *kernel_w;
+  DoubleVec *kernel_g;
+  DoubleVec *deflation_coeff;
+  DoubleVec *implicit_work;
+  DoubleVec *pls1_z;
+  DoubleVec *pls2_z;
   DoubleVec *ro;
   DoubleVec *y_values_ave;
   DoubleVec *explained_s2_y;
   DoubleVec *dummy_e_mat_full_ave;
   DoubleVec *f_mat_full_ave;
   DoubleVec *f_mat_ave;
+  DoubleVec *fold_train_weight;
+  DoubleVec *fold_train_sqrt_weight;
+  DoubleVec *fold_out_weight;
   DoubleVec *active_value_ave;
   DoubleVec *ave_sdep;
   DoubleVec *best_sdep;
@@ -1418,6 +1733,9 @@ struct VecList {
 
 struct PermList {
   IntPerm *out_structs;
+  IntPerm *fold_train_rows;
+  IntPerm *fold_out_rows;
+  IntPerm *kernel_rows;
   IntPerm *numberlist[MAX_LIST];
   IntPerm *pymol_object_id;
   IntPerm *pymol_old_object_id;
@@ -1457,14 +1775,15 @@ struct O3Data {
   char temp_dir[BUF_LEN];
   char home_dir[BUF_LEN];
   char default_folder[BUF_LEN];
+  char journal_base[BUF_LEN];
   char prompt;
   char terminal;
+  char quiet;
   int debug;
   int n_proc;
   int error_code;
   int save_ram;
   int file_num;
-  int mti; /* mti==MERSENNE_N+1 means mt[MERSENNE_N] is not initialized */
   int object_num;
   int active_object_num;
   int ext_pred_object_num;
@@ -1479,12 +1798,19 @@ struct O3Data {
   int x_vars;
   int y_vars;
   int pc_num;
+  int pls_algorithm;
+  int pls_precision;
+  int pls_y_mode;
+  int pls_storage;
+  int pls_incremental;
+  int pls_block_vars;
   int mmap_field_num;
   int mmap_pagesize;
   int object_pagesize;
   uint64_t valid;
   unsigned long random_seed;
-  unsigned long mt[MERSENNE_N]; /* the array for the state vector  */
+  unsigned long attr_generation;
+  RandomStream mt_stream;
   double max_coord[3];
   double min_coord[3];
   FILE *in;
@@ -1505,10 +1831,18 @@ struct O3Data {
   PyMOLInfo pymol;
   JmolInfo jmol;
   CVInfo cv;
+  CVPredStore cv_pred;
   FFDSELInfo ffdsel;
   UVEPLSInfo uvepls;
   GnuplotInfo gnuplot;
   ScrambleInfo scramble;
+  SweepInfo sweep;
+  ModelInfo model;
+  GramCache gram;
+  TaskQueue queue;
+  ThreadPool *pool;
+  BlasInfo blas;
+  WorkerInfo workers;
   #ifndef WIN32
   struct termios *user_termios;
   pthread_t thread_id[MAX_THREADS];
@@ -1531,6 +1865,11 @@ struct ThreadInfo {
   int groups;
   int data[MAX_DATA_FIELDS];
   int cannot_write_temp_file;
+  int out_of_memory;
+  int worker_lost;
+  double busy_time;
+  TaskQueue *queue;
+  O3Data *workspace;
   FileDescriptor temp_pred;
   FileDescriptor temp_cv_coeff;
   O3Data od;
@@ -1543,6 +1882,10 @@ int add_to_list(IntPerm **list, int elem);
 int align_iterative(O3Data *od);
 int align_random(O3Data *od);
 int align(O3Data *od);
+int ascii_reader_count_lines(AsciiReader *ar);
+int ascii_reader_get_double(AsciiReader *ar, double *value);
+int ascii_reader_get_token(AsciiReader *ar, char **token);
+char *ascii_reader_gets(char *data, int len, AsciiReader *ar);
 #ifndef WIN32
 void *align_atombased_thread(void *pointer);
 void *align_single_pharao_thread(void *pointer);
@@ -1552,11 +1895,13 @@ DWORD align_atombased_thread(void *pointer);
 DWORD align_single_pharao_thread(void *pointer);
 DWORD align_multi_pharao_thread(void *pointer);
 #endif
+int accept_workers(O3Data *od);
 int alignment_exists(O3Data *od, FileDescriptor *sdf_fd);
 char **alloc_array(int n, int size);
 CharMat *alloc_char_matrix(CharMat *old_char_mat, int m, int n);
 ConfInfo *alloc_conf(int n_atoms);
 int alloc_average_mat(O3Data *od, int model_type, int cv_type, int groups, int runs);
+int alloc_cv_pred(O3Data *od, int pc_num, int cv_type);
 int alloc_cv_sdep(O3Data *od, int pc_num, int runs);
 int alloc_file_descriptor(O3Data *od, int file_num);
 int *alloc_int_array(int *old_ptr, int places);
@@ -1564,7 +1909,9 @@ IntMat *alloc_int_matrix(IntMat *old_int_mat, int m, int n);
 int alloc_lap_info(LAPInfo *li, int max_n_atoms);
 int alloc_object_attr(O3Data *od, int start);
 int alloc_pls(O3Data *od, int x_vars, int pc_num, int model_type);
+float *alloc_resample_buffer(O3Data *od, int object_num, int initial_field_num, int n_fields);
 int prepare_scrambling(O3Data *od);
+int alloc_thread_pool(O3Data *od);
 int alloc_threads(O3Data *od);
 int alloc_voronoi(O3Data *od, int places);
 int alloc_x_var_array(O3Data *od, int num_fields);
@@ -1574,8 +1921,9 @@ int autoscale_y_var(O3Data *od);
 int average_x_var(O3Data *od, int field_num);
 void average_y_var(O3Data *od);
 int bond_in_aromatic_ring(RingInfo **ring, int *a);
-int break_sdf_to_mol(O3Data *od, TaskInfo *task, FileDescriptor *from_fd, char *to_dir);
 int break_sdf_to_sdf(O3Data *od, TaskInfo *task, FileDescriptor *from_fd, char *to_dir);
+void cache_pls_coefficients(O3Data *od, int pc_num);
+int cache_pls_model(O3Data *od);
 int calc_active_vars(O3Data *od, int model_type);
 void calc_conf_centroid(ConfInfo *conf, double *centroid);
 double calc_delta_ij(O3Data *od, DoubleMat *dispersion_mat, int i, int j);
@@ -1583,7 +1931,9 @@ double calc_dxi(O3Data *od, DoubleMat *dispersion_mat, DoubleMat *candidates_mat
 double calc_dxixj(O3Data *od, DoubleMat *dispersion_mat, int i, int j);
 double calc_dxixj(O3Data *od, DoubleMat *dispersion_mat, int i, int j);
 int calc_field(O3Data *od, void *thread_func, int prep_or_calc);
-void calc_large_mat_ave(O3Data *od, DoubleMat *large_mat, DoubleMat *large_mat_ave, int run);
+double calc_fold_column_ave(O3Data *od, DoubleMat *large_mat, DoubleMat *large_mat_sum, int x);
+void calc_large_mat_ave(O3Data *od, DoubleMat *large_mat, DoubleMat *large_mat_sum, DoubleMat *large_mat_ave, int run);
+int calc_large_mat_sum(O3Data *od, DoubleMat *large_mat, DoubleMat **large_mat_sum);
 #ifndef WIN32
 void *calc_cosmo_thread(void *pointer);
 void *calc_md_grid_thread(void *pointer);
@@ -1606,12 +1956,21 @@ int check_conf_db(O3Data *od, char *conf_dir, int type, int *wrong_object_id, in
 int check_define(O3Data *od, char *bin);
 int check_duplicate_parameter(int **max_vary, int *parameter);
 int check_file_pattern(FILE *handle, char *file_pattern, int object_num);
+int check_lmo_convergence(O3Data *od, int runs_done, int pc_num);
 int check_lmo_parameters(O3Data *od, char *tool_msg, int *groups, int *runs, int run_type, int overall_line_num);
+int check_pls_algorithm(O3Data *od, char *tool_msg, int run_type, int overall_line_num);
+int check_pls_incremental(O3Data *od, char *tool_msg, int run_type, int overall_line_num);
+int check_pls_out_of_core(O3Data *od, char *tool_msg, int run_type, int overall_line_num);
+int check_pls_precision(O3Data *od, char *tool_msg, int run_type, int overall_line_num);
+int check_pls_y_mode(O3Data *od, char *tool_msg, int run_type, int overall_line_num);
 int check_mmap(O3Data *od, int field_num);
 int check_pharao(O3Data *od, char *bin);
 void *check_readline();
 int check_regex_name(char *regex_name, int n_regex);
+void close_ascii_reader(AsciiReader *ar);
 void close_files(O3Data *od, int from);
+void close_task_queue(O3Data *od, ThreadInfo **thread_info, int n_threads);
+void close_workers(O3Data *od);
 int compare(O3Data *od, O3Data *od_comp, int type, int verbose);
 #ifndef WIN32
 void *compare_thread(void *pointer);
@@ -1622,6 +1981,7 @@ int compare_bond_info(const void *a, const void *b);
 int compare_bond_list(const void *a, const void *b);
 int compare_conf_energy(const void *a, const void *b);
 int compare_corr(const void *a, const void *b);
+int compare_cv_precision(O3Data *od, int pc_num, int cv_type, int groups, int runs);
 int compare_dist(const void *a, const void *b);
 int compare_integers(const void *a, const void *b);
 int compare_n_phar_points(const void *a, const void *b);
@@ -1629,10 +1989,14 @@ int compare_regex_data(const void *a, const void *b);
 int compare_score(const void *a, const void *b);
 int compare_template_score(const void *a, const void *b);
 int compare_seed_dist(const void *a, const void *b);
+void complete_task(ThreadInfo *ti, int task);
 void compute_conf_h(ConfInfo *conf);
 int compute_cost_matrix(LAPInfo *li, ConfInfo *moved_conf, ConfInfo *template_conf, int n_bins, int coeff, int options);
+SOCKET connect_socket(struct sockaddr *sa, int sa_len, int max_attempts);
+int connect_worker(O3Data *od, char *address);
 int convert_mol(O3Data *od, char *from_filename, char *to_filename, char *from_ext, char *to_ext, char *flags);
 void copy_plane_to_buffer(O3Data *od, float *float_xy_mat, float *buf_float_xy_mat);
+void copy_pls_workspace(O3Data *dest, O3Data *src);
 int create_box(O3Data *od, GridInfo *temp_grid, double outgap, int from_file);
 int create_design_support_matrices(O3Data *od, DoubleMat *candidates_mat, int design_points);
 int cutoff(O3Data *od, int type, double cutoff);
@@ -1646,6 +2010,7 @@ void double_mat_free(DoubleMat *double_mat);
 void double_vec_free(DoubleVec *double_vec);
 DoubleVec *double_vec_resize(DoubleVec *double_vec, int size);
 DoubleVec *double_vec_sort(DoubleVec *x, IntPerm *order);
+void drop_worker(O3Data *od, int n);
 void determine_best_cpu_number(O3Data *od, char *parameter);
 int dexist(char *dirname);
 void double_mat_free(DoubleMat *double_mat);
@@ -1664,6 +2029,7 @@ int exclude(O3Data *od, int type, int ref_field);
 void ext_program_wait(ProgExeInfo *prog_exe_info, int pid);
 int ext_program_exe(ProgExeInfo *prog_exe_info, int *error);
 int fcopy(char *from_filename, char *to_filename, char *mode);
+double fast_strtod(char *str, char **endptr);
 int fexist(char *filename);
 int ffdsel(O3Data *od, int pc);
 #ifndef WIN32
@@ -1671,6 +2037,7 @@ void *ffdsel_thread(void *pointer);
 #else
 DWORD ffdsel_thread(void *pointer);
 #endif
+void ffdsel_task(ThreadInfo *ti, int i);
 int fgrep(FILE *handle, char *buffer, char *grep_key);
 int fill_atom_info(O3Data *od, TaskInfo *task, AtomInfo **atom, BondList **bond_list, int object_num, char force_field);
 int fill_date_string(char *date_string);
@@ -1680,6 +2047,9 @@ char **fill_env(O3Data *od, EnvList personalized_env[], char *bin, int object_nu
 #else
 char *fill_env(O3Data *od, EnvList personalized_env[], char *bin, int object_num);
 #endif
+void fill_fold_rows(O3Data *od);
+int fill_group_composition(O3Data *od, int run);
+void fill_kernel_x_vector(O3Data *od, int object_num, int row);
 int fill_numberlist(O3Data *od, int len, int type);
 int fill_tinker_bond_info(O3Data *od, FileDescriptor *inp_fd, AtomInfo **atom, BondList **bond_list, int object_num);
 int fill_tinker_types(AtomInfo **atom);
@@ -1689,7 +2059,7 @@ int fill_x_matrix(O3Data *od, int model_type, int use_srd_groups);
 int fill_x_matrix_scrambled(O3Data *od);
 void fill_x_vector(O3Data *od, int object_num, int row, int model_type, int cv_run);
 int fill_y_matrix(O3Data *od);
-int fill_y_matrix_scrambled(O3Data *od);
+int fill_y_matrix_scrambled(O3Data *od, int scramble_run);
 void fill_y_vector(O3Data *od, int object_num, int row, int model_type, int cv_run);
 int filter(O3Data *od);
 int filter_extract_split_phar_thread(void *pointer);
@@ -1699,19 +2069,30 @@ int filter_sol_vector(LAPInfo *li, ConfInfo *moved_conf, ConfInfo *template_conf
 int find_atom_type(O3Data *od, int nb_pos, AtomInfo *atom);
 int find_conformation_in_sdf(FILE *handle_in, FILE *handle_out, int conf_num);
 int find_vary_speed(O3Data *od, char *name_list, int **max_vary, int **vary, int *field_num, int *object_num, VarCoord *varcoord);
+int finish_worker_tasks(O3Data *od, void *job, int n_threads);
 void fix_endianness(void *chunk, int chunk_len, int word_size, int swap_endianness);
+void float_mat_free(FloatMat *float_mat);
+FloatMat *float_mat_resize(FloatMat *float_mat, int m, int n);
 int fmove(char *filename1, char *filename2);
 void free_cv_groups(O3Data *od, int runs);
+void free_cv_pred(O3Data *od);
 void free_cv_sdep(O3Data *od);
+void free_gram_cache(O3Data *od);
+void free_kernel_cv(O3Data *od);
+void free_large_mat_sum(O3Data *od);
 void free_parallel_cv(O3Data *od, ThreadInfo **thread_info, int model_type, int cv_type, int runs);
 void free_pls(O3Data *od);
+void free_sweep(O3Data *od);
 void free_array(void *array);
 void free_atom_array(O3Data *od);
 void free_char_matrix(CharMat *char_mat);
 void free_conf(ConfInfo *conf);
 void free_lap_info(LAPInfo *li);
 void free_mem(O3Data *od);
+void free_model_cache(O3Data *od);
 void free_node(NodeInfo *fnode, int **path, RingInfo **ring, int n_atoms);
+void free_task_queue(O3Data *od);
+void free_thread_pool(O3Data *od);
 void free_threads(O3Data *od);
 void free_x_var_array(O3Data *od);
 void free_y_var_array(O3Data *od);
@@ -1733,25 +2114,32 @@ void fzrewind(fzPtr *fz_ptr);
 int fzseek(fzPtr *fz_ptr, long int offset, int whence);
 unsigned long genrand_int32(O3Data *od);
 double genrand_real(O3Data *od);
+unsigned long genrand_stream_int32(RandomStream *rs);
+double genrand_stream_real(RandomStream *rs);
 int get_alignment_score(O3Data *od, FileDescriptor *fd, int object_num, double *score, int *best_template_object_num);
 char *get_args(O3Data *od, char *parameter_name);
 void get_attr_struct_ave(O3Data *od, int y_var, uint16_t attr, int *attr_struct_num, double *attr_value_ave);
+int get_blas_threads(O3Data *od, int n_workers);
 char *get_basename(char *filename);
 int get_current_time(char *time_string);
 int get_cv_coeff(O3Data *od, int cv_run, int y, int x, double *cv_coeff, int save_ram);
+int get_cv_pred_sum(O3Data *od, int object_num, int x, int pc_num, double *sum);
 int get_datafile_coord(O3Data *od, FileDescriptor *data_fd, int n_atom, int n_total_atoms, int *cube_word_size, double *data_coord, int datafile_type);
 char *get_dirname(char *filename);
-int get_double_from_ascii_file(FILE *handle, char *read_buffer, int read_buffer_size, char **context, char **ptr, int *back, double *value);
 uint16_t get_field_attr(O3Data *od, int field_num, uint16_t attr);
 int get_gridkont_data_points(O3Data *od, int new_model, int replace_object_name, int endianness_switch, int dry_run);
+void get_journal_name(char *journal_name, char *dat_name);
+int get_next_task(ThreadInfo *ti);
 int get_number_of_procs();
 int get_n_atoms_bonds(MolInfo *mol_info, FILE *handle, char *buffer);
 uint16_t get_object_attr(O3Data *od, int object_num, uint16_t attr);
+void get_scrambling_order(O3Data *od, int scramble_run);
 #ifdef WIN32
 BOOL GetOSDisplayString(LPTSTR pszOS, int *page_size);
 #endif
 void get_system_information(O3Data *od);
 int get_voronoi_buf(O3Data *od, int field_num, int x_var);
+int get_worker_data(WorkerBuffer *buf, void *data, size_t len);
 int get_x_value(O3Data *od, int field_num, int object_num, int x_var, double *value, int flag);
 uint16_t get_x_var_attr(O3Data *od, int field_num, int x_var, uint16_t attr);
 double get_x_var_buf(O3Data *od, int field_num, int x_var, int buf_num);
@@ -1759,19 +2147,30 @@ double get_y_value(O3Data *od, int object_num, int y_var, int flag);
 uint16_t get_y_var_attr(O3Data *od, int y_var, uint16_t attr);
 double get_y_var_buf(O3Data *od, int y_var, int buf_num);
 char *get_y_var_name(char *buffer, char *y_name);
+void gram_cache_kernel(O3Data *od, DoubleMat *k_mat);
 int grid_write(O3Data *od, char *filename, int pc_num, int type, int sign, int format, int label, int interpolate, int requested_endianness);
+void implicit_cv_fold(O3Data *od);
 int import_dependent(O3Data *od, char *name_list);
 int import_free_format(O3Data *od, char *name_list, int skip_header, int *n_values);
-int import_grid_ascii(O3Data *od, char *regex_name);
-int import_opendx(O3Data *od, char *regex_name);
-int import_grid_formatted_cube(O3Data *od, int mo);
-int import_grid_unformatted_cube(O3Data *od, int mo);
+int import_grid_ascii(O3Data *od, TaskInfo *task, int object_num, int initial_field_num);
+int import_opendx(O3Data *od, TaskInfo *task, int object_num, int initial_field_num);
+int import_grid_formatted_cube(O3Data *od, TaskInfo *task, int object_num, int initial_field_num, int mo);
+int import_grid_unformatted_cube(O3Data *od, TaskInfo *task, int object_num, int initial_field_num, int mo);
 int import_gridkont(O3Data *od, int replace_object_name);
-int import_grid_moe(O3Data *od, char *regex_name);
-int import_grid_molden(O3Data *od);
+int import_grid_moe(O3Data *od, TaskInfo *task, int object_num, int initial_field_num);
+int import_grid_molden(O3Data *od, TaskInfo *task, int object_num, int initial_field_num);
+int import_grid_parallel(O3Data *od, int multi_file_type, char *regex_name, int mo, int interpolate);
+#ifndef WIN32
+void *import_grid_thread(void *pointer);
+#else
+DWORD import_grid_thread(void *pointer);
+#endif
+void init_blas_threads(O3Data *od);
 void init_cv_sdep(O3Data *od);
 void init_genrand(O3Data *od, unsigned long s);
+void init_journal(O3Data *od, char *dat_name);
 void init_pls(O3Data *od);
+int init_task_queue(O3Data *od, ThreadInfo **thread_info, int n_threads, int n_tasks);
 void int_perm_free(IntPerm *int_perm);
 IntPerm *int_perm_resize(IntPerm *int_perm, int size);
 DoubleMat *int_perm_rows(IntPerm *perm, DoubleMat *double_mat1, DoubleMat *double_mat2);
@@ -1781,9 +2180,13 @@ int is_aromatic_bond(BondList **bond_list, int a1, int a2);
 int is_in_list(IntPerm *list, int elem);
 int is_in_path(char *program, char *path_to_program);
 int join_aligned_files(O3Data *od, int done_array_pos, char *error_filename);
-int join_mol_to_sdf(O3Data *od, TaskInfo *task, FileDescriptor *to_fd, char *from_dir);
 int join_thread_files(O3Data *od, ThreadInfo **thread_info);
 int k_exchange(O3Data *od, DoubleMat *dispersion_mat);
+void kernel_cv_fold(O3Data *od, int active_object_num);
+void kernel_pls(O3Data *od, int suggested_pc_num, int model_type);
+void kernel_pls_extract(O3Data *od, int pc_num, int model_type);
+void kernel_pls_normalize(O3Data *od, int pc_num);
+void kernel_pls_resize(O3Data *od, int m, int n, int pc_num);
 void lap(LAPInfo *li, int dim);
 #ifndef WIN32
 void *lmo_cv_thread(void *pointer);
@@ -1794,7 +2197,12 @@ DWORD lmo_cv_thread(void *pointer);
 DWORD loo_cv_thread(void *pointer);
 DWORD lto_cv_thread(void *pointer);
 #endif
+int listen_workers(O3Data *od, char *address);
+void lmo_cv_task(ThreadInfo *ti, int j);
+void loo_cv_task(ThreadInfo *ti, int i);
+void lto_cv_task(ThreadInfo *ti, int i);
 int load_dat(O3Data *od, int file_id, int options);
+int load_dat_journal(O3Data *od, int file_id, int options);
 int machine_type();
 int match_grids(O3Data *od);
 int match_objects_with_datafile(O3Data *od, char *file_pattern, int datafile_type);
@@ -1804,7 +2212,15 @@ char *mkdtemp(char *tmpl);
 #ifndef HAVE_MKSTEMP
 int mkstemp(char *tmpl);
 #endif
+int model_cache_valid(O3Data *od);
 int mol_to_sdf(O3Data *od, int object_num, double actual_value);
+void nested_cv_task(ThreadInfo *ti, int j);
+#ifndef WIN32
+void *nested_cv_thread(void *pointer);
+#else
+DWORD nested_cv_thread(void *pointer);
+#endif
+int newgrid_xyz_to_var(O3Data *od, VarCoord *varcoord);
 int nlevel(O3Data *od);
 char *o3_completion_generator(const char *text, int state);
 char **o3_completion_matches(const char *text, int start, int end);
@@ -1812,19 +2228,28 @@ char **o3_completion_matches(const char *text, int start, int end);
 void o3_compentry_free(void *mem);
 #endif
 char *o3_get_keyword(int *keyword_len);
+AsciiReader *open_ascii_reader(FILE *handle, fzPtr *fz_handle);
+int open_mmff_record(O3Data *od, FileDescriptor *mmff_fd, int object_num);
+int open_mol_record(O3Data *od, FileDescriptor *mol_fd, int object_num);
 int open_perm_dir(O3Data *od, char *root_dir, char *id_string, char *perm_dir_name);
 int open_temp_dir(O3Data *od, char *root_dir, char *id_string, char *temp_dir_name);
 int open_temp_file(O3Data *od, FileDescriptor *file_descriptor, char *id_string);
 void overall_msd(AtomPair *sdm, int pairs, ConfInfo *moved_conf, ConfInfo *template_conf, double *heavy_msd);
+size_t max_worker_result_len(ThreadInfo *ti);
+int pack_worker_job(O3Data *od, int x_vars, int model_type, int cv_type, int pc_num, int groups, int runs, int n_tasks);
+int pack_worker_result(ThreadInfo *ti, int task, WorkerBuffer *buf);
+int pack_worker_task(ThreadInfo *ti, int task, WorkerBuffer *buf);
 int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num, int model_type, int cv_type, int groups, int runs);
 int parse_comma_hyphen_list_to_array(O3Data *od, char *list, int list_number);
 double parse_grid_ascii_line(char *line, char *parsed_line, VarCoord *varcoord);
 int parse_input(O3Data *od, FILE *input_stream, int run_type);
 int parse_o3_line(char *buffer);
 int parse_sdf(O3Data *od, int options, char *name_list);
+int parse_sweep_list(O3Data *od, int stage, int type, char *list);
 void parse_sdf_coord_line(int sdf_version, char *buffer, char *element, double *coord, int *charge);
 int parse_synonym_lists(O3Data *od, char *tool_name, char *tool_msg, int synonym_list, int *list_type, int default_list, int run_type, int overall_line_num);
-int pca(O3Data *od, int pc_num);
+int pca(O3Data *od, int pc_num, int algorithm, int power_iterations);
+int pca_randomized(O3Data *od, int pc_num, int power_iterations);
 double pearson_r(DoubleMat *mat, int *x, int check_missing, double missing);
 double perform_operation(int type, double value, double factor);
 #ifndef WIN32
@@ -1834,11 +2259,18 @@ DWORD phar_extract_thread(void *pointer);
 #endif
 int plot(O3Data *od, char *filename, int type, int label, int requested_pc_num, int *pc_axis);
 void pls(O3Data *od, int suggested_pc_num, int model_type);
+void pls1_batch(O3Data *od, int suggested_pc_num, int model_type);
+void pls2_block(O3Data *od, int suggested_pc_num, int model_type);
+int pls_out_of_core(O3Data *od, int suggested_pc_num);
+void pls_sp(O3Data *od, int suggested_pc_num, int model_type);
 int pred_ext_y_values(O3Data *od, int pc_num, int model_type);
 int predict(O3Data *od, int pc_num);
 int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv_run);
 int preload_best_templates(O3Data *od, FileDescriptor *fd, int *skip, double *score);
 int prepare_cv(O3Data *od, int pc_num, int cv_type, int groups, int runs);
+void prepare_implicit_cv(O3Data *od);
+int prepare_kernel_cv(O3Data *od);
+void prepare_sp_cv(O3Data *od);
 void prepare_design_model(O3Data *od, int design_row);
 void prepare_rototrans_matrix(double *rt_mat, double *t_mat1, double *t_mat2, double *rad);
 int prep_cosmo_input(O3Data *od, TaskInfo *task, AtomInfo **atom, int object_num);
@@ -1847,11 +2279,15 @@ void prep_moe_grid_input(O3Data *od);
 int prep_molden_input(O3Data *od, int object_num);
 int prep_qm_input(O3Data *od, TaskInfo *task, AtomInfo **atom, int object_num);
 void prep_sybyl_input(O3Data *od);
+void print_blas_threads(O3Data *od);
 int print_calc_values(O3Data *od, int options);
 void print_debug_info(O3Data *od, TaskInfo *task);
 int print_ext_pred_values(O3Data *od);
+void print_gram_cache_update(O3Data *od);
 void print_grid_comparison(O3Data *od);
 void print_grid_coordinates(O3Data *od, GridInfo *grid_info);
+void print_lmo_convergence(O3Data *od, int runs);
+void print_nested_cv(O3Data *od, int runs, double tss);
 int print_pred_values(O3Data *od);
 void print_pls_scores(O3Data *od, int options);
 int print_variables(O3Data *od, int type);
@@ -1861,16 +2297,18 @@ void program_signal_handler(int signum);
 BOOL program_signal_handler(DWORD fdwCtrlType);
 #endif
 void pseudo_seed_coord(O3Data *od, int field_num, int *seed);
+int put_worker_data(WorkerBuffer *buf, void *data, size_t len);
 int qmd(O3Data *od);
 #ifndef WIN32
 void *qmd_thread(void *pointer);
 #else
 DWORD qmd_thread(void *pointer);
 #endif
-int read_dx_header(O3Data *od, FileDescriptor *inp_fd, int object_num);
+int read_dx_header(O3Data *od, AsciiReader *ar, int object_num);
 void read_tinker_xyz_n_atoms_energy(char *line, int *n_atoms, double *energy);
 int realloc_x_var_array(O3Data *od, int old_object_num);
 int realloc_y_var_array(O3Data *od, int old_object_num);
+int recv_worker_msg(WorkerInfo *workers, int n, int *type, WorkerBuffer *buf, size_t max_len);
 int reload_coefficients(O3Data *od, int pc_num);
 int reload_weights_loadings(O3Data *od);
 void remove_box(O3Data *od);
@@ -1885,6 +2323,8 @@ void remove_temp_files(char *basename);
 int remove_with_prefix(char *temp_dir_string, char *prefix);
 int remove_x_vars(O3Data *od, uint16_t attr);
 int remove_y_vars(O3Data *od);
+void requeue_task(ThreadInfo *ti, int task);
+int resample_grid(O3Data *od, float *src_value, int interpolate, int object_num, int initial_field_num);
 int replace_coord(int sdf_version, char *buffer, double *coord);
 void replace_orig_y(O3Data *od);
 void reset_user_terminal(O3Data *od);
@@ -1892,32 +2332,42 @@ void restore_orig_y(O3Data *od);
 int rms_algorithm(int options, AtomPair *sdm, int pairs, ConfInfo *moved_conf, ConfInfo *template_conf, ConfInfo *fitted_conf, double *rt_mat, double *heavy_msd, double *original_heavy_msd);
 int rms_algorithm_multi(O3Data *od, O3Data *od_comp, double *rt_mat, double *heavy_msd);
 int rototrans(O3Data *od, char *out_sdf_name, double *trans, double *rot);
+int run_thread_pool(O3Data *od, void *job, int n_threads);
+int run_worker(O3Data *od, char *address);
 int save_dat(O3Data *od, int file_id);
+int save_dat_journal(O3Data *od, int file_id, int *record_num);
 double score_alignment(O3Data *od, ConfInfo *template_conf, ConfInfo *fitted_conf, AtomPair *sdm, int pairs);
 int scramble(O3Data *od, int pc_num);
 int sdcut(O3Data *od, double threshold);
 int sdm_algorithm(AtomPair *sdm, ConfInfo *moved_conf, ConfInfo *template_conf, char **used, int options, double threshold);
 int send_jmol_command(O3Data *od, char *command);
+int send_worker_msg(WorkerInfo *workers, int n, int type, WorkerBuffer *buf);
 int set_sel_included_bit(O3Data *od, int use_srd_groups);
 void set_voronoi_buf(O3Data *od, int field_num, int x_var, int voronoi_num);
+void sp_cv_fold(O3Data *od);
+int spawn_workers(O3Data *od, int n);
 int srd(O3Data *od, int pc_num, int seed_num, int type, int collapse, double critical_distance, double collapse_distance);
 int store_weights_loadings(O3Data *od);
 int set(O3Data *od, int type, uint16_t attr, int state, int verbose);
+void set_blas_threads(O3Data *od, int n_workers);
 void set_field_attr(O3Data *od, int field_num, uint16_t attr, int onoff);
 void set_field_weight(O3Data *od, double weight);
 void set_grid_point(O3Data *od, float *float_xy_mat, VarCoord *varcoord, double value);
+int set_imported_x_value(O3Data *od, float *src_value, int field_num, int initial_field_num, int object_num, VarCoord *varcoord, double value);
 void set_nice_value(O3Data *od, int nice_value);
 void set_object_attr(O3Data *od, int object_num, uint16_t attr, int onoff);
 int set_object_weight(O3Data *od, double weight, int list_type, int options);
 void set_random_seed(O3Data *od, unsigned long seed);
 int set_x_value(O3Data *od, int field_num, int object_num, int x_var, double value);
 int set_x_value_unbuffered(O3Data *od, int field_num, int object_num, int x_var, double value);
+int set_x_z_plane_unbuffered(O3Data *od, int field_num, int object_num, int z, float *z_plane);
 void set_x_var_attr(O3Data *od, int field_num, int x_var, uint16_t attr, int onoff);
 void set_x_var_buf(O3Data *od, int field_num, int x_var, int buf_num, double value);
 void set_y_value(O3Data *od, int object_num, int y_var, double value);
 void set_y_var_attr(O3Data *od, int y_var, uint16_t attr, int onoff);
 void set_y_var_buf(O3Data *od, int y_var, int buf_num, double value);
 void set_y_var_weight(O3Data *od, double weight);
+void skip_genrand_stream(RandomStream *rs, unsigned long n);
 void slash_to_backslash(char *string);
 double squared_euclidean_distance(double *coord1, double *coord2);
 void string_to_lowercase(char *string);
@@ -1928,6 +2378,7 @@ char *strtok_r(char *s1, const char *s2, char **lasts);
 #endif
 int superpose_conf_lap(LAPInfo *li, ConfInfo *moved_conf, ConfInfo *template_conf, ConfInfo *fitted_conf, ConfInfo *progress_conf, AtomPair *temp_sdm, AtomPair *fitted_sdm, char **used, double *rt_mat, double *heavy_msd, double *original_heavy_msd, int *pairs);
 int superpose_conf_syst(ConfInfo *moved_conf, ConfInfo *template_conf, ConfInfo *fitted_conf, ConfInfo *progress_conf, ConfInfo *cand_conf, AtomPair *sdm, AtomPair *local_best_sdm, AtomPair *fitted_sdm, char **used, double *rt_mat, int angle_step, double *heavy_msd, double *original_heavy_msd, int *pairs);
+int sweep(O3Data *od);
 void sync_field_mmap(O3Data *od);
 int exe_shell_cmd(O3Data *od, char *command, char *exedir, char *shell);
 int tanimoto(O3Data *od, int ref_struct);
@@ -1940,21 +2391,31 @@ int tinker_minimize(O3Data *od, char *work_dir, char *xyz, char *xyz_min, int ob
 int tinker_dynamic(O3Data *od, char *work_dir, char *xyz, int object_num, int conf_num, unsigned long seed);
 int transform(O3Data *od, int type, int operation, double value);
 void trim_mean_center_x_matrix_pca(O3Data *od);
-void trim_mean_center_matrix(O3Data *od, DoubleMat *large_mat, DoubleMat **mat,
-  DoubleVec **mat_ave, int model_type, int active_object_num);
+void trim_mean_center_matrix(O3Data *od, DoubleMat *large_mat, DoubleMat *large_mat_sum,
+  DoubleMat **mat, DoubleVec **mat_ave, int model_type, int active_object_num);
 void trim_mean_center_x_matrix_hp(O3Data *od, int model_type, int active_object_num, int run);
 void trim_mean_center_y_matrix_hp(O3Data *od, int active_object_num, int run);
+int unpack_worker_job(O3Data *od);
+int unpack_worker_result(ThreadInfo *ti, int task, WorkerBuffer *buf);
+int unpack_worker_task(ThreadInfo *ti, int *task, WorkerBuffer *buf);
 int up_n_levels(char *path, int levels);
 int update_conf_ln_k(O3Data *od, int model_type, int pc_num, double *ln_k_rmsd, int conv_method);
 void update_field_object_attr(O3Data *od, int verbose);
+int update_gram_cache(O3Data *od);
 int update_mol(O3Data *od);
 int update_pymol(O3Data *od);
 int update_jmol(O3Data *od);
+int use_workers(O3Data *od, int model_type);
 int uvepls(O3Data *od, int pc);
 int v_intersection(int *v1, int *v2);
 int v_union(int *v_union, int *v1, int *v2);
 void var_to_xyz(O3Data *od, int x_var, VarCoord *varcoord);
 void vertex_xyz(O3Data *od, FILE *handle, int x, int y, int z);
+#ifndef WIN32
+void *worker_proxy_thread(void *pointer);
+#else
+DWORD worker_proxy_thread(void *pointer);
+#endif
 int write_aligned_mol(O3Data *od, O3Data *od_comp, TaskInfo *task, ConfInfo *fitted_conf, int object_num);
 void write_ffd_design_matrix_col(O3Data *od, int first_element, int col, int decimal);
 int write_grid_plane(O3Data *od, FILE *plane_file, int z_plane, int interpolate, int swap_endianness, float *minVal, float *maxVal);
@@ -76,7 +76,34 @@ void init_pls(O3Data *od)
   od->mal.b_coefficients = NULL;
   od->vel.v = NULL;
   od->vel.v_new = NULL;
+  od->mal.kernel_mat = NULL;
+  od->mal.kernel_u = NULL;
+  od->vel.kernel_t = NULL;
+  od->vel.kernel_w = NULL;
+  od->vel.kernel_g = NULL;
+  od->vel.deflation_coeff = NULL;
+  od->vel.implicit_work = NULL;
+  od->mal.e_mat_sp = NULL;
+  od->mal.f_mat_sp = NULL;
+  od->mal.pls_sp_work = NULL;
+  od->mal.pls1_u = NULL;
+  od->mal.pls1_w = NULL;
+  od->mal.pls1_t = NULL;
+  od->mal.pls1_dual = NULL;
+  od->mal.pls1_coeff = NULL;
+  od->vel.pls1_z = NULL;
+  od->mal.pls2_s = NULL;
+  od->mal.pls2_m = NULL;
+  od->mal.pls2_g = NULL;
+  od->mal.pls2_work = NULL;
+  od->vel.pls2_z = NULL;
+  od->pel.kernel_rows = NULL;
   od->vel.ro = NULL;
+  od->vel.fold_train_weight = NULL;
+  od->vel.fold_train_sqrt_weight = NULL;
+  od->vel.fold_out_weight = NULL;
+  od->pel.fold_train_rows = NULL;
+  od->pel.fold_out_rows = NULL;
   od->vel.explained_s2_x = NULL;
   od->vel.explained_s2_y = NULL;
   od->vel.ave_sdep = NULL;
@@ -85,3 +112,67 @@ void init_pls(O3Data *od)
   od->vel.r2_pred = NULL;
   od->pel.out_structs = NULL;
 }
+
+
+/*
+copies from src to dest the pointers to all data structures
+which make up a PLS workspace, i.e. those which are allocated
+by alloc_pls() and freed by free_pls()
+*/
+void copy_pls_workspace(O3Data *dest, O3Data *src)
+{
+  dest->mal.e_mat = src->mal.e_mat;
+  dest->vel.e_mat_ave = src->vel.e_mat_ave;
+  dest->mal.f_mat = src->mal.f_mat;
+  dest->vel.f_mat_ave = src->vel.f_mat_ave;
+  dest->mal.pred_f_mat = src->mal.pred_f_mat;
+  dest->mal.x_scores = src->mal.x_scores;
+  dest->mal.y_loadings = src->mal.y_loadings;
+  dest->mal.y_scores = src->mal.y_scores;
+  dest->mal.temp = src->mal.temp;
+  dest->mel.ipiv = src->mel.ipiv;
+  #ifdef HAVE_LIBMKL
+  dest->mel.work = src->mel.work;
+  #endif
+  dest->mal.x_weights = src->mal.x_weights;
+  dest->mal.x_weights_star = src->mal.x_weights_star;
+  dest->mal.x_loadings = src->mal.x_loadings;
+  dest->mal.b_coefficients = src->mal.b_coefficients;
+  dest->vel.v = src->vel.v;
+  dest->vel.v_new = src->vel.v_new;
+  dest->mal.kernel_mat = src->mal.kernel_mat;
+  dest->mal.kernel_u = src->mal.kernel_u;
+  dest->vel.kernel_t = src->vel.kernel_t;
+  dest->vel.kernel_w = src->vel.kernel_w;
+  dest->vel.kernel_g = src->vel.kernel_g;
+  dest->vel.deflation_coeff = src->vel.deflation_coeff;
+  dest->vel.implicit_work = src->vel.implicit_work;
+  dest->mal.e_mat_sp = src->mal.e_mat_sp;
+  dest->mal.f_mat_sp = src->mal.f_mat_sp;
+  dest->mal.pls_sp_work = src->mal.pls_sp_work;
+  dest->mal.pls1_u = src->mal.pls1_u;
+  dest->mal.pls1_w = src->mal.pls1_w;
+  dest->mal.pls1_t = src->mal.pls1_t;
+  dest->mal.pls1_dual = src->mal.pls1_dual;
+  dest->mal.pls1_coeff = src->mal.pls1_coeff;
+  dest->vel.pls1_z = src->vel.pls1_z;
+  dest->mal.pls2_s = src->mal.pls2_s;
+  dest->mal.pls2_m = src->mal.pls2_m;
+  dest->mal.pls2_g = src->mal.pls2_g;
+  dest->mal.pls2_work = src->mal.pls2_work;
+  dest->vel.pls2_z = src->vel.pls2_z;
+  dest->pel.kernel_rows = src->pel.kernel_rows;
+  dest->vel.ro = src->vel.ro;
+  dest->vel.fold_train_weight = src->vel.fold_train_weight;
+  dest->vel.fold_train_sqrt_weight = src->vel.fold_train_sqrt_weight;
+  dest->vel.fold_out_weight = src->vel.fold_out_weight;
+  dest->pel.fold_train_rows = src->pel.fold_train_rows;
+  dest->pel.fold_out_rows = src->pel.fold_out_rows;
+  dest->vel.explained_s2_x = src->vel.explained_s2_x;
+  dest->vel.explained_s2_y = src->vel.explained_s2_y;
+  dest->vel.ave_sdep = src->vel.ave_sdep;
+  dest->vel.ave_sdec = src->vel.ave_sdec;
+  dest->vel.r2 = src->vel.r2;
+  dest->vel.r2_pred = src->vel.r2_pred;
+  dest->pel.out_structs = src->pel.out_structs;
+}
@@ -0,0 +1,1097 @@
+/*
+
+journal.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#endif
+
+#define JOURNAL_FIELD_NUM    0
+#define JOURNAL_OBJECT_NUM    1
+#define JOURNAL_X_VARS    2
+#define JOURNAL_SCAN_LEN    65536
+
+
+static int read_journal_chunk(void *chunk, int word_size,
+  int chunk_len, FILE *handle, int endianness_switch)
+{
+  int actual_len;
+  
+  
+  if (!chunk_len) {
+    return 0;
+  }
+  actual_len = fread(chunk, word_size, chunk_len, handle);
+  if (actual_len != chunk_len) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(chunk, word_size, chunk_len, endianness_switch);
+  
+  return 0;
+}
+
+
+static long get_file_size(char *filename)
+{
+  long size = -1;
+  FILE *handle;
+  
+  
+  if ((handle = fopen(filename, "rb"))) {
+    if (!fseek(handle, 0, SEEK_END)) {
+      size = ftell(handle);
+    }
+    fclose(handle);
+  }
+  
+  return size;
+}
+
+
+static int read_journal_header(FILE *handle, int *endianness_switch,
+  int *base_info, uint64_t *base_size, int **base_object_id)
+{
+  char o3j_header[TITLE_LEN];
+  int i;
+  
+  
+  /*
+  the first 4-byte word of the journal
+  is an endianness indicator
+  */
+  if (fread(&i, sizeof(int), 1, handle) != 1) {
+    return PREMATURE_DAT_EOF;
+  }
+  fix_endianness(&i, sizeof(int), 1, machine_type());
+  if (i <= 0xFFFF) {
+    *endianness_switch = machine_type();
+  }
+  else {
+    *endianness_switch = 1 - machine_type();
+  }
+  if (fread(o3j_header, 1, TITLE_LEN, handle) != TITLE_LEN) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (strncmp(o3j_header, JOURNAL_HEADER, strlen(JOURNAL_HEADER))) {
+    return PREMATURE_DAT_EOF;
+  }
+  /*
+  then read:
+  - the size in bytes of the base .dat file
+  - 3 int: number of fields, objects and x_vars of the base
+  - object IDs of the base
+  */
+  if (read_journal_chunk(base_size, sizeof(uint64_t), 1,
+    handle, *endianness_switch)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (read_journal_chunk(base_info, sizeof(int), 3,
+    handle, *endianness_switch)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if ((base_info[JOURNAL_FIELD_NUM] < 0)
+    || (base_info[JOURNAL_OBJECT_NUM] <= 0)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (!(*base_object_id = (int *)malloc
+    (base_info[JOURNAL_OBJECT_NUM] * sizeof(int)))) {
+    return OUT_OF_MEMORY;
+  }
+  if (read_journal_chunk(*base_object_id, sizeof(int),
+    base_info[JOURNAL_OBJECT_NUM], handle, *endianness_switch)) {
+    return PREMATURE_DAT_EOF;
+  }
+  
+  return 0;
+}
+
+
+static int check_journal_record(FILE *handle, long header_len,
+  long record_end, int endianness_switch, int *record_num)
+{
+  char marker[MAX_NAME_LEN + 1];
+  char record[MAX_NAME_LEN + 1];
+  long record_start;
+  uint64_t record_len;
+  
+  
+  /*
+  record_end is right after a JOURNAL_COMMIT marker;
+  the record is valid if the length stored before
+  the marker leads back to a JOURNAL_RECORD marker
+  */
+  if ((record_end - header_len) < (long)(2 * MAX_NAME_LEN
+    + sizeof(int) + sizeof(uint64_t))) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (fseek(handle, record_end - (long)(MAX_NAME_LEN
+    + sizeof(uint64_t)), SEEK_SET)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (read_journal_chunk(&record_len, sizeof(uint64_t), 1,
+    handle, endianness_switch)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if ((record_len < (uint64_t)(MAX_NAME_LEN + sizeof(int)))
+    || (record_len > (uint64_t)(record_end - header_len))) {
+    return PREMATURE_DAT_EOF;
+  }
+  record_start = record_end - (long)(record_len
+    + MAX_NAME_LEN + sizeof(uint64_t));
+  if (record_start < header_len) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (fseek(handle, record_start, SEEK_SET)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (fread(marker, 1, MAX_NAME_LEN, handle) != MAX_NAME_LEN) {
+    return PREMATURE_DAT_EOF;
+  }
+  sprintf(record, "%-32s", JOURNAL_RECORD);
+  if (memcmp(marker, record, MAX_NAME_LEN)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (read_journal_chunk(record_num, sizeof(int), 1,
+    handle, endianness_switch)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (*record_num <= 0) {
+    return PREMATURE_DAT_EOF;
+  }
+  
+  return 0;
+}
+
+
+static int seek_last_journal_record(FILE *handle, long header_len,
+  int endianness_switch, int *record_num, long *record_end)
+{
+  char commit[MAX_NAME_LEN + 1];
+  char *chunk;
+  long journal_len;
+  long chunk_start;
+  long chunk_end;
+  long end;
+  
+  
+  /*
+  each record is terminated by its length and by
+  a JOURNAL_COMMIT marker; a save interrupted by a
+  crash or by a full disk may leave a partly written
+  record behind, so scan backwards for the last
+  record whose trailer is intact and ignore the torn
+  tail. On return the handle is positioned right
+  after the record number, and record_end is the
+  length of the journal up to that record
+  (header_len if there are no valid records)
+  */
+  *record_num = 0;
+  *record_end = header_len;
+  if (fseek(handle, 0, SEEK_END)) {
+    return PREMATURE_DAT_EOF;
+  }
+  journal_len = ftell(handle);
+  if (journal_len == header_len) {
+    return 0;
+  }
+  if (!(chunk = malloc(JOURNAL_SCAN_LEN))) {
+    return OUT_OF_MEMORY;
+  }
+  sprintf(commit, "%-32s", JOURNAL_COMMIT);
+  chunk_end = journal_len;
+  while (chunk_end - header_len >= MAX_NAME_LEN) {
+    chunk_start = chunk_end - JOURNAL_SCAN_LEN;
+    if (chunk_start < header_len) {
+      chunk_start = header_len;
+    }
+    if (fseek(handle, chunk_start, SEEK_SET)
+      || (fread(chunk, 1, chunk_end - chunk_start, handle)
+      != (size_t)(chunk_end - chunk_start))) {
+      free(chunk);
+      return PREMATURE_DAT_EOF;
+    }
+    for (end = chunk_end; end - chunk_start >= MAX_NAME_LEN; --end) {
+      if (memcmp(&chunk[end - MAX_NAME_LEN - chunk_start],
+        commit, MAX_NAME_LEN)) {
+        continue;
+      }
+      if (!check_journal_record(handle, header_len,
+        end, endianness_switch, record_num)) {
+        free(chunk);
+        *record_end = end;
+        return 0;
+      }
+    }
+    /*
+    consecutive chunks overlap so that markers
+    straddling their boundary are not missed
+    */
+    if (chunk_start == header_len) {
+      break;
+    }
+    chunk_end = chunk_start + MAX_NAME_LEN - 1;
+  }
+  free(chunk);
+  *record_num = 0;
+  
+  return 0;
+}
+
+
+static int truncate_journal(char *journal_name, long journal_len)
+{
+  #ifndef WIN32
+  return truncate(journal_name, (off_t)journal_len);
+  #else
+  int fd;
+  int result;
+  
+  
+  if ((fd = _open(journal_name, _O_RDWR | _O_BINARY)) == -1) {
+    return -1;
+  }
+  result = _chsize(fd, journal_len);
+  _close(fd);
+  
+  return result;
+  #endif
+}
+
+
+void get_journal_name(char *journal_name, char *dat_name)
+{
+  snprintf(journal_name, BUF_LEN, "%s%s", dat_name, JOURNAL_EXTENSION);
+  journal_name[BUF_LEN - 1] = '\0';
+  absolute_path(journal_name);
+}
+
+
+void init_journal(O3Data *od, char *dat_name)
+{
+  int i;
+  int field_num = 0;
+  
+  
+  /*
+  after a full save or load the in-memory dataset
+  is identical to dat_name: each field maps onto
+  the base field with the same position and is clean
+  */
+  memset(od->journal_base, 0, BUF_LEN);
+  if (dat_name) {
+    strncpy(od->journal_base, dat_name, BUF_LEN - 1);
+    absolute_path(od->journal_base);
+  }
+  for (i = 0; i < od->field_num; ++i) {
+    if (od->mel.journal_origin) {
+      od->mel.journal_origin[i] = ((dat_name
+        && (!get_field_attr(od, i, DELETE_BIT))) ? field_num : -1);
+    }
+    if (od->mel.journal_dirty) {
+      od->mel.journal_dirty[i] = 0;
+    }
+    if (!get_field_attr(od, i, DELETE_BIT)) {
+      ++field_num;
+    }
+  }
+}
+
+
+static int write_journal_header(O3Data *od, char *dat_name, char *journal_name)
+{
+  char o3j_header[TITLE_LEN + 1];
+  int i;
+  int base_info[3];
+  int actual_len;
+  uint64_t base_size;
+  FILE *handle;
+  
+  
+  if (!(handle = fopen(journal_name, "wb"))) {
+    return PREMATURE_DAT_EOF;
+  }
+  /*
+  as the first 4-byte word of the journal
+  write (int)1 as an endianness indicator
+  */
+  i = 1;
+  fwrite(&i, sizeof(int), 1, handle);
+  memset(o3j_header, ' ', TITLE_LEN);
+  o3j_header[TITLE_LEN] = '\0';
+  sprintf(o3j_header, JOURNAL_HEADER" "PACKAGE_NAME" v %s", VERSION);
+  for (i = 0; i < TITLE_LEN; ++i) {
+    if (!o3j_header[i]) {
+      o3j_header[i] = ' ';
+      break;
+    }
+  }
+  fwrite(o3j_header, 1, TITLE_LEN, handle);
+  base_size = (uint64_t)get_file_size(dat_name);
+  fwrite(&base_size, sizeof(uint64_t), 1, handle);
+  memset(base_info, 0, 3 * sizeof(int));
+  for (i = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, DELETE_BIT)) {
+      ++base_info[JOURNAL_FIELD_NUM];
+    }
+  }
+  for (i = 0; i < od->grid.object_num; ++i) {
+    if (!get_object_attr(od, i, DELETE_BIT)) {
+      ++base_info[JOURNAL_OBJECT_NUM];
+    }
+  }
+  base_info[JOURNAL_X_VARS] = od->x_vars;
+  fwrite(base_info, sizeof(int), 3, handle);
+  for (i = 0; i < od->grid.object_num; ++i) {
+    if (!get_object_attr(od, i, DELETE_BIT)) {
+      fwrite(&(od->al.mol_info[i]->object_id), sizeof(int), 1, handle);
+    }
+  }
+  actual_len = fflush(handle);
+  if (ferror(handle) || actual_len) {
+    fclose(handle);
+    return PREMATURE_DAT_EOF;
+  }
+  fclose(handle);
+  
+  return 0;
+}
+
+
+static int check_journal_base(O3Data *od, char *dat_name,
+  char *journal_name, int *record_num, long *record_end)
+{
+  int i;
+  int j;
+  int n;
+  int result;
+  int last_origin;
+  int new_field;
+  int endianness_switch;
+  int base_info[3];
+  int *base_object_id = NULL;
+  long header_len;
+  uint64_t base_size;
+  FILE *handle;
+  
+  
+  /*
+  a record can be appended only if the journal
+  belongs to the .dat file the current dataset
+  was loaded from or last saved to, the base file
+  was not modified meanwhile and the journal is
+  not larger than the base itself, in which case
+  rewriting the base is more convenient
+  */
+  if (strcmp(od->journal_base, dat_name) || (!(od->mel.journal_origin))) {
+    return 1;
+  }
+  if (!(handle = fopen(journal_name, "rb"))) {
+    return 1;
+  }
+  result = read_journal_header(handle, &endianness_switch,
+    base_info, &base_size, &base_object_id);
+  header_len = ftell(handle);
+  if (!result) {
+    result = seek_last_journal_record(handle,
+      header_len, endianness_switch, record_num, record_end);
+  }
+  if (!result) {
+    if ((base_size != (uint64_t)get_file_size(dat_name))
+      || (*record_end > (long)base_size)
+      || (base_info[JOURNAL_X_VARS] != od->x_vars)) {
+      result = 1;
+    }
+  }
+  fclose(handle);
+  /*
+  surviving objects must be an ordered subset
+  of the objects present in the base
+  */
+  j = 0;
+  for (i = 0; (!result) && (i < od->grid.object_num); ++i) {
+    if (get_object_attr(od, i, DELETE_BIT)) {
+      continue;
+    }
+    while ((j < base_info[JOURNAL_OBJECT_NUM])
+      && (base_object_id[j] != od->al.mol_info[i]->object_id)) {
+      ++j;
+    }
+    if (j == base_info[JOURNAL_OBJECT_NUM]) {
+      result = 1;
+    }
+    ++j;
+  }
+  /*
+  fields which derive from base fields must come
+  in the same order, followed by new fields
+  */
+  last_origin = -1;
+  new_field = 0;
+  n = 0;
+  for (i = 0; (!result) && (i < od->field_num); ++i) {
+    if (get_field_attr(od, i, DELETE_BIT)) {
+      continue;
+    }
+    ++n;
+    if (od->mel.journal_origin[i] < 0) {
+      new_field = 1;
+    }
+    else if (new_field || (od->mel.journal_origin[i] <= last_origin)
+      || (od->mel.journal_origin[i] >= base_info[JOURNAL_FIELD_NUM])) {
+      result = 1;
+    }
+    else {
+      last_origin = od->mel.journal_origin[i];
+    }
+  }
+  if (base_object_id) {
+    free(base_object_id);
+  }
+  
+  return result;
+}
+
+
+static int write_journal_record(O3Data *od, FILE *handle,
+  long record_start, int record_num)
+{
+  char print_buf[BUF_LEN];
+  int i;
+  int j;
+  int n;
+  int actual_len;
+  int not_deleted_field_num;
+  int not_deleted_object_num;
+  int origin_dirty[2];
+  uint64_t valid;
+  uint64_t record_len;
+  float value;
+  
+  
+  memset(print_buf, ' ', MAX_NAME_LEN);
+  sprintf(print_buf, "%-32s", JOURNAL_RECORD);
+  fwrite(print_buf, 1, MAX_NAME_LEN, handle);
+  fwrite(&record_num, sizeof(int), 1, handle);
+  /*
+  then write od->valid, after zeroing
+  the PLS, CV, and PREDICT bits
+  */
+  valid = (uint64_t)(od->valid & (~(PLS_BIT | CV_BIT | PREDICT_BIT)));
+  fwrite(&valid, sizeof(uint64_t), 1, handle);
+  /*
+  then write the number of surviving objects
+  followed by their IDs; base objects which
+  are not listed were removed
+  */
+  not_deleted_object_num = 0;
+  for (i = 0; i < od->grid.object_num; ++i) {
+    if (!get_object_attr(od, i, DELETE_BIT)) {
+      ++not_deleted_object_num;
+    }
+  }
+  fwrite(&not_deleted_object_num, sizeof(int), 1, handle);
+  for (i = 0; i < od->grid.object_num; ++i) {
+    if (!get_object_attr(od, i, DELETE_BIT)) {
+      fwrite(&(od->al.mol_info[i]->object_id), sizeof(int), 1, handle);
+    }
+  }
+  /*
+  then write the number of surviving fields, and for
+  each of them the base field it derives from (-1 if
+  it is a new field) and whether its values changed
+  */
+  not_deleted_field_num = 0;
+  for (i = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, DELETE_BIT)) {
+      ++not_deleted_field_num;
+    }
+  }
+  fwrite(&not_deleted_field_num, sizeof(int), 1, handle);
+  for (i = 0; i < od->field_num; ++i) {
+    if (get_field_attr(od, i, DELETE_BIT)) {
+      continue;
+    }
+    origin_dirty[0] = od->mel.journal_origin[i];
+    origin_dirty[1] = (int)(od->mel.journal_dirty[i]);
+    fwrite(origin_dirty, sizeof(int), 2, handle);
+  }
+  /*
+  only values belonging to new or modified
+  fields are written to the journal
+  */
+  for (i = 0; i < od->field_num; ++i) {
+    if (get_field_attr(od, i, DELETE_BIT)
+      || ((od->mel.journal_origin[i] >= 0)
+      && (!(od->mel.journal_dirty[i])))) {
+      continue;
+    }
+    if (od->save_ram) {
+      if (check_mmap(od, i)) {
+        return OUT_OF_MEMORY;
+      }
+    }
+    for (j = 0; j < od->object_num; ++j) {
+      if (get_object_attr(od, j, DELETE_BIT)) {
+        continue;
+      }
+      actual_len = fwrite(od->mel.x_var_array[i][j],
+        sizeof(float), od->x_vars, handle);
+      if (actual_len != od->x_vars) {
+        return PREMATURE_DAT_EOF;
+      }
+    }
+  }
+  /*
+  Now save XData and attributes:
+  - x_data
+  - field_attr
+  - object_attr
+  - object_weight
+  - x_var_attr
+  */
+  for (i = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, DELETE_BIT)) {
+      fwrite(&(od->mel.x_data[i]), sizeof(XData), 1, handle);
+    }
+  }
+  for (i = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, DELETE_BIT)) {
+      fwrite(&(od->mel.field_attr[i]), sizeof(uint16_t), 1, handle);
+    }
+  }
+  for (i = 0; i < od->grid.object_num; ++i) {
+    if (!get_object_attr(od, i, DELETE_BIT)) {
+      fwrite(&(od->mel.object_attr[i]), sizeof(uint16_t), 1, handle);
+    }
+  }
+  for (i = 0; i < od->grid.object_num; ++i) {
+    if (!get_object_attr(od, i, DELETE_BIT)) {
+      fwrite(&(od->mel.object_weight[i]), sizeof(double), 1, handle);
+    }
+  }
+  for (i = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, DELETE_BIT)) {
+      actual_len = fwrite(od->mel.x_var_attr[i],
+        sizeof(uint16_t), od->x_vars, handle);
+      if (actual_len != od->x_vars) {
+        return PREMATURE_DAT_EOF;
+      }
+    }
+  }
+  if (IS_O3Q(od) && (od->valid & SEED_BIT)) {
+    /*
+    if a SRD analysis is present, then save
+    relevant data
+    */
+    fwrite(&(od->voronoi_num), sizeof(int), 1, handle);
+    fwrite(od->mel.voronoi_active, sizeof(int),
+      od->voronoi_num, handle);
+    for (i = 0; i < od->voronoi_num; ++i) {
+      fwrite(&(od->mel.voronoi_fill[i]), sizeof(int), 1, handle);
+      fwrite(od->al.voronoi_composition[i], sizeof(int),
+        od->mel.voronoi_fill[i], handle);
+    }
+    for (i = 0; i < od->field_num; ++i) {
+      fwrite(&(od->mel.seed_count[i]), sizeof(int), 1, handle);
+      fwrite(&(od->mel.seed_count_before_collapse[i]),
+        sizeof(int), 1, handle);
+      fwrite(&(od->mel.group_zero[i]), sizeof(int), 1, handle);
+      actual_len = fwrite(od->cimal.voronoi_buf->me[i],
+        sizeof(int), od->x_vars, handle);
+      if (actual_len != od->x_vars) {
+        return PREMATURE_DAT_EOF;
+      }
+    }
+  }
+  /*
+  dependent variables are small compared
+  to fields, so they are always saved
+  */
+  fwrite(&(od->y_vars), sizeof(int), 1, handle);
+  if (od->y_vars) {
+    for (i = 0; i < od->y_vars; ++i) {  
+      memset(print_buf, ' ', MAX_NAME_LEN);
+      snprintf(print_buf, MAX_NAME_LEN, "%-32s", od->cimal.y_var_name->me[i]);
+      fwrite(print_buf, 1, MAX_NAME_LEN, handle);
+    }
+    fwrite(od->mel.y_data, sizeof(YData), od->y_vars, handle);
+    for (i = 0; i < od->grid.object_num; ++i) {
+      if (get_object_attr(od, i, DELETE_BIT)) {
+        continue;
+      }
+      for (j = 0; j < od->y_vars; ++j) {
+        value = (float)get_y_value(od, i, j, 0);
+        fwrite(&value, sizeof(float), 1, handle);
+      }
+    }
+    fwrite(od->mel.y_var_attr, sizeof(uint16_t), od->y_vars, handle);
+  }
+  /*
+  finally, write the record length and
+  the JOURNAL_COMMIT marker
+  */
+  record_len = (uint64_t)(ftell(handle) - record_start);
+  fwrite(&record_len, sizeof(uint64_t), 1, handle);
+  memset(print_buf, ' ', MAX_NAME_LEN);
+  sprintf(print_buf, "%-32s", JOURNAL_COMMIT);
+  actual_len = fwrite(print_buf, 1, MAX_NAME_LEN, handle);
+  n = fflush(handle);
+  if ((actual_len != MAX_NAME_LEN) || n || ferror(handle)) {
+    return PREMATURE_DAT_EOF;
+  }
+  
+  return 0;
+}
+
+
+
+
+int save_dat_journal(O3Data *od, int file_id, int *record_num)
+{
+  char dat_name[BUF_LEN];
+  char journal_name[BUF_LEN];
+  int result;
+  long record_start;
+  FILE *handle;
+  
+  
+  strcpy(dat_name, od->file[file_id]->name);
+  absolute_path(dat_name);
+  get_journal_name(journal_name, dat_name);
+  *record_num = 0;
+  if (check_journal_base(od, dat_name, journal_name,
+    record_num, &record_start)) {
+    /*
+    write a full base .dat file and start
+    a new, empty journal
+    */
+    *record_num = 0;
+    if (!(od->file[file_id]->handle = (FILE *)
+      fzopen(od->file[file_id]->name, "wb"))) {
+      return CANNOT_WRITE_TEMP_FILE;
+    }
+    result = save_dat(od, file_id);
+    if (result) {
+      return result;
+    }
+    result = write_journal_header(od, dat_name, journal_name);
+    if (result) {
+      return result;
+    }
+    init_journal(od, dat_name);
+    
+    return 0;
+  }
+  /*
+  drop a partly written record left behind
+  by a previous save, if any, then append
+  */
+  if ((get_file_size(journal_name) > record_start)
+    && truncate_journal(journal_name, record_start)) {
+    return PREMATURE_DAT_EOF;
+  }
+  if (!(handle = fopen(journal_name, "ab"))) {
+    return PREMATURE_DAT_EOF;
+  }
+  ++(*record_num);
+  result = write_journal_record(od, handle, record_start, *record_num);
+  fclose(handle);
+  if (result) {
+    /*
+    do not leave a half-written record behind
+    */
+    truncate_journal(journal_name, record_start);
+  }
+  
+  return result;
+}
+
+
+int load_dat_journal(O3Data *od, int file_id, int options)
+{
+  char dat_name[BUF_LEN];
+  char journal_name[BUF_LEN];
+  char header[MAX_NAME_LEN + 1];
+  int i;
+  int j;
+  int n;
+  int result;
+  int endianness_switch;
+  int record_num;
+  int object_num;
+  int field_num;
+  int base_field_num;
+  int y_vars;
+  int base_info[3];
+  int *base_object_id = NULL;
+  int *object_id = NULL;
+  int *origin_dirty = NULL;
+  long header_len;
+  long record_end;
+  uint64_t base_size;
+  uint64_t valid;
+  float value;
+  FILE *handle;
+  
+  
+  strcpy(dat_name, od->file[file_id]->name);
+  absolute_path(dat_name);
+  get_journal_name(journal_name, dat_name);
+  init_journal(od, dat_name);
+  if (!fexist(journal_name)) {
+    return 0;
+  }
+  if (!(handle = fopen(journal_name, "rb"))) {
+    return CANNOT_READ_TEMP_FILE;
+  }
+  result = read_journal_header(handle, &endianness_switch,
+    base_info, &base_size, &base_object_id);
+  header_len = ftell(handle);
+  if (!result) {
+    result = seek_last_journal_record(handle,
+      header_len, endianness_switch, &record_num, &record_end);
+  }
+  if ((!result) && (options & VERBOSE_BIT)
+    && (get_file_size(journal_name) > record_end)) {
+    tee_printf(od, "An incomplete record at the end of %s "
+      "was ignored.\n\n", journal_name);
+  }
+  if ((!result) && ((base_size != (uint64_t)get_file_size(dat_name))
+    || (base_info[JOURNAL_FIELD_NUM] != od->field_num)
+    || (base_info[JOURNAL_OBJECT_NUM] != od->grid.object_num)
+    || (base_info[JOURNAL_X_VARS] != od->x_vars))) {
+    result = JOURNAL_NOT_MATCHING;
+  }
+  for (i = 0; (!result) && (i < od->grid.object_num); ++i) {
+    if (base_object_id[i] != od->al.mol_info[i]->object_id) {
+      result = JOURNAL_NOT_MATCHING;
+    }
+  }
+  if (result || (!record_num)) {
+    fclose(handle);
+    if (base_object_id) {
+      free(base_object_id);
+    }
+    return result;
+  }
+  /*
+  records are relative to the base, so only
+  the last one needs to be replayed
+  */
+  result = read_journal_chunk(&valid, sizeof(uint64_t), 1,
+    handle, endianness_switch);
+  if (!result) {
+    result = read_journal_chunk(&object_num, sizeof(int), 1,
+      handle, endianness_switch);
+  }
+  if ((!result) && ((object_num <= 0) || (object_num > od->grid.object_num))) {
+    result = PREMATURE_DAT_EOF;
+  }
+  if (!result) {
+    if (!(object_id = alloc_int_array(NULL, object_num))) {
+      result = OUT_OF_MEMORY;
+    }
+  }
+  if (!result) {
+    result = read_journal_chunk(object_id, sizeof(int), object_num,
+      handle, endianness_switch);
+  }
+  /*
+  remove base objects which are not
+  listed in the record
+  */
+  if (!result) {
+    j = 0;
+    n = 0;
+    for (i = 0; i < od->grid.object_num; ++i) {
+      if ((j < object_num) && (od->al.mol_info[i]->object_id == object_id[j])) {
+        set_object_attr(od, i, OPERATE_BIT, 0);
+        ++j;
+      }
+      else {
+        set_object_attr(od, i, OPERATE_BIT, 1);
+        ++n;
+      }
+    }
+    if (j != object_num) {
+      result = PREMATURE_DAT_EOF;
+    }
+    else if (n) {
+      result = remove_object(od);
+    }
+  }
+  if (!result) {
+    result = read_journal_chunk(&field_num, sizeof(int), 1,
+      handle, endianness_switch);
+  }
+  if ((!result) && (field_num < 0)) {
+    result = PREMATURE_DAT_EOF;
+  }
+  if ((!result) && field_num) {
+    if (!(origin_dirty = alloc_int_array(NULL, 2 * field_num))) {
+      result = OUT_OF_MEMORY;
+    }
+    if (!result) {
+      result = read_journal_chunk(origin_dirty, sizeof(int), 2 * field_num,
+        handle, endianness_switch);
+    }
+  }
+  /*
+  remove base fields which are not
+  referenced by the record
+  */
+  base_field_num = 0;
+  if ((!result) && od->field_num) {
+    for (i = 0; i < od->field_num; ++i) {
+      set_field_attr(od, i, OPERATE_BIT, 1);
+    }
+    for (i = 0; i < field_num; ++i) {
+      if (origin_dirty[2 * i] >= od->field_num) {
+        result = PREMATURE_DAT_EOF;
+      }
+      else if (origin_dirty[2 * i] >= 0) {
+        set_field_attr(od, origin_dirty[2 * i], OPERATE_BIT, 0);
+        ++base_field_num;
+      }
+    }
+    if ((!result) && (base_field_num < od->field_num)) {
+      sprintf(od->file[TEMP_MOLFILE]->name, "%s%ctemp_loaded_molfile.sdf",
+        od->field.mol_dir, SEPARATOR);
+      result = remove_field(od);
+      remove(od->file[TEMP_MOLFILE]->name);
+      memset(od->file[TEMP_MOLFILE]->name, 0, BUF_LEN);
+    }
+  }
+  /*
+  read values of modified fields in place
+  and append new fields
+  */
+  for (i = 0; (!result) && (i < field_num); ++i) {
+    if (origin_dirty[2 * i] < 0) {
+      if (i != od->field_num) {
+        result = PREMATURE_DAT_EOF;
+        break;
+      }
+      if ((result = alloc_x_var_array(od, 1))) {
+        break;
+      }
+    }
+    else if (!origin_dirty[2 * i + 1]) {
+      continue;
+    }
+    if (od->save_ram) {
+      if (check_mmap(od, i)) {
+        result = OUT_OF_MEMORY;
+        break;
+      }
+    }
+    for (j = 0; (!result) && (j < od->object_num); ++j) {
+      result = read_journal_chunk(od->mel.x_var_array[i][j],
+        sizeof(float), od->x_vars, handle, endianness_switch);
+    }
+  }
+  if ((!result) && (field_num != od->field_num)) {
+    result = PREMATURE_DAT_EOF;
+  }
+  /*
+  Now load XData and attributes:
+  - x_data
+  - field_attr
+  - object_attr
+  - object_weight
+  - x_var_attr
+  */
+  if (!result) {
+    result = read_journal_chunk(od->mel.x_data, sizeof(XData),
+      field_num, handle, 0);
+  }
+  if (!result) {
+    result = read_journal_chunk(od->mel.field_attr, sizeof(uint16_t),
+      field_num, handle, endianness_switch);
+  }
+  if (!result) {
+    result = read_journal_chunk(od->mel.object_attr, sizeof(uint16_t),
+      object_num, handle, endianness_switch);
+  }
+  if (!result) {
+    result = read_journal_chunk(od->mel.object_weight, sizeof(double),
+      object_num, handle, endianness_switch);
+  }
+  for (i = 0; (!result) && (i < field_num); ++i) {
+    result = read_journal_chunk(od->mel.x_var_attr[i], sizeof(uint16_t),
+      od->x_vars, handle, endianness_switch);
+  }
+  od->valid = valid;
+  if ((!result) && IS_O3Q(od) && (od->valid & SEED_BIT)) {
+    /*
+    if a SRD analysis is present, then load
+    relevant data
+    */
+    free_array(od->al.voronoi_composition);
+    od->al.voronoi_composition = NULL;
+    result = read_journal_chunk(&(od->voronoi_num), sizeof(int), 1,
+      handle, endianness_switch);
+    if (!result) {
+      result = alloc_voronoi(od, od->voronoi_num);
+    }
+    if (!result) {
+      result = read_journal_chunk(od->mel.voronoi_active, sizeof(int),
+        od->voronoi_num, handle, endianness_switch);
+    }
+    for (i = 0; (!result) && (i < od->voronoi_num); ++i) {
+      result = read_journal_chunk(&(od->mel.voronoi_fill[i]), sizeof(int), 1,
+        handle, endianness_switch);
+      if (!result) {
+        if (!(od->al.voronoi_composition[i] =
+          alloc_int_array(NULL, od->mel.voronoi_fill[i]))) {
+          result = OUT_OF_MEMORY;
+        }
+      }
+      if (!result) {
+        result = read_journal_chunk(od->al.voronoi_composition[i], sizeof(int),
+          od->mel.voronoi_fill[i], handle, endianness_switch);
+      }
+    }
+    for (i = 0; (!result) && (i < od->field_num); ++i) {
+      result = read_journal_chunk(&(od->mel.seed_count[i]), sizeof(int), 1,
+        handle, endianness_switch);
+      if (!result) {
+        result = read_journal_chunk(&(od->mel.seed_count_before_collapse[i]),
+          sizeof(int), 1, handle, endianness_switch);
+      }
+      if (!result) {
+        result = read_journal_chunk(&(od->mel.group_zero[i]), sizeof(int), 1,
+          handle, endianness_switch);
+      }
+      if (!result) {
+        result = read_journal_chunk(od->cimal.voronoi_buf->me[i], sizeof(int),
+          od->x_vars, handle, endianness_switch);
+      }
+    }
+  }
+  /*
+  then load dependent variables
+  */
+  if (!result) {
+    result = read_journal_chunk(&y_vars, sizeof(int), 1,
+      handle, endianness_switch);
+  }
+  if ((!result) && (y_vars < 0)) {
+    result = PREMATURE_DAT_EOF;
+  }
+  if (!result) {
+    if (y_vars) {
+      od->y_vars = y_vars;
+      if (alloc_y_var_array(od)) {
+        result = OUT_OF_MEMORY;
+      }
+      if (!result) {
+        free_char_matrix(od->cimal.y_var_name);
+        od->cimal.y_var_name = NULL;
+        if (!(od->cimal.y_var_name = alloc_char_matrix
+          (od->cimal.y_var_name, od->y_vars, MAX_NAME_LEN))) {
+          result = OUT_OF_MEMORY;
+        }
+      }
+      for (i = 0; (!result) && (i < od->y_vars); ++i) {
+        memset(header, 0, MAX_NAME_LEN + 1);
+        if (fread(header, 1, MAX_NAME_LEN, handle) != MAX_NAME_LEN) {
+          result = PREMATURE_DAT_EOF;
+          break;
+        }
+        j = 0;
+        while ((header[j] != ' ') && (j < MAX_NAME_LEN)) {
+          ++j;
+        }
+        header[j] = '\0';
+        strcpy(od->cimal.y_var_name->me[i], header);
+      }
+      if (!result) {
+        result = read_journal_chunk(od->mel.y_data, sizeof(YData),
+          od->y_vars, handle, 0);
+      }
+      for (i = 0; (!result) && (i < od->grid.object_num); ++i) {
+        for (j = 0; (!result) && (j < od->y_vars); ++j) {
+          result = read_journal_chunk(&value, sizeof(float), 1,
+            handle, endianness_switch);
+          set_y_value(od, i, j, (double)value);
+        }
+      }
+      if (!result) {
+        result = read_journal_chunk(od->mel.y_var_attr, sizeof(uint16_t),
+          od->y_vars, handle, endianness_switch);
+      }
+    }
+    else if (od->y_vars) {
+      free_y_var_array(od);
+    }
+  }
+  fclose(handle);
+  if (!result) {
+    if (od->save_ram) {
+      sync_field_mmap(od);
+    }
+    update_field_object_attr(od, options & VERBOSE_BIT);
+    result = calc_active_vars(od, FULL_MODEL);
+  }
+  if (!result) {
+    for (i = 0; i < field_num; ++i) {
+      od->mel.journal_origin[i] = origin_dirty[2 * i];
+      od->mel.journal_dirty[i] = (unsigned char)origin_dirty[2 * i + 1];
+    }
+    if (options & VERBOSE_BIT) {
+      tee_printf(od, "Journal record %d was replayed from %s.\n\n",
+        record_num, journal_name);
+    }
+  }
+  if (base_object_id) {
+    free(base_object_id);
+  }
+  if (object_id) {
+    free(object_id);
+  }
+  if (origin_dirty) {
+    free(origin_dirty);
+  }
+  
+  return result;
+}
@@ -0,0 +1,248 @@
+/*
+
+kernel_cv.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+kernel CV engine: the Gram matrix of all active objects
+is computed once, then for each CV fold the mean-centered,
+weighted training kernel and test cross-kernel are derived
+from it by index selection plus a rank correction for the
+shift of the training set mean, so that the E matrix never
+needs to be copied again.
+If x = z + m, where m is any constant shift, the training
+mean is a = sum(w[k]z[k]) / sum(w[k]) + m and then
+(x[i] - a)'(x[j] - a) = G[i][j] - g[i] - g[j] + c
+where G[i][j] = z[i]'z[j], g[i] = z[i]'(a - m) and
+c = (a - m)'(a - m)
+*/
+int prepare_kernel_cv(O3Data *od)
+{
+  int i;
+  int j;
+  int x;
+  int n_block;
+  double value;
+  double ave;
+  DoubleMat *block_mat;
+  
+  
+  od->cv.kernel_cv = 0;
+  od->mal.kernel_gram = double_mat_resize(od->mal.kernel_gram,
+    od->active_object_num, od->active_object_num);
+  if (!(od->mal.kernel_gram)) {
+    return OUT_OF_MEMORY;
+  }
+  if (od->pls_incremental && od->gram.valid) {
+    /*
+    fold kernels only depend on the Gram matrix, which
+    in incremental mode is kept across commands and has
+    just been updated by update_gram_cache()
+    */
+    for (j = 0; j < od->active_object_num; ++j) {
+      cblas_dcopy(od->active_object_num,
+        &M_PEEK(od->gram.gram, 0, j), 1,
+        &M_PEEK(od->mal.kernel_gram, 0, j), 1);
+    }
+    od->cv.kernel_cv = 1;
+    return 0;
+  }
+  memset(od->mal.kernel_gram->base, 0, od->mal.kernel_gram->max_m
+    * od->mal.kernel_gram->max_n * sizeof(double));
+  block_mat = double_mat_alloc(od->active_object_num,
+    KERNEL_CV_BLOCK_SIZE);
+  if (!block_mat) {
+    return OUT_OF_MEMORY;
+  }
+  /*
+  accumulate G = ZZ' one block of columns at a time;
+  z is centered on the plain column average of all active
+  objects to limit round-off when the shift is undone
+  */
+  for (x = 0; x < od->mal.large_e_mat->n; x += n_block) {
+    n_block = od->mal.large_e_mat->n - x;
+    if (n_block > KERNEL_CV_BLOCK_SIZE) {
+      n_block = KERNEL_CV_BLOCK_SIZE;
+    }
+    for (j = 0; j < n_block; ++j) {
+      for (i = 0, ave = 0.0; i < od->active_object_num; ++i) {
+        value = M_PEEK(od->mal.large_e_mat, i, x + j);
+        /*
+        missing values are zeroed after centering rather than
+        centered, which does not commute with the mean shift:
+        in this case fall back to the regular CV engine
+        */
+        if (MISSING(value)) {
+          double_mat_free(block_mat);
+          free_kernel_cv(od);
+          return 0;
+        }
+        ave += value;
+      }
+      ave /= (double)(od->active_object_num);
+      for (i = 0; i < od->active_object_num; ++i) {
+        M_POKE(block_mat, i, j,
+          M_PEEK(od->mal.large_e_mat, i, x + j) - ave);
+      }
+    }
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+      od->active_object_num,
+      od->active_object_num,
+      n_block, 1.0,
+      block_mat->base,
+      block_mat->max_m,
+      block_mat->base,
+      block_mat->max_m, 1.0,
+      od->mal.kernel_gram->base,
+      od->mal.kernel_gram->max_m);
+  }
+  double_mat_free(block_mat);
+  od->cv.kernel_cv = 1;
+  
+  return 0;
+}
+
+
+void kernel_cv_fold(O3Data *od, int active_object_num)
+{
+  int i;
+  int j;
+  int n;
+  int y;
+  int n_train;
+  int n_test;
+  int object_num;
+  double sumweight = 0.0;
+  DoubleMat *gram;
+  DoubleVec *w;
+  DoubleVec *g;
+  IntPerm *rows;
+  
+  
+  gram = od->mal.kernel_gram;
+  w = od->vel.kernel_w;
+  g = od->vel.kernel_g;
+  rows = od->pel.kernel_rows;
+  /*
+  rows of the Gram matrix belonging to the training set
+  are listed first, followed by those of left-out objects
+  in the order used by pred_y_values(); left-out objects
+  are given zero weight
+  */
+  n = 0;
+  n_train = 0;
+  n_test = 0;
+  for (object_num = 0, y = 0; object_num < od->object_num; ++object_num) {
+    if (!get_object_attr(od, object_num, ACTIVE_BIT)) {
+      continue;
+    }
+    if ((n < od->pel.out_structs->size) && (od->al.mol_info[object_num]
+      ->struct_num == od->pel.out_structs->pe[n])) {
+      ++n;
+      rows->pe[active_object_num + n_test] = y;
+      ++n_test;
+      w->ve[y] = 0.0;
+    }
+    else {
+      rows->pe[n_train] = y;
+      ++n_train;
+      w->ve[y] = od->mel.object_weight[object_num];
+      sumweight += w->ve[y];
+    }
+    ++y;
+  }
+  /*
+  g = Gw / sum(w), c = w'g / sum(w)
+  */
+  cblas_dgemv(CblasColMajor, CblasNoTrans,
+    gram->m, gram->n,
+    ((sumweight > 0.0) ? 1.0 / sumweight : 0.0),
+    gram->base, gram->max_m,
+    w->ve, 1, 0.0, g->ve, 1);
+  od->cv.kernel_c = ((sumweight > 0.0)
+    ? cblas_ddot(gram->m, w->ve, 1, g->ve, 1) / sumweight : 0.0);
+  /*
+  K = W^(1/2) (G[S][S] - g[S]1' - 1g[S]' + c) W^(1/2)
+  */
+  od->mal.e_mat = double_mat_resize(od->mal.e_mat,
+    active_object_num, active_object_num);
+  for (j = 0; j < active_object_num; ++j) {
+    for (i = 0; i < active_object_num; ++i) {
+      M_POKE(od->mal.e_mat, i, j,
+        (M_PEEK(gram, rows->pe[i], rows->pe[j])
+        - g->ve[rows->pe[i]] - g->ve[rows->pe[j]]
+        + od->cv.kernel_c)
+        * sqrt(w->ve[rows->pe[i]] * w->ve[rows->pe[j]]));
+    }
+  }
+}
+
+
+void fill_kernel_x_vector(O3Data *od, int object_num, int row)
+{
+  int j;
+  int test_row;
+  double sqrt_weight;
+  DoubleMat *gram;
+  DoubleVec *w;
+  DoubleVec *g;
+  IntPerm *rows;
+  
+  
+  gram = od->mal.kernel_gram;
+  w = od->vel.kernel_w;
+  g = od->vel.kernel_g;
+  rows = od->pel.kernel_rows;
+  /*
+  the training kernel is as wide as the training set
+  */
+  test_row = rows->pe[od->mal.e_mat->n + row];
+  sqrt_weight = sqrt(od->mel.object_weight[object_num]);
+  for (j = 0; j < od->mal.e_mat->n; ++j) {
+    M_POKE(od->mal.e_mat, row, j,
+      (M_PEEK(gram, test_row, rows->pe[j])
+      - g->ve[test_row] - g->ve[rows->pe[j]]
+      + od->cv.kernel_c)
+      * sqrt_weight * sqrt(w->ve[rows->pe[j]]));
+  }
+}
@@ -0,0 +1,454 @@
+/*
+
+kernel_pls.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+kernel PLS for wide matrices (many more variables than objects);
+components are extracted from the m x m kernel matrix K = EE',
+which is deflated in place, so that each iteration costs O(m^2)
+instead of O(mn). Weights and loadings are reconstructed from
+the undeflated E in a final pass, so that they are equivalent
+to those computed by NIPALS in pls().
+In kernel CV (see kernel_cv.c) E already holds the training
+kernel, so that objects take the place of variables: weights
+and loadings are then returned in this dual space, and
+pred_y_values() works unchanged on the test cross-kernel
+*/
+void kernel_pls(O3Data *od, int suggested_pc_num, int model_type)
+{
+  int i;
+  int j;
+  int pc_num;
+  int kernel_cv;
+  DoubleMat *k_mat;
+  DoubleMat *k_u;
+    
+
+  pc_num = suggested_pc_num;
+  if (suggested_pc_num > od->mal.e_mat->n) {
+    pc_num = od->mal.e_mat->n;
+  }
+  kernel_pls_resize(od, od->mal.e_mat->m, od->mal.e_mat->n, pc_num);
+  k_mat = od->mal.kernel_mat;
+  k_u = od->mal.kernel_u;
+  kernel_cv = (od->cv.kernel_cv && (model_type & CV_MODEL));
+
+  if (kernel_cv) {
+    for (j = 0; j < k_mat->n; ++j) {
+      cblas_dcopy(k_mat->m,
+        &M_PEEK(od->mal.e_mat, 0, j), 1,
+        &M_PEEK(k_mat, 0, j), 1);
+    }
+  }
+  else if (od->pls_incremental && (model_type & FULL_MODEL)
+    && od->gram.valid) {
+    /*
+    K is derived from the Gram matrix kept across
+    commands, which update_gram_cache() has just
+    brought up to date with the current objects
+    */
+    gram_cache_kernel(od, k_mat);
+  }
+  else {
+    /*
+    K = EE'
+    */
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+      od->mal.e_mat->m,
+      od->mal.e_mat->m,
+      od->mal.e_mat->n, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m, 0.0,
+      k_mat->base, k_mat->max_m);
+  }
+  kernel_pls_extract(od, pc_num, model_type);
+  if (kernel_cv) {
+    /*
+    in the dual space c = v~
+    */
+    for (i = 0; i <= pc_num; ++i) {
+      cblas_dcopy(k_u->m,
+        &M_PEEK(k_u, 0, i), 1,
+        &M_PEEK(od->mal.x_weights, 0, i), 1);
+    }
+  }
+  else {
+    /*
+    c = E'v~
+    */
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+      od->mal.e_mat->n,
+      pc_num + 1,
+      od->mal.e_mat->m, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m,
+      k_u->base, k_u->max_m, 0.0,
+      od->mal.x_weights->base,
+      od->mal.x_weights->max_m);
+  }
+  /*
+  b = E[i]'u / u'u = E'u / u'u
+  (in kernel CV E is the symmetric training kernel,
+  so the same product yields the dual loadings)
+  */
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+    od->mal.e_mat->n,
+    pc_num + 1,
+    od->mal.e_mat->m, 1.0,
+    od->mal.e_mat->base,
+    od->mal.e_mat->max_m,
+    od->mal.x_scores->base,
+    od->mal.x_scores->max_m, 0.0,
+    od->mal.x_loadings->base,
+    od->mal.x_loadings->max_m);
+  kernel_pls_normalize(od, pc_num);
+  /*
+  NIPALS leaves the X residuals in E; the full model
+  needs them for leverage calculation, so
+  E[pc_num + 1] = E - UB'
+  */
+  if (model_type & FULL_MODEL) {
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+      od->mal.e_mat->m,
+      od->mal.e_mat->n,
+      pc_num + 1, -1.0,
+      od->mal.x_scores->base,
+      od->mal.x_scores->max_m,
+      od->mal.x_loadings->base,
+      od->mal.x_loadings->max_m, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m);
+  }
+}
+
+
+/*
+logical resizing of the matrices and vectors used by kernel PLS
+for an m x n E matrix; they have been allocated with maximal
+size by alloc_pls(), so there is no need to check return values
+*/
+void kernel_pls_resize(O3Data *od, int m, int n, int pc_num)
+{
+  double_mat_resize(od->mal.x_scores,
+    m, pc_num + 1);
+  double_mat_resize(od->mal.x_weights,
+    n, pc_num + 1);
+  double_mat_resize(od->mal.x_loadings,
+    n, pc_num + 1);
+  double_mat_resize(od->mal.pred_f_mat,
+    m, od->mal.f_mat->n);
+  double_vec_resize(od->vel.ave_sdep, pc_num + 1);
+  double_vec_resize(od->vel.v, m);
+  double_vec_resize(od->vel.v_new, m);
+  double_mat_resize(od->mal.y_loadings,
+    od->mal.f_mat->n, pc_num + 1);
+  double_mat_resize(od->mal.y_scores,
+    od->mal.f_mat->m, pc_num + 1);
+  double_vec_resize(od->vel.ro, pc_num + 1);
+  double_mat_resize(od->mal.kernel_mat, m, m);
+  double_mat_resize(od->mal.kernel_u, m, pc_num + 1);
+  double_vec_resize(od->vel.kernel_t, m);
+  od->pc_num = pc_num;
+}
+
+
+/*
+extract pc_num + 1 components from the kernel K = EE' stored
+in od->mal.kernel_mat, which is deflated in place; scores go
+to od->mal.x_scores, while od->mal.kernel_u collects the
+vectors v~ from which the weights c = E'v~ are reconstructed
+*/
+void kernel_pls_extract(O3Data *od, int pc_num, int model_type)
+{
+  int i;
+  int j;
+  int x;
+  int conv;
+  double norm_c;
+  double norm_d;
+  double ss_u;
+  double ss_v_diff;
+  double ss_ktu;
+  double s2_x_tot;
+  double s2_x_tot_start = 0.0;
+  double s2_y_tot;
+  double s2_y_tot_start = 0.0;
+  double sum_object_weight = 0.0;
+  double cum_explained_s2_x = 0.0;
+  double cum_explained_s2_y = 0.0;
+  DoubleMat *k_mat;
+  DoubleMat *k_u;
+  DoubleVec *k_t;
+  
+  
+  k_mat = od->mal.kernel_mat;
+  k_u = od->mal.kernel_u;
+  k_t = od->vel.kernel_t;
+  /*
+  Copy first dependent variable into vector v
+  */
+  cblas_dcopy(od->mal.f_mat->m,
+    od->mal.f_mat->base, 1,
+    od->vel.v->ve, 1);
+  /*
+  calculate total variances of the E, F matrices;
+  the variance of E[i] is the trace of K[i]
+  */
+  if (model_type & FULL_MODEL) {
+    for (i = 0; i < od->object_num; ++i) {
+      if (get_object_attr(od, i, ACTIVE_BIT)) {
+        sum_object_weight += od->mel.object_weight[i];
+      }
+    }
+    for (j = 0, s2_x_tot_start = 0.0; j < k_mat->m; ++j) {
+      s2_x_tot_start += M_PEEK(k_mat, j, j);
+    }
+    for (x = 0, s2_y_tot_start = 0.0; x < od->mal.f_mat->n; ++x) {
+      s2_y_tot_start += cblas_ddot(od->mal.f_mat->m,
+        &M_PEEK(od->mal.f_mat, 0, x), 1, &M_PEEK(od->mal.f_mat, 0, x), 1);
+    }
+    tee_printf(od, "  %12s%12s%12s%12s\n", "Exp.", "Cum. exp.",
+      "Exp.", "Cum. exp.");
+    tee_printf(od, "PC%12s%12s%12s%12s%12s%12s\n", "var. X %", "var. X %",
+      "var. Y %", "var. Y %", "SDEC", "r2");
+    tee_printf(od, "--------------------------------------------------------------------------\n");
+  }
+  for (i = 0; i <= pc_num; ++i) {
+    if (model_type & FULL_MODEL) {
+      for (j = 0, s2_x_tot = 0.0; j < k_mat->m; ++j) {
+        s2_x_tot += M_PEEK(k_mat, j, j);
+      }
+      for (x = 0, s2_y_tot = 0.0; x < od->mal.f_mat->n; ++x) {
+        s2_y_tot += cblas_ddot(od->mal.f_mat->m,
+          &M_PEEK(od->mal.f_mat, 0, x), 1, &M_PEEK(od->mal.f_mat, 0, x), 1);
+      }
+      od->vel.explained_s2_x->ve[i] =
+        1.0 - cum_explained_s2_x - s2_x_tot / s2_x_tot_start;
+      cum_explained_s2_x += od->vel.explained_s2_x->ve[i];
+      od->vel.explained_s2_y->ve[i] =
+        1.0 - cum_explained_s2_y - s2_y_tot / s2_y_tot_start;
+      cum_explained_s2_y += od->vel.explained_s2_y->ve[i];
+      od->vel.ave_sdec->ve[i] =
+        sqrt(s2_y_tot / sum_object_weight);
+      od->vel.r2->ve[i] = cum_explained_s2_y;
+      tee_printf(od, "%2d%12.4lf%12.4lf%12.4lf%12.4lf%12.4lf%12.4lf\n",
+        i, od->vel.explained_s2_x->ve[i] * 100,
+        cum_explained_s2_x * 100,
+        od->vel.explained_s2_y->ve[i] * 100,
+        cum_explained_s2_y * 100,
+        od->vel.ave_sdec->ve[i],
+        cum_explained_s2_y);
+    }
+    conv = 0;
+    while (!conv) {
+      /*
+      keep track of v, since c = E[i]'v will be
+      reconstructed from it at the end
+      */
+      cblas_dcopy(od->vel.v->size,
+        od->vel.v->ve, 1,
+        &M_PEEK(k_u, 0, i), 1);
+      /*
+      u = E[i]c = K[i]v * (v'K[i]v)^(-0.5)
+      */
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        k_mat->m, k_mat->n, 1.0,
+        k_mat->base, k_mat->max_m,
+        od->vel.v->ve, 1, 0.0,
+        &M_PEEK(od->mal.x_scores, 0, i), 1);
+      norm_c = sqrt(cblas_ddot(od->vel.v->size,
+        od->vel.v->ve, 1,
+        &M_PEEK(od->mal.x_scores, 0, i), 1));
+      cblas_dscal(od->mal.x_scores->m, 1.0 / norm_c,
+        &M_PEEK(od->mal.x_scores, 0, i), 1);
+      /*
+      d = F[i]'u
+      */
+      cblas_dgemv(CblasColMajor, CblasTrans,
+        od->mal.f_mat->m,
+        od->mal.f_mat->n, 1.0,
+        od->mal.f_mat->base,
+        od->mal.f_mat->max_m,
+        &M_PEEK(od->mal.x_scores, 0, i), 1, 0.0,
+        &M_PEEK(od->mal.y_loadings, 0, i), 1);
+      /*
+      d = d * (d'd)^(-0.5)
+      */
+      norm_d = cblas_dnrm2(od->mal.y_loadings->m,
+        &M_PEEK(od->mal.y_loadings, 0, i), 1);
+      cblas_dscal(od->mal.y_loadings->m, 1.0 / norm_d,
+        &M_PEEK(od->mal.y_loadings, 0, i), 1);
+      /*
+      v_new = F[i]d
+      */
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        od->mal.f_mat->m,
+        od->mal.f_mat->n, 1.0,
+        od->mal.f_mat->base,
+        od->mal.f_mat->max_m,
+        &M_PEEK(od->mal.y_loadings, 0, i),
+        1, 0.0, od->vel.v_new->ve, 1);
+      conv = 1;
+      if (od->mal.f_mat->n > 1) {
+        /*
+        if there are multiple y vars, check convergence
+        */
+        cblas_daxpy(od->vel.v_new->size, -1.0,
+          od->vel.v_new->ve, 1,
+          od->vel.v->ve, 1);
+        ss_v_diff = cblas_ddot(od->mal.y_scores->m,
+          od->vel.v->ve, 1,
+          od->vel.v->ve, 1);
+        if (fabs(ss_v_diff) >= PLS_CONV_THRESHOLD) {
+          conv = 0;
+        }
+      }
+      cblas_dcopy(od->vel.v_new->size,
+        od->vel.v_new->ve, 1,
+        od->vel.v->ve, 1);
+    }
+    /*
+    since E[i] = (I - sum(u[j]u[j]' / u[j]'u[j])) E for j < i,
+    E[i]'v = E'v~, where v~ is v projected out of previous scores;
+    v~ is also scaled such that c = E'v~ has unit norm
+    */
+    for (j = 0; j < i; ++j) {
+      cblas_daxpy(k_u->m,
+        - cblas_ddot(k_u->m,
+        &M_PEEK(od->mal.x_scores, 0, j), 1,
+        &M_PEEK(k_u, 0, i), 1)
+        / cblas_ddot(k_u->m,
+        &M_PEEK(od->mal.x_scores, 0, j), 1,
+        &M_PEEK(od->mal.x_scores, 0, j), 1),
+        &M_PEEK(od->mal.x_scores, 0, j), 1,
+        &M_PEEK(k_u, 0, i), 1);
+    }
+    cblas_dscal(k_u->m, 1.0 / norm_c, &M_PEEK(k_u, 0, i), 1);
+    /*
+    ro = u'v / u'u
+    */
+    ss_u = cblas_ddot(od->mal.x_scores->m,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      &M_PEEK(od->mal.x_scores, 0, i), 1);
+    od->vel.ro->ve[i] =
+      cblas_ddot(od->mal.x_scores->m,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      od->vel.v->ve, 1) / ss_u;
+    
+    if (model_type & FULL_MODEL) {
+      cblas_dcopy(od->mal.f_mat->m,
+        od->vel.v->ve, 1,
+        &M_PEEK(od->mal.y_scores, 0, i), 1);
+    }
+    /*
+    d = ro d
+    */
+    cblas_dscal(od->mal.y_loadings->m,
+      od->vel.ro->ve[i],
+      &M_PEEK(od->mal.y_loadings, 0, i), 1);
+    /*
+    F[i + 1] = F[i] - ud'
+    */
+    cblas_dger(CblasColMajor,
+      od->mal.f_mat->m,
+      od->mal.f_mat->n, -1.0,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      od->mal.f_mat->base,
+      od->mal.f_mat->max_m);
+    /*
+    K[i + 1] = (I - uu' / u'u) K[i] (I - uu' / u'u)
+    = K[i] - (uz' + zu') / u'u
+    where z = K[i]u - (u'K[i]u / 2u'u) u
+    */
+    cblas_dgemv(CblasColMajor, CblasNoTrans,
+      k_mat->m, k_mat->n, 1.0,
+      k_mat->base, k_mat->max_m,
+      &M_PEEK(od->mal.x_scores, 0, i), 1, 0.0,
+      k_t->ve, 1);
+    ss_ktu = cblas_ddot(k_t->size,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      k_t->ve, 1);
+    cblas_daxpy(k_t->size, -0.5 * ss_ktu / ss_u,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      k_t->ve, 1);
+    cblas_dger(CblasColMajor,
+      k_mat->m, k_mat->n, -1.0 / ss_u,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      k_t->ve, 1,
+      k_mat->base, k_mat->max_m);
+    cblas_dger(CblasColMajor,
+      k_mat->m, k_mat->n, -1.0 / ss_u,
+      k_t->ve, 1,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      k_mat->base, k_mat->max_m);
+  }
+}
+
+
+void kernel_pls_normalize(O3Data *od, int pc_num)
+{
+  int i;
+  double norm_c;
+  double ss_u;
+  
+  
+  for (i = 0; i <= pc_num; ++i) {
+    /*
+    renormalize c to remove the round-off
+    accumulated while deflating K
+    */
+    norm_c = cblas_dnrm2(od->mal.x_weights->m,
+      &M_PEEK(od->mal.x_weights, 0, i), 1);
+    cblas_dscal(od->mal.x_weights->m, 1.0 / norm_c,
+      &M_PEEK(od->mal.x_weights, 0, i), 1);
+    ss_u = cblas_ddot(od->mal.x_scores->m,
+      &M_PEEK(od->mal.x_scores, 0, i), 1,
+      &M_PEEK(od->mal.x_scores, 0, i), 1);
+    cblas_dscal(od->mal.x_loadings->m, 1.0 / ss_u,
+      &M_PEEK(od->mal.x_loadings, 0, i), 1);
+  }
+}
@@ -0,0 +1,130 @@
+/*
+
+lmo_convergence.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+
+/*
+two-sided 95% quantile of Student's t distribution
+with dof degrees of freedom (Cornish-Fisher expansion
+around the normal quantile, accurate to 1.0e-02
+for dof >= 4)
+*/
+static double student_t_95(int dof)
+{
+  double z;
+  double z2;
+  double n;
+  
+  
+  z = 1.959964;
+  z2 = z * z;
+  n = (double)dof;
+  
+  return z + (z2 + 1.0) * z / (4.0 * n)
+    + ((5.0 * z2 + 16.0) * z2 + 3.0) * z / (96.0 * n * n)
+    + (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z
+    / (384.0 * n * n * n);
+}
+
+
+/*
+returns 1 when, for all PCs, the 95% confidence interval
+of the average q2 over the first runs_done LMO runs is
+narrower than od->cv.runs_tolerance; q2 for each run is
+recovered from its SDEP, which is stored in sdep_mat by
+whichever thread carried out the run. Since runs are always
+evaluated in run order, the number of runs needed to meet
+the tolerance does not depend on the number of threads
+*/
+int check_lmo_convergence(O3Data *od, int runs_done, int pc_num)
+{
+  int i;
+  int j;
+  double run_tss;
+  double run_predictions;
+  double q2;
+  double ave;
+  double sum2;
+  double delta;
+  double half_width;
+  
+  
+  if (runs_done < MIN_AUTO_LMO_RUNS) {
+    return 0;
+  }
+  run_tss = od->cv.tss / (double)(od->cv.runs);
+  run_predictions = (double)(od->y_vars * od->cv.active_struct_num);
+  for (j = 1; j <= pc_num; ++j) {
+    ave = 0.0;
+    sum2 = 0.0;
+    for (i = 0; i < runs_done; ++i) {
+      q2 = 1.0 - square(M_PEEK(od->mal.sdep_mat, i, j))
+        * run_predictions / run_tss;
+      delta = q2 - ave;
+      ave += delta / (double)(i + 1);
+      sum2 += delta * (q2 - ave);
+    }
+    half_width = student_t_95(runs_done - 1)
+      * sqrt(sum2 / (double)((runs_done - 1) * runs_done));
+    if ((2.0 * half_width) >= od->cv.runs_tolerance) {
+      return 0;
+    }
+  }
+  
+  return 1;
+}
+
+
+void print_lmo_convergence(O3Data *od, int runs)
+{
+  if (runs < od->cv.runs) {
+    tee_printf(od, "\nThe 95%% confidence interval of average q2 "
+      "was narrower than %.4lf after %d runs.\n",
+      od->cv.runs_tolerance, runs);
+  }
+  else {
+    tee_printf(od, "\nThe 95%% confidence interval of average q2 "
+      "was still wider than %.4lf after %d runs.\n",
+      od->cv.runs_tolerance, runs);
+  }
+}
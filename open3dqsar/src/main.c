@@ -704,6 +704,11 @@ int main(int argc, char **argv)
     "  -i <filein>                Input is read from <filein>\n"
     "  -o <fileout>               Output is written to <fileout>\n"
     "  -p                         Input is piped through standard input\n"
+    #ifdef O3Q
+    "      --worker <address>     Carry out CV tasks on behalf of the\n"
+    "                             "PACKAGE_NAME" process listening\n"
+    "                             at <address>\n"
+    #endif
     "  -?, --help                 Give this help list\n"
     "      --usage                Give a short usage message\n"
     "  -V, --version              Print program version\n"
@@ -712,6 +717,9 @@ int main(int argc, char **argv)
     "\n";
   char usage[] =
     "Usage: "PACKAGE_NAME_LOWERCASE" [-p?V] [-i FILE] [-o FILE] "
+    #ifdef O3Q
+    "[--worker ADDRESS] "
+    #endif
     "[--help] [--usage] [--version]\n";
   int i;
   int result;
@@ -815,6 +823,18 @@ int main(int argc, char **argv)
   strncpy(bin, argv[0], BUF_LEN - 2);
   absolute_path(bin);
   get_dirname(bin);
+  #ifdef O3Q
+  /*
+  worker processes are spawned from this same executable
+  */
+  if (strchr(argv[0], SEPARATOR)) {
+    strncpy(od.workers.exe, argv[0], BUF_LEN - 2);
+    absolute_path(od.workers.exe);
+  }
+  else if (!is_in_path(argv[0], od.workers.exe)) {
+    strncpy(od.workers.exe, argv[0], BUF_LEN - 2);
+  }
+  #endif
   dl_handle = check_readline();
   if (have_editline) {
     memset(el_rc, 0, BUF_LEN);
@@ -895,6 +915,23 @@ int main(int argc, char **argv)
         return -1;
       }
     }
+    #ifdef O3Q
+    else if (!strcmp(argv[i], "--worker")) {
+      if ((i + 1) < argc) {
+        strncpy(cli_args.worker_address, argv[i + 1], BUF_LEN);
+        cli_args.worker_address[BUF_LEN - 2] = '\0';
+        cli_args.worker = 1;
+        cli_args.prompt = 0;
+        i += 2;
+        continue;
+      }
+      else {
+        fprintf(stderr, option_requires_argument, "worker");
+        fputs(try_help_usage, stderr);
+        return -1;
+      }
+    }
+    #endif
     else if (!strcmp(argv[i], "--term")) {
       od.terminal = 1;
       #ifdef WIN32
@@ -1086,7 +1123,7 @@ int main(int argc, char **argv)
   #else
   SET_INK(&od, NORMAL_INK);
   #endif
-  od.mti = MERSENNE_N + 1;
+  od.mt_stream.mti = MERSENNE_N + 1;
   tee_printf(&od, "%s\n", package_version);
   tee_flush(&od);
   get_system_information(&od);
@@ -1096,6 +1133,7 @@ int main(int argc, char **argv)
     determine_best_cpu_number(&od, n_cpus_string);
   }
   tee_printf(&od, M_NUMBER_OF_CPUS, PACKAGE_NAME, od.n_proc);
+  init_blas_threads(&od);
   
   /*
   if the O3_NICE environment variable
@@ -1630,7 +1668,19 @@ int main(int argc, char **argv)
   }
   tee_flush(&od);
   result = 0;
-  if (!(cli_args.prompt) && (cli_args.input)) {
+  #ifdef O3Q
+  if (cli_args.worker) {
+    /*
+    in worker mode no input is read: tasks
+    are received from the main process
+    */
+    result = run_worker(&od, cli_args.worker_address);
+    if (result) {
+      tee_printf(&od, "Abnormal exit.\n");
+    }
+  }
+  #endif
+  if ((!(cli_args.worker)) && (!(cli_args.prompt)) && (cli_args.input)) {
     /*
     if an input script is being sourced,
     make a dry run to check out its consistency
@@ -1646,7 +1696,7 @@ int main(int argc, char **argv)
       od.field_num = 0;
     }
   }
-  if (!result) {
+  if ((!(cli_args.worker)) && (!result)) {
     result = parse_input(&od, od.in, cli_args.prompt);
     if (!get_current_time(current_time)) {
       tee_printf(&od, "\n\n"
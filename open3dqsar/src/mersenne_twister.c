@@ -47,22 +47,26 @@
 /* initializes mt[MERSENNE_N] with a seed */
 void init_genrand(O3Data *od, unsigned long s)
 {
-  od->mt[0]= s & 0xffffffffUL;
-  for (od->mti = 1; od->mti < MERSENNE_N; ++(od->mti)) {
-    od->mt[od->mti] = 
-      (1812433253UL * (od->mt[od->mti-1]
-      ^ (od->mt[od->mti-1] >> 30)) + od->mti); 
+  RandomStream *rs;
+  
+  
+  rs = &(od->mt_stream);
+  rs->mt[0]= s & 0xffffffffUL;
+  for (rs->mti = 1; rs->mti < MERSENNE_N; ++(rs->mti)) {
+    rs->mt[rs->mti] = 
+      (1812433253UL * (rs->mt[rs->mti-1]
+      ^ (rs->mt[rs->mti-1] >> 30)) + rs->mti); 
     /* See Knuth TAOCP Vol2. 3rd Ed. P.106 for coefficient. */
     /* In the previous versions, MSBs of the seed affect   */
     /* only MSBs of the array mt[].                        */
     /* 2002/01/09 modified by Makoto Matsumoto             */
-    od->mt[od->mti] &= 0xffffffffUL;
+    rs->mt[rs->mti] &= 0xffffffffUL;
     /* for >32 bit machines */
   }
 }
 
-/* generates a random number on [0,0xffffffff]-interval */
-unsigned long genrand_int32(O3Data *od)
+/* generates MERSENNE_N words at one time */
+static void next_genrand_state(RandomStream *rs)
 {
   unsigned long y;
   static unsigned long mag01[2] = { 0x0UL, MATRIX_A };
@@ -70,25 +74,31 @@ unsigned long genrand_int32(O3Data *od)
 
   /* mag01[x] = x * MATRIX_A  for x=0,1 */
 
-  if (od->mti >= MERSENNE_N) { /* generate MERSENNE_N words at one time */
-    if (od->mti == (MERSENNE_N + 1))   /* if init_genrand() has not been called, */
-      init_genrand(od, od->random_seed); /* a default initial seed is used */
+  for (kk = 0; kk < (MERSENNE_N - MERSENNE_M); ++kk) {
+    y = (rs->mt[kk] & UPPER_MASK) | (rs->mt[kk + 1] & LOWER_MASK);
+    rs->mt[kk] = rs->mt[kk + MERSENNE_M] ^ (y >> 1) ^ mag01[y & 0x1UL];
+  }
+  for (; kk < (MERSENNE_N - 1); ++kk) {
+    y = (rs->mt[kk] & UPPER_MASK) | (rs->mt[kk + 1] & LOWER_MASK);
+    rs->mt[kk] = rs->mt[kk + (MERSENNE_M - MERSENNE_N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
+  }
+  y = (rs->mt[MERSENNE_N - 1] & UPPER_MASK) | (rs->mt[0] & LOWER_MASK);
+  rs->mt[MERSENNE_N - 1] = rs->mt[MERSENNE_M - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
 
-    for (kk = 0; kk < (MERSENNE_N - MERSENNE_M); ++kk) {
-      y = (od->mt[kk] & UPPER_MASK) | (od->mt[kk + 1] & LOWER_MASK);
-      od->mt[kk] = od->mt[kk + MERSENNE_M] ^ (y >> 1) ^ mag01[y & 0x1UL];
-    }
-    for (; kk < (MERSENNE_N - 1); ++kk) {
-      y = (od->mt[kk] & UPPER_MASK) | (od->mt[kk + 1] & LOWER_MASK);
-      od->mt[kk] = od->mt[kk + (MERSENNE_M - MERSENNE_N)] ^ (y >> 1) ^ mag01[y & 0x1UL];
-    }
-    y = (od->mt[MERSENNE_N - 1] & UPPER_MASK) | (od->mt[0] & LOWER_MASK);
-    od->mt[MERSENNE_N - 1] = od->mt[MERSENNE_M - 1] ^ (y >> 1) ^ mag01[y & 0x1UL];
+  rs->mti = 0;
+}
+
+/* generates a random number on [0,0xffffffff]-interval
+   from an initialized stream */
+unsigned long genrand_stream_int32(RandomStream *rs)
+{
+  unsigned long y;
 
-    od->mti = 0;
+  if (rs->mti >= MERSENNE_N) {
+    next_genrand_state(rs);
   }
   
-  y = od->mt[(od->mti)++];
+  y = rs->mt[(rs->mti)++];
 
   /* Tempering */
   y ^= (y >> 11);
@@ -99,6 +109,43 @@ unsigned long genrand_int32(O3Data *od)
   return y;
 }
 
+/* generates a random number on [0,1]-real-interval
+   from an initialized stream */
+double genrand_stream_real(RandomStream *rs)
+{
+  return genrand_stream_int32(rs) * (1.0 / 4294967295.0); 
+  /* divided by 2^32-1 */ 
+}
+
+/* jumps n numbers ahead along an initialized stream;
+   tempering is skipped, and whole blocks of MERSENNE_N
+   numbers only cost one state update */
+void skip_genrand_stream(RandomStream *rs, unsigned long n)
+{
+  unsigned long left;
+  
+  while (n) {
+    if (rs->mti >= MERSENNE_N) {
+      next_genrand_state(rs);
+    }
+    left = (unsigned long)(MERSENNE_N - rs->mti);
+    if (left > n) {
+      left = n;
+    }
+    rs->mti += (int)left;
+    n -= left;
+  }
+}
+
+/* generates a random number on [0,0xffffffff]-interval */
+unsigned long genrand_int32(O3Data *od)
+{
+  if (od->mt_stream.mti == (MERSENNE_N + 1))   /* if init_genrand() has not been called, */
+    init_genrand(od, od->random_seed); /* a default initial seed is used */
+
+  return genrand_stream_int32(&(od->mt_stream));
+}
+
 /* generates a random number on [0,1]-real-interval */
 double genrand_real(O3Data *od)
 {
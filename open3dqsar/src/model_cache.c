@@ -0,0 +1,159 @@
+/*
+
+model_cache.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+
+
+static int cache_resize(double **array, int size)
+{
+  double *new_array;
+  
+  
+  new_array = (double *)realloc(*array,
+    ((size > 0) ? size : 1) * sizeof(double));
+  if (!new_array) {
+    return OUT_OF_MEMORY;
+  }
+  *array = new_array;
+  
+  return 0;
+}
+
+
+int cache_pls_model(O3Data *od)
+{
+  int i;
+  int x_vars;
+  int y_vars;
+  int pc_num;
+  int rows;
+  
+  
+  /*
+  keep an in-memory copy of the full PLS model just built,
+  so that commands run after pls can reuse it instead of
+  reading it back from TEMP_WLS and TEMP_PLS_COEFF; the copy
+  is laid out exactly as the temporary files are, and it is
+  only trusted as long as od->attr_generation is unchanged
+  */
+  od->model.valid = 0;
+  x_vars = od->mal.x_weights->m;
+  y_vars = od->mal.f_mat->n;
+  pc_num = od->pc_num;
+  rows = od->mal.x_scores->m;
+  if (cache_resize(&(od->model.x_weights), x_vars * (pc_num + 1))
+    || cache_resize(&(od->model.x_loadings), x_vars * (pc_num + 1))
+    || cache_resize(&(od->model.y_loadings), y_vars * (pc_num + 1))
+    || cache_resize(&(od->model.b_coefficients),
+    x_vars * y_vars * (pc_num + 1))
+    || cache_resize(&(od->model.x_scores), rows * pc_num)
+    || cache_resize(&(od->model.e_mat_ave), x_vars)
+    || cache_resize(&(od->model.f_mat_ave), y_vars)) {
+    free_model_cache(od);
+    return OUT_OF_MEMORY;
+  }
+  if (od->mal.y_scores) {
+    if (cache_resize(&(od->model.y_scores), rows * pc_num)) {
+      free_model_cache(od);
+      return OUT_OF_MEMORY;
+    }
+  }
+  else if (od->model.y_scores) {
+    free(od->model.y_scores);
+    od->model.y_scores = NULL;
+  }
+  memcpy(od->model.x_weights, od->mal.x_weights->base,
+    x_vars * (pc_num + 1) * sizeof(double));
+  memcpy(od->model.x_loadings, od->mal.x_loadings->base,
+    x_vars * (pc_num + 1) * sizeof(double));
+  memcpy(od->model.y_loadings, od->mal.y_loadings->base,
+    y_vars * (pc_num + 1) * sizeof(double));
+  for (i = 0; i < pc_num; ++i) {
+    cblas_dcopy(rows, &M_PEEK(od->mal.x_scores, 0, i), 1,
+      &(od->model.x_scores[i * rows]), 1);
+    if (od->model.y_scores) {
+      cblas_dcopy(rows, &M_PEEK(od->mal.y_scores, 0, i), 1,
+        &(od->model.y_scores[i * rows]), 1);
+    }
+  }
+  memcpy(od->model.e_mat_ave, od->vel.e_mat_ave->ve,
+    x_vars * sizeof(double));
+  memcpy(od->model.f_mat_ave, od->vel.f_mat_ave->ve,
+    y_vars * sizeof(double));
+  od->model.pc_num = pc_num;
+  od->model.x_vars = x_vars;
+  od->model.y_vars = y_vars;
+  od->model.score_rows = rows;
+  od->model.generation = od->attr_generation;
+  
+  return 0;
+}
+
+
+void cache_pls_coefficients(O3Data *od, int pc_num)
+{
+  int x;
+  int x_vars;
+  int y_vars;
+  
+  
+  /*
+  coefficients for pc_num components are stored
+  in block pc_num, one column per y variable
+  */
+  x_vars = od->model.x_vars;
+  y_vars = od->model.y_vars;
+  for (x = 0; x < y_vars; ++x) {
+    cblas_dcopy(x_vars, &M_PEEK(od->mal.b_coefficients, 0, x), 1,
+      &(od->model.b_coefficients[(pc_num * y_vars + x) * x_vars]), 1);
+  }
+}
+
+
+int model_cache_valid(O3Data *od)
+{
+  return (od->model.valid && (od->valid & PLS_BIT)
+    && (od->model.generation == od->attr_generation)
+    && (od->model.x_vars == od->overall_active_x_vars)
+    && (od->model.y_vars == od->y_vars));
+}
@@ -0,0 +1,313 @@
+/*
+
+nested_cv.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+
+/*
+nested CV: each LMO run is split into groups as usual
+(outer folds); the training set of each outer fold is in
+turn split into inner_groups inner folds, whose PRESS
+chooses the number of PCs for that outer fold only, so
+that the objects which are predicted never take part
+in choosing the model complexity.
+Inner folds are drawn from the outer training set in the
+(random) order of the outer run composition, hence they
+depend neither on the number of threads nor on which
+thread carried out the run
+*/
+static int fill_nested_out_structs(O3Data *od, int run,
+  int outer_group, int inner_group, int with_outer)
+{
+  int n;
+  int count;
+  int group_num;
+  int struct_count;
+  IntMat *group_composition;
+  
+  
+  group_composition = od->cimal.group_composition_list[run];
+  n = 0;
+  if (with_outer) {
+    for (struct_count = 0;
+      struct_count < od->mel.struct_per_group[outer_group];
+      ++struct_count) {
+      od->pel.out_structs->pe[n] =
+        group_composition->me[outer_group][struct_count];
+      ++n;
+    }
+  }
+  if (inner_group >= 0) {
+    for (group_num = 0, count = 0; group_num < od->cv.groups; ++group_num) {
+      if (group_num == outer_group) {
+        continue;
+      }
+      for (struct_count = 0;
+        struct_count < od->mel.struct_per_group[group_num];
+        ++struct_count, ++count) {
+        if ((count % od->cv.inner_groups) == inner_group) {
+          od->pel.out_structs->pe[n] =
+            group_composition->me[group_num][struct_count];
+          ++n;
+        }
+      }
+    }
+  }
+  od->pel.out_structs->size = n;
+  qsort(od->pel.out_structs->pe, n, sizeof(int), compare_integers);
+  
+  return n;
+}
+
+
+/*
+the training set is trimmed and mean-centered starting
+from the same large E and F matrices (and their column
+sums) used by outer folds, so nothing is recomputed
+from the field data
+*/
+static void fit_nested_fold(ThreadInfo *ti, int object_count)
+{
+  trim_mean_center_matrix(&(ti->od), ti->od.mal.large_e_mat,
+    ti->od.mal.large_e_mat_sum,
+    &(ti->od.mal.e_mat), &(ti->od.vel.e_mat_ave),
+    ti->model_type, ti->od.active_object_num - object_count);
+  trim_mean_center_matrix(&(ti->od), ti->od.mal.large_f_mat,
+    ti->od.mal.large_f_mat_sum,
+    &(ti->od.mal.f_mat), &(ti->od.vel.f_mat_ave),
+    ti->model_type, ti->od.active_object_num - object_count);
+  pls(&(ti->od), ti->pc_num, ti->model_type);
+}
+
+
+static void clear_press(ThreadInfo *ti, DoubleMat *press)
+{
+  int i;
+  int x;
+  
+  
+  for (x = 0; x < ti->od.y_vars; ++x) {
+    for (i = 0; i <= ti->pc_num; ++i) {
+      M_POKE(press, i, x, 0.0);
+    }
+  }
+}
+
+
+/*
+carries out LMO run j exactly as lmo_cv_task() does, so the
+usual LMO statistics are obtained as well; in addition, the
+PC number chosen by the inner CV of each outer fold and the
+PRESS of that fold at that PC number are stored in
+od->mel.nested_pc and od->mal.nested_press
+*/
+void nested_cv_task(ThreadInfo *ti, int j)
+{
+  int i;
+  int x;
+  int fold;
+  int inner;
+  int inner_pc;
+  int pc_sel;
+  int object_count;
+  int group_num;
+  int num_predictions;
+  double cum_press;
+  double best_press;
+  DoubleMat *press;
+  DoubleMat *inner_press;
+  
+  
+  press = ti->od.mal.press;
+  inner_press = ti->od.mal.inner_press;
+  clear_press(ti, press);
+  if (fill_group_composition(&(ti->od), j)
+    || (!int_perm_resize(ti->od.pel.out_structs,
+    ti->od.cv.active_struct_num))) {
+    ti->out_of_memory = 1;
+    return;
+  }
+  num_predictions = 0;
+  for (group_num = 0; group_num < ti->groups; ++group_num) {
+    fold = j * ti->groups + group_num;
+    /*
+    inner CV; predictions are only used to choose
+    the number of PCs, so they are not stored
+    */
+    ti->od.mal.press = inner_press;
+    clear_press(ti, inner_press);
+    inner_pc = ti->pc_num;
+    for (inner = 0; inner < ti->od.cv.inner_groups; ++inner) {
+      object_count = fill_nested_out_structs(&(ti->od),
+        j, group_num, inner, 1);
+      fit_nested_fold(ti, object_count);
+      if (ti->od.pc_num < inner_pc) {
+        inner_pc = ti->od.pc_num;
+      }
+      fill_nested_out_structs(&(ti->od), j, group_num, inner, 0);
+      pred_y_values(&(ti->od), ti, ti->od.pc_num, 0, fold);
+    }
+    pc_sel = 0;
+    best_press = 0.0;
+    for (i = 0; i <= inner_pc; ++i) {
+      cum_press = 0.0;
+      for (x = 0; x < ti->od.y_vars; ++x) {
+        cum_press += M_PEEK(inner_press, i, x);
+      }
+      if ((!i) || (cum_press < best_press)) {
+        pc_sel = i;
+        best_press = cum_press;
+      }
+    }
+    /*
+    outer fold; its PRESS is first collected on its
+    own, then added to that of the whole run
+    */
+    object_count = fill_nested_out_structs(&(ti->od),
+      j, group_num, -1, 1);
+    fit_nested_fold(ti, object_count);
+    clear_press(ti, inner_press);
+    if (pred_y_values(&(ti->od), ti, ti->od.pc_num,
+      ti->model_type, fold)) {
+      ti->cannot_write_temp_file = 1;
+    }
+    ti->od.mal.press = press;
+    if (pc_sel > ti->od.pc_num) {
+      pc_sel = ti->od.pc_num;
+    }
+    for (x = 0; x < ti->od.y_vars; ++x) {
+      for (i = 0; i <= ti->pc_num; ++i) {
+        M_POKE(press, i, x, M_PEEK(press, i, x)
+          + M_PEEK(inner_press, i, x));
+      }
+      M_POKE(ti->od.mal.nested_press, x, fold,
+        M_PEEK(inner_press, pc_sel, x));
+    }
+    ti->od.mel.nested_pc[fold] = pc_sel;
+    num_predictions += (ti->od.y_vars
+      * ti->od.mel.struct_per_group[group_num]);
+  }
+  for (x = 0; x < ti->od.y_vars; ++x) {
+    for (i = 0; i <= ti->pc_num; ++i) {
+      M_POKE(ti->od.mal.task_press, x * (ti->pc_num + 1) + i, j,
+        M_PEEK(press, i, x));
+    }
+  }
+  for (i = 0; i <= ti->od.pc_num; ++i) {
+    cum_press = 0.0;
+    for (x = 0; x < ti->od.y_vars; ++x) {
+      cum_press += M_PEEK(press, i, x);
+    }
+    M_POKE(ti->od.mal.sdep_mat, j, i,
+      sqrt(cum_press / (double)num_predictions));
+  }
+}
+
+
+#ifndef WIN32
+void *nested_cv_thread(void *pointer)
+#else
+DWORD nested_cv_thread(void *pointer)
+#endif
+{
+  int j;
+  ThreadInfo *ti;
+
+
+  ti = (ThreadInfo *)pointer;
+  while ((j = get_next_task(ti)) != -1) {
+    nested_cv_task(ti, j);
+    if (ti->od.cv.auto_runs && (!(ti->out_of_memory))) {
+      complete_task(ti, j);
+    }
+  }
+  #ifndef WIN32
+  return pointer;
+  #else
+  return 0;
+  #endif
+}
+
+
+/*
+prints how many times each number of PCs was chosen
+by the inner CV, then SDEP and q2 obtained predicting
+each outer fold with its own number of PCs
+*/
+void print_nested_cv(O3Data *od, int runs, double tss)
+{
+  int i;
+  int x;
+  int fold;
+  int n_folds;
+  int count;
+  double cum_press;
+  
+  
+  n_folds = runs * od->cv.groups;
+  tee_printf(od, "\nNumber of PCs chosen by inner LMO CV "
+    "(%d groups) over %d outer folds:\n\n", od->cv.inner_groups, n_folds);
+  tee_printf(od, "PC%12s\n", "Folds");
+  tee_printf(od, "--------------\n");
+  for (i = 0; i <= od->cv.pc_num; ++i) {
+    for (fold = 0, count = 0; fold < n_folds; ++fold) {
+      if (od->mel.nested_pc[fold] == i) {
+        ++count;
+      }
+    }
+    tee_printf(od, "%2d%12d\n", i, count);
+  }
+  cum_press = 0.0;
+  for (fold = 0; fold < n_folds; ++fold) {
+    for (x = 0; x < od->y_vars; ++x) {
+      cum_press += M_PEEK(od->mal.nested_press, x, fold);
+    }
+  }
+  tee_printf(od, "\n%12s%12s\n", "Nested SDEP", "Nested q2");
+  tee_printf(od, "------------------------\n");
+  tee_printf(od, "%12.4lf%12.4lf\n",
+    sqrt(cum_press / (double)(od->cv.num_predictions)),
+    1.0 - cum_press / tss);
+}
@@ -45,6 +45,79 @@ E-mail: paolo.tosco@unito.it
 #endif
 
 
+/*
+with LMO runs=AUTO, threads may have carried out a few runs
+beyond the first converged sequence; blocks of predictions
+belonging to those runs are left out while joining the
+per-thread files into a new one, which then replaces
+the file of thread 0
+*/
+static int join_converged_runs(O3Data *od, ThreadInfo **thread_info)
+{
+  char buffer[LARGE_BUF_LEN];
+  int i;
+  int t;
+  int keep;
+  int block;
+  int header[3];
+  size_t len;
+  size_t block_len;
+  FILE *handle;
+  FileDescriptor joined;
+  TaskQueue *queue;
+  
+  
+  queue = &(od->queue);
+  memset(&joined, 0, sizeof(FileDescriptor));
+  if (open_temp_file(od, &joined, "pred_y")) {
+    return CANNOT_WRITE_TEMP_FILE;
+  }
+  for (i = 0; i < od->cv.n_threads; ++i) {
+    handle = thread_info[i]->temp_pred.handle;
+    fflush(handle);
+    rewind(handle);
+    block = 0;
+    /*
+    each block starts with number of PCs, number of y_vars
+    and number of objects, followed by object numbers
+    and predicted values
+    */
+    while (fread(header, sizeof(int), 3, handle) == 3) {
+      block_len = (size_t)header[2] * sizeof(int)
+        + (size_t)header[2] * header[1] * (header[0] + 1) * sizeof(double);
+      for (t = 0, keep = 0; (!keep) && (t < queue->stop_task); ++t) {
+        keep = ((queue->thread_num[t] == i)
+          && (queue->slot[t] == block / od->cv.groups));
+      }
+      if (keep && (fwrite(header, sizeof(int), 3, joined.handle) != 3)) {
+        return CANNOT_WRITE_TEMP_FILE;
+      }
+      while (block_len) {
+        len = ((block_len < LARGE_BUF_LEN) ? block_len : LARGE_BUF_LEN);
+        if (fread(buffer, 1, len, handle) != len) {
+          return CANNOT_READ_TEMP_FILE;
+        }
+        if (keep && (fwrite(buffer, 1, len, joined.handle) != len)) {
+          return CANNOT_WRITE_TEMP_FILE;
+        }
+        block_len -= len;
+      }
+      ++block;
+    }
+  }
+  fclose(thread_info[0]->temp_pred.handle);
+  remove(thread_info[0]->temp_pred.name);
+  memcpy(thread_info[0]->temp_pred.name, joined.name, BUF_LEN);
+  thread_info[0]->temp_pred.handle = joined.handle;
+  od->file[TEMP_PRED]->handle = joined.handle;
+  memcpy(od->file[TEMP_PRED]->name, joined.name, BUF_LEN);
+  fflush(joined.handle);
+  rewind(joined.handle);
+  
+  return 0;
+}
+
+
 int join_thread_files(O3Data *od, ThreadInfo **thread_info)
 {
   char buffer[LARGE_BUF_LEN];
@@ -54,6 +127,9 @@ int join_thread_files(O3Data *od, ThreadInfo **thread_info)
   int actual_len_write;
 
 
+  if (od->queue.next_task > od->queue.stop_task) {
+    return join_converged_runs(od, thread_info);
+  }
   for (i = 0; i < od->cv.n_threads; ++i) {
     eof = 0;
     fflush(thread_info[i]->temp_pred.handle);
@@ -89,6 +165,8 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
   int x;
   int result;
   int first_parallel_run = 0;
+  int dispatch;
+  int verbose;
   int run_count = 0;
   int object_num = 0;
   int object_num2 = 0;
@@ -102,26 +180,32 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
   double cum_press;
   double sd_sdep;
   double temp;
+  double tss;
   ThreadInfo **ti;
-  #ifndef WIN32
-  pthread_attr_t thread_attr;
-  #endif
   
 
   result = 0;
   ti = od->mel.thread_info;
-  if (((model_type & UVEPLS_CV_MODEL) && (!ti[0]))
-    || (!(model_type & UVEPLS_CV_MODEL))) {
-    alloc_threads(od);
+  verbose = ((model_type & CV_MODEL) && (!(model_type & SILENT_PLS)));
+  /*
+  if worker processes are connected, CV runs are
+  sent to them by one local thread per worker
+  */
+  dispatch = use_workers(od, model_type);
+  od->workers.dispatch = dispatch;
+  /*
+  UVE-PLS sets up its threads on the first of its parallel runs
+  and keeps them until free_parallel_cv() is called
+  */
+  if ((!(model_type & UVEPLS_CV_MODEL)) || (!(od->cv.n_threads))) {
+    if (alloc_threads(od)) {
+      od->workers.dispatch = 0;
+      return OUT_OF_MEMORY;
+    }
     first_parallel_run = 1;
   }
   #ifndef WIN32
-  /*
-  set pthread attributes
-  */
   pthread_mutex_init(od->mel.mutex, NULL);
-  pthread_attr_init(&thread_attr);
-  pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
   #else
   if (!(*(od->mel.mutex) = CreateMutex(NULL, FALSE, NULL))) {
     return CANNOT_CREATE_THREAD;
@@ -130,8 +214,6 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
 
   switch (cv_type) {
     case LEAVE_ONE_OUT:
-    memset(od->mal.press->base, 0,
-      od->mal.press->m * od->mal.press->n * sizeof(double));
     if (((model_type & UVEPLS_CV_MODEL)
       && first_parallel_run) || (!(model_type & UVEPLS_CV_MODEL))) {
       od->cv.cv_thread = (void *)loo_cv_thread;
@@ -157,8 +239,6 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
     break;
 
     case LEAVE_TWO_OUT:
-    memset(od->mal.press->base, 0,
-      od->mal.press->m * od->mal.press->n * sizeof(double));
     if (((model_type & UVEPLS_CV_MODEL) && first_parallel_run)
       || (!(model_type & UVEPLS_CV_MODEL))) {
       od->cv.cv_thread = (void *)lto_cv_thread;
@@ -208,7 +288,8 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
     case LEAVE_MANY_OUT:
     if (((model_type & UVEPLS_CV_MODEL)
       && first_parallel_run) || (!(model_type & UVEPLS_CV_MODEL))) {
-      od->cv.cv_thread = (void *)lmo_cv_thread;
+      od->cv.cv_thread = (od->cv.nested
+        ? (void *)nested_cv_thread : (void *)lmo_cv_thread);
     }
     run_count = runs;
     break;
@@ -218,17 +299,44 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
   also allocate a new array of matrices containing the group_composition_list
   peculiar of each thread
   */
+  if ((model_type & UVEPLS_CV_MODEL) && (!first_parallel_run)) {
+    /*
+    IVE iterations repeat the same CV runs
+    */
+    run_count = od->queue.n_tasks;
+  }
+  /*
+  each CV run stores its PRESS contributions in its own
+  column of task_press; columns are merged in run order
+  once all threads have finished, so that results are
+  identical irrespective of the number of threads
+  */
+  od->mal.task_press = double_mat_resize(od->mal.task_press,
+    (suggested_pc_num + 1) * od->y_vars, run_count);
+  if (!(od->mal.task_press)) {
+    return OUT_OF_MEMORY;
+  }
   od->cv.n_threads = ((run_count < od->n_proc) ? run_count : od->n_proc);
+  if (dispatch) {
+    result = pack_worker_job(od, x_vars, model_type, cv_type,
+      suggested_pc_num, groups, runs, run_count);
+    if (result) {
+      od->workers.dispatch = 0;
+      return result;
+    }
+  }
   if (((model_type & UVEPLS_CV_MODEL) && first_parallel_run)
     || (!(model_type & UVEPLS_CV_MODEL))) {
     od->cv.n_threads = fill_thread_info(od, run_count);
   }
+  od->workers.dispatch = 0;
+  result = init_task_queue(od, ti, od->cv.n_threads, run_count);
+  if (result) {
+    return result;
+  }
   for (i = 0; i < od->cv.n_threads; ++i) {
     if (((model_type & UVEPLS_CV_MODEL) && first_parallel_run)
       || (!(model_type & UVEPLS_CV_MODEL))) {
-      /*
-      ave_press, ave_sdep, sum1, sumweight need to be updated by all threads
-      */
       ti[i]->pc_num = suggested_pc_num;
       ti[i]->groups = groups;
       ti[i]->model_type = model_type;
@@ -236,27 +344,38 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
       it is not necessary to reallocate data structures for thread 0,
       since they are already allocated
       */
-      if (i) {
-        /*
-        this function sets to NULL all data structures which need to be reallocated
-        */
-        init_pls(&(ti[i]->od));
+      if (i && (!dispatch)) {
         /*
-        this function allocates new data structures
+        fill_thread_info() handed over the PLS data structures
+        left in the thread workspace by the previous command;
+        alloc_pls() only grows them when they are too small
         */
         result = alloc_pls(&(ti[i]->od), x_vars, suggested_pc_num, model_type);
+        copy_pls_workspace(ti[i]->workspace, &(ti[i]->od));
         if (result) {
           return OUT_OF_MEMORY;
         }
-        if (cv_type == LEAVE_MANY_OUT) {
-          ti[i]->od.mal.press =
-            double_mat_alloc(suggested_pc_num + 1, od->y_vars);
-          if (!(ti[i]->od.mal.press)) {
+        /*
+        each thread accumulates PRESS in a private matrix,
+        while thread 0 uses the one in the main od structure
+        */
+        ti[i]->workspace->mal.press = double_mat_resize
+          (ti[i]->workspace->mal.press, suggested_pc_num + 1, od->y_vars);
+        ti[i]->od.mal.press = ti[i]->workspace->mal.press;
+        if (!(ti[i]->od.mal.press)) {
+          return OUT_OF_MEMORY;
+        }
+        if (od->cv.nested) {
+          ti[i]->workspace->mal.inner_press = double_mat_resize
+            (ti[i]->workspace->mal.inner_press,
+            suggested_pc_num + 1, od->y_vars);
+          ti[i]->od.mal.inner_press = ti[i]->workspace->mal.inner_press;
+          if (!(ti[i]->od.mal.inner_press)) {
             return OUT_OF_MEMORY;
           }
         }
       }
-      if (model_type & (CV_MODEL | SILENT_PLS)) {
+      if ((model_type & (CV_MODEL | SILENT_PLS)) && (!(od->cv_pred.active))) {
         memset(pred_y_temp_filename, 0, TITLE_LEN);
         sprintf(pred_y_temp_filename, "pred_y_t%02d", i + 1);
         if (open_temp_file(&(ti[i]->od),
@@ -281,74 +400,107 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
         }
       }
     }
-    if (cv_type == LEAVE_MANY_OUT) {
-      memset(ti[i]->od.mal.press->base, 0,
-        ti[i]->od.mal.press->m * ti[i]->od.mal.press->n * sizeof(double));
-    }
+    ti[i]->od.mal.task_press = od->mal.task_press;
     if ((model_type & UVEPLS_CV_MODEL) && od->uvepls.save_ram) {
       rewind(ti[i]->temp_cv_coeff.handle);
     }
-    #ifndef WIN32
-    od->error_code = pthread_create
-      (&(od->thread_id[i]), &thread_attr,
-      (void *(*)(void *))(od->cv.cv_thread),
-      (void *)ti[i]);
-    if (od->error_code) {
-      return CANNOT_CREATE_THREAD;
-    }
-    #else
-    od->hThreadArray[i] = CreateThread(NULL, 0,
-      (LPTHREAD_START_ROUTINE)(od->cv.cv_thread),
-      ti[i], 0, &(od->dwThreadIdArray[i]));
-    if (!(od->hThreadArray[i])) {
-      return CANNOT_CREATE_THREAD;
-    }
-    #endif
-    
   }
-  #ifndef WIN32
-  /*
-  free the pthread attribute memory
-  */
-  pthread_attr_destroy(&thread_attr);
   /*
-  wait for all threads to have finished
+  hand the job over to the worker pool
+  and wait for all threads to have finished
   */
-  for (i = 0; i < od->cv.n_threads; ++i) {
-    od->error_code = pthread_join(od->thread_id[i],
-      &(od->thread_result[i]));
-    if (od->error_code) {
-      return CANNOT_JOIN_THREAD;
+  if (dispatch) {
+    result = run_thread_pool(od, (void *)worker_proxy_thread, od->cv.n_threads);
+    if (!result) {
+      result = finish_worker_tasks(od, od->cv.cv_thread, od->cv.n_threads);
     }
   }
+  else {
+    result = run_thread_pool(od, (void *)(od->cv.cv_thread), od->cv.n_threads);
+  }
+  #ifndef WIN32
   pthread_mutex_destroy(od->mel.mutex);
   #else
-  WaitForMultipleObjects(od->cv.n_threads, od->hThreadArray, TRUE, INFINITE);
-  for (i = 0; i < od->cv.n_threads; ++i) {
-    CloseHandle(od->hThreadArray[i]);
-  }
   CloseHandle(*(od->mel.mutex));
   #endif
+  if (result) {
+    return result;
+  }
+  close_task_queue(od, ti, od->cv.n_threads);
+  for (i = 1; (!dispatch) && (i < od->cv.n_threads); ++i) {
+    /*
+    threads may have grown their data structures
+    */
+    copy_pls_workspace(ti[i]->workspace, &(ti[i]->od));
+  }
   for (i = 0; i < od->cv.n_threads; ++i) {
+    if (ti[i]->out_of_memory) {
+      return OUT_OF_MEMORY;
+    }
     if (ti[i]->cannot_write_temp_file) {
       return CANNOT_WRITE_TEMP_FILE;
     }
   }
   od->pc_num = ti[0]->od.pc_num;
-  if (model_type & (CV_MODEL | SILENT_PLS)) {
+  tss = od->cv.tss;
+  if (cv_type == LEAVE_MANY_OUT) {
+    /*
+    with runs=AUTO, only the runs up to the first
+    converged sequence are taken into account
+    */
+    if (od->cv.auto_runs) {
+      runs = od->queue.stop_task;
+      run_count = runs;
+      od->cv.num_predictions = runs
+        * od->cv.active_struct_num * od->y_vars;
+      if (od->cv_pred.active) {
+        od->cv_pred.n_blocks = runs * groups;
+      }
+      if (runs < od->cv.runs) {
+        tss *= ((double)runs / (double)(od->cv.runs));
+      }
+    }
+    od->cv.runs_done = runs;
+  }
+  /*
+  merge PRESS contributions in run order; LOO/LTO
+  accumulate them in press, LMO in ave_press
+  (SDEP for each LMO run was already computed
+  by the thread which carried it out)
+  */
+  for (j = 0; j < run_count; ++j) {
+    for (x = 0; x < od->y_vars; ++x) {
+      for (i = 0; i <= suggested_pc_num; ++i) {
+        temp = M_PEEK(od->mal.task_press,
+          x * (suggested_pc_num + 1) + i, j);
+        if (cv_type == LEAVE_MANY_OUT) {
+          M_POKE(od->mal.ave_press, i, x,
+            M_PEEK(od->mal.ave_press, i, x) + temp);
+        }
+        else {
+          M_POKE(od->mal.press, i, x, (j
+            ? M_PEEK(od->mal.press, i, x) + temp : temp));
+        }
+      }
+    }
+  }
+  if ((model_type & (CV_MODEL | SILENT_PLS)) && (!(od->cv_pred.active))) {
     result = join_thread_files(od, ti);
     if (result) {
       return result;
     }
-    if (model_type & CV_MODEL) {
-      result = print_pred_values(od);
-      if (result) {
-        return result;
-      }
+  }
+  if (verbose) {
+    result = print_pred_values(od);
+    if (result) {
+      return result;
     }
   }
   if (cv_type == LEAVE_MANY_OUT) {
-    if (model_type & CV_MODEL) {
+    if (verbose) {
+      if (od->cv.auto_runs) {
+        print_lmo_convergence(od, runs);
+      }
       tee_printf(od, "\nPC%12s%12s%12s\n",
         "SDEP", "SD on SDEP", "Average q2");
       tee_printf(od, "--------------------------------------\n");
@@ -382,20 +534,23 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
       for (x = 0; x < od->y_vars; ++x) {
         cum_press += M_PEEK(od->mal.ave_press, j, x);
       }
-      od->vel.q2->ve[j] = 1.0 - cum_press / od->cv.tss;
+      od->vel.q2->ve[j] = 1.0 - cum_press / tss;
       if (model_type & SCRAMBLE_CV_MODEL) {
         od->vel.secv->ve[j] =
           sqrt(cum_press / (od->y_vars
           * ((double)(od->cv.num_predictions) - j - 1)));
       }
-      if (model_type & CV_MODEL) {
+      if (verbose) {
         tee_printf(od, "%2d%12.4lf%12.4lf%12.4lf\n", j, od->vel.ave_sdep->ve[j],
           sd_sdep, od->vel.q2->ve[j]);
       }
     }
+    if (od->cv.nested && verbose) {
+      print_nested_cv(od, runs, tss);
+    }
   }
   else {
-    if (model_type & CV_MODEL) {
+    if (verbose) {
       tee_printf(od, "\nPC%12s%12s\n",
         "SDEP", "q2");
       tee_printf(od, "--------------------------\n");
@@ -413,7 +568,7 @@ int parallel_cv(O3Data *od, int x_vars, int suggested_pc_num,
           sqrt(cum_press / (od->y_vars
           * ((double)(od->cv.num_predictions) - i - 1)));
       }
-      if (model_type & CV_MODEL) {
+      if (verbose) {
         tee_printf(od, "%2d%12.4lf%12.4lf\n", i, od->vel.ave_sdep->ve[i],
           od->vel.q2->ve[i]);
       }
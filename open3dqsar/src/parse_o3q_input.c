@@ -72,6 +72,84 @@ void *el_thread(void *pointer)
 #endif
 
 
+static int print_import_grid_errors(O3Data *od, char *file_type)
+{
+  /*
+  list all objects whose grid file could not be
+  imported by import_grid_parallel(); returns
+  non-zero if there was at least one
+  */
+  int i;
+  int found;
+  
+  
+  found = 0;
+  for (i = 0; od->al.task_list && (i < od->grid.object_num); ++i) {
+    if (!(od->al.task_list[i]->code)) {
+      continue;
+    }
+    found = 1;
+    memcpy(&(od->newgrid), od->al.newgrid_list[i], sizeof(GridInfo));
+    tee_printf(od, "Object ID %4d:\n", od->al.mol_info[i]->object_id);
+    switch (od->al.task_list[i]->code) {
+      case NOT_ENOUGH_OBJECTS:
+      tee_printf(od, E_FILE_CANNOT_BE_OPENED_FOR_READING,
+        od->al.task_list[i]->string, "");
+      break;
+
+      case PREMATURE_DAT_EOF:
+      tee_printf(od, E_FILE_CORRUPTED_OR_IN_WRONG_FORMAT,
+        file_type, od->al.task_list[i]->string, "");
+      break;
+
+      case CANNOT_WRITE_TEMP_FILE:
+      tee_printf(od, E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", "");
+      break;
+
+      case OUT_OF_MEMORY:
+      tee_printf(od, E_OUT_OF_MEMORY, "");
+      break;
+
+      case CANNOT_READ_GRID_DATA:
+      tee_printf(od, E_ERROR_IN_GRID_DATA, od->newgrid.x_vars,
+        od->al.task_list[i]->string, "");
+      break;
+
+      case GRID_NOT_MATCHING:
+      tee_printf(od, E_GRID_NOT_MATCHING,
+        file_type, od->al.task_list[i]->string, "");
+      print_grid_comparison(od);
+      break;
+
+      case GRID_NOT_MATCHING_OFF_CENTER:
+      case GRID_NOT_MATCHING_OUT_OF_BOUNDS:
+      tee_printf(od, E_GRID_NOT_MATCHING_DATA_POINT,
+        od->newgrid.x_vars,
+        od->newgrid.start_coord[0],
+        od->newgrid.start_coord[1],
+        od->newgrid.start_coord[2],
+        od->al.task_list[i]->string,
+        (od->al.task_list[i]->code == GRID_NOT_MATCHING_OFF_CENTER)
+        ? "is off-center" : "is out of bounds", "");
+      break;
+
+      case BAD_DX_HEADER:
+      tee_printf(od, "The header information in file %s is corrupted or "
+        "not consistent with the grid box definitions.\n%s",
+        od->al.task_list[i]->string, "");
+      break;
+
+      case CANNOT_FIND_MO:
+      tee_printf(od, E_CANNOT_FIND_MO,
+        od->al.task_list[i]->string, "");
+      break;
+    }
+  }
+  
+  return found;
+}
+
+
 int parse_input(O3Data *od, FILE *input_stream, int run_type)
 {
   char *ptr;
@@ -144,6 +222,7 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
   int from_file = 0;
   int skip_header;
   int options;
+  int model_type;
   int n_values;
   int label = 0;
   int *max_vary[MAX_FREE_FORMAT_PARAMETERS + 1];
@@ -163,13 +242,15 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
   VarCoord temp_varcoord;
   FileDescriptor **source;
   FileDescriptor *current_source;
-  FileDescriptor *multi_file_fd = NULL;
   FileDescriptor log_fd;
   FILE *touch;
   HIST_ENTRY *last_entry;
   int active_struct_num;
   int groups = 0;
   int runs = 0;
+  int check_precision = 0;
+  int nested_cv = 0;
+  int power_iterations;
   int percent_remove;
   int start_gnuplot = 0;
   int srd_collapse;
@@ -1487,28 +1568,22 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
       else if ((!strcasecmp(parameter, "gamess_cube"))
         || (!strcasecmp(parameter, "formatted_cube"))) {
         multi_file_type = FORMATTED_CUBE_INPUT_FILE;
-        multi_file_fd = od->file[ASCII_IN];
       }
       else if ((!strcasecmp(parameter, "gaussian_cube"))
         || (!strcasecmp(parameter, "unformatted_cube"))) {
         multi_file_type = UNFORMATTED_CUBE_INPUT_FILE;
-        multi_file_fd = od->file[BINARY_IN];
       }
       else if (!strcasecmp(parameter, "molden")) {
         multi_file_type = MOLDEN_INPUT_FILE;
-        multi_file_fd = od->file[BINARY_IN];
       }
       else if (!strcasecmp(parameter, "moe_grid")) {
         multi_file_type = MOE_GRID_INPUT_FILE;
-        multi_file_fd = od->file[BINARY_IN];
       }
       else if (!strcasecmp(parameter, "grid_ascii")) {
         multi_file_type = GRID_ASCII_INPUT_FILE;
-        multi_file_fd = NULL;
       }
       else if (!strcasecmp(parameter, "opendx")) {
         multi_file_type = OPENDX_INPUT_FILE;
-        multi_file_fd = NULL;
       }
       else {
         tee_error(od, run_type, overall_line_num,
@@ -1571,6 +1646,27 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             }
           }
         }
+        /*
+        by default, grid files must match the current grid box;
+        otherwise they may be resampled onto it
+        */
+        interpolate = 0;
+        if ((parameter = get_args(od, "interpolate"))) {
+          if (!strncasecmp(parameter, "trilinear", 9)) {
+            interpolate = TRILINEAR_INTERPOLATION;
+          }
+          else if (!strncasecmp(parameter, "tricubic", 8)) {
+            interpolate = TRICUBIC_INTERPOLATION;
+          }
+          else if (strncasecmp(parameter, "none", 4)) {
+            tee_error(od, run_type, overall_line_num,
+              "The interpolate parameter should be "
+              "NONE, TRILINEAR or TRICUBIC.\n%s",
+              IMPORT_FAILED);
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+        }
         if (!(od->valid & SDF_BIT)) {
           tee_error(od, run_type, overall_line_num,
             E_IMPORT_MOLFILE_FIRST, IMPORT_FAILED);
@@ -1665,121 +1761,48 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           tee_printf(od, M_TOOL_INVOKE, nesting, command,
             multi_file_name[multi_file_type], line_orig);
           tee_flush(od);
-          switch (multi_file_type) {
-            case FORMATTED_CUBE_INPUT_FILE:
-            result = import_grid_formatted_cube(od, mo);
-            break;
-
-            case UNFORMATTED_CUBE_INPUT_FILE:
-            result = import_grid_unformatted_cube(od, mo);
-            break;
-
-            case MOLDEN_INPUT_FILE:
-            result = import_grid_molden(od);
-            break;
-
-            case MOE_GRID_INPUT_FILE:
-            result = import_grid_moe(od, regex_name[0]);
-            break;
-
-            case OPENDX_INPUT_FILE:
-            result = import_opendx(od, regex_name[0]);
-            break;
-
-            default:
-            result = import_grid_ascii(od, regex_name[0]);
-            break;
-          }
+          result = import_grid_parallel(od, multi_file_type,
+            regex_name[0], mo, interpolate);
           gettimeofday(&end, NULL);
           elapsed_time(od, &start, &end);
           /*
-          check for errors
+          check for errors; grid files which
+          could not be imported are listed first
           */
-          switch (result) {
-            case NOT_ENOUGH_OBJECTS:
+          found = print_import_grid_errors(od,
+            multi_file_name[multi_file_type]);
+          free_array(od->al.task_list);
+          od->al.task_list = NULL;
+          free_array(od->al.newgrid_list);
+          od->al.newgrid_list = NULL;
+          if (found) {
             tee_error(od, run_type, overall_line_num,
-              E_NOT_ENOUGH_OBJECTS,
-              od->object_num, regex_name[0],
+              E_CALCULATION_ERROR, "grid file imports",
               IMPORT_FAILED);
             return PARSE_INPUT_ERROR;
-
-            case PREMATURE_DAT_EOF:
-            tee_error(od, run_type, overall_line_num,
-              E_FILE_CORRUPTED_OR_IN_WRONG_FORMAT,
-              multi_file_name[multi_file_type],
-              od->file[BINARY_IN]->name, IMPORT_FAILED);
-            return PARSE_INPUT_ERROR;
-
+          }
+          switch (result) {
             case CANNOT_READ_TEMP_FILE:
             tee_error(od, run_type, overall_line_num,
               E_ERROR_IN_READING_TEMP_FILE,
               od->file[TEMP_SORTED_MATCH]->name, IMPORT_FAILED);
             return PARSE_INPUT_ERROR;
 
-            case CANNOT_WRITE_TEMP_FILE:
-            tee_error(od, run_type, overall_line_num,
-              E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", IMPORT_FAILED);
-            return PARSE_INPUT_ERROR;
-
             case OUT_OF_MEMORY:
             tee_error(od, run_type, overall_line_num,
               E_OUT_OF_MEMORY, IMPORT_FAILED);
             return PARSE_INPUT_ERROR;
 
-            case CANNOT_READ_GRID_DATA:
-            sprintf(buffer, regex_name[0], od->newgrid.object_num + 1);
-            tee_error(od, run_type, overall_line_num,
-              E_ERROR_IN_GRID_DATA,
-              od->newgrid.x_vars, buffer,
-              IMPORT_FAILED);
-            return PARSE_INPUT_ERROR;
-
-            case GRID_NOT_MATCHING:
-            sprintf(buffer, regex_name[0], od->newgrid.object_num + 1);
-            tee_error(od, run_type, overall_line_num,
-              E_GRID_NOT_MATCHING,
-              multi_file_name[multi_file_type],
-              multi_file_fd ? multi_file_fd->name : buffer,
-              IMPORT_FAILED);
-            print_grid_comparison(od);
-            return PARSE_INPUT_ERROR;
-
-            case GRID_NOT_MATCHING_OFF_CENTER:
-            sprintf(buffer, regex_name[0], od->newgrid.object_num + 1);
-            tee_error(od, run_type, overall_line_num,
-              E_GRID_NOT_MATCHING_DATA_POINT,
-              od->newgrid.x_vars,
-              od->newgrid.start_coord[0],
-              od->newgrid.start_coord[1],
-              od->newgrid.start_coord[2],
-              buffer, "is off-center",
-              IMPORT_FAILED);
-            return PARSE_INPUT_ERROR;
-
-            case GRID_NOT_MATCHING_OUT_OF_BOUNDS:
-            sprintf(buffer, regex_name[0], od->newgrid.object_num + 1);
-            tee_error(od, run_type, overall_line_num,
-              E_GRID_NOT_MATCHING_DATA_POINT,
-              od->newgrid.x_vars,
-              od->newgrid.start_coord[0],
-              od->newgrid.start_coord[1],
-              od->newgrid.start_coord[2],
-              buffer, "is out of bounds",
-              IMPORT_FAILED);
-            return PARSE_INPUT_ERROR;
-            
-            case BAD_DX_HEADER:
-            sprintf(buffer, regex_name[0], od->newgrid.object_num + 1);
+            case CANNOT_CREATE_THREAD:
             tee_error(od, run_type, overall_line_num,
-              "The header information in file %s is corrupted or "
-              "not consistent with the grid box definitions.\n%s",
-              buffer, IMPORT_FAILED);
+              E_THREAD_ERROR, "create",
+              od->error_code, IMPORT_FAILED);
             return PARSE_INPUT_ERROR;
 
-            case CANNOT_FIND_MO:
-            sprintf(buffer, regex_name[0], od->newgrid.object_num + 1);
+            case CANNOT_JOIN_THREAD:
             tee_error(od, run_type, overall_line_num,
-              E_CANNOT_FIND_MO, buffer, IMPORT_FAILED);
+              E_THREAD_ERROR, "join",
+              od->error_code, IMPORT_FAILED);
             return PARSE_INPUT_ERROR;
 
             default:
@@ -2758,40 +2781,42 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             }
             sprintf(regex_name[0], "%s%c%s_####"GAUSSIAN_CUBE_EXT,
               od->field.qm_dir, SEPARATOR, od->field.qm_software);
-            result = import_grid_unformatted_cube(od, 1);
+            result = import_grid_parallel(od,
+              UNFORMATTED_CUBE_INPUT_FILE, regex_name[0], 1, 0);
             gettimeofday(&end, NULL);
             elapsed_time(od, &start, &end);
-            switch (result) {
-              case NOT_ENOUGH_OBJECTS:
+            found = print_import_grid_errors(od, "GAUSSIAN CUBE");
+            free_array(od->al.task_list);
+            od->al.task_list = NULL;
+            free_array(od->al.newgrid_list);
+            od->al.newgrid_list = NULL;
+            if (found) {
               tee_error(od, run_type, overall_line_num,
-                E_NOT_ENOUGH_OBJECTS, od->object_num,
-                regex_name[0], failed);
+                E_CALCULATION_ERROR, "grid file imports", failed);
               return PARSE_INPUT_ERROR;
-
-              case PREMATURE_DAT_EOF:
+            }
+            switch (result) {
+              case CANNOT_READ_TEMP_FILE:
               tee_error(od, run_type, overall_line_num,
-                E_FILE_CORRUPTED_OR_IN_WRONG_FORMAT,
-                "GAUSSIAN CUBE", od->file[BINARY_IN]->name,
-                failed);
+                E_ERROR_IN_READING_TEMP_FILE,
+                od->file[TEMP_SORTED_MATCH]->name, failed);
               return PARSE_INPUT_ERROR;
 
-              case CANNOT_WRITE_TEMP_FILE:
+              case OUT_OF_MEMORY:
               tee_error(od, run_type, overall_line_num,
-                E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", failed);
+                E_OUT_OF_MEMORY, failed);
               return PARSE_INPUT_ERROR;
 
-              case OUT_OF_MEMORY:
+              case CANNOT_CREATE_THREAD:
               tee_error(od, run_type, overall_line_num,
-                E_OUT_OF_MEMORY, failed);
+                E_THREAD_ERROR, "create",
+                od->error_code, failed);
               return PARSE_INPUT_ERROR;
 
-              case GRID_NOT_MATCHING:
+              case CANNOT_JOIN_THREAD:
               tee_error(od, run_type, overall_line_num,
-                E_GRID_NOT_MATCHING, "GAUSSIAN_CUBE",
-                od->file[BINARY_IN]->name, "");
-              print_grid_comparison(od);
-              tee_error(od, run_type, overall_line_num, "%s\n",
-                failed);
+                E_THREAD_ERROR, "join",
+                od->error_code, failed);
               return PARSE_INPUT_ERROR;
 
               default:
@@ -2809,39 +2834,42 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             }
             sprintf(regex_name[0], "%s%c%s_####"GAMESS_PUNCH_EXT,
               od->field.qm_dir, SEPARATOR, od->field.qm_software);
-            result = import_grid_formatted_cube(od, 1);
+            result = import_grid_parallel(od,
+              FORMATTED_CUBE_INPUT_FILE, regex_name[0], 1, 0);
             gettimeofday(&end, NULL);
             elapsed_time(od, &start, &end);
-            switch (result) {
-              case NOT_ENOUGH_OBJECTS:
+            found = print_import_grid_errors(od, "GAMESS CUBE");
+            free_array(od->al.task_list);
+            od->al.task_list = NULL;
+            free_array(od->al.newgrid_list);
+            od->al.newgrid_list = NULL;
+            if (found) {
               tee_error(od, run_type, overall_line_num,
-                E_NOT_ENOUGH_OBJECTS, od->object_num,
-                regex_name[0], failed);
+                E_CALCULATION_ERROR, "grid file imports", failed);
               return PARSE_INPUT_ERROR;
-
-              case PREMATURE_DAT_EOF:
+            }
+            switch (result) {
+              case CANNOT_READ_TEMP_FILE:
               tee_error(od, run_type, overall_line_num,
-                E_FILE_CORRUPTED_OR_IN_WRONG_FORMAT,
-                "GAMESS CUBE", od->file[ASCII_IN]->name,
-                failed);
+                E_ERROR_IN_READING_TEMP_FILE,
+                od->file[TEMP_SORTED_MATCH]->name, failed);
               return PARSE_INPUT_ERROR;
 
-              case CANNOT_WRITE_TEMP_FILE:
+              case OUT_OF_MEMORY:
               tee_error(od, run_type, overall_line_num,
-                E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", failed);
+                E_OUT_OF_MEMORY, failed);
               return PARSE_INPUT_ERROR;
 
-              case OUT_OF_MEMORY:
+              case CANNOT_CREATE_THREAD:
               tee_error(od, run_type, overall_line_num,
-                E_OUT_OF_MEMORY, failed);
+                E_THREAD_ERROR, "create",
+                od->error_code, failed);
               return PARSE_INPUT_ERROR;
 
-              case GRID_NOT_MATCHING:
+              case CANNOT_JOIN_THREAD:
               tee_error(od, run_type, overall_line_num,
-                E_GRID_NOT_MATCHING, "GAMESS CUBE",
-                od->file[ASCII_IN]->name, "");
-              print_grid_comparison(od);
-              tee_error(od, run_type, overall_line_num, "%s\n", failed);
+                E_THREAD_ERROR, "join",
+                od->error_code, failed);
               return PARSE_INPUT_ERROR;
 
               default:
@@ -2859,39 +2887,42 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             }
             sprintf(regex_name[0], "%s%c%s_####"GAMESS_PUNCH_EXT,
               od->field.qm_dir, SEPARATOR, od->field.qm_software);
-            result = import_grid_formatted_cube(od, 1);
+            result = import_grid_parallel(od,
+              FORMATTED_CUBE_INPUT_FILE, regex_name[0], 1, 0);
             gettimeofday(&end, NULL);
             elapsed_time(od, &start, &end);
-            switch (result) {
-              case NOT_ENOUGH_OBJECTS:
+            found = print_import_grid_errors(od, "TURBOMOLE CUBE");
+            free_array(od->al.task_list);
+            od->al.task_list = NULL;
+            free_array(od->al.newgrid_list);
+            od->al.newgrid_list = NULL;
+            if (found) {
               tee_error(od, run_type, overall_line_num,
-                E_NOT_ENOUGH_OBJECTS, od->object_num,
-                regex_name[0], failed);
+                E_CALCULATION_ERROR, "grid file imports", failed);
               return PARSE_INPUT_ERROR;
-
-              case PREMATURE_DAT_EOF:
+            }
+            switch (result) {
+              case CANNOT_READ_TEMP_FILE:
               tee_error(od, run_type, overall_line_num,
-                E_FILE_CORRUPTED_OR_IN_WRONG_FORMAT,
-                "TURBOMOLE CUBE", od->file[ASCII_IN]->name,
-                failed);
+                E_ERROR_IN_READING_TEMP_FILE,
+                od->file[TEMP_SORTED_MATCH]->name, failed);
               return PARSE_INPUT_ERROR;
 
-              case CANNOT_WRITE_TEMP_FILE:
+              case OUT_OF_MEMORY:
               tee_error(od, run_type, overall_line_num,
-                E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", failed);
+                E_OUT_OF_MEMORY, failed);
               return PARSE_INPUT_ERROR;
 
-              case OUT_OF_MEMORY:
+              case CANNOT_CREATE_THREAD:
               tee_error(od, run_type, overall_line_num,
-                E_OUT_OF_MEMORY, failed);
+                E_THREAD_ERROR, "create",
+                od->error_code, failed);
               return PARSE_INPUT_ERROR;
 
-              case GRID_NOT_MATCHING:
+              case CANNOT_JOIN_THREAD:
               tee_error(od, run_type, overall_line_num,
-                E_GRID_NOT_MATCHING, "TURBOMOLE CUBE",
-                od->file[ASCII_IN]->name, "");
-              print_grid_comparison(od);
-              tee_error(od, run_type, overall_line_num, "%s\n", failed);
+                E_THREAD_ERROR, "join",
+                od->error_code, failed);
               return PARSE_INPUT_ERROR;
 
               default:
@@ -3601,6 +3632,46 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           O3_ERROR_PRINT(&(od->task));
           return PARSE_INPUT_ERROR;
         }
+        if (options & APPEND_BIT) {
+          init_journal(od, NULL);
+        }
+        else {
+          /*
+          if incremental saves were journaled
+          against this .dat file, replay them
+          */
+          get_journal_name(buffer, od->file[DAT_IN]->name);
+          result = load_dat_journal(od, DAT_IN, options);
+          switch (result) {
+            case PREMATURE_DAT_EOF:
+            tee_error(od, run_type, overall_line_num,
+              E_FILE_CORRUPTED_OR_IN_WRONG_FORMAT, "journal",
+              buffer, LOAD_FAILED);
+            return PARSE_INPUT_ERROR;
+
+            case JOURNAL_NOT_MATCHING:
+            tee_error(od, run_type, overall_line_num,
+              E_JOURNAL_NOT_MATCHING, buffer,
+              od->file[DAT_IN]->name, LOAD_FAILED);
+            return PARSE_INPUT_ERROR;
+
+            case OUT_OF_MEMORY:
+            tee_error(od, run_type, overall_line_num,
+              E_OUT_OF_MEMORY, LOAD_FAILED);
+            return PARSE_INPUT_ERROR;
+
+            case CANNOT_READ_TEMP_FILE:
+            tee_error(od, run_type, overall_line_num,
+              E_FILE_CANNOT_BE_OPENED_FOR_READING,
+              buffer, LOAD_FAILED);
+            return PARSE_INPUT_ERROR;
+
+            case CANNOT_WRITE_TEMP_FILE:
+            tee_error(od, run_type, overall_line_num,
+              E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", LOAD_FAILED);
+            return PARSE_INPUT_ERROR;
+          }
+        }
         if (update_mol(od)) {
           tee_error(od, run_type, overall_line_num,
             E_ERROR_IN_READING_TEMP_FILE,
@@ -3642,6 +3713,20 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         continue;
       }
       strcpy(od->file[DAT_OUT]->name, parameter);
+      options = 0;
+      if ((parameter = get_args(od, "mode"))) {
+        if (!strncasecmp(parameter, "incremental", 11)) {
+          options = 1;
+        }
+        else if (strncasecmp(parameter, "full", 4)) {
+          tee_error(od, run_type, overall_line_num,
+            "Only \"FULL\" and \"INCREMENTAL\" "
+            "save modes are allowed.\n%s",
+            SAVE_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+      }
       if (!(run_type & DRY_RUN)) {
         if (!(od->grid.object_num)) {
           tee_error(od, run_type, overall_line_num,
@@ -3649,11 +3734,12 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           fail = !(run_type & INTERACTIVE_RUN);
           continue;
         }
+        get_journal_name(buffer, od->file[DAT_OUT]->name);
         /*
         save .dat file
         */
-        if (!(od->file[DAT_OUT]->handle = (FILE *)
-          fzopen(od->file[DAT_OUT]->name, "wb"))) {
+        if ((!options) && (!(od->file[DAT_OUT]->handle = (FILE *)
+          fzopen(od->file[DAT_OUT]->name, "wb")))) {
           tee_error(od, run_type, overall_line_num,
             E_TEMP_FILE_CANNOT_BE_OPENED_FOR_WRITING,
             od->file[DAT_OUT]->name, SAVE_FAILED);
@@ -3663,7 +3749,28 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         ++command;
         tee_printf(od, M_TOOL_INVOKE, nesting, command, "SAVE", line_orig);
         tee_flush(od);
-        result = save_dat(od, DAT_OUT);
+        if (options) {
+          /*
+          append a record to the journal if possible,
+          otherwise write a new base .dat file
+          */
+          result = save_dat_journal(od, DAT_OUT, &i);
+        }
+        else {
+          result = save_dat(od, DAT_OUT);
+          /*
+          a journal left over from a previous
+          incremental save is now stale
+          */
+          if (!result) {
+            remove(buffer);
+            strcpy(file_basename, od->file[DAT_OUT]->name);
+            absolute_path(file_basename);
+            if (!strcmp(file_basename, od->journal_base)) {
+              init_journal(od, file_basename);
+            }
+          }
+        }
         if (od->file[DAT_OUT]->handle) {
           fzclose((fzPtr *)(od->file[DAT_OUT]->handle));
           od->file[DAT_OUT]->handle = NULL;
@@ -3674,6 +3781,12 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           case PREMATURE_DAT_EOF:
           tee_error(od, run_type, overall_line_num,
             E_ERROR_IN_WRITING_TEMP_FILE,
+            options ? buffer : od->file[DAT_OUT]->name, SAVE_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case CANNOT_WRITE_TEMP_FILE:
+          tee_error(od, run_type, overall_line_num,
+            E_FILE_CANNOT_BE_OPENED_FOR_WRITING,
             od->file[DAT_OUT]->name, SAVE_FAILED);
           return PARSE_INPUT_ERROR;
 
@@ -3682,6 +3795,16 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             E_OUT_OF_MEMORY, SAVE_FAILED);
           return PARSE_INPUT_ERROR;
         }
+        if (options) {
+          if (i) {
+            tee_printf(od, "Record %d was appended to the journal \"%s\".\n\n",
+              i, buffer);
+          }
+          else {
+            tee_printf(od, "A new base file was written and the journal "
+              "\"%s\" was started.\n\n", buffer);
+          }
+        }
         tee_printf(od, M_TOOL_SUCCESS, nesting, command, "SAVE");
         tee_flush(od);
       }
@@ -4498,6 +4621,30 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           fail = !(run_type & INTERACTIVE_RUN);
           continue;
         }
+        type = NIPALS_PCA;
+        if ((parameter = get_args(od, "algorithm"))) {
+          if (!strncasecmp(parameter, "randomized", 10)) {
+            type = RANDOMIZED_PCA;
+          }
+          else if (strncasecmp(parameter, "nipals", 6)) {
+            tee_error(od, run_type, overall_line_num,
+              "The algorithm parameter should be NIPALS or RANDOMIZED.\n%s",
+              PCA_FAILED);
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+        }
+        power_iterations = DEFAULT_PCA_POWER_ITERATIONS;
+        if ((parameter = get_args(od, "power_iterations"))) {
+          sscanf(parameter, "%d", &power_iterations);
+        }
+        if (power_iterations < 0) {
+          tee_error(od, run_type, overall_line_num,
+            "The number of power iterations cannot be negative.\n%s",
+            PCA_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
         /*
         perform pca operation
         */
@@ -4560,7 +4707,10 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         ++command;
         tee_printf(od, M_TOOL_INVOKE, nesting, command, "PCA", line_orig);
         tee_flush(od);
-        result = pca(od, pc);
+        if (type == RANDOMIZED_PCA) {
+          set_random_seed(od, od->random_seed);
+        }
+        result = pca(od, pc, type, power_iterations);
         gettimeofday(&end, NULL);
         elapsed_time(od, &start, &end);
         switch (result) {
@@ -4968,29 +5118,104 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         determine_best_cpu_number(od, "all");
         determine_best_cpu_number(od, parameter);
         tee_printf(od, M_NUMBER_OF_CPUS, PACKAGE_NAME, od->n_proc);
-      }
-      else if ((parameter = get_args(od, "random_seed"))) {
+        set_blas_threads(od, 1);
         if (!(run_type & DRY_RUN)) {
-          sscanf(parameter, "%ld", &random_seed);
-          set_random_seed(od, (unsigned long)absval(random_seed));
-          tee_printf(od, "The random seed has been set to %ld.\n\n",
-            random_seed);
+          print_blas_threads(od);
         }
       }
-      else if ((parameter = get_args(od, "temp_dir"))) {
-        if (dexist(parameter)) {
-          strcpy(od->temp_dir, parameter);
-          absolute_path(od->temp_dir);
-          if (!(run_type & DRY_RUN)) {
-            tee_printf(od, "The temporary directory has been set to %s.\n\n",
-              od->temp_dir);
-          }
+      else if ((parameter = get_args(od, "blas_threads"))) {
+        if (!strncasecmp(parameter, "auto", 4)) {
+          od->blas.max_threads = 0;
         }
         else {
-          tee_error(od, run_type, overall_line_num,
-            E_DIR_NOT_EXISTING, parameter, ENV_FAILED);
-          fail = !(run_type & INTERACTIVE_RUN);
-          continue;
+          sscanf(parameter, "%d", &(od->blas.max_threads));
+          if (od->blas.max_threads < 1) {
+            tee_error(od, run_type, overall_line_num,
+              "The number of BLAS threads should be "
+              "AUTO or a positive integer.\n%s",
+              ENV_FAILED);
+            od->blas.max_threads = 0;
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+        }
+        set_blas_threads(od, 1);
+        if (!(run_type & DRY_RUN)) {
+          print_blas_threads(od);
+        }
+      }
+      else if ((parameter = get_args(od, "workers"))) {
+        /*
+        CV and FFD selection tasks are sent to worker
+        processes connecting to this address; with
+        spawn=N, N workers are started on this machine
+        */
+        i = 0;
+        if ((point = get_args(od, "spawn"))) {
+          sscanf(point, "%d", &i);
+          if ((i < 1) || (i > MAX_WORKERS)) {
+            tee_error(od, run_type, overall_line_num,
+              "The number of worker processes to be spawned "
+              "should be an integer between 1 and %d.\n%s",
+              MAX_WORKERS, ENV_FAILED);
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+        }
+        if ((!(run_type & DRY_RUN)) && (!strcasecmp(parameter, "none"))) {
+          close_workers(od);
+          tee_printf(od, "Worker processes will not be used.\n\n");
+        }
+        else if (!(run_type & DRY_RUN)) {
+          close_workers(od);
+          if (listen_workers(od, parameter)) {
+            tee_error(od, run_type, overall_line_num,
+              "Cannot listen for worker processes at %s.\n%s",
+              parameter, ENV_FAILED);
+            close_workers(od);
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+          tee_printf(od, "Listening for worker processes at %s.\n",
+            od->workers.address);
+          if (i) {
+            if (!spawn_workers(od, i)) {
+              tee_error(od, run_type, overall_line_num,
+                "None of the worker processes could be started.\n%s",
+                ENV_FAILED);
+              close_workers(od);
+              fail = !(run_type & INTERACTIVE_RUN);
+              continue;
+            }
+            tee_printf(od, "%d worker process%s connected.\n",
+              od->workers.n_workers,
+              ((od->workers.n_workers > 1) ? "es" : ""));
+          }
+          tee_printf(od, "\n");
+        }
+      }
+      else if ((parameter = get_args(od, "random_seed"))) {
+        if (!(run_type & DRY_RUN)) {
+          sscanf(parameter, "%ld", &random_seed);
+          set_random_seed(od, (unsigned long)absval(random_seed));
+          tee_printf(od, "The random seed has been set to %ld.\n\n",
+            random_seed);
+        }
+      }
+      else if ((parameter = get_args(od, "temp_dir"))) {
+        if (dexist(parameter)) {
+          strcpy(od->temp_dir, parameter);
+          absolute_path(od->temp_dir);
+          if (!(run_type & DRY_RUN)) {
+            tee_printf(od, "The temporary directory has been set to %s.\n\n",
+              od->temp_dir);
+          }
+        }
+        else {
+          tee_error(od, run_type, overall_line_num,
+            E_DIR_NOT_EXISTING, parameter, ENV_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
         }
       }
       else if ((parameter = get_args(od, "qm_engine"))) {
@@ -5272,7 +5497,8 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
       else {
         tee_error(od, run_type, overall_line_num,
           "Allowed environmental variables which may be set are: "
-          "\"random_seed\", \"temp_dir\", \"n_cpus\", \"nice\", "
+          "\"random_seed\", \"temp_dir\", \"n_cpus\", \"blas_threads\", "
+          "\"workers\", \"nice\", "
           "\"babel_path\", \"md_grid_path\", "
           "\"qm_engine\", \"cs3d\", \"gnuplot\", "
           "\"jmol\" and \"pymol\".\n%s",
@@ -6646,6 +6872,21 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           fail = !(run_type & INTERACTIVE_RUN);
           continue;
         }
+        if (check_pls_algorithm(od, PLS_FAILED,
+          run_type, overall_line_num)) {
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+        if (check_pls_incremental(od, PLS_FAILED,
+          run_type, overall_line_num)) {
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+        if (check_pls_out_of_core(od, PLS_FAILED,
+          run_type, overall_line_num)) {
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
         pc = 5;
         if ((parameter = get_args(od, "pc"))) {
           sscanf(parameter, "%d", &pc);
@@ -6669,6 +6910,14 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             options |= CALC_LEVERAGE_BIT;
           }
         }
+        if ((options & CALC_LEVERAGE_BIT)
+          && (od->pls_storage == PLS_OUT_OF_CORE)) {
+          tee_error(od, run_type, overall_line_num,
+            "Leverages cannot be calculated for "
+            "out-of-core PLS models.\n%s", PLS_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
         if ((parameter = get_args(od, "calc_field_contrib"))) {
           if (!strncasecmp(parameter, "y", 1)) {
             options |= CALC_FIELD_CONTRIB_BIT;
@@ -6692,8 +6941,24 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         }
         memset(od->mal.press->base, 0,
           od->mal.press->m * od->mal.press->n * sizeof(double));
+        model_type = FULL_MODEL;
+        if (od->pls_storage == PLS_OUT_OF_CORE) {
+          model_type |= OUT_OF_CORE_MODEL;
+          /*
+          release E matrices left over by previous
+          commands, so that memory stays within budget
+          */
+          if (od->mal.large_e_mat) {
+            double_mat_free(od->mal.large_e_mat);
+            od->mal.large_e_mat = NULL;
+          }
+          if (od->mal.e_mat) {
+            double_mat_free(od->mal.e_mat);
+            od->mal.e_mat = NULL;
+          }
+        }
         result = alloc_pls(od, od->overall_active_x_vars,
-          pc, FULL_MODEL);
+          pc, model_type);
         if (result) {
           tee_error(od, run_type, overall_line_num,
             E_OUT_OF_MEMORY, PLS_FAILED);
@@ -6711,12 +6976,22 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             E_Y_VAR_LOW_SD, PLS_FAILED);
           return PARSE_INPUT_ERROR;
         }
-        result = fill_x_matrix(od, FULL_MODEL, 0);
-        switch (result) {
-          case OUT_OF_MEMORY:
-          tee_error(od, run_type, overall_line_num,
-            E_OUT_OF_MEMORY, PLS_FAILED);
-          return PARSE_INPUT_ERROR;
+        if (!(model_type & OUT_OF_CORE_MODEL)) {
+          result = fill_x_matrix(od, FULL_MODEL, 0);
+          switch (result) {
+            case OUT_OF_MEMORY:
+            tee_error(od, run_type, overall_line_num,
+              E_OUT_OF_MEMORY, PLS_FAILED);
+            return PARSE_INPUT_ERROR;
+          }
+        }
+        if (od->pls_incremental) {
+          result = update_gram_cache(od);
+          if (result) {
+            tee_error(od, run_type, overall_line_num,
+              E_OUT_OF_MEMORY, PLS_FAILED);
+            return PARSE_INPUT_ERROR;
+          }
         }
         result = fill_y_matrix(od);
         if (result) {
@@ -6724,10 +6999,12 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             E_OUT_OF_MEMORY, PLS_FAILED);
           return PARSE_INPUT_ERROR;
         }
-        trim_mean_center_matrix(od, od->mal.large_e_mat,
-          &(od->mal.e_mat), &(od->vel.e_mat_ave),
-          FULL_MODEL, od->active_object_num);
-        trim_mean_center_matrix(od, od->mal.large_f_mat,
+        if (!(model_type & OUT_OF_CORE_MODEL)) {
+          trim_mean_center_matrix(od, od->mal.large_e_mat, NULL,
+            &(od->mal.e_mat), &(od->vel.e_mat_ave),
+            FULL_MODEL, od->active_object_num);
+        }
+        trim_mean_center_matrix(od, od->mal.large_f_mat, NULL,
           &(od->mal.f_mat), &(od->vel.f_mat_ave),
           FULL_MODEL, od->active_object_num);
         od->file[ASCII_IN]->name[0] = '\0';
@@ -6745,7 +7022,30 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         ++command;
         tee_printf(od, M_TOOL_INVOKE, nesting, command, "PLS", line_orig);
         tee_flush(od);
-        pls(od, pc, FULL_MODEL);
+        if (model_type & OUT_OF_CORE_MODEL) {
+          tee_printf(od, "Out-of-core PLS: %d variables are streamed "
+            "in blocks of %d variables.\n\n",
+            od->overall_active_x_vars, od->pls_block_vars);
+          tee_flush(od);
+          result = pls_out_of_core(od, pc);
+          switch (result) {
+            case OUT_OF_MEMORY:
+            tee_error(od, run_type, overall_line_num,
+              E_OUT_OF_MEMORY, PLS_FAILED);
+            return PARSE_INPUT_ERROR;
+
+            case CANNOT_WRITE_TEMP_FILE:
+            tee_error(od, run_type, overall_line_num,
+              E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_X_MATRIX", PLS_FAILED);
+            return PARSE_INPUT_ERROR;
+          }
+        }
+        else {
+          if (od->pls_incremental) {
+            print_gram_cache_update(od);
+          }
+          pls(od, pc, FULL_MODEL);
+        }
         gettimeofday(&end, NULL);
         elapsed_time(od, &start, &end);
         tee_flush(od);
@@ -6755,6 +7055,12 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", PLS_FAILED);
           return PARSE_INPUT_ERROR;
         }
+        result = cache_pls_model(od);
+        if (result) {
+          tee_error(od, run_type, overall_line_num,
+            E_OUT_OF_MEMORY, PLS_FAILED);
+          return PARSE_INPUT_ERROR;
+        }
         result = open_temp_file(od, od->file[TEMP_CALC], "calc_y");
         if (result) {
           tee_error(od, run_type, overall_line_num,
@@ -6837,7 +7143,28 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         fail = !(run_type & INTERACTIVE_RUN);
         continue;
       }
+      if (check_pls_algorithm(od, CV_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_precision(od, CV_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_y_mode(od, CV_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_incremental(od, CV_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
       type = LEAVE_ONE_OUT;
+      nested_cv = 0;
       if ((parameter = get_args(od, "type"))) {
         if (!strncasecmp(parameter, "lto", 3)) {
           type = LEAVE_TWO_OUT;
@@ -6845,13 +7172,43 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         else if (!strncasecmp(parameter, "lmo", 3)) {
           type = LEAVE_MANY_OUT;
         }
+        else if (!strncasecmp(parameter, "nested", 6)) {
+          /*
+          nested CV is an LMO CV whose outer folds
+          get their own number of PCs
+          */
+          type = LEAVE_MANY_OUT;
+          nested_cv = 1;
+        }
         else if (strncasecmp(parameter, "loo", 3)) {
           tee_error(od, run_type, overall_line_num,
-            E_ONLY_LOO_LTO_LMO_CV_ALLOWED, CV_FAILED);
+            "Only \"LOO\", \"LTO\", \"LMO\", \"NESTED\" CV types "
+            "are allowed.\n%s", CV_FAILED);
           fail = !(run_type & INTERACTIVE_RUN);
           continue;
         }
       }
+      check_precision = 0;
+      if ((parameter = get_args(od, "check_precision"))) {
+        if (!strncasecmp(parameter, "y", 1)) {
+          check_precision = 1;
+        }
+      }
+      if (check_precision && nested_cv) {
+        tee_error(od, run_type, overall_line_num,
+          "check_precision=YES is not available with nested CV.\n%s",
+          CV_FAILED);
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_precision
+        && (od->pls_precision != PLS_SINGLE_PRECISION)) {
+        tee_error(od, run_type, overall_line_num,
+          "check_precision=YES requires precision=SINGLE.\n%s",
+          CV_FAILED);
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
       if (!(run_type & DRY_RUN)) {
         pc = od->pc_num;
         if ((parameter = get_args(od, "pc"))) {
@@ -6883,7 +7240,8 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           break;
 
           case LEAVE_MANY_OUT:
-          tee_printf(od, "LMO CV was chosen.\n\n");
+          tee_printf(od, "%s CV was chosen.\n\n",
+            (nested_cv ? "Nested" : "LMO"));
           result = check_lmo_parameters(od, CV_FAILED,
             &groups, &runs, run_type, overall_line_num);
           if (result) {
@@ -6892,6 +7250,35 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           }
           break;
         }
+        if (nested_cv) {
+          od->cv.inner_groups = 5;
+          if ((parameter = get_args(od, "inner_groups"))) {
+            sscanf(parameter, "%d", &(od->cv.inner_groups));
+          }
+          if (od->cv.inner_groups < 2) {
+            tee_error(od, run_type, overall_line_num,
+              E_TOO_FEW_MANY_FOR_AVAILABLE_DATA, "few inner groups",
+              CV_FAILED);
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+          /*
+          the training set of the largest outer
+          fold must fill all inner groups
+          */
+          get_attr_struct_ave(od, 0, ACTIVE_BIT, &active_struct_num, NULL);
+          if (od->cv.inner_groups > (active_struct_num
+            - (active_struct_num + groups - 1) / groups)) {
+            tee_error(od, run_type, overall_line_num,
+              E_TOO_FEW_MANY_FOR_AVAILABLE_DATA, "many inner groups",
+              CV_FAILED);
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+          tee_printf(od, "The number of PCs of each outer fold will be "
+            "chosen by an inner LMO CV with %d groups.\n\n",
+            od->cv.inner_groups);
+        }
         tee_flush(od);
         if ((pc > od->pc_num)
           || (pc > od->overall_active_x_vars)) {
@@ -6935,6 +7322,42 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             E_OUT_OF_MEMORY, CV_FAILED);
           return PARSE_INPUT_ERROR;
         }
+        result = calc_large_mat_sum(od, od->mal.large_e_mat,
+          &(od->mal.large_e_mat_sum));
+        if (!result) {
+          result = calc_large_mat_sum(od, od->mal.large_f_mat,
+            &(od->mal.large_f_mat_sum));
+        }
+        if (result) {
+          tee_error(od, run_type, overall_line_num,
+            E_OUT_OF_MEMORY, CV_FAILED);
+          return PARSE_INPUT_ERROR;
+        }
+        if (od->pls_incremental) {
+          result = update_gram_cache(od);
+          if (result) {
+            tee_error(od, run_type, overall_line_num,
+              E_OUT_OF_MEMORY, CV_FAILED);
+            return PARSE_INPUT_ERROR;
+          }
+          print_gram_cache_update(od);
+        }
+        /*
+        inner folds of nested CV are fitted on
+        the plain E matrix, as outer folds
+        */
+        if ((od->pls_algorithm == KERNEL_PLS) && (!nested_cv)) {
+          result = prepare_kernel_cv(od);
+          if (result) {
+            tee_error(od, run_type, overall_line_num,
+              E_OUT_OF_MEMORY, CV_FAILED);
+            return PARSE_INPUT_ERROR;
+          }
+        }
+        if (!nested_cv) {
+          prepare_implicit_cv(od);
+          prepare_sp_cv(od);
+        }
         set_random_seed(od, od->random_seed);
         result = prepare_cv(od, pc, type, groups, runs);
         switch (result) {
@@ -6948,6 +7371,26 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             E_TOO_FEW_STRUCTURES_FOR_CV, CV_FAILED);
           return PARSE_INPUT_ERROR;
         }
+        result = alloc_cv_pred(od, pc, type);
+        if (result) {
+          tee_error(od, run_type, overall_line_num,
+            E_OUT_OF_MEMORY, CV_FAILED);
+          return PARSE_INPUT_ERROR;
+        }
+        if (nested_cv) {
+          od->mal.inner_press = double_mat_resize
+            (od->mal.inner_press, pc + 1, od->y_vars);
+          od->mal.nested_press = double_mat_resize
+            (od->mal.nested_press, od->y_vars, runs * groups);
+          od->mel.nested_pc = alloc_int_array
+            (od->mel.nested_pc, runs * groups);
+          if ((!(od->mal.inner_press)) || (!(od->mal.nested_press))
+            || (!(od->mel.nested_pc))) {
+            tee_error(od, run_type, overall_line_num,
+              E_OUT_OF_MEMORY, CV_FAILED);
+            return PARSE_INPUT_ERROR;
+          }
+        }
         od->file[ASCII_IN]->name[0] = '\0';
         if ((parameter = get_args(od, "file"))) {
           strcpy(od->file[ASCII_IN]->name, parameter);
@@ -6960,13 +7403,21 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             continue;
           }
         }
-        if (od->n_proc > 1) {
+        /*
+        nested CV is always run through the thread pool,
+        even with a single CPU
+        */
+        od->cv.nested = nested_cv;
+        accept_workers(od);
+        if ((od->n_proc > 1) || nested_cv || use_workers(od, CV_MODEL)) {
           result = parallel_cv(od, od->overall_active_x_vars,
              pc, PARALLEL_CV | CV_MODEL, type, groups, runs);
           free_parallel_cv(od, od->mel.thread_info, CV_MODEL, type, runs);
+          od->cv.nested = 0;
         }
         else {
-          if (open_temp_file(od, od->file[TEMP_PRED], "pred_y")) {
+          if ((!(od->cv_pred.active))
+            && open_temp_file(od, od->file[TEMP_PRED], "pred_y")) {
             tee_error(od, run_type, overall_line_num,
               E_TEMP_FILE_CANNOT_BE_OPENED_FOR_WRITING,
               od->file[TEMP_PRED]->name, CV_FAILED);
@@ -6981,6 +7432,13 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
             free_cv_groups(od, runs);
           }
         }
+        if ((!result) && check_precision) {
+          result = compare_cv_precision(od, pc, type, groups, runs);
+        }
+        free_kernel_cv(od);
+        od->cv.implicit_cv = 0;
+        od->cv.sp_cv = 0;
+        free_large_mat_sum(od);
         gettimeofday(&end, NULL);
         elapsed_time(od, &start, &end);
         switch (result) {
@@ -7039,6 +7497,16 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         fail = !(run_type & INTERACTIVE_RUN);
         continue;
       }
+      if (check_pls_algorithm(od, SCRAMBLE_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_precision(od, SCRAMBLE_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
       od->scramble.scramblings = 10;
       if ((parameter = get_args(od, "scramblings"))) {
         sscanf(parameter, "%d", &(od->scramble.scramblings));
@@ -7161,13 +7629,6 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           fail = !(run_type & INTERACTIVE_RUN);
           continue;
         }
-        if (open_temp_file(od, od->file[TEMP_SCRAMBLE], "scramble")) {
-          tee_error(od, run_type, overall_line_num,
-            E_TEMP_FILE_CANNOT_BE_OPENED_FOR_WRITING,
-            od->file[TEMP_SCRAMBLE]->name, SCRAMBLE_FAILED);
-          fail = !(run_type & INTERACTIVE_RUN);
-          continue;
-        }
         result = scramble(od, pc);
         gettimeofday(&end, NULL);
         elapsed_time(od, &start, &end);
@@ -7203,10 +7664,6 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           return PARSE_INPUT_ERROR;
 
           default:
-          if (od->file[TEMP_SCRAMBLE]->handle) {
-            fclose(od->file[TEMP_SCRAMBLE]->handle);
-            od->file[TEMP_SCRAMBLE]->handle = NULL;
-          }
           result = reload_weights_loadings(od);
           if (result) {
             tee_error(od, run_type, overall_line_num,
@@ -7221,6 +7678,235 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         od->valid |= SCRAMBLE_BIT;
       }
     }
+    else if (!strcasecmp(arg->me[0], "sweep")) {
+      gettimeofday(&start, NULL);
+      /*
+      user wants to compare PLS models built
+      on a grid of preprocessing settings
+      */
+      if (check_pls_algorithm(od, SWEEP_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_precision(od, SWEEP_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_y_mode(od, SWEEP_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      /*
+      r2 comes from a full PLS2 model, hence q2
+      must come from a PLS2 CV model as well
+      */
+      if (od->pls_y_mode == PLS1_Y_MODE) {
+        od->pls_y_mode = PLS2_Y_MODE;
+        tee_error(od, run_type, overall_line_num,
+          "y_mode=PLS1 is not available with SWEEP.\n%s",
+          SWEEP_FAILED);
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      od->pls_incremental = 0;
+      od->pls_storage = PLS_IN_CORE;
+      type = CUTOFF_MAX;
+      if ((parameter = get_args(od, "cutoff_type"))) {
+        if (!strncasecmp(parameter, "min", 3)) {
+          type = CUTOFF_MIN;
+        }
+        else if (strncasecmp(parameter, "max", 3)) {
+          tee_error(od, run_type, overall_line_num,
+            "Error while parsing the type of cutoff "
+            "(MIN | MAX) to be operated.\n%s",
+            SWEEP_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+      }
+      /*
+      each stage of the grid is given as a comma-separated
+      list of settings; NONE skips the stage
+      */
+      result = parse_sweep_list(od, SWEEP_CUTOFF, type,
+        ((parameter = get_args(od, "cutoff")) ? parameter : "none"));
+      if (!result) {
+        result = parse_sweep_list(od, SWEEP_ZERO, ZERO_ALL,
+          ((parameter = get_args(od, "zero")) ? parameter : "none"));
+      }
+      if (!result) {
+        result = parse_sweep_list(od, SWEEP_SDCUT, 0,
+          ((parameter = get_args(od, "sdcut")) ? parameter : "none"));
+      }
+      if (!result) {
+        result = parse_sweep_list(od, SWEEP_SCALE, 0,
+          ((parameter = get_args(od, "scaling")) ? parameter : "none"));
+      }
+      switch (result) {
+        case OUT_OF_MEMORY:
+        tee_error(od, run_type, overall_line_num,
+          E_OUT_OF_MEMORY, SWEEP_FAILED);
+        return PARSE_INPUT_ERROR;
+
+        case INVALID_LIST_RANGE:
+        free_sweep(od);
+        tee_error(od, run_type, overall_line_num,
+          "CUTOFF, ZERO and SDCUT settings should be comma-separated "
+          "lists of numbers or \"NONE\"; scaling settings should be "
+          "chosen among \"NONE\", \"AUTO\" and \"BUW\".\n%s",
+          SWEEP_FAILED);
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      od->sweep.cv_type = LEAVE_ONE_OUT;
+      od->sweep.groups = 0;
+      od->sweep.runs = 0;
+      if ((parameter = get_args(od, "type"))) {
+        if (!strncasecmp(parameter, "lto", 3)) {
+          od->sweep.cv_type = LEAVE_TWO_OUT;
+        }
+        else if (!strncasecmp(parameter, "lmo", 3)) {
+          od->sweep.cv_type = LEAVE_MANY_OUT;
+        }
+        else if (strncasecmp(parameter, "loo", 3)) {
+          free_sweep(od);
+          tee_error(od, run_type, overall_line_num,
+            E_ONLY_LOO_LTO_LMO_CV_ALLOWED, SWEEP_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+      }
+      od->sweep.pc_num = 5;
+      if ((parameter = get_args(od, "pc"))) {
+        sscanf(parameter, "%d", &(od->sweep.pc_num));
+      }
+      if (od->sweep.pc_num < 1) {
+        free_sweep(od);
+        tee_error(od, run_type, overall_line_num,
+          E_AT_LEAST_ONE_PC, SWEEP_FAILED);
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      /*
+      the models built by SWEEP replace the current one
+      */
+      od->valid &= (~(PLS_BIT | CV_BIT));
+      if (!(run_type & DRY_RUN)) {
+        if (!(od->field_num)) {
+          free_sweep(od);
+          tee_error(od, run_type, overall_line_num,
+            E_NO_FIELDS_PRESENT, SWEEP_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+        if (!(od->y_vars)) {
+          free_sweep(od);
+          tee_error(od, run_type, overall_line_num,
+            E_NO_Y_VARS_PRESENT, SWEEP_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+        strcpy(comma_hyphen_list, "all");
+        if ((parameter = get_args(od, "field_list"))) {
+          strcpy(comma_hyphen_list, parameter);
+        }
+        result = parse_comma_hyphen_list_to_array
+          (od, comma_hyphen_list, FIELD_LIST);
+        switch (result) {
+          case OUT_OF_MEMORY:
+          tee_error(od, run_type, overall_line_num,
+            E_OUT_OF_MEMORY, SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case INVALID_LIST_RANGE:
+          free_sweep(od);
+          tee_error(od, run_type, overall_line_num,
+            E_LIST_PARSING, "fields", "SWEEP",
+            SWEEP_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+        result = set(od, FIELD_LIST, OPERATE_BIT, 1, SILENT);
+        if (result) {
+          free_sweep(od);
+          tee_error(od, run_type, overall_line_num,
+            E_ALLOWED_FIELD_RANGE,
+            od->field_num, SWEEP_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
+        ++command;
+        tee_printf(od, M_TOOL_INVOKE, nesting, command, "SWEEP", line_orig);
+        if (od->sweep.cv_type == LEAVE_MANY_OUT) {
+          result = check_lmo_parameters(od, SWEEP_FAILED,
+            &(od->sweep.groups), &(od->sweep.runs),
+            run_type, overall_line_num);
+          if (result) {
+            free_sweep(od);
+            fail = !(run_type & INTERACTIVE_RUN);
+            continue;
+          }
+        }
+        for (i = 0, j = 1; i < SWEEP_STAGES; ++i) {
+          j *= od->sweep.n_settings[i];
+        }
+        tee_printf(od, "%d preprocessing configuration%s will be "
+          "evaluated with %s CV and up to %d PC%s.\n\n", j,
+          ((j > 1) ? "s" : ""), ((od->sweep.cv_type == LEAVE_ONE_OUT)
+          ? "LOO" : ((od->sweep.cv_type == LEAVE_TWO_OUT) ? "LTO" : "LMO")),
+          od->sweep.pc_num, ((od->sweep.pc_num > 1) ? "s" : ""));
+        tee_flush(od);
+        result = sweep(od);
+        gettimeofday(&end, NULL);
+        elapsed_time(od, &start, &end);
+        switch (result) {
+          case OUT_OF_MEMORY:
+          tee_error(od, run_type, overall_line_num,
+            E_OUT_OF_MEMORY, SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case Y_VAR_LOW_SD:
+          tee_error(od, run_type, overall_line_num,
+            E_Y_VAR_LOW_SD, SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case CANNOT_WRITE_TEMP_FILE:
+          tee_error(od, run_type, overall_line_num,
+            E_ERROR_IN_WRITING_TEMP_FILE, "TEMP_FIELD", SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case CANNOT_READ_TEMP_FILE:
+          tee_error(od, run_type, overall_line_num,
+            E_ERROR_IN_READING_TEMP_FILE, "TEMP_FIELD", SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case CANNOT_CREATE_THREAD:
+          tee_error(od, run_type, overall_line_num, E_THREAD_ERROR, "create",
+            od->error_code, SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case CANNOT_JOIN_THREAD:
+          tee_error(od, run_type, overall_line_num, E_THREAD_ERROR, "join",
+            od->error_code, SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          case NOT_ENOUGH_OBJECTS:
+          tee_error(od, run_type, overall_line_num,
+            E_TOO_FEW_STRUCTURES_FOR_CV, SWEEP_FAILED);
+          return PARSE_INPUT_ERROR;
+
+          default:
+          tee_printf(od, M_TOOL_SUCCESS, nesting, command, "SWEEP");
+          tee_flush(od);
+        }
+      }
+      else {
+        free_sweep(od);
+      }
+    }
     else if (!strcasecmp(arg->me[0], "ffdsel")) {
       gettimeofday(&start, NULL);
       if (!(od->valid & PLS_BIT)) {
@@ -7229,6 +7915,16 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         fail = !(run_type & INTERACTIVE_RUN);
         continue;
       }
+      if (check_pls_algorithm(od, FFDSEL_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_precision(od, FFDSEL_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
       od->ffdsel.cv_type = LEAVE_ONE_OUT;
       if ((parameter = get_args(od, "type"))) {
         if (!strncasecmp(parameter, "ext", 3)) {
@@ -7420,6 +8116,16 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
         fail = !(run_type & INTERACTIVE_RUN);
         continue;
       }
+      if (check_pls_algorithm(od, UVEPLS_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
+      if (check_pls_precision(od, UVEPLS_FAILED,
+        run_type, overall_line_num)) {
+        fail = !(run_type & INTERACTIVE_RUN);
+        continue;
+      }
       od->uvepls.cv_type = LEAVE_ONE_OUT;
       od->uvepls.groups = 1;
       od->uvepls.runs = od->active_object_num;
@@ -7535,6 +8241,18 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
               fail = !(run_type & INTERACTIVE_RUN);
               continue;
             }
+            /*
+            UVE-PLS statistics need the coefficients
+            of a fixed number of CV runs
+            */
+            if (od->cv.auto_runs) {
+              od->cv.auto_runs = 0;
+              tee_error(od, run_type, overall_line_num,
+                "runs=AUTO is not supported by UVEPLS.\n%s",
+                UVEPLS_FAILED);
+              fail = !(run_type & INTERACTIVE_RUN);
+              continue;
+            }
           }
           else if (strncasecmp(parameter, "loo", 3)) {
             tee_error(od, run_type, overall_line_num,
@@ -7681,6 +8399,13 @@ int parse_input(O3Data *od, FILE *input_stream, int run_type)
           fail = !(run_type & INTERACTIVE_RUN);
           continue;
         }
+        if (od->pls_storage == PLS_OUT_OF_CORE) {
+          tee_error(od, run_type, overall_line_num,
+            "External prediction is not available for "
+            "out-of-core PLS models.\n%s", PREDICT_FAILED);
+          fail = !(run_type & INTERACTIVE_RUN);
+          continue;
+        }
         result = open_temp_file(od, od->file[TEMP_EXT_PRED], "ext_pred_y");
         if (result) {
           tee_error(od, run_type, overall_line_num,
@@ -8488,8 +9213,16 @@ int check_lmo_parameters(O3Data *od, char *tool_msg, int *groups, int *runs,
     return PARSE_INPUT_RECOVERABLE_ERROR;
   }
   *runs = 20;
+  od->cv.auto_runs = 0;
+  od->cv.runs_tolerance = DEFAULT_AUTO_LMO_TOLERANCE;
   if ((parameter = get_args(od, "runs"))) {
-    sscanf(parameter, "%d", runs);
+    if (!strncasecmp(parameter, "auto", 4)) {
+      od->cv.auto_runs = 1;
+      *runs = DEFAULT_MAX_AUTO_LMO_RUNS;
+    }
+    else {
+      sscanf(parameter, "%d", runs);
+    }
   }
   if (*runs < 1) {
     tee_error(od, run_type, overall_line_num,
@@ -8498,6 +9231,209 @@ int check_lmo_parameters(O3Data *od, char *tool_msg, int *groups, int *runs,
       CV_FAILED);
     return PARSE_INPUT_RECOVERABLE_ERROR;
   }
+  if (od->cv.auto_runs) {
+    /*
+    runs are carried out until the confidence interval
+    of average q2 is narrower than tolerance, up to max_runs
+    */
+    if ((parameter = get_args(od, "max_runs"))) {
+      sscanf(parameter, "%d", runs);
+    }
+    if (*runs < MIN_AUTO_LMO_RUNS) {
+      tee_error(od, run_type, overall_line_num,
+        "At least %d runs must be allowed "
+        "with runs=AUTO.\n%s",
+        MIN_AUTO_LMO_RUNS, tool_msg);
+      return PARSE_INPUT_RECOVERABLE_ERROR;
+    }
+    if ((parameter = get_args(od, "tolerance"))) {
+      sscanf(parameter, "%lf", &(od->cv.runs_tolerance));
+    }
+    if (od->cv.runs_tolerance <= 0.0) {
+      tee_error(od, run_type, overall_line_num,
+        "The tolerance on average q2 must be positive.\n%s",
+        tool_msg);
+      return PARSE_INPUT_RECOVERABLE_ERROR;
+    }
+    tee_printf(od, "Up to %d runs will be carried out, stopping when "
+      "the 95%% confidence interval of average q2 is narrower than %.4lf.\n\n",
+      *runs, od->cv.runs_tolerance);
+  }
+  
+  return 0;
+}
+
+
+int check_pls_algorithm(O3Data *od, char *tool_msg,
+  int run_type, int overall_line_num)
+{
+  char *parameter;
+  
+  
+  od->pls_algorithm = NIPALS_PLS;
+  od->pls_precision = PLS_DOUBLE_PRECISION;
+  od->pls_y_mode = PLS2_Y_MODE;
+  od->pls_incremental = 0;
+  if ((parameter = get_args(od, "algorithm"))) {
+    if (!strncasecmp(parameter, "kernel", 6)) {
+      od->pls_algorithm = KERNEL_PLS;
+    }
+    else if (!strncasecmp(parameter, "implicit", 8)) {
+      od->pls_algorithm = IMPLICIT_PLS;
+    }
+    else if (strncasecmp(parameter, "nipals", 6)) {
+      tee_error(od, run_type, overall_line_num,
+        "The algorithm parameter should be NIPALS, KERNEL or IMPLICIT.\n%s",
+        tool_msg);
+      return PARSE_INPUT_RECOVERABLE_ERROR;
+    }
+  }
+  
+  return 0;
+}
+
+
+int check_pls_incremental(O3Data *od, char *tool_msg,
+  int run_type, int overall_line_num)
+{
+  char *parameter;
+  
+  
+  od->pls_incremental = 0;
+  if ((parameter = get_args(od, "incremental"))) {
+    if (!strncasecmp(parameter, "y", 1)) {
+      od->pls_incremental = 1;
+    }
+  }
+  if (!(od->pls_incremental)) {
+    return 0;
+  }
+  if (get_args(od, "algorithm") && (od->pls_algorithm != KERNEL_PLS)) {
+    tee_error(od, run_type, overall_line_num,
+      "Incremental update is only available "
+      "with algorithm=KERNEL.\n%s", tool_msg);
+    return PARSE_INPUT_RECOVERABLE_ERROR;
+  }
+  od->pls_algorithm = KERNEL_PLS;
+  
+  return 0;
+}
+
+
+int check_pls_out_of_core(O3Data *od, char *tool_msg,
+  int run_type, int overall_line_num)
+{
+  char *parameter;
+  double memory;
+  double kernel_size;
+  double block_vars;
+  
+  
+  od->pls_storage = PLS_IN_CORE;
+  if ((parameter = get_args(od, "out_of_core"))) {
+    if (!strncasecmp(parameter, "y", 1)) {
+      od->pls_storage = PLS_OUT_OF_CORE;
+    }
+  }
+  if (od->pls_storage == PLS_IN_CORE) {
+    return 0;
+  }
+  if (od->pls_incremental) {
+    tee_error(od, run_type, overall_line_num,
+      "Out-of-core PLS cannot be combined "
+      "with incremental=YES.\n%s", tool_msg);
+    return PARSE_INPUT_RECOVERABLE_ERROR;
+  }
+  if (get_args(od, "algorithm") && (od->pls_algorithm != KERNEL_PLS)) {
+    tee_error(od, run_type, overall_line_num,
+      "Out-of-core PLS is only available "
+      "with algorithm=KERNEL.\n%s", tool_msg);
+    return PARSE_INPUT_RECOVERABLE_ERROR;
+  }
+  od->pls_algorithm = KERNEL_PLS;
+  memory = DEFAULT_PLS_MEMORY;
+  if ((parameter = get_args(od, "memory"))) {
+    sscanf(parameter, "%lf", &memory);
+  }
+  /*
+  the budget must hold the m x m kernel plus
+  at least one column of the streamed E block
+  */
+  kernel_size = (double)(od->active_object_num)
+    * (double)(od->active_object_num);
+  block_vars = (memory * 1048576.0 / sizeof(double)
+    - kernel_size) / (double)(od->active_object_num);
+  if (block_vars < 1.0) {
+    tee_error(od, run_type, overall_line_num,
+      "A memory budget of at least %.2lf MB is needed "
+      "to hold the %d x %d kernel matrix.\n%s",
+      ((kernel_size + (double)(od->active_object_num))
+      * sizeof(double) / 1048576.0),
+      od->active_object_num, od->active_object_num, tool_msg);
+    return PARSE_INPUT_RECOVERABLE_ERROR;
+  }
+  od->pls_block_vars = ((block_vars < (double)(od->overall_active_x_vars))
+    ? (int)block_vars : od->overall_active_x_vars);
+  
+  return 0;
+}
+
+
+int check_pls_precision(O3Data *od, char *tool_msg,
+  int run_type, int overall_line_num)
+{
+  char *parameter;
+  
+  
+  od->pls_precision = PLS_DOUBLE_PRECISION;
+  if ((parameter = get_args(od, "precision"))) {
+    if (!strncasecmp(parameter, "single", 6)) {
+      od->pls_precision = PLS_SINGLE_PRECISION;
+    }
+    else if (strncasecmp(parameter, "double", 6)) {
+      tee_error(od, run_type, overall_line_num,
+        "The precision parameter should be DOUBLE or SINGLE.\n%s",
+        tool_msg);
+      return PARSE_INPUT_RECOVERABLE_ERROR;
+    }
+  }
+  if ((od->pls_precision == PLS_SINGLE_PRECISION)
+    && (od->pls_algorithm != NIPALS_PLS)) {
+    tee_error(od, run_type, overall_line_num,
+      "Single precision is only available "
+      "with algorithm=NIPALS.\n%s", tool_msg);
+    return PARSE_INPUT_RECOVERABLE_ERROR;
+  }
+  
+  return 0;
+}
+
+
+int check_pls_y_mode(O3Data *od, char *tool_msg,
+  int run_type, int overall_line_num)
+{
+  char *parameter;
+  
+  
+  od->pls_y_mode = PLS2_Y_MODE;
+  if ((parameter = get_args(od, "y_mode"))) {
+    if (!strncasecmp(parameter, "pls1", 4)) {
+      od->pls_y_mode = PLS1_Y_MODE;
+    }
+    else if (strncasecmp(parameter, "pls2", 4)) {
+      tee_error(od, run_type, overall_line_num,
+        "The y_mode parameter should be PLS2 or PLS1.\n%s",
+        tool_msg);
+      return PARSE_INPUT_RECOVERABLE_ERROR;
+    }
+  }
+  if ((od->pls_y_mode == PLS1_Y_MODE)
+    && (od->pls_precision != PLS_DOUBLE_PRECISION)) {
+    tee_error(od, run_type, overall_line_num,
+      "y_mode=PLS1 is only available "
+      "with precision=DOUBLE.\n%s", tool_msg);
+    return PARSE_INPUT_RECOVERABLE_ERROR;
+  }
   
   return 0;
 }
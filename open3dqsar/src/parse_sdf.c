@@ -167,58 +167,72 @@ int get_n_atoms_bonds(MolInfo *mol_info, FILE *handle, char *buffer)
 }
 
 
-int break_sdf_to_mol(O3Data *od, TaskInfo *task, FileDescriptor *from_fd, char *to_dir)
+int open_mol_record(O3Data *od, FileDescriptor *mol_fd, int object_num)
 {
-  char buffer[BUF_LEN];
-  int object_num;
-  int found;
-  FileDescriptor mol_fd;
+  /*
+  MOL records of all objects are stored back to back
+  in a single file; open it and position the handle
+  at the beginning of the record of object_num
+  */
+  sprintf(mol_fd->name, "%s%c"MOL_STORE_FILENAME,
+    od->field.mol_dir, SEPARATOR);
+  if (!(mol_fd->handle = fopen(mol_fd->name, "rb"))) {
+    return CANNOT_READ_TEMP_FILE;
+  }
+  if (fseek(mol_fd->handle,
+    od->al.mol_info[object_num]->mol_offset, SEEK_SET)) {
+    fclose(mol_fd->handle);
+    mol_fd->handle = NULL;
+    return CANNOT_READ_TEMP_FILE;
+  }
+  
+  return 0;
+}
 
 
-  memset(&mol_fd, 0, sizeof(FileDescriptor));
-  memset(buffer, 0, BUF_LEN);
-  if (!(from_fd->handle = fopen(from_fd->name, "rb"))) {
-    O3_ERROR_LOCATE(task);
-    O3_ERROR_STRING(task, from_fd->name);
-    return FL_CANNOT_READ_SDF_FILE;
+int open_mmff_record(O3Data *od, FileDescriptor *mmff_fd, int object_num)
+{
+  /*
+  obenergy atom type/charge blocks of all objects are
+  stored back to back in a single file; open it and
+  position the handle at the block of object_num
+  */
+  sprintf(mmff_fd->name, "%s%c"MMFF_STORE_FILENAME,
+    od->field.mol_dir, SEPARATOR);
+  if (!(mmff_fd->handle = fopen(mmff_fd->name, "rb"))) {
+    return CANNOT_READ_TEMP_FILE;
   }
-  for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
-    sprintf(mol_fd.name, "%s%c%04d.mol", to_dir, SEPARATOR,
-      od->al.mol_info[object_num]->object_id);
-    if (!(mol_fd.handle = fopen(mol_fd.name, "wb"))) {
-      O3_ERROR_LOCATE(task);
-      O3_ERROR_STRING(task, mol_fd.name);
-      fclose(from_fd->handle);
-      return FL_CANNOT_WRITE_TEMP_FILE;
-    }
-    found = 0;
-    while ((!found) && fgets(buffer, BUF_LEN, from_fd->handle)) {
-      buffer[BUF_LEN - 1] = '\0';
-      remove_newline(buffer);
-      fprintf(mol_fd.handle, "%s\n", buffer);
-      found = (!strncmp(buffer, MOL_DELIMITER, strlen(MOL_DELIMITER)));
-    }
-    if (!found) {
-      O3_ERROR_LOCATE(task);
-      O3_ERROR_STRING(task, from_fd->name);
-      fclose(from_fd->handle);
-      fclose(mol_fd.handle);
-      return FL_CANNOT_READ_SDF_FILE;
-    }
-    found = 0;
-    while ((!found) && fgets(buffer, BUF_LEN, from_fd->handle)) {
-      buffer[BUF_LEN - 1] = '\0';
-      found = (!strncmp(buffer, SDF_DELIMITER, 4));
-    }
-    fclose(mol_fd.handle);
-    if (!found) {
-      O3_ERROR_LOCATE(task);
-      O3_ERROR_STRING(task, from_fd->name);
-      fclose(from_fd->handle);
-      return FL_CANNOT_READ_SDF_FILE;
+  if (fseek(mmff_fd->handle,
+    od->al.mol_info[object_num]->mmff_offset, SEEK_SET)) {
+    fclose(mmff_fd->handle);
+    mmff_fd->handle = NULL;
+    return CANNOT_READ_TEMP_FILE;
+  }
+  
+  return 0;
+}
+
+
+static int fgrep_mmff_record(O3Data *od, FILE *handle, char *buffer, char *grep_key, int object_num)
+{
+  /*
+  same as fgrep(), but the search is restricted
+  to the obenergy block of object_num
+  */
+  long end;
+  
+  
+  if (fseek(handle, od->al.mol_info[object_num]->mmff_offset, SEEK_SET)) {
+    return 0;
+  }
+  end = od->al.mol_info[object_num]->mmff_offset
+    + od->al.mol_info[object_num]->mmff_len;
+  while ((ftell(handle) < end) && fgets(buffer, BUF_LEN, handle)) {
+    buffer[BUF_LEN - 1] = '\0';
+    if (strstr(buffer, grep_key)) {
+      return 1;
     }
   }
-  fclose(from_fd->handle);
   
   return 0;
 }
@@ -272,46 +286,6 @@ int break_sdf_to_sdf(O3Data *od, TaskInfo *task, FileDescriptor *from_fd, char *
 }
 
 
-int join_mol_to_sdf(O3Data *od, TaskInfo *task, FileDescriptor *to_fd, char *from_dir)
-{
-  char buffer[BUF_LEN];
-  int object_num;
-  FileDescriptor mol_fd;
-
-
-  memset(&mol_fd, 0, sizeof(FileDescriptor));
-  memset(buffer, 0, BUF_LEN);
-  if (!(to_fd->handle = fopen(to_fd->name, "wb"))) {
-    O3_ERROR_LOCATE(task);
-    O3_ERROR_STRING(task, to_fd->name);
-    return FL_CANNOT_WRITE_TEMP_FILE;
-  }
-  for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
-    if (od->al.mol_info[object_num]->done & OBJECT_ALREADY_DONE) {
-      continue;
-    }
-    sprintf(mol_fd.name, "%s%c%04d.mol",
-      from_dir, SEPARATOR, od->al.mol_info[object_num]->object_id);
-    if (!(mol_fd.handle = fopen(mol_fd.name, "rb"))) {
-      O3_ERROR_LOCATE(task);
-      O3_ERROR_STRING(task, mol_fd.name);
-      fclose(to_fd->handle);
-      return FL_CANNOT_READ_SDF_FILE;
-    }
-    while (fgets(buffer, BUF_LEN, mol_fd.handle)) {
-      buffer[BUF_LEN - 1] = '\0';
-      remove_newline(buffer);
-      fprintf(to_fd->handle, "%s\n", buffer);
-    }
-    fprintf(to_fd->handle, SDF_DELIMITER"\n");
-    fclose(mol_fd.handle);
-  }
-  fclose(to_fd->handle);
-  
-  return 0;
-}
-
-
 int convert_mol(O3Data *od, char *from_filename, char *to_filename, char *from_ext, char *to_ext, char *flags)
 {
   char buffer[BUF_LEN];
@@ -405,9 +379,7 @@ int update_mol(O3Data *od)
     }
   }
   for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
-    sprintf(mol_fd.name, "%s%c%04d.mol", od->field.mol_dir,
-      SEPARATOR, od->al.mol_info[object_num]->object_id);
-    if (!(mol_fd.handle = fopen(mol_fd.name, "rb"))) {
+    if (open_mol_record(od, &mol_fd, object_num)) {
       O3_ERROR_LOCATE(&(od->task));
       O3_ERROR_STRING(&(od->task), mol_fd.name);
       return CANNOT_READ_TEMP_FILE;
@@ -623,15 +595,22 @@ int parse_sdf(O3Data *od, int options, char *name_list)
       return OUT_OF_MEMORY;
     }
   }
+  /*
+  MOL records are written back to back to a single
+  file and indexed by their byte offset and length
+  */
+  sprintf(mol_fd.name, "%s%c"MOL_STORE_FILENAME,
+    od->field.mol_dir, SEPARATOR);
+  if (!(mol_fd.handle = fopen(mol_fd.name, "wb"))) {
+    O3_ERROR_LOCATE(&(od->task));
+    O3_ERROR_STRING(&(od->task), mol_fd.name);
+    return CANNOT_WRITE_TEMP_FILE;
+  }
   while (fgets(buffer, BUF_LEN, od->file[MOLFILE_IN]->handle)
     && (object_num < molecule_num)) {
     buffer[BUF_LEN - 1] = '\0';
     remove_newline(buffer);
     if (look_for_sdf_delimiter) {
-      if (mol_fd.handle) {
-        fclose(mol_fd.handle);
-        memset(&mol_fd, 0, sizeof(FileDescriptor));
-      }
       if (read_y_value) {
         /*
         get y var value
@@ -681,13 +660,7 @@ int parse_sdf(O3Data *od, int options, char *name_list)
     }
     ++line;
     if (line == 1) {
-      sprintf(mol_fd.name, "%s%c%04d.mol",
-        od->field.mol_dir, SEPARATOR, od->al.mol_info[object_num]->object_id);
-      if (!(mol_fd.handle = fopen(mol_fd.name, "wb+"))) {
-        O3_ERROR_LOCATE(&(od->task));
-        O3_ERROR_STRING(&(od->task), mol_fd.name);
-        return CANNOT_WRITE_TEMP_FILE;
-      }
+      od->al.mol_info[object_num]->mol_offset = ftell(mol_fd.handle);
       /*
       get molecule name
       */
@@ -717,12 +690,18 @@ int parse_sdf(O3Data *od, int options, char *name_list)
     if (line == 4) {
       if (get_n_atoms_bonds(od->al.mol_info[object_num],
         od->file[MOLFILE_IN]->handle, buffer)) {
+        fclose(mol_fd.handle);
         return PREMATURE_EOF;
       }
     }
     fprintf(mol_fd.handle, "%s\n", buffer);
     look_for_sdf_delimiter = (!strncmp(buffer, MOL_DELIMITER, strlen(MOL_DELIMITER)));
+    if (look_for_sdf_delimiter) {
+      od->al.mol_info[object_num]->mol_len = (int)(ftell(mol_fd.handle)
+        - od->al.mol_info[object_num]->mol_offset);
+    }
   }
+  fclose(mol_fd.handle);
   if (options & IMPORT_Y_VARS_BIT) {
     tee_printf(od, "\n");
   }
@@ -744,10 +723,11 @@ int call_obenergy(O3Data *od, int force_field)
 
 
   memset(buffer, 0, BUF_LEN);
-  for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
-    sprintf(buffer, "%s%c%04d.%s", od->field.mol_dir, SEPARATOR,
-      od->al.mol_info[object_num]->object_id, "mmff");
-    if (!fexist(buffer)) {
+  sprintf(buffer, "%s%c"MMFF_STORE_FILENAME,
+    od->field.mol_dir, SEPARATOR);
+  for (object_num = 0; fexist(buffer)
+    && (object_num < od->grid.object_num); ++object_num) {
+    if (!(od->al.mol_info[object_num]->mmff_len)) {
       break;
     }
   }
@@ -790,40 +770,57 @@ int call_obenergy(O3Data *od, int force_field)
   fclose(od->file[TEMP_LOG]->handle);
   od->file[TEMP_LOG]->handle = NULL;
   /*
-  split obenergy output into multiple files
+  copy obenergy output into a single file, keeping
+  track of the offset and length of the block
+  belonging to each object
   */
   if (!(od->file[TEMP_OUT]->handle = fopen
     (od->file[TEMP_OUT]->name, "rb"))) {
     return OPENBABEL_ERROR;
   }
+  sprintf(od->file[BINARY_IN]->name, "%s%c"MMFF_STORE_FILENAME,
+    od->field.mol_dir, SEPARATOR);
+  if (!(od->file[BINARY_IN]->handle = fopen
+    (od->file[BINARY_IN]->name, "wb"))) {
+    fclose(od->file[TEMP_OUT]->handle);
+    od->file[TEMP_OUT]->handle = NULL;
+    return OPENBABEL_ERROR;
+  }
   object_num = 0;
   while (fgets(buffer, BUF_LEN, od->file[TEMP_OUT]->handle)) {
     buffer[BUF_LEN - 1] = '\0';
     remove_newline(buffer);
     if (strstr(buffer, "A T O M   T Y P E S")) {
-      if (od->file[BINARY_IN]->handle) {
-        fclose(od->file[BINARY_IN]->handle);
-        od->file[BINARY_IN]->handle = NULL;
+      if (object_num == od->grid.object_num) {
+        ++object_num;
+        break;
       }
-      sprintf(od->file[BINARY_IN]->name, "%s%c%04d.%s", od->field.mol_dir,
-        SEPARATOR, od->al.mol_info[object_num]->object_id, "mmff");
-      if (!(od->file[BINARY_IN]->handle = fopen
-        (od->file[BINARY_IN]->name, "wb"))) {
-        return OPENBABEL_ERROR;
+      if (object_num) {
+        od->al.mol_info[object_num - 1]->mmff_len =
+          (int)(ftell(od->file[BINARY_IN]->handle)
+          - od->al.mol_info[object_num - 1]->mmff_offset);
       }
+      od->al.mol_info[object_num]->mmff_offset =
+        ftell(od->file[BINARY_IN]->handle);
       ++object_num;
     }
-    if (od->file[BINARY_IN]->handle) {
+    if (object_num) {
       fprintf(od->file[BINARY_IN]->handle, "%s\n", buffer);
     }
   }
-  if (od->file[BINARY_IN]->handle) {
-    fclose(od->file[BINARY_IN]->handle);
-    od->file[BINARY_IN]->handle = NULL;
+  if (object_num && (object_num <= od->grid.object_num)) {
+    od->al.mol_info[object_num - 1]->mmff_len =
+      (int)(ftell(od->file[BINARY_IN]->handle)
+      - od->al.mol_info[object_num - 1]->mmff_offset);
   }
+  fclose(od->file[BINARY_IN]->handle);
+  od->file[BINARY_IN]->handle = NULL;
   fclose(od->file[TEMP_OUT]->handle);
   od->file[TEMP_OUT]->handle = NULL;
   if (object_num != od->grid.object_num) {
+    for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
+      od->al.mol_info[object_num]->mmff_len = 0;
+    }
     return OPENBABEL_ERROR;
   }
   
@@ -871,14 +868,10 @@ int fill_atom_info(O3Data *od, TaskInfo *task, AtomInfo **atom, BondList **bond_
 
   memset(&mol_fd, 0, sizeof(FileDescriptor));
   memset(&out_fd, 0, sizeof(FileDescriptor));
-  sprintf(mol_fd.name, "%s%c%04d.mol", od->field.mol_dir,
-    SEPARATOR, od->al.mol_info[object_num]->object_id);
-  sprintf(out_fd.name, "%s%c%04d.%s", od->field.mol_dir,
-    SEPARATOR, od->al.mol_info[object_num]->object_id, "mmff");
   /*
-  open MOL file and get number of atoms, bonds
+  open MOL record and get number of atoms, bonds
   */
-  if (!(mol_fd.handle = fopen(mol_fd.name, "rb"))) {
+  if (open_mol_record(od, &mol_fd, object_num)) {
     O3_ERROR_LOCATE(task);
     O3_ERROR_STRING(task, mol_fd.name);
     return FL_CANNOT_READ_MOL_FILE;
@@ -909,14 +902,14 @@ int fill_atom_info(O3Data *od, TaskInfo *task, AtomInfo **atom, BondList **bond_
   for (i = 0; bond_list && (i < n_bonds); ++i) {
     memset(bond_list[i], 0, sizeof(BondList));
   }
-  if (!(out_fd.handle = fopen(out_fd.name, "rb"))) {
+  if (open_mmff_record(od, &out_fd, object_num)) {
     fclose(mol_fd.handle);
     O3_ERROR_LOCATE(task);
     O3_ERROR_STRING(task, out_fd.name);
     return FL_CANNOT_READ_OB_OUTPUT;
   }
-  if (!fgrep(out_fd.handle, buffer,
-    "F O R M A L   C H A R G E S")) {
+  if (!fgrep_mmff_record(od, out_fd.handle, buffer,
+    "F O R M A L   C H A R G E S", object_num)) {
     fclose(out_fd.handle);
     fclose(mol_fd.handle);
     O3_ERROR_LOCATE(task);
@@ -955,7 +948,8 @@ int fill_atom_info(O3Data *od, TaskInfo *task, AtomInfo **atom, BondList **bond_
   /*
   find atom types for this molecule
   */
-  if (!fgrep(out_fd.handle, buffer, "A T O M   T Y P E S")) {
+  if (!fgrep_mmff_record(od, out_fd.handle, buffer,
+    "A T O M   T Y P E S", object_num)) {
     fclose(out_fd.handle);
     fclose(mol_fd.handle);
     O3_ERROR_LOCATE(task);
@@ -1022,7 +1016,8 @@ int fill_atom_info(O3Data *od, TaskInfo *task, AtomInfo **atom, BondList **bond_
   /*
   find partial charges for this molecule
   */
-  if (!fgrep(out_fd.handle, buffer, "P A R T I A L   C H A R G E S")) {
+  if (!fgrep_mmff_record(od, out_fd.handle, buffer,
+    "P A R T I A L   C H A R G E S", object_num)) {
     fclose(out_fd.handle);
     fclose(mol_fd.handle);
     O3_ERROR_LOCATE(task);
@@ -3449,6 +3444,7 @@ int rototrans(O3Data *od, char *out_sdf_name, double *trans, double *rot)
 {
   char buffer[BUF_LEN];
   int i;
+  int found;
   int x;
   int object_num;
   int n_atoms = 0;
@@ -3504,9 +3500,7 @@ int rototrans(O3Data *od, char *out_sdf_name, double *trans, double *rot)
     }
   }
   for (object_num = 0; object_num < od->grid.object_num; ++object_num) {
-    sprintf(mol_fd.name, "%s%c%04d.mol", od->field.mol_dir,
-      SEPARATOR, od->al.mol_info[object_num]->object_id);
-    if (!(mol_fd.handle = fopen(mol_fd.name, "rb"))) {
+    if (open_mol_record(od, &mol_fd, object_num)) {
       O3_ERROR_LOCATE(&(od->task));
       O3_ERROR_STRING(&(od->task), mol_fd.name);
       fclose(out_sdf_fd.handle);
@@ -3576,10 +3570,12 @@ int rototrans(O3Data *od, char *out_sdf_name, double *trans, double *rot)
       }
       fprintf(out_sdf_fd.handle, "%s\n", buffer);
     }
-    while (fgets(buffer, BUF_LEN, mol_fd.handle)) {
+    found = 0;
+    while ((!found) && fgets(buffer, BUF_LEN, mol_fd.handle)) {
       buffer[BUF_LEN - 1] = '\0';
       remove_newline(buffer);
       fprintf(out_sdf_fd.handle, "%s\n", buffer);
+      found = (!strncmp(buffer, MOL_DELIMITER, strlen(MOL_DELIMITER)));
     }
     fprintf(out_sdf_fd.handle, SDF_DELIMITER"\n");
     fclose(mol_fd.handle);
@@ -42,7 +42,7 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
-int pca(O3Data *od, int pc_num)
+int pca(O3Data *od, int pc_num, int algorithm, int power_iterations)
 {
   int i;
   int j;
@@ -54,6 +54,7 @@ int pca(O3Data *od, int pc_num)
   int max_ss_x;
   int cmp;
   int actual_len;
+  int result;
   double norm_b;
   double max_ss;
   double ss_u;
@@ -119,23 +120,22 @@ int pca(O3Data *od, int pc_num)
   if (actual_len != 1) {
     return CANNOT_WRITE_TEMP_FILE;
   }
-    
-        for (i = 0; i < pc_num; ++i) {
+  if (algorithm == RANDOMIZED_PCA) {
+    result = pca_randomized(od, pc_num, power_iterations);
+    if (result) {
+      return result;
+    }
+  }
+  for (i = 0; (algorithm == NIPALS_PCA) && (i < pc_num); ++i) {
     /*
     Find the column vector with the largest sum of squares
     */
     max_ss = 0.0;
     max_ss_x = 0;
     for (x = 0; x < x_max; ++x) {
-      /*
-      extract x-th column vector from X
-      */
-      cblas_dcopy(od->mal.e_mat->m,
+      ss_u = cblas_ddot(od->mal.e_mat->m,
         &M_PEEK(od->mal.e_mat, 0, x), 1,
-        od->vel.u->ve, 1);
-      ss_u = cblas_ddot(od->vel.u->size,
-        od->vel.u->ve, 1,
-        od->vel.u->ve, 1);
+        &M_PEEK(od->mal.e_mat, 0, x), 1);
       if (ss_u > max_ss) {
         max_ss = ss_u;
         max_ss_x = x;
@@ -208,13 +208,13 @@ int pca(O3Data *od, int pc_num)
     /*
     E[i + 1] = E[i] - ub'
     */
-    for (y = 0; y < y_max; ++y) {
-      cblas_daxpy(od->mal.e_mat->n,
-        - od->vel.u->ve[y],
-        od->vel.b->ve, 1,
-        &M_PEEK(od->mal.e_mat, y, 0),
-        od->mal.e_mat->max_m);
-    }
+    cblas_dger(CblasColMajor,
+      od->mal.e_mat->m,
+      od->mal.e_mat->n, -1.0,
+      od->vel.u->ve, 1,
+      od->vel.b->ve, 1,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m);
     actual_len = fwrite(od->vel.u->ve,
       sizeof(double), od->mal.e_mat->m,
       od->file[TEMP_PCA_SCORES]->handle);
@@ -236,6 +236,10 @@ int pca(O3Data *od, int pc_num)
       - s2_x_tot / s2_x_tot_start;
     cum_explained_s2_x +=
       od->vel.explained_s2_x->ve[i];
+  }
+  for (i = 0, cum_explained_s2_x = 0.0; i < pc_num; ++i) {
+    cum_explained_s2_x +=
+      od->vel.explained_s2_x->ve[i];
     tee_printf(od, "%2d%20.4lf%20.4lf\n", i + 1,
       od->vel.explained_s2_x->ve[i] * 100,
       cum_explained_s2_x * 100);
@@ -0,0 +1,340 @@
+/*
+
+pca_randomized.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+/*
+orthonormalize the first n columns of q through classical
+Gram-Schmidt with reorthogonalization; columns which turn
+out to be linearly dependent on the previous ones are zeroed
+*/
+static void orthonormalize_columns(DoubleMat *q, int n, DoubleVec *z)
+{
+  int j;
+  int pass;
+  double norm;
+  double norm_start;
+  
+  
+  for (j = 0; j < n; ++j) {
+    norm_start = cblas_dnrm2(q->m, &M_PEEK(q, 0, j), 1);
+    for (pass = 0; j && (pass < 2); ++pass) {
+      cblas_dgemv(CblasColMajor, CblasTrans,
+        q->m, j, 1.0, q->base, q->max_m,
+        &M_PEEK(q, 0, j), 1, 0.0, z->ve, 1);
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        q->m, j, -1.0, q->base, q->max_m,
+        z->ve, 1, 1.0, &M_PEEK(q, 0, j), 1);
+    }
+    norm = cblas_dnrm2(q->m, &M_PEEK(q, 0, j), 1);
+    if ((norm > 0.0) && (norm > (ALMOST_ZERO * norm_start))) {
+      cblas_dscal(q->m, 1.0 / norm, &M_PEEK(q, 0, j), 1);
+    }
+    else {
+      memset(&M_PEEK(q, 0, j), 0, q->m * sizeof(double));
+    }
+  }
+}
+
+
+/*
+eigenvalues and eigenvectors of the small symmetric
+matrix c through cyclic Jacobi rotations; c is destroyed,
+eigenvalues are returned in its diagonal and eigenvectors
+in the columns of v
+*/
+static void jacobi_eigen(DoubleMat *c, DoubleMat *v)
+{
+  int i;
+  int j;
+  int k;
+  int sweep;
+  double off;
+  double diag;
+  double theta;
+  double t;
+  double cs;
+  double sn;
+  double c_ki;
+  double c_kj;
+  
+  
+  for (j = 0; j < v->n; ++j) {
+    for (i = 0; i < v->m; ++i) {
+      M_POKE(v, i, j, ((i == j) ? 1.0 : 0.0));
+    }
+  }
+  for (sweep = 0; sweep < JACOBI_MAX_SWEEPS; ++sweep) {
+    /*
+    converged when the off-diagonal elements are negligible
+    compared to the diagonal ones, whatever the scale of c
+    */
+    for (j = 0, off = 0.0, diag = 0.0; j < c->n; ++j) {
+      diag += square(M_PEEK(c, j, j));
+      for (i = 0; i < j; ++i) {
+        off += square(M_PEEK(c, i, j));
+      }
+    }
+    if (off <= (ALMOST_ZERO * ALMOST_ZERO * diag)) {
+      break;
+    }
+    for (i = 0; i < c->n - 1; ++i) {
+      for (j = i + 1; j < c->n; ++j) {
+        if (M_PEEK(c, i, j) == 0.0) {
+          continue;
+        }
+        theta = (M_PEEK(c, j, j) - M_PEEK(c, i, i))
+          / (2.0 * M_PEEK(c, i, j));
+        t = ((theta >= 0.0) ? 1.0 : -1.0)
+          / (fabs(theta) + sqrt(theta * theta + 1.0));
+        cs = 1.0 / sqrt(t * t + 1.0);
+        sn = t * cs;
+        for (k = 0; k < c->n; ++k) {
+          c_ki = M_PEEK(c, k, i);
+          c_kj = M_PEEK(c, k, j);
+          M_POKE(c, k, i, cs * c_ki - sn * c_kj);
+          M_POKE(c, k, j, sn * c_ki + cs * c_kj);
+        }
+        for (k = 0; k < c->n; ++k) {
+          c_ki = M_PEEK(c, i, k);
+          c_kj = M_PEEK(c, j, k);
+          M_POKE(c, i, k, cs * c_ki - sn * c_kj);
+          M_POKE(c, j, k, sn * c_ki + cs * c_kj);
+        }
+        for (k = 0; k < v->m; ++k) {
+          c_ki = M_PEEK(v, k, i);
+          c_kj = M_PEEK(v, k, j);
+          M_POKE(v, k, i, cs * c_ki - sn * c_kj);
+          M_POKE(v, k, j, sn * c_ki + cs * c_kj);
+        }
+      }
+    }
+  }
+}
+
+
+/*
+randomized truncated SVD (Halko, Martinsson and Tropp):
+the range of E is sampled with a block of random vectors,
+refined through a few power iterations and orthonormalized
+into Q; the leading components of E are then obtained from
+the eigendecomposition of the small matrix Q'EE'Q. E is only
+accessed through matrix-matrix products, 2 * power_iterations + 2
+passes in total, and is not deflated.
+Scores and loadings are written to the TEMP_PCA_* files and
+explained variances are stored as pca() does for NIPALS; the
+sign of each component is the one NIPALS would converge to,
+starting from the column with the largest residual variance
+*/
+int pca_randomized(O3Data *od, int pc_num, int power_iterations)
+{
+  int i;
+  int j;
+  int x;
+  int l;
+  int it;
+  int max_ss_x;
+  int actual_len;
+  int result = 0;
+  double max_ss;
+  double s2_x_tot_start;
+  double sigma;
+  DoubleMat *omega;
+  DoubleMat *q;
+  DoubleMat *c;
+  DoubleMat *v;
+  DoubleVec *z;
+  DoubleVec *col_ss;
+  
+  
+  l = pc_num + RANDOMIZED_PCA_OVERSAMPLING;
+  if (l > od->mal.e_mat->n) {
+    l = od->mal.e_mat->n;
+  }
+  omega = double_mat_alloc(od->mal.e_mat->n, l);
+  q = double_mat_alloc(od->mal.e_mat->m, l);
+  c = double_mat_alloc(l, l);
+  v = double_mat_alloc(l, l);
+  z = double_vec_alloc(l);
+  col_ss = double_vec_alloc(od->mal.e_mat->n);
+  if (!(omega && q && c && v && z && col_ss)) {
+    if (omega) {
+      double_mat_free(omega);
+    }
+    if (q) {
+      double_mat_free(q);
+    }
+    if (c) {
+      double_mat_free(c);
+    }
+    if (v) {
+      double_mat_free(v);
+    }
+    if (z) {
+      double_vec_free(z);
+    }
+    if (col_ss) {
+      double_vec_free(col_ss);
+    }
+    return OUT_OF_MEMORY;
+  }
+  for (x = 0, s2_x_tot_start = 0.0; x < od->mal.e_mat->n; ++x) {
+    col_ss->ve[x] = cblas_ddot(od->mal.e_mat->m,
+      &M_PEEK(od->mal.e_mat, 0, x), 1, &M_PEEK(od->mal.e_mat, 0, x), 1);
+    s2_x_tot_start += col_ss->ve[x];
+  }
+  for (j = 0; j < l; ++j) {
+    for (x = 0; x < od->mal.e_mat->n; ++x) {
+      M_POKE(omega, x, j, 2.0 * genrand_real(od) - 1.0);
+    }
+  }
+  /*
+  Q = EW
+  */
+  cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+    od->mal.e_mat->m, l, od->mal.e_mat->n, 1.0,
+    od->mal.e_mat->base, od->mal.e_mat->max_m,
+    omega->base, omega->max_m, 0.0,
+    q->base, q->max_m);
+  for (it = 0; it < power_iterations; ++it) {
+    /*
+    W = E'Q, Q = EW, orthonormalizing in between
+    to preserve the small singular directions
+    */
+    orthonormalize_columns(q, l, z);
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+      od->mal.e_mat->n, l, od->mal.e_mat->m, 1.0,
+      od->mal.e_mat->base, od->mal.e_mat->max_m,
+      q->base, q->max_m, 0.0,
+      omega->base, omega->max_m);
+    orthonormalize_columns(omega, l, z);
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+      od->mal.e_mat->m, l, od->mal.e_mat->n, 1.0,
+      od->mal.e_mat->base, od->mal.e_mat->max_m,
+      omega->base, omega->max_m, 0.0,
+      q->base, q->max_m);
+  }
+  orthonormalize_columns(q, l, z);
+  /*
+  B' = E'Q, C = BB'
+  */
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+    od->mal.e_mat->n, l, od->mal.e_mat->m, 1.0,
+    od->mal.e_mat->base, od->mal.e_mat->max_m,
+    q->base, q->max_m, 0.0,
+    omega->base, omega->max_m);
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+    l, l, od->mal.e_mat->n, 1.0,
+    omega->base, omega->max_m,
+    omega->base, omega->max_m, 0.0,
+    c->base, c->max_m);
+  jacobi_eigen(c, v);
+  for (i = 0; i < pc_num; ++i) {
+    /*
+    pick the largest remaining eigenvalue
+    */
+    for (j = i, it = i; j < l; ++j) {
+      if (M_PEEK(c, j, j) > M_PEEK(c, it, it)) {
+        it = j;
+      }
+    }
+    if (it != i) {
+      sigma = M_PEEK(c, i, i);
+      M_POKE(c, i, i, M_PEEK(c, it, it));
+      M_POKE(c, it, it, sigma);
+      cblas_dswap(l, &M_PEEK(v, 0, i), 1, &M_PEEK(v, 0, it), 1);
+    }
+    sigma = ((M_PEEK(c, i, i) > 0.0) ? sqrt(M_PEEK(c, i, i)) : 0.0);
+    /*
+    b = B'v / sigma, u = Qv sigma
+    */
+    cblas_dgemv(CblasColMajor, CblasNoTrans,
+      od->mal.e_mat->n, l,
+      ((sigma > 0.0) ? 1.0 / sigma : 0.0),
+      omega->base, omega->max_m,
+      &M_PEEK(v, 0, i), 1, 0.0, od->vel.b->ve, 1);
+    cblas_dgemv(CblasColMajor, CblasNoTrans,
+      od->mal.e_mat->m, l, sigma,
+      q->base, q->max_m,
+      &M_PEEK(v, 0, i), 1, 0.0, od->vel.u->ve, 1);
+    /*
+    the residual variance of each column after the previous
+    components is ||e||^2 - sum(sigma^2 b^2)
+    */
+    for (x = 0, max_ss = 0.0, max_ss_x = 0; x < od->mal.e_mat->n; ++x) {
+      if (col_ss->ve[x] > max_ss) {
+        max_ss = col_ss->ve[x];
+        max_ss_x = x;
+      }
+    }
+    if (od->vel.b->ve[max_ss_x] < 0.0) {
+      cblas_dscal(od->vel.b->size, -1.0, od->vel.b->ve, 1);
+      cblas_dscal(od->vel.u->size, -1.0, od->vel.u->ve, 1);
+    }
+    for (x = 0; x < od->mal.e_mat->n; ++x) {
+      col_ss->ve[x] -= square(sigma * od->vel.b->ve[x]);
+    }
+    actual_len = fwrite(od->vel.u->ve,
+      sizeof(double), od->mal.e_mat->m,
+      od->file[TEMP_PCA_SCORES]->handle);
+    if (actual_len != od->mal.e_mat->m) {
+      result = CANNOT_WRITE_TEMP_FILE;
+      break;
+    }
+    actual_len = fwrite(od->vel.b->ve,
+      sizeof(double), od->mal.e_mat->n,
+      od->file[TEMP_PCA_LOADINGS]->handle);
+    if (actual_len != od->mal.e_mat->n) {
+      result = CANNOT_WRITE_TEMP_FILE;
+      break;
+    }
+    od->vel.explained_s2_x->ve[i] = square(sigma) / s2_x_tot_start;
+  }
+  double_mat_free(omega);
+  double_mat_free(q);
+  double_mat_free(c);
+  double_mat_free(v);
+  double_vec_free(z);
+  double_vec_free(col_ss);
+  
+  return result;
+}
@@ -285,11 +285,17 @@ int plot(O3Data *od, char *filename, int type,
       }
     }
     else {
-      temp_handle = fopen(od->file[TEMP_PRED]->name, "rb");
-      if (!temp_handle) {
-        return CANNOT_READ_TEMP_FILE;
+      /*
+      CV predictions are read from memory unless
+      they were spilled to a temporary file
+      */
+      if (!(od->cv_pred.active)) {
+        temp_handle = fopen(od->file[TEMP_PRED]->name, "rb");
+        if (!temp_handle) {
+          return CANNOT_READ_TEMP_FILE;
+        }
+        od->file[TEMP_PRED]->handle = temp_handle;
       }
-      od->file[TEMP_PRED]->handle = temp_handle;
       strcpy(type_of_data, "Predicted values");
       if (type & RESIDUALS) {
         strcat(type_of_data, " (residuals)");
@@ -374,8 +380,18 @@ int plot(O3Data *od, char *filename, int type,
               memset(od->mel.sum, 0,
                 (od->pc_num + 1) * sizeof(double));
               actual_value = M_PEEK(od->mal.large_f_mat, y, x);
-              rewind(temp_handle);
-              while (!feof(temp_handle)) {
+              if (od->cv_pred.active) {
+                num_values = get_cv_pred_sum(od, i, x,
+                  requested_pc_num, od->mel.sum);
+                if (type & RESIDUALS) {
+                  od->mel.sum[requested_pc_num] -=
+                    ((double)num_values * actual_value);
+                }
+              }
+              else {
+                rewind(temp_handle);
+              }
+              while (temp_handle && (!feof(temp_handle))) {
                 /*
                 Read number of PCs
                 */
@@ -42,19 +42,86 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
+/*
+out = E'in (trans) or out = E in (!trans); in implicit-deflation
+CV E is not stored, and products are computed from the shared
+large_e_mat, the training rows and the column averages of the
+current fold (see implicit_cv.c)
+*/
+static void mult_e_mat(O3Data *od, int shared, int trans,
+  double *in, double *out)
+{
+  int i;
+  int m;
+  int n;
+  double sum;
+  double *work;
+  
+  
+  if (!shared) {
+    cblas_dgemv(CblasColMajor, trans ? CblasTrans : CblasNoTrans,
+      od->mal.e_mat->m,
+      od->mal.e_mat->n, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m,
+      in, 1, 0.0, out, 1);
+    return;
+  }
+  m = od->active_object_num;
+  n = od->mal.large_e_mat->n;
+  work = od->vel.implicit_work->ve;
+  if (trans) {
+    /*
+    E'v = X[S]'W^(1/2)v - a(1'W^(1/2)v), where left-out
+    rows of X are given zero weight
+    */
+    memset(work, 0, m * sizeof(double));
+    for (i = 0, sum = 0.0; i < od->pel.fold_train_rows->size; ++i) {
+      work[od->pel.fold_train_rows->pe[i]] =
+        in[i] * od->vel.fold_train_sqrt_weight->ve[i];
+      sum += work[od->pel.fold_train_rows->pe[i]];
+    }
+    cblas_dgemv(CblasColMajor, CblasTrans, m, n, 1.0,
+      od->mal.large_e_mat->base,
+      od->mal.large_e_mat->max_m,
+      work, 1, 0.0, out, 1);
+    cblas_daxpy(n, -sum, od->vel.e_mat_ave->ve, 1, out, 1);
+  }
+  else {
+    /*
+    Ec = W^(1/2)(X[S]c - 1(a'c))
+    */
+    cblas_dgemv(CblasColMajor, CblasNoTrans, m, n, 1.0,
+      od->mal.large_e_mat->base,
+      od->mal.large_e_mat->max_m,
+      in, 1, 0.0, work, 1);
+    sum = cblas_ddot(n, od->vel.e_mat_ave->ve, 1, in, 1);
+    for (i = 0; i < od->pel.fold_train_rows->size; ++i) {
+      out[i] = (work[od->pel.fold_train_rows->pe[i]] - sum)
+        * od->vel.fold_train_sqrt_weight->ve[i];
+    }
+  }
+}
+
+
 void pls(O3Data *od, int suggested_pc_num, int model_type)
 {
   int i;
   int x;
   int y;
   int pc_num;
+  int m;
+  int n;
   int conv;
+  int implicit;
+  int shared;
   double norm_c;
   double norm_d;
   double ss_u;
   double ss_v_diff;
   double s2_x_tot;
   double s2_x_tot_start = 0.0;
+  double s2_x_res = 0.0;
   double s2_y_tot;
   double s2_y_tot_start = 0.0;
   double sum_object_weight = 0.0;
@@ -62,6 +129,34 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
   double cum_explained_s2_y = 0.0;
     
 
+  if ((od->pls_y_mode == PLS1_Y_MODE) && (model_type & CV_MODEL)) {
+    pls1_batch(od, suggested_pc_num, model_type);
+    return;
+  }
+  if (od->pls_algorithm == KERNEL_PLS) {
+    kernel_pls(od, suggested_pc_num, model_type);
+    return;
+  }
+  if (od->pls_precision == PLS_SINGLE_PRECISION) {
+    pls_sp(od, suggested_pc_num, model_type);
+    return;
+  }
+  if ((od->pls_algorithm == NIPALS_PLS) && (od->mal.f_mat->n > 1)
+    && (model_type & CV_MODEL)) {
+    pls2_block(od, suggested_pc_num, model_type);
+    return;
+  }
+  /*
+  with implicit deflation E is never written: E[i] = E - T[i]P[i]'
+  is applied through the scores and loadings of the components
+  extracted so far, which is equivalent because the scores are
+  mutually orthogonal; in CV this allows E to be replaced by
+  the shared large_e_mat (see implicit_cv.c)
+  */
+  implicit = (od->pls_algorithm == IMPLICIT_PLS);
+  shared = (implicit && od->cv.implicit_cv && (model_type & CV_MODEL));
+  m = (shared ? od->pel.fold_train_rows->size : od->mal.e_mat->m);
+  n = (shared ? od->mal.large_e_mat->n : od->mal.e_mat->n);
   pc_num = suggested_pc_num;
   /*
   this check is useful for FFD variable selection:
@@ -69,8 +164,8 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
   combination there are not enough active variables, the number
   of PCs must be reduced
   */
-  if (suggested_pc_num > od->mal.e_mat->n) {
-    pc_num = od->mal.e_mat->n;
+  if (suggested_pc_num > n) {
+    pc_num = n;
   }
   /*
   no need to check the return value, since this is just a logical
@@ -78,16 +173,16 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
   with maximal size with this purpose
   */
   double_mat_resize(od->mal.x_scores,
-    od->mal.e_mat->m, pc_num + 1);
+    m, pc_num + 1);
   double_mat_resize(od->mal.x_weights,
-    od->mal.e_mat->n, pc_num + 1);
+    n, pc_num + 1);
   double_mat_resize(od->mal.x_loadings,
-    od->mal.e_mat->n, pc_num + 1);
+    n, pc_num + 1);
   double_mat_resize(od->mal.pred_f_mat,
-    od->mal.e_mat->m, od->mal.f_mat->n);
+    m, od->mal.f_mat->n);
   double_vec_resize(od->vel.ave_sdep, pc_num + 1);
-  double_vec_resize(od->vel.v, od->mal.e_mat->m);
-  double_vec_resize(od->vel.v_new, od->mal.e_mat->m);
+  double_vec_resize(od->vel.v, m);
+  double_vec_resize(od->vel.v_new, m);
   double_mat_resize(od->mal.y_loadings,
     od->mal.f_mat->n, pc_num + 1);
   double_mat_resize(od->mal.y_scores,
@@ -114,6 +209,7 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
       s2_x_tot_start += cblas_ddot(od->mal.e_mat->m,
         &M_PEEK(od->mal.e_mat, 0, x), 1, &M_PEEK(od->mal.e_mat, 0, x), 1);
     }
+    s2_x_res = s2_x_tot_start;
     for (x = 0, s2_y_tot_start = 0.0; x < od->mal.f_mat->n; ++x) {
       s2_y_tot_start += cblas_ddot(od->mal.f_mat->m,
         &M_PEEK(od->mal.f_mat, 0, x), 1, &M_PEEK(od->mal.f_mat, 0, x), 1);
@@ -126,9 +222,14 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
   }
   for (i = 0; i <= pc_num; ++i) {
     if (model_type & FULL_MODEL) {
-      for (x = 0, s2_x_tot = 0.0; x < od->mal.e_mat->n; ++x) {
-        s2_x_tot += cblas_ddot(od->mal.e_mat->m,
-          &M_PEEK(od->mal.e_mat, 0, x), 1, &M_PEEK(od->mal.e_mat, 0, x), 1);
+      if (implicit) {
+        s2_x_tot = s2_x_res;
+      }
+      else {
+        for (x = 0, s2_x_tot = 0.0; x < od->mal.e_mat->n; ++x) {
+          s2_x_tot += cblas_ddot(od->mal.e_mat->m,
+            &M_PEEK(od->mal.e_mat, 0, x), 1, &M_PEEK(od->mal.e_mat, 0, x), 1);
+        }
       }
       for (x = 0, s2_y_tot = 0.0; x < od->mal.f_mat->n; ++x) {
         s2_y_tot += cblas_ddot(od->mal.f_mat->m,
@@ -156,13 +257,25 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
       /*
       c = E[i]'v
       */
-      cblas_dgemv(CblasColMajor, CblasTrans,
-        od->mal.e_mat->m,
-        od->mal.e_mat->n, 1.0,
-        od->mal.e_mat->base,
-        od->mal.e_mat->max_m,
-        od->vel.v->ve, 1, 0.0,
-        &M_PEEK(od->mal.x_weights, 0, i), 1);
+      mult_e_mat(od, shared, 1, od->vel.v->ve,
+        &M_PEEK(od->mal.x_weights, 0, i));
+      if (implicit && i) {
+        /*
+        c = c - P[i](T[i]'v)
+        */
+        cblas_dgemv(CblasColMajor, CblasTrans,
+          od->mal.x_scores->m, i, 1.0,
+          od->mal.x_scores->base,
+          od->mal.x_scores->max_m,
+          od->vel.v->ve, 1, 0.0,
+          od->vel.deflation_coeff->ve, 1);
+        cblas_dgemv(CblasColMajor, CblasNoTrans,
+          od->mal.x_loadings->m, i, -1.0,
+          od->mal.x_loadings->base,
+          od->mal.x_loadings->max_m,
+          od->vel.deflation_coeff->ve, 1, 1.0,
+          &M_PEEK(od->mal.x_weights, 0, i), 1);
+      }
       
       /*
       c = c * (c'c)^(-0.5)
@@ -174,13 +287,25 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
       /*
       u = E[i]c
       */
-      cblas_dgemv(CblasColMajor, CblasNoTrans,
-        od->mal.e_mat->m,
-        od->mal.e_mat->n, 1.0,
-        od->mal.e_mat->base,
-        od->mal.e_mat->max_m,
-        &M_PEEK(od->mal.x_weights, 0, i), 1, 0.0,
-        &M_PEEK(od->mal.x_scores, 0, i), 1);
+      mult_e_mat(od, shared, 0, &M_PEEK(od->mal.x_weights, 0, i),
+        &M_PEEK(od->mal.x_scores, 0, i));
+      if (implicit && i) {
+        /*
+        u = u - T[i](P[i]'c)
+        */
+        cblas_dgemv(CblasColMajor, CblasTrans,
+          od->mal.x_loadings->m, i, 1.0,
+          od->mal.x_loadings->base,
+          od->mal.x_loadings->max_m,
+          &M_PEEK(od->mal.x_weights, 0, i), 1, 0.0,
+          od->vel.deflation_coeff->ve, 1);
+        cblas_dgemv(CblasColMajor, CblasNoTrans,
+          od->mal.x_scores->m, i, -1.0,
+          od->mal.x_scores->base,
+          od->mal.x_scores->max_m,
+          od->vel.deflation_coeff->ve, 1, 1.0,
+          &M_PEEK(od->mal.x_scores, 0, i), 1);
+      }
       /*
       d = F[i]'u
       */
@@ -253,13 +378,25 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
     /*
     b = E[i]'u / u'u
     */
-    cblas_dgemv(CblasColMajor, CblasTrans,
-      od->mal.e_mat->m,
-      od->mal.e_mat->n, 1.0,
-      od->mal.e_mat->base,
-      od->mal.e_mat->max_m,
-      &M_PEEK(od->mal.x_scores, 0, i), 1, 0.0,
-      &M_PEEK(od->mal.x_loadings, 0, i), 1);
+    mult_e_mat(od, shared, 1, &M_PEEK(od->mal.x_scores, 0, i),
+      &M_PEEK(od->mal.x_loadings, 0, i));
+    if (implicit && i) {
+      /*
+      b = b - P[i](T[i]'u)
+      */
+      cblas_dgemv(CblasColMajor, CblasTrans,
+        od->mal.x_scores->m, i, 1.0,
+        od->mal.x_scores->base,
+        od->mal.x_scores->max_m,
+        &M_PEEK(od->mal.x_scores, 0, i), 1, 0.0,
+        od->vel.deflation_coeff->ve, 1);
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        od->mal.x_loadings->m, i, -1.0,
+        od->mal.x_loadings->base,
+        od->mal.x_loadings->max_m,
+        od->vel.deflation_coeff->ve, 1, 1.0,
+        &M_PEEK(od->mal.x_loadings, 0, i), 1);
+    }
     cblas_dscal(od->mal.x_loadings->m, 1.0 / ss_u,
       &M_PEEK(od->mal.x_loadings, 0, i), 1);
 
@@ -267,17 +404,44 @@ void pls(O3Data *od, int suggested_pc_num, int model_type)
     E[i + 1] = E[i] - ub'
     F[i + 1] = F[i] - ud'
     */
-    for (y = 0; y < od->mal.e_mat->m; ++y) {
-      cblas_daxpy(od->mal.e_mat->n,
-        - M_PEEK(od->mal.x_scores, y, i),
-        &M_PEEK(od->mal.x_loadings, 0, i), 1,
-        &M_PEEK(od->mal.e_mat, y, 0),
-        od->mal.e_mat->max_m);
+    for (y = 0; y < od->mal.f_mat->m; ++y) {
+      if (!implicit) {
+        cblas_daxpy(od->mal.e_mat->n,
+          - M_PEEK(od->mal.x_scores, y, i),
+          &M_PEEK(od->mal.x_loadings, 0, i), 1,
+          &M_PEEK(od->mal.e_mat, y, 0),
+          od->mal.e_mat->max_m);
+      }
       cblas_daxpy(od->mal.f_mat->n,
         - M_PEEK(od->mal.x_scores, y, i),
         &M_PEEK(od->mal.y_loadings, 0, i), 1,
         &M_PEEK(od->mal.f_mat, y, 0),
         od->mal.f_mat->max_m);
     }
+    if (implicit && (model_type & FULL_MODEL)) {
+      /*
+      ||E[i + 1]||^2 = ||E[i]||^2 - (u'u)(b'b)
+      */
+      s2_x_res -= (ss_u * cblas_ddot(od->mal.x_loadings->m,
+        &M_PEEK(od->mal.x_loadings, 0, i), 1,
+        &M_PEEK(od->mal.x_loadings, 0, i), 1));
+    }
+  }
+  /*
+  the full model needs the X residuals in E
+  for leverage calculation, so
+  E[pc_num + 1] = E - UB'
+  */
+  if (implicit && (model_type & FULL_MODEL)) {
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+      od->mal.e_mat->m,
+      od->mal.e_mat->n,
+      pc_num + 1, -1.0,
+      od->mal.x_scores->base,
+      od->mal.x_scores->max_m,
+      od->mal.x_loadings->base,
+      od->mal.x_loadings->max_m, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m);
   }
 }
@@ -0,0 +1,217 @@
+/*
+
+pls1_batch.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+/*
+PLS1 models for all y variables at once: each y variable
+gets its own components, but all of them share the kernel
+K = EE', so that each component is extracted for the whole
+Y block through a single KF product. Since y variables are
+deflated as they go, E[a]E[a]'u = (I - TT')Ku, hence K needs
+not be deflated. Predictions are obtained from the dual
+coefficients U(T'KU)^(-1)T'y (T'KU is upper triangular),
+which are mapped back onto the variables as E'U(T'KU)^(-1)T'y.
+Coefficients for all y variables and numbers of PCs are
+stored in pls1_coeff for pred_y_values(), PC block by PC block
+*/
+void pls1_batch(O3Data *od, int suggested_pc_num, int model_type)
+{
+  int a;
+  int i;
+  int j;
+  int m;
+  int y_vars;
+  int pc_num;
+  int kernel_cv;
+  double norm_t;
+  DoubleMat *k_mat;
+  
+  
+  pc_num = suggested_pc_num;
+  if (suggested_pc_num > od->mal.e_mat->n) {
+    pc_num = od->mal.e_mat->n;
+  }
+  m = od->mal.e_mat->m;
+  y_vars = od->mal.f_mat->n;
+  /*
+  no need to check the return value, since this is just a logical
+  resizing: all these matrices and vectors have been allocated
+  with maximal size by alloc_pls()
+  */
+  double_mat_resize(od->mal.pred_f_mat, m, y_vars);
+  double_vec_resize(od->vel.ave_sdep, pc_num + 1);
+  double_mat_resize(od->mal.y_loadings, y_vars, pc_num + 1);
+  double_mat_resize(od->mal.temp, pc_num, pc_num);
+  double_mat_resize(od->mal.pls1_coeff,
+    od->mal.e_mat->n, y_vars * (pc_num + 1));
+  od->pc_num = pc_num;
+  kernel_cv = (od->cv.kernel_cv && (model_type & CV_MODEL));
+  
+  if (kernel_cv) {
+    /*
+    E already is the training kernel
+    */
+    k_mat = od->mal.e_mat;
+  }
+  else {
+    /*
+    K = EE'
+    */
+    k_mat = double_mat_resize(od->mal.kernel_mat, m, m);
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+      m, m, od->mal.e_mat->n, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m, 0.0,
+      k_mat->base, k_mat->max_m);
+  }
+  for (a = 0; a < pc_num; ++a) {
+    /*
+    Ku for all y variables, where u = F[a]
+    */
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+      m, y_vars, m, 1.0,
+      k_mat->base, k_mat->max_m,
+      od->mal.f_mat->base,
+      od->mal.f_mat->max_m, 0.0,
+      od->mal.pred_f_mat->base,
+      od->mal.pred_f_mat->max_m);
+    for (j = 0; j < y_vars; ++j) {
+      i = j * pc_num + a;
+      cblas_dcopy(m, &M_PEEK(od->mal.f_mat, 0, j), 1,
+        &M_PEEK(od->mal.pls1_u, 0, i), 1);
+      cblas_dcopy(m, &M_PEEK(od->mal.pred_f_mat, 0, j), 1,
+        &M_PEEK(od->mal.pls1_w, 0, i), 1);
+      cblas_dcopy(m, &M_PEEK(od->mal.pred_f_mat, 0, j), 1,
+        &M_PEEK(od->mal.pls1_t, 0, i), 1);
+      if (a) {
+        /*
+        t = Ku - T(T'Ku)
+        */
+        cblas_dgemv(CblasColMajor, CblasTrans,
+          m, a, 1.0,
+          &M_PEEK(od->mal.pls1_t, 0, j * pc_num),
+          od->mal.pls1_t->max_m,
+          &M_PEEK(od->mal.pls1_t, 0, i), 1, 0.0,
+          od->vel.pls1_z->ve, 1);
+        cblas_dgemv(CblasColMajor, CblasNoTrans,
+          m, a, -1.0,
+          &M_PEEK(od->mal.pls1_t, 0, j * pc_num),
+          od->mal.pls1_t->max_m,
+          od->vel.pls1_z->ve, 1, 1.0,
+          &M_PEEK(od->mal.pls1_t, 0, i), 1);
+      }
+      /*
+      t = t * (t't)^(-0.5)
+      */
+      norm_t = cblas_dnrm2(m, &M_PEEK(od->mal.pls1_t, 0, i), 1);
+      cblas_dscal(m, 1.0 / norm_t, &M_PEEK(od->mal.pls1_t, 0, i), 1);
+      /*
+      d = t'f, f[a + 1] = f[a] - td
+      */
+      M_POKE(od->mal.y_loadings, j, a,
+        cblas_ddot(m, &M_PEEK(od->mal.pls1_t, 0, i), 1,
+        &M_PEEK(od->mal.f_mat, 0, j), 1));
+      cblas_daxpy(m, -M_PEEK(od->mal.y_loadings, j, a),
+        &M_PEEK(od->mal.pls1_t, 0, i), 1,
+        &M_PEEK(od->mal.f_mat, 0, j), 1);
+    }
+  }
+  /*
+  the model with no PCs has null coefficients
+  */
+  for (j = 0; j < y_vars; ++j) {
+    memset(&M_PEEK(od->mal.pls1_dual, 0, j), 0, m * sizeof(double));
+  }
+  for (j = 0; j < y_vars; ++j) {
+    /*
+    R = T'KU
+    */
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+      pc_num, pc_num, m, 1.0,
+      &M_PEEK(od->mal.pls1_t, 0, j * pc_num),
+      od->mal.pls1_t->max_m,
+      &M_PEEK(od->mal.pls1_w, 0, j * pc_num),
+      od->mal.pls1_w->max_m, 0.0,
+      od->mal.temp->base, od->mal.temp->max_m);
+    for (a = 1; a <= pc_num; ++a) {
+      /*
+      dual coefficients for a PCs: U R^(-1) d
+      */
+      cblas_dcopy(a, &M_PEEK(od->mal.y_loadings, j, 0),
+        od->mal.y_loadings->max_m, od->vel.pls1_z->ve, 1);
+      cblas_dtrsv(CblasColMajor, CblasUpper, CblasNoTrans,
+        CblasNonUnit, a, od->mal.temp->base, od->mal.temp->max_m,
+        od->vel.pls1_z->ve, 1);
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        m, a, 1.0,
+        &M_PEEK(od->mal.pls1_u, 0, j * pc_num),
+        od->mal.pls1_u->max_m,
+        od->vel.pls1_z->ve, 1, 0.0,
+        &M_PEEK(od->mal.pls1_dual, 0, a * y_vars + j), 1);
+    }
+  }
+  if (kernel_cv) {
+    /*
+    in the dual space coefficients are the dual coefficients
+    */
+    for (i = 0; i < y_vars * (pc_num + 1); ++i) {
+      cblas_dcopy(m, &M_PEEK(od->mal.pls1_dual, 0, i), 1,
+        &M_PEEK(od->mal.pls1_coeff, 0, i), 1);
+    }
+  }
+  else {
+    /*
+    B = E'D for all y variables and numbers of PCs at once
+    */
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+      od->mal.e_mat->n, y_vars * (pc_num + 1), m, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m,
+      od->mal.pls1_dual->base,
+      od->mal.pls1_dual->max_m, 0.0,
+      od->mal.pls1_coeff->base,
+      od->mal.pls1_coeff->max_m);
+  }
+}
@@ -0,0 +1,280 @@
+/*
+
+pls2_block.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+/*
+PLS2 CV models for multiple y variables. The NIPALS inner loop
+v = F[a]d, c = E[a]'v, u = E[a]c, d = F[a]'u is carried out
+entirely in the y variable space as a power iteration on
+M = S'S, where S = E[a]'F; convergence is checked on
+||F[a](d_new - d)||^2 through G = F[a]'F[a], so that the
+components match those of pls(). S, M and G are computed once
+by dgemm and then deflated by rank-one updates; scores are
+computed from the undeflated E through r = w - R(P'w), hence
+each component only needs two passes over E. x_weights,
+x_loadings and y_loadings are the same as in pls(), so
+pred_y_values() needs no changes; x_weights_star is used as
+scratch space for R, since pred_y_values() overwrites it
+*/
+void pls2_block(O3Data *od, int suggested_pc_num, int model_type)
+{
+  int i;
+  int m;
+  int n;
+  int y_vars;
+  int pc_num;
+  int conv;
+  double norm;
+  double ss_t;
+  double ss_p;
+  double ss_d_diff;
+  double ss_v_start;
+  double *d;
+  double *d_new;
+  double *d_diff;
+  double *g_d_diff;
+  double *s_p;
+  
+  
+  pc_num = suggested_pc_num;
+  if (suggested_pc_num > od->mal.e_mat->n) {
+    pc_num = od->mal.e_mat->n;
+  }
+  m = od->mal.e_mat->m;
+  n = od->mal.e_mat->n;
+  y_vars = od->mal.f_mat->n;
+  /*
+  no need to check the return value, since this is just a logical
+  resizing: all these matrices and vectors have been allocated
+  with maximal size by alloc_pls()
+  */
+  double_mat_resize(od->mal.x_scores, m, pc_num + 1);
+  double_mat_resize(od->mal.x_weights, n, pc_num + 1);
+  double_mat_resize(od->mal.x_weights_star, n, pc_num + 1);
+  double_mat_resize(od->mal.x_loadings, n, pc_num + 1);
+  double_mat_resize(od->mal.pred_f_mat, m, y_vars);
+  double_vec_resize(od->vel.ave_sdep, pc_num + 1);
+  double_mat_resize(od->mal.y_loadings, y_vars, pc_num + 1);
+  double_mat_resize(od->mal.pls2_s, n, y_vars);
+  double_mat_resize(od->mal.pls2_m, y_vars, y_vars);
+  double_mat_resize(od->mal.pls2_g, y_vars, y_vars);
+  od->pc_num = pc_num;
+  d = &M_PEEK(od->mal.pls2_work, 0, 0);
+  d_new = &M_PEEK(od->mal.pls2_work, 0, 1);
+  d_diff = &M_PEEK(od->mal.pls2_work, 0, 2);
+  g_d_diff = &M_PEEK(od->mal.pls2_work, 0, 3);
+  s_p = &M_PEEK(od->mal.pls2_work, 0, 4);
+  
+  /*
+  S = E'F, G = F'F, M = S'S
+  */
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+    n, y_vars, m, 1.0,
+    od->mal.e_mat->base,
+    od->mal.e_mat->max_m,
+    od->mal.f_mat->base,
+    od->mal.f_mat->max_m, 0.0,
+    od->mal.pls2_s->base,
+    od->mal.pls2_s->max_m);
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+    y_vars, y_vars, m, 1.0,
+    od->mal.f_mat->base,
+    od->mal.f_mat->max_m,
+    od->mal.f_mat->base,
+    od->mal.f_mat->max_m, 0.0,
+    od->mal.pls2_g->base,
+    od->mal.pls2_g->max_m);
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+    y_vars, y_vars, n, 1.0,
+    od->mal.pls2_s->base,
+    od->mal.pls2_s->max_m,
+    od->mal.pls2_s->base,
+    od->mal.pls2_s->max_m, 0.0,
+    od->mal.pls2_m->base,
+    od->mal.pls2_m->max_m);
+  /*
+  as in pls(), start from the first dependent variable
+  */
+  memset(d, 0, y_vars * sizeof(double));
+  d[0] = 1.0;
+  ss_v_start = 0.0;
+  for (i = 0; i <= pc_num; ++i) {
+    conv = 0;
+    while (!conv) {
+      /*
+      d_new = Md * (d'M'Md)^(-0.5)
+      */
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        y_vars, y_vars, 1.0,
+        od->mal.pls2_m->base,
+        od->mal.pls2_m->max_m,
+        d, 1, 0.0, d_new, 1);
+      norm = cblas_dnrm2(y_vars, d_new, 1);
+      cblas_dscal(y_vars, 1.0 / norm, d_new, 1);
+      /*
+      ||v - v_new||^2 = (d - d_new)'G(d - d_new)
+      */
+      cblas_dcopy(y_vars, d, 1, d_diff, 1);
+      cblas_daxpy(y_vars, -1.0, d_new, 1, d_diff, 1);
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        y_vars, y_vars, 1.0,
+        od->mal.pls2_g->base,
+        od->mal.pls2_g->max_m,
+        d_diff, 1, 0.0, g_d_diff, 1);
+      ss_d_diff = cblas_ddot(y_vars, d_diff, 1, g_d_diff, 1)
+        + ss_v_start;
+      ss_v_start = 0.0;
+      if (fabs(ss_d_diff) < PLS_CONV_THRESHOLD) {
+        conv = 1;
+      }
+      else {
+        cblas_dcopy(y_vars, d_new, 1, d, 1);
+      }
+    }
+    /*
+    c = Sd * (d'S'Sd)^(-0.5)
+    */
+    cblas_dgemv(CblasColMajor, CblasNoTrans,
+      n, y_vars, 1.0,
+      od->mal.pls2_s->base,
+      od->mal.pls2_s->max_m,
+      d, 1, 0.0,
+      &M_PEEK(od->mal.x_weights, 0, i), 1);
+    norm = cblas_dnrm2(n, &M_PEEK(od->mal.x_weights, 0, i), 1);
+    cblas_dscal(n, 1.0 / norm, &M_PEEK(od->mal.x_weights, 0, i), 1);
+    /*
+    r = c - R[i](P[i]'c)
+    */
+    cblas_dcopy(n, &M_PEEK(od->mal.x_weights, 0, i), 1,
+      &M_PEEK(od->mal.x_weights_star, 0, i), 1);
+    if (i) {
+      cblas_dgemv(CblasColMajor, CblasTrans,
+        n, i, 1.0,
+        od->mal.x_loadings->base,
+        od->mal.x_loadings->max_m,
+        &M_PEEK(od->mal.x_weights, 0, i), 1, 0.0,
+        od->vel.pls2_z->ve, 1);
+      cblas_dgemv(CblasColMajor, CblasNoTrans,
+        n, i, -1.0,
+        od->mal.x_weights_star->base,
+        od->mal.x_weights_star->max_m,
+        od->vel.pls2_z->ve, 1, 1.0,
+        &M_PEEK(od->mal.x_weights_star, 0, i), 1);
+    }
+    /*
+    u = Er = E[i]c
+    */
+    cblas_dgemv(CblasColMajor, CblasNoTrans,
+      m, n, 1.0,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m,
+      &M_PEEK(od->mal.x_weights_star, 0, i), 1, 0.0,
+      &M_PEEK(od->mal.x_scores, 0, i), 1);
+    ss_t = cblas_ddot(m, &M_PEEK(od->mal.x_scores, 0, i), 1,
+      &M_PEEK(od->mal.x_scores, 0, i), 1);
+    /*
+    b = E'u / u'u = E[i]'u / u'u
+    d = F'u / u'u = F[i]'u / u'u
+    */
+    cblas_dgemv(CblasColMajor, CblasTrans,
+      m, n, 1.0 / ss_t,
+      od->mal.e_mat->base,
+      od->mal.e_mat->max_m,
+      &M_PEEK(od->mal.x_scores, 0, i), 1, 0.0,
+      &M_PEEK(od->mal.x_loadings, 0, i), 1);
+    cblas_dgemv(CblasColMajor, CblasTrans,
+      m, y_vars, 1.0 / ss_t,
+      od->mal.f_mat->base,
+      od->mal.f_mat->max_m,
+      &M_PEEK(od->mal.x_scores, 0, i), 1, 0.0,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1);
+    if (i == pc_num) {
+      break;
+    }
+    /*
+    pls() starts the next component from the last v = F[i]d_new
+    = F[i + 1]d_new + u(d'd_new), hence the first convergence
+    check also includes the squared norm of u(d'd_new)
+    */
+    cblas_dcopy(y_vars, d_new, 1, d, 1);
+    ss_v_start = cblas_ddot(y_vars, &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      d_new, 1);
+    ss_v_start *= (ss_v_start * ss_t);
+    /*
+    S[i + 1] = S[i] - (u'u)bd'
+    G[i + 1] = G[i] - (u'u)dd'
+    M[i + 1] = M[i] - (u'u)(d(S[i]'b)' + (S[i]'b)d') + (u'u)^2(b'b)dd'
+    */
+    cblas_dgemv(CblasColMajor, CblasTrans,
+      n, y_vars, 1.0,
+      od->mal.pls2_s->base,
+      od->mal.pls2_s->max_m,
+      &M_PEEK(od->mal.x_loadings, 0, i), 1, 0.0,
+      s_p, 1);
+    ss_p = cblas_ddot(n, &M_PEEK(od->mal.x_loadings, 0, i), 1,
+      &M_PEEK(od->mal.x_loadings, 0, i), 1);
+    cblas_dger(CblasColMajor, n, y_vars, -ss_t,
+      &M_PEEK(od->mal.x_loadings, 0, i), 1,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      od->mal.pls2_s->base,
+      od->mal.pls2_s->max_m);
+    cblas_dger(CblasColMajor, y_vars, y_vars, -ss_t,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      od->mal.pls2_g->base,
+      od->mal.pls2_g->max_m);
+    cblas_dger(CblasColMajor, y_vars, y_vars, -ss_t,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1, s_p, 1,
+      od->mal.pls2_m->base,
+      od->mal.pls2_m->max_m);
+    cblas_dger(CblasColMajor, y_vars, y_vars, -ss_t,
+      s_p, 1, &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      od->mal.pls2_m->base,
+      od->mal.pls2_m->max_m);
+    cblas_dger(CblasColMajor, y_vars, y_vars, ss_t * ss_t * ss_p,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      &M_PEEK(od->mal.y_loadings, 0, i), 1,
+      od->mal.pls2_m->base,
+      od->mal.pls2_m->max_m);
+  }
+}
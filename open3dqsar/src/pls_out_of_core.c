@@ -0,0 +1,274 @@
+/*
+
+pls_out_of_core.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+/*
+load into block the mean-centered, weighted values of
+x_count variables, starting from x_start in var_list
+(field, variable pairs); as in fill_x_matrix(), fields are
+scanned in the outer loop, so that with O3_SAVE_RAM each
+field present in the block is mapped only once.
+Averages are computed exactly as trim_mean_center_matrix()
+does and stored in od->vel.e_mat_ave
+*/
+static int fill_x_block(O3Data *od, DoubleMat *block,
+  DoubleVec *sumweight, int *var_list, int x_start, int x_count)
+{
+  int i;
+  int j;
+  int k;
+  int x;
+  int y;
+  int x_field;
+  int x_end;
+  int result;
+  double value;
+  double sqrt_weight;
+  double *ave;
+  
+  
+  double_mat_resize(block, od->active_object_num, x_count);
+  ave = &(od->vel.e_mat_ave->ve[x_start]);
+  memset(ave, 0, x_count * sizeof(double));
+  memset(sumweight->ve, 0, x_count * sizeof(double));
+  for (x_field = 0; x_field < x_count; x_field = x_end) {
+    /*
+    variables of field i span x_field to x_end - 1
+    */
+    i = var_list[(x_start + x_field) * 2];
+    x_end = x_field + 1;
+    while ((x_end < x_count) && (var_list[(x_start + x_end) * 2] == i)) {
+      ++x_end;
+    }
+    for (j = 0, y = 0; j < od->object_num; ++j) {
+      if (!get_object_attr(od, j, ACTIVE_BIT)) {
+        continue;
+      }
+      for (x = x_field; x < x_end; ++x) {
+        k = var_list[(x_start + x) * 2 + 1];
+        result = get_x_value(od, i, j, k, &value, 0);
+        if (result) {
+          return result;
+        }
+        if (!MISSING(value)) {
+          result = get_x_value(od, i, j, k, &value,
+            CUTOFF_BIT | WEIGHT_BIT);
+          if (result) {
+            return result;
+          }
+          ave[x] += (value * od->mel.object_weight[j]);
+          sumweight->ve[x] += od->mel.object_weight[j];
+        }
+        M_POKE(block, y, x, value);
+      }
+      ++y;
+    }
+  }
+  for (x = 0; x < x_count; ++x) {
+    if (sumweight->ve[x] > 0.0) {
+      ave[x] /= sumweight->ve[x];
+    }
+  }
+  for (j = 0, y = 0; j < od->object_num; ++j) {
+    if (!get_object_attr(od, j, ACTIVE_BIT)) {
+      continue;
+    }
+    sqrt_weight = sqrt(od->mel.object_weight[j]);
+    for (x = 0; x < x_count; ++x) {
+      value = M_PEEK(block, y, x);
+      M_POKE(block, y, x, (MISSING(value)
+        ? 0.0 : (value - ave[x])) * sqrt_weight);
+    }
+    ++y;
+  }
+  
+  return 0;
+}
+
+
+/*
+the two streaming passes of pls_out_of_core(); block,
+sumweight and var_list have been allocated by the caller
+*/
+static int stream_kernel_pls(O3Data *od, int pc_num, int block_vars,
+  DoubleMat *block, DoubleVec *sumweight, int *var_list)
+{
+  int i;
+  int k;
+  int x;
+  int m;
+  int n;
+  int x_count;
+  int actual_len;
+  int result;
+  
+  
+  m = od->active_object_num;
+  n = od->overall_active_x_vars;
+  /*
+  list active variables in the same order as fill_x_matrix()
+  and write the same TEMP_X_MATRIX map
+  */
+  if (open_temp_file(od, od->file[TEMP_X_MATRIX], "x_matrix")) {
+    return CANNOT_WRITE_TEMP_FILE;
+  }
+  for (i = 0, x = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, ACTIVE_BIT)) {
+      continue;
+    }
+    for (k = 0; k < od->x_vars; ++k) {
+      if (!get_x_var_attr(od, i, k, ACTIVE_BIT)) {
+        continue;
+      }
+      var_list[x * 2] = i;
+      var_list[x * 2 + 1] = k;
+      fwrite(&i, sizeof(int), 1,
+        od->file[TEMP_X_MATRIX]->handle);
+      actual_len = fwrite(&k, sizeof(int), 1,
+        od->file[TEMP_X_MATRIX]->handle);
+      if (actual_len != 1) {
+        return CANNOT_WRITE_TEMP_FILE;
+      }
+      ++x;
+    }
+  }
+  fclose(od->file[TEMP_X_MATRIX]->handle);
+  od->file[TEMP_X_MATRIX]->handle = NULL;
+  kernel_pls_resize(od, m, n, pc_num);
+  /*
+  first pass: K = sum(EbEb')
+  */
+  for (x = 0; x < n; x += block_vars) {
+    x_count = (((n - x) < block_vars) ? (n - x) : block_vars);
+    result = fill_x_block(od, block, sumweight, var_list, x, x_count);
+    if (result) {
+      return result;
+    }
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+      m, m, x_count, 1.0,
+      block->base, block->max_m,
+      block->base, block->max_m, (x ? 1.0 : 0.0),
+      od->mal.kernel_mat->base, od->mal.kernel_mat->max_m);
+  }
+  kernel_pls_extract(od, pc_num, FULL_MODEL);
+  /*
+  second pass: c = E'v~ and b = E'u, one block of rows
+  at a time; if E fitted in a single block it is
+  still there and need not be read again
+  */
+  for (x = 0; x < n; x += block_vars) {
+    x_count = (((n - x) < block_vars) ? (n - x) : block_vars);
+    if (n > block_vars) {
+      result = fill_x_block(od, block, sumweight, var_list, x, x_count);
+      if (result) {
+        return result;
+      }
+    }
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+      x_count, pc_num + 1, m, 1.0,
+      block->base, block->max_m,
+      od->mal.kernel_u->base, od->mal.kernel_u->max_m, 0.0,
+      &M_PEEK(od->mal.x_weights, x, 0), od->mal.x_weights->max_m);
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+      x_count, pc_num + 1, m, 1.0,
+      block->base, block->max_m,
+      od->mal.x_scores->base, od->mal.x_scores->max_m, 0.0,
+      &M_PEEK(od->mal.x_loadings, x, 0), od->mal.x_loadings->max_m);
+  }
+  kernel_pls_normalize(od, pc_num);
+  
+  return 0;
+}
+
+
+/*
+out-of-core kernel PLS for datasets whose E matrix does not
+fit in memory: E is never materialized, but it is streamed
+from field storage in blocks of at most od->pls_block_vars
+variables. The first pass accumulates K = EE' = sum(EbEb'),
+then components are extracted from K by kernel_pls_extract();
+a second pass reconstructs the rows of weights (c = E'v~) and
+loadings (b = E'u) belonging to each block. Apart from the
+m x m kernel and a single m x block_vars buffer, memory is
+only needed for the model itself.
+The X residuals are not computed, so leverages cannot be
+calculated, and the large-E matrix is not available for
+external prediction
+*/
+int pls_out_of_core(O3Data *od, int suggested_pc_num)
+{
+  int n;
+  int pc_num;
+  int block_vars;
+  int result;
+  int *var_list;
+  DoubleMat *block;
+  DoubleVec *sumweight;
+  
+  
+  n = od->overall_active_x_vars;
+  pc_num = suggested_pc_num;
+  if (suggested_pc_num > n) {
+    pc_num = n;
+  }
+  block_vars = ((od->pls_block_vars < n) ? od->pls_block_vars : n);
+  var_list = alloc_int_array(NULL, n * 2);
+  block = double_mat_alloc(od->active_object_num, block_vars);
+  sumweight = double_vec_alloc(block_vars);
+  result = OUT_OF_MEMORY;
+  if (var_list && block && sumweight) {
+    result = stream_kernel_pls(od, pc_num, block_vars,
+      block, sumweight, var_list);
+  }
+  if (var_list) {
+    free(var_list);
+  }
+  if (block) {
+    double_mat_free(block);
+  }
+  if (sumweight) {
+    double_vec_free(sumweight);
+  }
+  
+  return result;
+}
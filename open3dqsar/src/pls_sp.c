@@ -0,0 +1,270 @@
+/*
+
+pls_sp.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+#include <include/o3header.h>
+
+
+/*
+in single-precision CV the training rows of each fold are
+centered straight into the float E matrix, so that threads
+need not hold a double precision copy of E; sp_cv is only
+set for plain CV, since nested, FFDSEL, UVEPLS and
+scrambling folds are still built in double precision
+*/
+void prepare_sp_cv(O3Data *od)
+{
+  od->cv.sp_cv = ((od->pls_precision == PLS_SINGLE_PRECISION)
+    && (od->pls_algorithm == NIPALS_PLS)
+    && (od->pls_y_mode == PLS2_Y_MODE));
+}
+
+
+void sp_cv_fold(O3Data *od)
+{
+  int i;
+  int x;
+  double value;
+  double ave;
+  FloatMat *e_sp;
+  
+  
+  /*
+  no need to check the return value, since this is just a logical
+  resizing: the float E matrix has been allocated with maximal size
+  */
+  fill_fold_rows(od);
+  double_vec_resize(od->vel.e_mat_ave, od->mal.large_e_mat->n);
+  e_sp = float_mat_resize(od->mal.e_mat_sp,
+    od->pel.fold_train_rows->size, od->mal.large_e_mat->n);
+  for (x = 0; x < od->mal.large_e_mat->n; ++x) {
+    ave = calc_fold_column_ave(od, od->mal.large_e_mat,
+      od->mal.large_e_mat_sum, x);
+    od->vel.e_mat_ave->ve[x] = ave;
+    for (i = 0; i < od->pel.fold_train_rows->size; ++i) {
+      value = M_PEEK(od->mal.large_e_mat, od->pel.fold_train_rows->pe[i], x);
+      M_POKE(e_sp, i, x, (float)((MISSING(value) ? 0.0 : (value - ave))
+        * od->vel.fold_train_sqrt_weight->ve[i]));
+    }
+  }
+  /*
+  E only holds the left-out rows which are filled in
+  by pred_y_values(); it is grown here if needed
+  */
+  od->mal.e_mat = double_mat_resize(od->mal.e_mat,
+    od->pel.fold_out_rows->size, od->mal.large_e_mat->n);
+}
+
+
+/*
+single-precision NIPALS PLS: the E and F matrices of the
+current model are copied once into float matrices (E is
+already there in single-precision CV folds), then
+components are extracted with float32 BLAS, which halves
+the memory traffic of each matrix-vector product and of
+deflation; weights, loadings and scores are stored back
+in double precision, so that predictions and statistics
+are computed by the usual code
+*/
+void pls_sp(O3Data *od, int suggested_pc_num, int model_type)
+{
+  int i;
+  int x;
+  int y;
+  int pc_num;
+  int conv;
+  int sp_cv;
+  float norm_c;
+  float norm_d;
+  float *c;
+  float *u;
+  float *b;
+  float *d;
+  float *v;
+  float *v_new;
+  double ss_u;
+  double ro;
+  double ss_v_diff;
+  FloatMat *e_sp;
+  FloatMat *f_sp;
+  
+  
+  sp_cv = (od->cv.sp_cv && (model_type & CV_MODEL));
+  e_sp = (sp_cv ? od->mal.e_mat_sp : float_mat_resize(od->mal.e_mat_sp,
+    od->mal.e_mat->m, od->mal.e_mat->n));
+  pc_num = suggested_pc_num;
+  if (suggested_pc_num > e_sp->n) {
+    pc_num = e_sp->n;
+  }
+  /*
+  no need to check the return value, since this is just a logical
+  resizing: all these matrices and vectors have been allocated
+  with maximal size with this purpose
+  */
+  double_mat_resize(od->mal.x_scores,
+    e_sp->m, pc_num + 1);
+  double_mat_resize(od->mal.x_weights,
+    e_sp->n, pc_num + 1);
+  double_mat_resize(od->mal.x_loadings,
+    e_sp->n, pc_num + 1);
+  double_mat_resize(od->mal.pred_f_mat,
+    e_sp->m, od->mal.f_mat->n);
+  double_vec_resize(od->vel.ave_sdep, pc_num + 1);
+  double_mat_resize(od->mal.y_loadings,
+    od->mal.f_mat->n, pc_num + 1);
+  double_mat_resize(od->mal.y_scores,
+    od->mal.f_mat->m, pc_num + 1);
+  double_vec_resize(od->vel.ro, pc_num + 1);
+  od->pc_num = pc_num;
+  f_sp = float_mat_resize(od->mal.f_mat_sp,
+    od->mal.f_mat->m, od->mal.f_mat->n);
+  c = &M_PEEK(od->mal.pls_sp_work, 0, 0);
+  u = &M_PEEK(od->mal.pls_sp_work, 0, 1);
+  b = &M_PEEK(od->mal.pls_sp_work, 0, 2);
+  d = &M_PEEK(od->mal.pls_sp_work, 0, 3);
+  v = &M_PEEK(od->mal.pls_sp_work, 0, 4);
+  v_new = &M_PEEK(od->mal.pls_sp_work, 0, 5);
+  /*
+  narrow E (unless already done) and F to single precision
+  */
+  for (x = 0; (!sp_cv) && (x < e_sp->n); ++x) {
+    for (y = 0; y < e_sp->m; ++y) {
+      M_POKE(e_sp, y, x, (float)M_PEEK(od->mal.e_mat, y, x));
+    }
+  }
+  for (x = 0; x < f_sp->n; ++x) {
+    for (y = 0; y < f_sp->m; ++y) {
+      M_POKE(f_sp, y, x, (float)M_PEEK(od->mal.f_mat, y, x));
+    }
+  }
+  /*
+  Copy first dependent variable into vector v
+  */
+  cblas_scopy(f_sp->m, f_sp->base, 1, v, 1);
+  for (i = 0; i <= pc_num; ++i) {
+    conv = 0;
+    while (!conv) {
+      /*
+      c = E[i]'v
+      c = c * (c'c)^(-0.5)
+      */
+      cblas_sgemv(CblasColMajor, CblasTrans,
+        e_sp->m, e_sp->n, 1.0f,
+        e_sp->base, e_sp->max_m,
+        v, 1, 0.0f, c, 1);
+      norm_c = cblas_snrm2(e_sp->n, c, 1);
+      cblas_sscal(e_sp->n, 1.0f / norm_c, c, 1);
+      /*
+      u = E[i]c
+      */
+      cblas_sgemv(CblasColMajor, CblasNoTrans,
+        e_sp->m, e_sp->n, 1.0f,
+        e_sp->base, e_sp->max_m,
+        c, 1, 0.0f, u, 1);
+      /*
+      d = F[i]'u
+      d = d * (d'd)^(-0.5)
+      */
+      cblas_sgemv(CblasColMajor, CblasTrans,
+        f_sp->m, f_sp->n, 1.0f,
+        f_sp->base, f_sp->max_m,
+        u, 1, 0.0f, d, 1);
+      norm_d = cblas_snrm2(f_sp->n, d, 1);
+      cblas_sscal(f_sp->n, 1.0f / norm_d, d, 1);
+      /*
+      v_new = F[i]d
+      */
+      cblas_sgemv(CblasColMajor, CblasNoTrans,
+        f_sp->m, f_sp->n, 1.0f,
+        f_sp->base, f_sp->max_m,
+        d, 1, 0.0f, v_new, 1);
+      conv = 1;
+      if (f_sp->n > 1) {
+        /*
+        if there are multiple y vars, check convergence
+        */
+        cblas_saxpy(f_sp->m, -1.0f, v_new, 1, v, 1);
+        ss_v_diff = cblas_dsdot(f_sp->m, v, 1, v, 1);
+        if (fabs(ss_v_diff) >= PLS_CONV_THRESHOLD) {
+          conv = 0;
+        }
+      }
+      cblas_scopy(f_sp->m, v_new, 1, v, 1);
+    }
+    /*
+    ro = u'v / u'u, accumulated in double precision
+    */
+    ss_u = cblas_dsdot(e_sp->m, u, 1, u, 1);
+    ro = cblas_dsdot(e_sp->m, u, 1, v, 1) / ss_u;
+    od->vel.ro->ve[i] = ro;
+    /*
+    d = ro d
+    */
+    cblas_sscal(f_sp->n, (float)ro, d, 1);
+    /*
+    b = E[i]'u / u'u
+    */
+    cblas_sgemv(CblasColMajor, CblasTrans,
+      e_sp->m, e_sp->n, (float)(1.0 / ss_u),
+      e_sp->base, e_sp->max_m,
+      u, 1, 0.0f, b, 1);
+    /*
+    E[i + 1] = E[i] - ub'
+    F[i + 1] = F[i] - ud'
+    */
+    cblas_sger(CblasColMajor, e_sp->m, e_sp->n, -1.0f,
+      u, 1, b, 1, e_sp->base, e_sp->max_m);
+    cblas_sger(CblasColMajor, f_sp->m, f_sp->n, -1.0f,
+      u, 1, d, 1, f_sp->base, f_sp->max_m);
+    /*
+    store the component in double precision
+    */
+    for (x = 0; x < e_sp->n; ++x) {
+      M_POKE(od->mal.x_weights, x, i, (double)c[x]);
+      M_POKE(od->mal.x_loadings, x, i, (double)b[x]);
+    }
+    for (y = 0; y < e_sp->m; ++y) {
+      M_POKE(od->mal.x_scores, y, i, (double)u[y]);
+    }
+    for (x = 0; x < f_sp->n; ++x) {
+      M_POKE(od->mal.y_loadings, x, i, (double)d[x]);
+    }
+  }
+}
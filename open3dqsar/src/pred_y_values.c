@@ -60,14 +60,16 @@ int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv
   #if (!defined HAVE_LIBLAPACK_ATLAS) && (!defined HAVE_LIBSUNPERF)
   int lwork;
   #endif
-  double value;
   double ave_res;
+  double run_press;
   double sqrt_weight;
   double sumweight;
   FileDescriptor *temp_pred;
   FileDescriptor *temp_cv_coeff;
+  CVPredStore *store;
   
   
+  store = &(od->cv_pred);
   temp_pred = (ti ? &(ti->temp_pred) : od->file[TEMP_PRED]);
   temp_cv_coeff = (ti ? &(ti->temp_cv_coeff) : od->file[TEMP_CV_COEFF]);
   /*
@@ -90,7 +92,12 @@ int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv
         continue;
       }
       fill_y_vector(od, object_num, y, model_type, cv_run);
-      fill_x_vector(od, object_num, y, model_type, cv_run);
+      if (od->cv.kernel_cv && (model_type & CV_MODEL)) {
+        fill_kernel_x_vector(od, object_num, y);
+      }
+      else {
+        fill_x_vector(od, object_num, y, model_type, cv_run);
+      }
       ++y;
     }
     ++i;
@@ -103,7 +110,34 @@ int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv
   double_mat_resize(od->mal.f_mat, y, od->y_vars);
   double_mat_resize(od->mal.e_mat, y, od->mal.e_mat->n);
   double_mat_resize(od->mal.pred_f_mat, y, od->y_vars);
-  if (model_type & (CV_MODEL | SILENT_PLS)) {
+  if ((model_type & (CV_MODEL | SILENT_PLS)) && store->active) {
+    /*
+    each CV run fills in its own block of the in-memory store
+    */
+    store->block_pc[cv_run] = pc_num;
+    store->block_len[cv_run] = y;
+    object_num = 0;
+    i = 0;
+    j = 0;
+    while ((object_num < od->object_num)
+      && (i < od->pel.out_structs->size)) {
+      struct_num = od->al.mol_info[object_num]->struct_num;
+      conf_num = 1;
+      if (struct_num != od->pel.out_structs->pe[i]) {
+        object_num += conf_num;
+        continue;
+      }
+      for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num) {
+        if (!get_object_attr(od, object_num, ACTIVE_BIT)) {
+          continue;
+        }
+        store->object_list[cv_run * store->block_size + j] = object_num;
+        ++j;
+      }
+      ++i;
+    }
+  }
+  else if (model_type & (CV_MODEL | SILENT_PLS)) {
     /*
     write number of PCs
     */
@@ -187,107 +221,109 @@ int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv
   resizing: all these matrices have been allocated
   with maximal size with this purpose
   */
-  double_mat_resize(od->mal.x_weights, od->mal.e_mat->n, pc_num);
   double_mat_resize(od->mal.b_coefficients, od->mal.e_mat->n, od->y_vars);
-  double_mat_resize(od->mal.x_loadings, od->mal.e_mat->n, pc_num);
-  double_mat_resize(od->mal.temp, pc_num, pc_num);
-  
-  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
-    od->mal.x_loadings->n,
-    od->mal.x_weights->n,
-    od->mal.x_loadings->m, 1.0,
-    od->mal.x_loadings->base,
-    od->mal.x_loadings->max_m,
-    od->mal.x_weights->base,
-    od->mal.x_weights->max_m, 0.0,
-    od->mal.temp->base,
-    od->mal.temp->max_m);
-  
-  /*
-  if the matrix is singular, replace weights_star with weights
-  */
-  #ifdef HAVE_LIBMKL
-  dgetrf(&(od->mal.temp->m),
-    &(od->mal.temp->m),
-    od->mal.temp->base,
-    &(od->mal.temp->max_m),
-    od->mel.ipiv, &info);
-  #elif HAVE_LIBSUNPERF
-  dgetrf(od->mal.temp->m,
-    od->mal.temp->m,
-    od->mal.temp->base,
-    od->mal.temp->max_m,
-    od->mel.ipiv, &info);
-  #elif HAVE_LIBLAPACK_ATLAS
-  info = clapack_dgetrf(CblasColMajor,
-    od->mal.temp->m,
-    od->mal.temp->m,
-    od->mal.temp->base,
-    od->mal.temp->max_m,
-    od->mel.ipiv);
-  #elif HAVE_LIBLAPACKE
-  info = LAPACKE_dgetrf(LAPACK_COL_MAJOR,
-    od->mal.temp->m,
-    od->mal.temp->m,
-    od->mal.temp->base,
-    od->mal.temp->max_m,
-    od->mel.ipiv);
-  #else
-  dgetrf_(&(od->mal.temp->m),
-    &(od->mal.temp->m),
-    od->mal.temp->base,
-    &(od->mal.temp->max_m),
-    od->mel.ipiv, &info);
-  #endif
-  if (!info) {
+  if (od->pls_y_mode == PLS2_Y_MODE) {
+    double_mat_resize(od->mal.x_weights, od->mal.e_mat->n, pc_num);
+    double_mat_resize(od->mal.x_loadings, od->mal.e_mat->n, pc_num);
+    double_mat_resize(od->mal.temp, pc_num, pc_num);
+    
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans,
+      od->mal.x_loadings->n,
+      od->mal.x_weights->n,
+      od->mal.x_loadings->m, 1.0,
+      od->mal.x_loadings->base,
+      od->mal.x_loadings->max_m,
+      od->mal.x_weights->base,
+      od->mal.x_weights->max_m, 0.0,
+      od->mal.temp->base,
+      od->mal.temp->max_m);
+    
+    /*
+    if the matrix is singular, replace weights_star with weights
+    */
     #ifdef HAVE_LIBMKL
-    lwork = (pc_num + 1) * LWORK_BLOCK_SIZE * sizeof(double);
-    dgetri(&(od->mal.temp->m),
+    dgetrf(&(od->mal.temp->m),
+      &(od->mal.temp->m),
       od->mal.temp->base,
       &(od->mal.temp->max_m),
-      od->mel.ipiv,
-      od->mel.work, &lwork, &info);
+      od->mel.ipiv, &info);
     #elif HAVE_LIBSUNPERF
-    dgetri(od->mal.temp->m,
+    dgetrf(od->mal.temp->m,
+      od->mal.temp->m,
       od->mal.temp->base,
       od->mal.temp->max_m,
       od->mel.ipiv, &info);
     #elif HAVE_LIBLAPACK_ATLAS
-    info = clapack_dgetri(CblasColMajor,
+    info = clapack_dgetrf(CblasColMajor,
+      od->mal.temp->m,
       od->mal.temp->m,
       od->mal.temp->base,
       od->mal.temp->max_m,
       od->mel.ipiv);
     #elif HAVE_LIBLAPACKE
-    info = LAPACKE_dgetri(LAPACK_COL_MAJOR,
+    info = LAPACKE_dgetrf(LAPACK_COL_MAJOR,
+      od->mal.temp->m,
       od->mal.temp->m,
       od->mal.temp->base,
       od->mal.temp->max_m,
       od->mel.ipiv);
     #else
-    lwork = (pc_num + 1) * LWORK_BLOCK_SIZE * sizeof(double);
-    dgetri_(&(od->mal.temp->m),
+    dgetrf_(&(od->mal.temp->m),
+      &(od->mal.temp->m),
       od->mal.temp->base,
       &(od->mal.temp->max_m),
-      od->mel.ipiv,
-      od->mel.work, &lwork, &info);
+      od->mel.ipiv, &info);
     #endif
-  }
-  if (!info) {
-    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
-      od->mal.x_weights->m,
-      od->mal.temp->n,
-      pc_num, 1.0,
-      od->mal.x_weights->base,
-      od->mal.x_weights->max_m,
-      od->mal.temp->base,
-      od->mal.temp->max_m, 0.0,
-      od->mal.x_weights_star->base,
-      od->mal.x_weights_star->max_m);
-  }
-  else {
-    memcpy(od->mal.x_weights_star->base, od->mal.x_weights->base,
-      od->mal.x_weights->m * od->mal.x_weights->n * sizeof(double));
+    if (!info) {
+      #ifdef HAVE_LIBMKL
+      lwork = (pc_num + 1) * LWORK_BLOCK_SIZE * sizeof(double);
+      dgetri(&(od->mal.temp->m),
+        od->mal.temp->base,
+        &(od->mal.temp->max_m),
+        od->mel.ipiv,
+        od->mel.work, &lwork, &info);
+      #elif HAVE_LIBSUNPERF
+      dgetri(od->mal.temp->m,
+        od->mal.temp->base,
+        od->mal.temp->max_m,
+        od->mel.ipiv, &info);
+      #elif HAVE_LIBLAPACK_ATLAS
+      info = clapack_dgetri(CblasColMajor,
+        od->mal.temp->m,
+        od->mal.temp->base,
+        od->mal.temp->max_m,
+        od->mel.ipiv);
+      #elif HAVE_LIBLAPACKE
+      info = LAPACKE_dgetri(LAPACK_COL_MAJOR,
+        od->mal.temp->m,
+        od->mal.temp->base,
+        od->mal.temp->max_m,
+        od->mel.ipiv);
+      #else
+      lwork = (pc_num + 1) * LWORK_BLOCK_SIZE * sizeof(double);
+      dgetri_(&(od->mal.temp->m),
+        od->mal.temp->base,
+        &(od->mal.temp->max_m),
+        od->mel.ipiv,
+        od->mel.work, &lwork, &info);
+      #endif
+    }
+    if (!info) {
+      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
+        od->mal.x_weights->m,
+        od->mal.temp->n,
+        pc_num, 1.0,
+        od->mal.x_weights->base,
+        od->mal.x_weights->max_m,
+        od->mal.temp->base,
+        od->mal.temp->max_m, 0.0,
+        od->mal.x_weights_star->base,
+        od->mal.x_weights_star->max_m);
+    }
+    else {
+      memcpy(od->mal.x_weights_star->base, od->mal.x_weights->base,
+        od->mal.x_weights->m * od->mal.x_weights->n * sizeof(double));
+    }
   }
   for (i = pc_num; i >= 0; --i) {
     /*
@@ -295,18 +331,30 @@ int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv
     resizing: all these matrices have been allocated
     with maximal size with this purpose
     */
-    double_mat_resize(od->mal.x_weights_star, od->mal.e_mat->n, i);
-    double_mat_resize(od->mal.y_loadings, od->y_vars, i);
-    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
-      od->mal.x_weights_star->m,
-      od->mal.y_loadings->m,
-      i, 1.0,
-      od->mal.x_weights_star->base,
-      od->mal.x_weights_star->max_m,
-      od->mal.y_loadings->base,
-      od->mal.y_loadings->max_m, 0.0,
-      od->mal.b_coefficients->base,
-      od->mal.b_coefficients->max_m);
+    if (od->pls_y_mode == PLS1_Y_MODE) {
+      /*
+      PLS1 coefficients were computed by pls1_batch()
+      */
+      for (x = 0; x < od->y_vars; ++x) {
+        cblas_dcopy(od->mal.b_coefficients->m,
+          &M_PEEK(od->mal.pls1_coeff, 0, i * od->y_vars + x), 1,
+          &M_PEEK(od->mal.b_coefficients, 0, x), 1);
+      }
+    }
+    else {
+      double_mat_resize(od->mal.x_weights_star, od->mal.e_mat->n, i);
+      double_mat_resize(od->mal.y_loadings, od->y_vars, i);
+      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasTrans,
+        od->mal.x_weights_star->m,
+        od->mal.y_loadings->m,
+        i, 1.0,
+        od->mal.x_weights_star->base,
+        od->mal.x_weights_star->max_m,
+        od->mal.y_loadings->base,
+        od->mal.y_loadings->max_m, 0.0,
+        od->mal.b_coefficients->base,
+        od->mal.b_coefficients->max_m);
+    }
     cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
       od->mal.e_mat->m,
       od->mal.b_coefficients->n,
@@ -321,6 +369,7 @@ int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv
       object_num = 0;
       j = 0;
       y = 0;
+      run_press = 0.0;
       while ((object_num < od->object_num)
         && (j < od->pel.out_structs->size)) {
         struct_num = od->al.mol_info[object_num]->struct_num;
@@ -341,40 +390,48 @@ int pred_y_values(O3Data *od, ThreadInfo *ti, int pc_num, int model_type, int cv
             * sqrt_weight;
           if (model_type & (CV_MODEL | SILENT_PLS)) {
             /*
-            write predicted value to file
+            the predicted value is not needed anymore,
+            so it can be replaced with the value to be
+            written to file
             */
-            value = ((sqrt_weight > 0.0)
+            M_POKE(od->mal.pred_f_mat, y, x, ((sqrt_weight > 0.0)
               ? M_PEEK(od->mal.pred_f_mat, y, x) / sqrt_weight
-              + od->vel.f_mat_ave->ve[x] : INFINITY);
-            actual_len = fwrite(&value, sizeof(double), 1,
-              temp_pred->handle);
-            if (actual_len != 1) {
-              return CANNOT_WRITE_TEMP_FILE;
-            }
+              + od->vel.f_mat_ave->ve[x] : INFINITY));
           }
           ++y;
         }
         if (sumweight > 0.0) {
           ave_res /= sumweight;
-          if (model_type & PARALLEL_CV) {
-            #ifndef WIN32
-            pthread_mutex_lock(od->mel.mutex);
-            #else
-            WaitForSingleObject(*(od->mel.mutex), INFINITE);
-            #endif
-          }
-          M_POKE(od->mal.press, i, x,
-            M_PEEK(od->mal.press, i, x) + square(ave_res));
-          if (model_type & PARALLEL_CV) {
-            #ifndef WIN32
-            pthread_mutex_unlock(od->mel.mutex);
-            #else
-            ReleaseMutex(*(od->mel.mutex));
-            #endif
-          }
+          run_press += square(ave_res);
         }
         ++j;
       }
+      /*
+      od->mal.press is private to the caller
+      (each CV thread has its own), so no lock
+      is needed; the contributions of this run
+      are summed first and then added at once,
+      which keeps the summation order independent
+      of the number of threads
+      */
+      M_POKE(od->mal.press, i, x,
+        M_PEEK(od->mal.press, i, x) + run_press);
+      if ((model_type & (CV_MODEL | SILENT_PLS)) && store->active) {
+        for (j = 0; j < y; ++j) {
+          CV_PRED_VALUE(store, cv_run * store->block_size + j, x, i) =
+            M_PEEK(od->mal.pred_f_mat, j, x);
+        }
+      }
+      else if (model_type & (CV_MODEL | SILENT_PLS)) {
+        /*
+        write predicted values for this y variable to file
+        */
+        actual_len = fwrite(&M_PEEK(od->mal.pred_f_mat, 0, x),
+          sizeof(double), y, temp_pred->handle);
+        if (actual_len != y) {
+          return CANNOT_WRITE_TEMP_FILE;
+        }
+      }
     }
     if ((model_type & UVEPLS_CV_MODEL) && (i == pc_num)) {
       /*
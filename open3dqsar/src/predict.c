@@ -47,12 +47,31 @@ int predict(O3Data *od, int pc_num)
   int result;
   
   
-  trim_mean_center_matrix(od, od->mal.large_e_mat,
-    &(od->mal.e_mat), &(od->vel.e_mat_ave),
-    FULL_MODEL, od->active_object_num);
-  trim_mean_center_matrix(od, od->mal.large_f_mat,
-    &(od->mal.f_mat), &(od->vel.f_mat_ave),
-    FULL_MODEL, od->active_object_num);
+  /*
+  centering vectors of the current PLS model are
+  reused if available, otherwise they are recomputed
+  */
+  if (model_cache_valid(od)) {
+    od->vel.e_mat_ave = double_vec_resize
+      (od->vel.e_mat_ave, od->model.x_vars);
+    od->vel.f_mat_ave = double_vec_resize
+      (od->vel.f_mat_ave, od->model.y_vars);
+    if (!(od->vel.e_mat_ave) || !(od->vel.f_mat_ave)) {
+      return OUT_OF_MEMORY;
+    }
+    memcpy(od->vel.e_mat_ave->ve, od->model.e_mat_ave,
+      od->model.x_vars * sizeof(double));
+    memcpy(od->vel.f_mat_ave->ve, od->model.f_mat_ave,
+      od->model.y_vars * sizeof(double));
+  }
+  else {
+    trim_mean_center_matrix(od, od->mal.large_e_mat, NULL,
+      &(od->mal.e_mat), &(od->vel.e_mat_ave),
+      FULL_MODEL, od->active_object_num);
+    trim_mean_center_matrix(od, od->mal.large_f_mat, NULL,
+      &(od->mal.f_mat), &(od->vel.f_mat_ave),
+      FULL_MODEL, od->active_object_num);
+  }
   result = pred_ext_y_values(od, pc_num, FULL_MODEL);
   if (result) {
     return result;
@@ -45,7 +45,6 @@ E-mail: paolo.tosco@unito.it
 int prepare_cv(O3Data *od, int pc_num, int cv_type, int groups, int runs)
 {
   int i;
-  int j;
   int n;
   int x;
   int object_num;
@@ -56,12 +55,7 @@ int prepare_cv(O3Data *od, int pc_num, int cv_type, int groups, int runs)
   int conf_num;
   int conf_num2;
   int n_conf;
-  int group_num;
   int excess;
-  int structs_to_be_assigned;
-  int struct_count;
-  int position;
-  int random_struct;
   double sumweight = 0.0;
   double active_value_ave = 0.0;
   
@@ -144,22 +138,35 @@ int prepare_cv(O3Data *od, int pc_num, int cv_type, int groups, int runs)
     
     case LEAVE_MANY_OUT:
     /*
-    initialize structure list with all active structure numbers
+    group composition matrices are allocated here, but they
+    are filled by fill_group_composition() only when each
+    CV run is carried out
     */
     od->cimal.group_composition_list =
       (IntMat **)malloc(runs * sizeof(IntMat *));
     if (!(od->cimal.group_composition_list)) {
       return OUT_OF_MEMORY;
     }
+    memset(od->cimal.group_composition_list, 0, runs * sizeof(IntMat *));
     od->mel.struct_per_group =
       alloc_int_array(od->mel.struct_per_group, groups);
     if (!(od->mel.struct_per_group)) {
       return OUT_OF_MEMORY;
     }
+    od->mel.group_ready =
+      alloc_int_array(od->mel.group_ready, runs);
+    if (!(od->mel.group_ready)) {
+      return OUT_OF_MEMORY;
+    }
     for (x = 0; x < od->y_vars; ++x) {
       get_attr_struct_ave(od, 0, ACTIVE_BIT,
         &active_struct_num, &(od->vel.active_value_ave->ve[x]));
     }
+    od->mel.active_struct_list =
+      alloc_int_array(od->mel.active_struct_list, active_struct_num);
+    if (!(od->mel.active_struct_list)) {
+      return OUT_OF_MEMORY;
+    }
     excess = active_struct_num % groups;
     for (i = 0; i < groups; ++i) {
       od->mel.struct_per_group[i] = active_struct_num / groups;
@@ -179,9 +186,9 @@ int prepare_cv(O3Data *od, int pc_num, int cv_type, int groups, int runs)
       if (!(od->cimal.group_composition_list[i])) {
         return OUT_OF_MEMORY;
       }
-      group_num = 0;
-      struct_count = 0;
-      structs_to_be_assigned = active_struct_num;
+      /*
+      each active structure is left out once per run
+      */
       object_num = 0;
       n = 0;
       while (object_num < od->object_num) {
@@ -194,57 +201,31 @@ int prepare_cv(O3Data *od, int pc_num, int cv_type, int groups, int runs)
           }
         }
         if (sumweight > 0.0) {
-          od->mel.struct_list[n] = struct_num;
-          ++n;
-        }
-      }
-      while (structs_to_be_assigned) {
-        position = (int)safe_rint((double)(structs_to_be_assigned - 1)
-          * genrand_real(od));
-        random_struct = od->mel.struct_list[position];
-        object_num = 0;
-        while (1) {
-          struct_num = od->al.mol_info[object_num]->struct_num;
-          if (struct_num == random_struct) {
-            break;
+          if (!i) {
+            od->mel.active_struct_list[n] = struct_num;
+            ++n;
           }
-          conf_num = 1;
-          for (n_conf = 0;
-            n_conf < conf_num; ++n_conf, ++object_num) {
-            if (!get_object_attr(od, object_num, ACTIVE_BIT | PREDICT_BIT)) {
-              continue;
-            }
+          for (x = 0; x < od->y_vars; ++x) {
+            od->cv.tss += square(get_y_value(od, object_num - conf_num,
+              x, WEIGHT_BIT) - od->vel.active_value_ave->ve[x]);
           }
-        }
-        for (x = 0; x < od->y_vars; ++x) {
-          od->cv.tss += square(get_y_value
-            (od, object_num, x, WEIGHT_BIT) - od->vel.active_value_ave->ve[x]);
-        }
-        ++(od->cv.num_predictions);
-        /*
-        take random objects out of the list shifting
-        those which follow up one place
-        */
-        --structs_to_be_assigned;
-        for (j = position; j < structs_to_be_assigned; ++j) {
-          od->mel.struct_list[j] =
-            od->mel.struct_list[j + 1];
-        }
-        /*
-        assign random object to current group; if object run_count
-        exceeds size of current group, then reset the counter
-        and pass on to the next group
-        */
-        od->cimal.group_composition_list[i]->me
-          [group_num][struct_count] = random_struct;
-        ++struct_count;
-        if (struct_count >=
-          od->mel.struct_per_group[group_num]) {
-          struct_count = 0;
-          ++group_num;
+          ++(od->cv.num_predictions);
         }
       }
     }
+    od->cv.groups = groups;
+    od->cv.runs = runs;
+    od->cv.runs_done = runs;
+    od->cv.active_struct_num = active_struct_num;
+    /*
+    each run draws one random number per active structure;
+    the generator is left in the same state as if all groups
+    had been drawn here, while each run will later jump
+    ahead to its own starting point
+    */
+    memcpy(&(od->cv.group_stream), &(od->mt_stream), sizeof(RandomStream));
+    skip_genrand_stream(&(od->mt_stream),
+      (unsigned long)runs * (unsigned long)active_struct_num);
     od->cv.overall_cv_runs = groups * runs;
     break;
   }
@@ -252,3 +233,71 @@ int prepare_cv(O3Data *od, int pc_num, int cv_type, int groups, int runs)
   
   return 0;
 }
+
+
+
+/*
+randomly assign active structures to LMO groups for a
+given CV run; the random numbers used for each run are
+picked from the stream saved by prepare_cv() jumping ahead
+to the first number belonging to that run, so groups are
+the same irrespective of which thread carries out the run,
+and of the order in which runs are carried out
+*/
+int fill_group_composition(O3Data *od, int run)
+{
+  int j;
+  int position;
+  int random_struct;
+  int structs_to_be_assigned;
+  int group_num;
+  int struct_count;
+  int *struct_list;
+  RandomStream rs;
+  
+  
+  if (od->mel.group_ready[run]) {
+    return 0;
+  }
+  struct_list = (int *)malloc(od->cv.active_struct_num * sizeof(int));
+  if (!struct_list) {
+    return OUT_OF_MEMORY;
+  }
+  memcpy(struct_list, od->mel.active_struct_list,
+    od->cv.active_struct_num * sizeof(int));
+  memcpy(&rs, &(od->cv.group_stream), sizeof(RandomStream));
+  skip_genrand_stream(&rs,
+    (unsigned long)run * (unsigned long)od->cv.active_struct_num);
+  group_num = 0;
+  struct_count = 0;
+  structs_to_be_assigned = od->cv.active_struct_num;
+  while (structs_to_be_assigned) {
+    position = (int)safe_rint((double)(structs_to_be_assigned - 1)
+      * genrand_stream_real(&rs));
+    random_struct = struct_list[position];
+    /*
+    take random objects out of the list shifting
+    those which follow up one place
+    */
+    --structs_to_be_assigned;
+    for (j = position; j < structs_to_be_assigned; ++j) {
+      struct_list[j] = struct_list[j + 1];
+    }
+    /*
+    assign random object to current group; if object run_count
+    exceeds size of current group, then reset the counter
+    and pass on to the next group
+    */
+    od->cimal.group_composition_list[run]->me
+      [group_num][struct_count] = random_struct;
+    ++struct_count;
+    if (struct_count >= od->mel.struct_per_group[group_num]) {
+      struct_count = 0;
+      ++group_num;
+    }
+  }
+  free(struct_list);
+  od->mel.group_ready[run] = 1;
+  
+  return 0;
+}
@@ -52,9 +52,7 @@ int mol_to_sdf(O3Data *od, int object_num, double actual_value)
   memset(buffer, 0, BUF_LEN);
   if (od->file[ASCII_IN]->handle) {
     memset(&mol_fd, 0, sizeof(FileDescriptor));
-    sprintf(mol_fd.name, "%s%c%04d.mol", od->field.mol_dir,
-      SEPARATOR, od->al.mol_info[object_num]->object_id);
-    if (!(mol_fd.handle = fopen(mol_fd.name, "rb"))) {
+    if (open_mol_record(od, &mol_fd, object_num)) {
       return CANNOT_READ_TEMP_FILE;
     }
     found = 0;
@@ -870,8 +868,15 @@ int print_pred_values(O3Data *od)
         sumweight += od->mel.object_weight[object_num];
         num_values = 0;
         memset(od->mel.sum, 0, (od->pc_num + 1) * sizeof(double));
-        rewind(od->file[TEMP_PRED]->handle);
-        while (!feof(od->file[TEMP_PRED]->handle)) {
+        if (od->cv_pred.active) {
+          pc_num = od->pc_num;
+          num_values = get_cv_pred_sum(od, object_num, x, pc_num, od->mel.sum);
+        }
+        else {
+          rewind(od->file[TEMP_PRED]->handle);
+        }
+        while ((!(od->cv_pred.active))
+          && (!feof(od->file[TEMP_PRED]->handle))) {
           /*
           Read number of PCs
           */
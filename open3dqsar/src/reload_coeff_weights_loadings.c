@@ -52,6 +52,20 @@ int reload_coefficients(O3Data *od, int pc_num)
   int num_blocks;
   double coeff;
   
+  /*
+  if the in-memory model is still current,
+  coefficients are copied from there
+  */
+  if (model_cache_valid(od)) {
+    x_max_x = od->model.x_vars;
+    x_max_y = od->model.y_vars;
+    for (x = 0; x < x_max_y; ++x) {
+      cblas_dcopy(x_max_x, &(od->model.b_coefficients
+        [(pc_num * x_max_y + x) * x_max_x]), 1,
+        &M_PEEK(od->mal.b_coefficients, 0, x), 1);
+    }
+    return 0;
+  }
   od->file[TEMP_PLS_COEFF]->handle = fopen(od->file[TEMP_PLS_COEFF]->name, "rb");
   if (!(od->file[TEMP_PLS_COEFF]->handle)) {
     return CANNOT_READ_TEMP_FILE;
@@ -95,26 +109,34 @@ int reload_coefficients(O3Data *od, int pc_num)
 
 int reload_weights_loadings(O3Data *od)
 {
+  int i;
   int x_max_x;
   int x_max_y;
   int actual_len;
+  int cached;
   
   
   /*
-  reload original weights and loadings
+  reload original weights and loadings,
+  from memory if the cached model is still current
   */
   x_max_x = od->overall_active_x_vars;
   x_max_y = od->y_vars;
-  od->file[TEMP_WLS]->handle =
-    fopen(od->file[TEMP_WLS]->name, "rb");
-  if (!(od->file[TEMP_WLS]->handle)) {
-    return CANNOT_READ_TEMP_FILE;
-  }
-  
-  actual_len = fread(&(od->pc_num), sizeof(int), 1,
-    od->file[TEMP_WLS]->handle);
-  if (actual_len != 1) {
-    return CANNOT_READ_TEMP_FILE;
+  cached = model_cache_valid(od);
+  if (cached) {
+    od->pc_num = od->model.pc_num;
+  }
+  else {
+    od->file[TEMP_WLS]->handle =
+      fopen(od->file[TEMP_WLS]->name, "rb");
+    if (!(od->file[TEMP_WLS]->handle)) {
+      return CANNOT_READ_TEMP_FILE;
+    }
+    actual_len = fread(&(od->pc_num), sizeof(int), 1,
+      od->file[TEMP_WLS]->handle);
+    if (actual_len != 1) {
+      return CANNOT_READ_TEMP_FILE;
+    }
   }
   if (od->mal.x_loadings) {
     double_mat_free(od->mal.x_loadings);
@@ -144,6 +166,36 @@ int reload_weights_loadings(O3Data *od)
   if (!(od->mal.x_weights_star)) {
     return OUT_OF_MEMORY;
   }
+  if (cached) {
+    memcpy(od->mal.x_weights->base, od->model.x_weights,
+      x_max_x * (od->pc_num + 1) * sizeof(double));
+    memcpy(od->mal.x_loadings->base, od->model.x_loadings,
+      x_max_x * (od->pc_num + 1) * sizeof(double));
+    memcpy(od->mal.y_loadings->base, od->model.y_loadings,
+      x_max_y * (od->pc_num + 1) * sizeof(double));
+    /*
+    scores may have been overwritten by CV models
+    */
+    if (od->mal.x_scores) {
+      double_mat_resize(od->mal.x_scores,
+        od->model.score_rows, od->pc_num);
+      for (i = 0; i < od->pc_num; ++i) {
+        cblas_dcopy(od->model.score_rows,
+          &(od->model.x_scores[i * od->model.score_rows]), 1,
+          &M_PEEK(od->mal.x_scores, 0, i), 1);
+      }
+    }
+    if (od->mal.y_scores && od->model.y_scores) {
+      double_mat_resize(od->mal.y_scores,
+        od->model.score_rows, od->pc_num);
+      for (i = 0; i < od->pc_num; ++i) {
+        cblas_dcopy(od->model.score_rows,
+          &(od->model.y_scores[i * od->model.score_rows]), 1,
+          &M_PEEK(od->mal.y_scores, 0, i), 1);
+      }
+    }
+    return 0;
+  }
   actual_len = fread(od->mal.x_weights->base,
     sizeof(double), x_max_x * (od->pc_num + 1),
     od->file[TEMP_WLS]->handle);
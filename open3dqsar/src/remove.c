@@ -49,6 +49,8 @@ int remove_field(O3Data *od)
   int k;
   int deleted_fields;
   int result;
+  int *journal_origin = NULL;
+  unsigned char *journal_dirty = NULL;
   
 
   deleted_fields = 0;
@@ -87,11 +89,49 @@ int remove_field(O3Data *od)
     if (!(od->file[TEMP_DAT]->handle)) {
       return CANNOT_READ_TEMP_FILE;
     }
+    /*
+    keep track of the journal base fields
+    surviving fields derive from
+    */
+    if (od->mel.journal_origin) {
+      journal_origin = alloc_int_array(NULL, od->field_num);
+      journal_dirty = (unsigned char *)malloc(od->field_num);
+      if (!(journal_origin && journal_dirty)) {
+        if (journal_origin) {
+          free(journal_origin);
+        }
+        if (journal_dirty) {
+          free(journal_dirty);
+        }
+        fzclose((fzPtr *)(od->file[TEMP_DAT]->handle));
+        od->file[TEMP_DAT]->handle = NULL;
+        remove_recursive(buffer);
+        od->file[TEMP_DAT]->name[0] = '\0';
+        return OUT_OF_MEMORY;
+      }
+      for (i = 0, k = 0; i < od->field_num; ++i) {
+        if (!get_field_attr(od, i, DELETE_BIT)) {
+          journal_origin[k] = od->mel.journal_origin[i];
+          journal_dirty[k] = od->mel.journal_dirty[i];
+          ++k;
+        }
+      }
+    }
     if (od->field_num) {
       close_files(od, MAX_FILES);
       free_x_var_array(od);
     }
     result = load_dat(od, TEMP_DAT, SILENT);
+    if (journal_origin) {
+      if (!result) {
+        memcpy(od->mel.journal_origin, journal_origin,
+          od->field_num * sizeof(int));
+        memcpy(od->mel.journal_dirty, journal_dirty,
+          od->field_num * sizeof(unsigned char));
+      }
+      free(journal_origin);
+      free(journal_dirty);
+    }
     if (result) {
       return result;
     }
@@ -125,6 +165,8 @@ int remove_object(O3Data *od)
   int k;
   int deleted_objects;
   int result;
+  int *journal_origin = NULL;
+  unsigned char *journal_dirty = NULL;
   
 
   deleted_objects = 0;
@@ -166,6 +208,27 @@ int remove_object(O3Data *od)
     if (!(od->file[TEMP_DAT]->handle)) {
       return CANNOT_READ_TEMP_FILE;
     }
+    if (od->mel.journal_origin && od->field_num) {
+      journal_origin = alloc_int_array(NULL, od->field_num);
+      journal_dirty = (unsigned char *)malloc(od->field_num);
+      if (!(journal_origin && journal_dirty)) {
+        if (journal_origin) {
+          free(journal_origin);
+        }
+        if (journal_dirty) {
+          free(journal_dirty);
+        }
+        fzclose((fzPtr *)(od->file[TEMP_DAT]->handle));
+        od->file[TEMP_DAT]->handle = NULL;
+        remove_recursive(buffer);
+        od->file[TEMP_DAT]->name[0] = '\0';
+        return OUT_OF_MEMORY;
+      }
+      memcpy(journal_origin, od->mel.journal_origin,
+        od->field_num * sizeof(int));
+      memcpy(journal_dirty, od->mel.journal_dirty,
+        od->field_num * sizeof(unsigned char));
+    }
     if (od->field_num) {
       close_files(od, MAX_FILES);
       free_x_var_array(od);
@@ -173,6 +236,16 @@ int remove_object(O3Data *od)
     sprintf(od->file[TEMP_MOLFILE]->name, "%s%ctemp_loaded_molfile.sdf",
       od->field.mol_dir, SEPARATOR);
     result = load_dat(od, TEMP_DAT, SILENT);
+    if (journal_origin) {
+      if (!result) {
+        memcpy(od->mel.journal_origin, journal_origin,
+          od->field_num * sizeof(int));
+        memcpy(od->mel.journal_dirty, journal_dirty,
+          od->field_num * sizeof(unsigned char));
+      }
+      free(journal_origin);
+      free(journal_dirty);
+    }
     memset(od->file[TEMP_MOLFILE]->name, 0, BUF_LEN);
     remove(od->file[TEMP_MOLFILE]->name);
     remove_recursive(buffer);
@@ -0,0 +1,349 @@
+/*
+
+resample_grid.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+fill the interpolation stencil along one axis: for each
+node of od->grid, the index of the source nodes which
+contribute to it and their weights are stored in index
+and weight (taps entries per node), while outside is set
+if the node lies beyond the source grid boundaries
+*/
+static void build_axis_stencil(O3Data *od, int axis, int taps,
+  int *index, double *weight, unsigned char *outside)
+{
+  int n;
+  int t;
+  int i0;
+  int src_nodes;
+  double coord;
+  double pos;
+  double f;
+  
+  
+  src_nodes = od->newgrid.nodes[axis];
+  for (n = 0; n < od->grid.nodes[axis]; ++n) {
+    coord = (double)(od->grid.start_coord[axis])
+      + (double)n * (double)(od->grid.step[axis]);
+    pos = (src_nodes > 1) ? (coord - (double)(od->newgrid.start_coord[axis]))
+      / (double)(od->newgrid.step[axis]) : 0.0;
+    outside[n] = (((coord - (double)(od->newgrid.start_coord[axis])) < -1.0e-03)
+      || ((coord - ((double)(od->newgrid.start_coord[axis])
+      + (double)(src_nodes - 1) * (double)(od->newgrid.step[axis]))) > 1.0e-03));
+    if (pos < 0.0) {
+      pos = 0.0;
+    }
+    if (pos > (double)(src_nodes - 1)) {
+      pos = (double)(src_nodes - 1);
+    }
+    i0 = (int)floor(pos);
+    if (i0 > (src_nodes - 2)) {
+      i0 = ((src_nodes > 1) ? src_nodes - 2 : 0);
+    }
+    f = pos - (double)i0;
+    if (taps == 2) {
+      index[n * taps] = i0;
+      index[n * taps + 1] = ((src_nodes > 1) ? i0 + 1 : i0);
+      weight[n * taps] = 1.0 - f;
+      weight[n * taps + 1] = f;
+    }
+    else {
+      /*
+      cubic convolution (Catmull-Rom); source nodes
+      beyond the edges are replaced by the edge nodes
+      */
+      for (t = 0; t < 4; ++t) {
+        index[n * taps + t] = i0 - 1 + t;
+        if (index[n * taps + t] < 0) {
+          index[n * taps + t] = 0;
+        }
+        if (index[n * taps + t] > (src_nodes - 1)) {
+          index[n * taps + t] = src_nodes - 1;
+        }
+      }
+      weight[n * taps] = ((-0.5 * f + 1.0) * f - 0.5) * f;
+      weight[n * taps + 1] = (1.5 * f - 2.5) * f * f + 1.0;
+      weight[n * taps + 2] = ((-1.5 * f + 2.0) * f + 0.5) * f;
+      weight[n * taps + 3] = (0.5 * f - 0.5) * f * f;
+    }
+  }
+}
+
+
+float *alloc_resample_buffer(O3Data *od, int object_num,
+  int initial_field_num, int n_fields)
+{
+  /*
+  the source grid is od->newgrid; the buffer holds
+  n_fields source grids (one for each field held by
+  the file), each stored as od->grid with x varying
+  fastest. Objects other than the first must provide
+  as many fields as the first one did
+  */
+  if (object_num) {
+    n_fields = od->field_num - initial_field_num;
+  }
+  if (n_fields < 1) {
+    n_fields = 1;
+  }
+  
+  return (float *)calloc((size_t)n_fields * (size_t)(od->newgrid.nodes[0]
+    * od->newgrid.nodes[1] * od->newgrid.nodes[2]), sizeof(float));
+}
+
+
+int set_imported_x_value(O3Data *od, float *src_value, int field_num,
+  int initial_field_num, int object_num, VarCoord *varcoord, double value)
+{
+  /*
+  if grid data are being resampled, values read
+  from the file are collected in src_value,
+  otherwise they are stored straight away
+  */
+  if (src_value) {
+    src_value[(field_num - initial_field_num) * od->newgrid.nodes[0]
+      * od->newgrid.nodes[1] * od->newgrid.nodes[2]
+      + newgrid_xyz_to_var(od, varcoord)] = (float)value;
+    
+    return 0;
+  }
+  
+  return set_x_value_xyz_unbuffered(od, field_num,
+    object_num, varcoord, value);
+}
+
+
+int resample_grid(O3Data *od, float *src_value, int interpolate,
+  int object_num, int initial_field_num)
+{
+  int i;
+  int j;
+  int k;
+  int n;
+  int t;
+  int taps;
+  int axis;
+  int field_num;
+  int result = 0;
+  int src_x_vars;
+  int src_plane_len;
+  int *index[3];
+  unsigned char missing;
+  unsigned char *outside[3];
+  unsigned char *plane_missing;
+  unsigned char *row_missing;
+  float *src;
+  float *src_plane;
+  float *z_plane;
+  double w;
+  double value;
+  double *plane_row;
+  double *weight[3];
+  double *plane;
+  double *row;
+  
+  
+  /*
+  map the values of object_num held in src_value,
+  which were sampled on od->newgrid, onto od->grid.
+  Interpolation is separable: each z plane of od->grid
+  is obtained by first combining whole source z planes,
+  then whole source rows and finally single source nodes,
+  so that the two inner passes are contiguous
+  multiply-add loops which compilers can vectorize.
+  The tricubic scheme is the Catmull-Rom spline, which
+  gives the same interpolant as the tricubic scheme used
+  by grid_write() with central difference derivatives.
+  Nodes lying outside the source grid are set as missing,
+  and so are nodes to which a missing source node
+  contributes with a non-zero weight; missing source
+  nodes are tracked in plane_missing and row_missing
+  rather than summed, lest they be mistaken for valid
+  values once scaled down by a small weight
+  */
+  for (axis = 0; axis < 3; ++axis) {
+    if ((od->newgrid.nodes[axis] < 1) || ((od->newgrid.nodes[axis] > 1)
+      && (od->newgrid.step[axis] <= 0.0))) {
+      od->newgrid.object_num = object_num;
+      return GRID_NOT_MATCHING;
+    }
+  }
+  taps = ((interpolate == TRICUBIC_INTERPOLATION) ? 4 : 2);
+  src_plane_len = od->newgrid.nodes[0] * od->newgrid.nodes[1];
+  src_x_vars = src_plane_len * od->newgrid.nodes[2];
+  memset(index, 0, 3 * sizeof(int *));
+  memset(weight, 0, 3 * sizeof(double *));
+  memset(outside, 0, 3 * sizeof(unsigned char *));
+  plane = (double *)malloc(src_plane_len * sizeof(double));
+  row = (double *)malloc(od->newgrid.nodes[0] * sizeof(double));
+  plane_missing = (unsigned char *)malloc(src_plane_len);
+  row_missing = (unsigned char *)malloc(od->newgrid.nodes[0]);
+  z_plane = (float *)malloc(od->grid.nodes[0]
+    * od->grid.nodes[1] * sizeof(float));
+  for (axis = 0; axis < 3; ++axis) {
+    index[axis] = (int *)malloc(od->grid.nodes[axis] * taps * sizeof(int));
+    weight[axis] = (double *)malloc(od->grid.nodes[axis] * taps * sizeof(double));
+    outside[axis] = (unsigned char *)malloc(od->grid.nodes[axis]);
+    if (!(index[axis] && weight[axis] && outside[axis])) {
+      result = OUT_OF_MEMORY;
+    }
+  }
+  if (!(plane && row && z_plane && plane_missing && row_missing)) {
+    result = OUT_OF_MEMORY;
+  }
+  if (!result) {
+    for (axis = 0; axis < 3; ++axis) {
+      build_axis_stencil(od, axis, taps,
+        index[axis], weight[axis], outside[axis]);
+    }
+  }
+  for (field_num = initial_field_num; (!result)
+    && (field_num < od->field_num); ++field_num) {
+    src = &src_value[(field_num - initial_field_num) * src_x_vars];
+    for (k = 0; (!result) && (k < od->grid.nodes[2]); ++k) {
+      if (outside[2][k]) {
+        for (n = 0; n < (od->grid.nodes[0] * od->grid.nodes[1]); ++n) {
+          z_plane[n] = (float)MISSING_VALUE;
+        }
+        result = set_x_z_plane_unbuffered(od,
+          field_num, object_num, k, z_plane);
+        continue;
+      }
+      /*
+      combine source z planes
+      */
+      memset(plane, 0, src_plane_len * sizeof(double));
+      memset(plane_missing, 0, src_plane_len);
+      for (t = 0; t < taps; ++t) {
+        w = weight[2][k * taps + t];
+        if (w == 0.0) {
+          continue;
+        }
+        src_plane = &src[index[2][k * taps + t] * src_plane_len];
+        for (n = 0; n < src_plane_len; ++n) {
+          if (MISSING(src_plane[n])) {
+            plane_missing[n] = 1;
+            continue;
+          }
+          plane[n] += w * (double)src_plane[n];
+        }
+      }
+      for (j = 0; j < od->grid.nodes[1]; ++j) {
+        if (outside[1][j]) {
+          for (i = 0; i < od->grid.nodes[0]; ++i) {
+            z_plane[j * od->grid.nodes[0] + i] = (float)MISSING_VALUE;
+          }
+          continue;
+        }
+        /*
+        combine source rows
+        */
+        memset(row, 0, od->newgrid.nodes[0] * sizeof(double));
+        memset(row_missing, 0, od->newgrid.nodes[0]);
+        for (t = 0; t < taps; ++t) {
+          w = weight[1][j * taps + t];
+          if (w == 0.0) {
+            continue;
+          }
+          n = index[1][j * taps + t] * od->newgrid.nodes[0];
+          plane_row = &plane[n];
+          for (i = 0; i < od->newgrid.nodes[0]; ++i) {
+            row_missing[i] |= plane_missing[n + i];
+            row[i] += w * plane_row[i];
+          }
+        }
+        /*
+        combine source nodes; if a missing source
+        value contributed, the result is missing too
+        */
+        for (i = 0; i < od->grid.nodes[0]; ++i) {
+          value = 0.0;
+          missing = outside[0][i];
+          for (t = 0; t < taps; ++t) {
+            w = weight[0][i * taps + t];
+            if (w == 0.0) {
+              continue;
+            }
+            missing |= row_missing[index[0][i * taps + t]];
+            value += w * row[index[0][i * taps + t]];
+          }
+          if (missing) {
+            value = MISSING_VALUE;
+          }
+          z_plane[j * od->grid.nodes[0] + i] = (float)value;
+        }
+      }
+      result = set_x_z_plane_unbuffered(od,
+        field_num, object_num, k, z_plane);
+    }
+  }
+  for (axis = 0; axis < 3; ++axis) {
+    if (index[axis]) {
+      free(index[axis]);
+    }
+    if (weight[axis]) {
+      free(weight[axis]);
+    }
+    if (outside[axis]) {
+      free(outside[axis]);
+    }
+  }
+  if (plane) {
+    free(plane);
+  }
+  if (row) {
+    free(row);
+  }
+  if (plane_missing) {
+    free(plane_missing);
+  }
+  if (row_missing) {
+    free(row_missing);
+  }
+  if (z_plane) {
+    free(z_plane);
+  }
+  
+  return result;
+}
@@ -206,16 +206,8 @@ int save_dat(O3Data *od, int file_id)
       */
       mol_len = 0;
       if (!field_num) {
-        sprintf(mol_fd.name, "%s%c%04d.mol", od->field.mol_dir,
-          SEPARATOR, od->al.mol_info[j]->object_id);
-        mol_fd.handle = fopen(mol_fd.name, "rb");
-        if (mol_fd.handle) {
-          actual_len = LARGE_BUF_LEN;
-          while (actual_len == LARGE_BUF_LEN) {
-            actual_len = fread(buffer, 1, LARGE_BUF_LEN, mol_fd.handle);
-            mol_len += actual_len;
-          }
-          rewind(mol_fd.handle);
+        if (!open_mol_record(od, &mol_fd, j)) {
+          mol_len = od->al.mol_info[j]->mol_len;
         }
       }
       actual_len = fzwrite(&mol_len, sizeof(int), 1, dat_out);
@@ -224,18 +216,17 @@ int save_dat(O3Data *od, int file_id)
       }
       if (!field_num) {
         if (mol_fd.handle) {
-          actual_len = LARGE_BUF_LEN;
-          while (actual_len == LARGE_BUF_LEN) {
-            mol_len = fread(buffer, 1, LARGE_BUF_LEN, mol_fd.handle);
-            if (mol_len > 0) {
-              actual_len = fzwrite(buffer, 1, mol_len, dat_out);
-              if (actual_len != mol_len) {
-                return PREMATURE_DAT_EOF;
-              }
+          while (mol_len > 0) {
+            to_be_read = ((mol_len > LARGE_BUF_LEN) ? LARGE_BUF_LEN : mol_len);
+            actual_len = fread(buffer, 1, to_be_read, mol_fd.handle);
+            if (actual_len != to_be_read) {
+              return PREMATURE_DAT_EOF;
             }
-            else {
-              break;
+            actual_len = fzwrite(buffer, 1, to_be_read, dat_out);
+            if (actual_len != to_be_read) {
+              return PREMATURE_DAT_EOF;
             }
+            mol_len -= to_be_read;
           }
           fclose(mol_fd.handle);
           mol_fd.handle = NULL;
@@ -319,34 +310,25 @@ int save_dat(O3Data *od, int file_id)
       write MOL information
       */
       mol_len = 0;
-      sprintf(mol_fd.name, "%s%c%04d.mol", od->field.mol_dir,
-        SEPARATOR, od->al.mol_info[j]->object_id);
-      mol_fd.handle = fopen(mol_fd.name, "rb");
-      if (mol_fd.handle) {
-        actual_len = LARGE_BUF_LEN;
-        while (actual_len == LARGE_BUF_LEN) {
-          actual_len = fread(buffer, 1, LARGE_BUF_LEN, mol_fd.handle);
-          mol_len += actual_len;
-        }
-        rewind(mol_fd.handle);
+      if (!open_mol_record(od, &mol_fd, j)) {
+        mol_len = od->al.mol_info[j]->mol_len;
       }
       actual_len = fzwrite(&mol_len, sizeof(int), 1, dat_out);
       if (actual_len != 1) {
         return PREMATURE_DAT_EOF;
       }
       if (mol_fd.handle) {
-        actual_len = LARGE_BUF_LEN;
-        while (actual_len == LARGE_BUF_LEN) {
-          mol_len = fread(buffer, 1, LARGE_BUF_LEN, mol_fd.handle);
-          if (mol_len > 0) {
-            actual_len = fzwrite(buffer, 1, mol_len, dat_out);
-            if (actual_len != mol_len) {
-              return PREMATURE_DAT_EOF;
-            }
+        while (mol_len > 0) {
+          to_be_read = ((mol_len > LARGE_BUF_LEN) ? LARGE_BUF_LEN : mol_len);
+          actual_len = fread(buffer, 1, to_be_read, mol_fd.handle);
+          if (actual_len != to_be_read) {
+            return PREMATURE_DAT_EOF;
           }
-          else {
-            break;
+          actual_len = fzwrite(buffer, 1, to_be_read, dat_out);
+          if (actual_len != to_be_read) {
+            return PREMATURE_DAT_EOF;
           }
+          mol_len -= to_be_read;
         }
         fclose(mol_fd.handle);
         mol_fd.handle = NULL;
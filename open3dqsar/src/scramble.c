@@ -49,7 +49,6 @@ int prepare_scrambling(O3Data *od)
   int j;
   int k;
   int n;
-  int x;
   int y;
   int object_num;
   int struct_num;
@@ -57,16 +56,7 @@ int prepare_scrambling(O3Data *od)
   int conf_num;
   int n_conf;
   int active_struct_count;
-  int actual_len;
   int found;
-  int top_outgap_len;
-  int bottom_outgap_len;
-  int bins;
-  int structs_per_bin;
-  int excess_structs;
-  int random_index;
-  int positions_to_be_assigned;
-  int start;
   double sumweight;
   
   
@@ -189,66 +179,82 @@ int prepare_scrambling(O3Data *od)
     return OUT_OF_MEMORY;
   }
   /*
-  create a temporary file to store scrambled orders
-  */
-  /*
-  write the initial order of objects
+  scrambled orders are not generated here; each scrambling
+  draws one random number per active structure, so the
+  generator state is saved and then moved on as if all
+  orders had been drawn
   */
-  actual_len = fwrite(od->pel.scrambling_order->pe,
-    sizeof(int), active_struct_num,
-    od->file[TEMP_SCRAMBLE]->handle);
-  if (actual_len != active_struct_num) {
-    return CANNOT_WRITE_TEMP_FILE;
-  }
   set_random_seed(od, od->random_seed);
-  for (bins = od->scramble.max_bins;
-    bins >= od->scramble.min_bins; --bins) {
-    structs_per_bin = active_struct_num / bins;
-    excess_structs = active_struct_num % bins;
-    top_outgap_len = (bins - excess_structs) / 2;
-    bottom_outgap_len = top_outgap_len;
-    if ((bins - excess_structs) % 2) {
-      ++top_outgap_len;
-    }
-    for (j = 0; j < bins; ++j) {
-      od->mel.bin_populations[j] = structs_per_bin;
-    }
-    for (j = top_outgap_len; j < (bins - bottom_outgap_len); ++j) {
-      ++(od->mel.bin_populations[j]);
+  memcpy(&(od->scramble.order_stream), &(od->mt_stream), sizeof(RandomStream));
+  skip_genrand_stream(&(od->mt_stream),
+    (unsigned long)(od->scramble.overall_scramblings)
+    * (unsigned long)active_struct_num);
+  
+  return 0;
+}
+
+
+/*
+draw the scrambled order of objects for a given scrambling
+run; random numbers are picked from the stream saved by
+prepare_scrambling() jumping ahead to the first number
+belonging to that run, so each order only depends on the
+random seed and on the run number
+*/
+void get_scrambling_order(O3Data *od, int scramble_run)
+{
+  int j;
+  int k;
+  int n;
+  int x;
+  int start;
+  int random_index;
+  int positions_to_be_assigned;
+  int top_outgap_len;
+  int bottom_outgap_len;
+  int bins;
+  int structs_per_bin;
+  int excess_structs;
+  int active_struct_num;
+  RandomStream rs;
+  
+  
+  active_struct_num = od->pel.scrambling_order->size;
+  bins = od->scramble.max_bins - scramble_run / od->scramble.scramblings;
+  structs_per_bin = active_struct_num / bins;
+  excess_structs = active_struct_num % bins;
+  top_outgap_len = (bins - excess_structs) / 2;
+  bottom_outgap_len = top_outgap_len;
+  if ((bins - excess_structs) % 2) {
+    ++top_outgap_len;
+  }
+  for (j = 0; j < bins; ++j) {
+    od->mel.bin_populations[j] = structs_per_bin;
+  }
+  for (j = top_outgap_len; j < (bins - bottom_outgap_len); ++j) {
+    ++(od->mel.bin_populations[j]);
+  }
+  memcpy(&rs, &(od->scramble.order_stream), sizeof(RandomStream));
+  skip_genrand_stream(&rs,
+    (unsigned long)scramble_run * (unsigned long)active_struct_num);
+  for (k = 0, x = 0, start = 0; k < bins; ++k) {
+    for (n = 0; n < od->mel.bin_populations[k]; ++n) {
+      od->mel.candidate_pos[n] = n;
     }
-    for (j = 0; j < od->scramble.scramblings; ++j) {
-      x = 0;
-      for (k = 0; k < bins; ++k) {
-        for (n = 0; n < od->mel.bin_populations[k]; ++n) {
-          od->mel.candidate_pos[n] = n;
-        }
-        positions_to_be_assigned = od->mel.bin_populations[k];
-        for (n = 0, start = 0; n < k; ++n) {
-          start += od->mel.bin_populations[n];
-        }
-        while (positions_to_be_assigned) {
-          random_index = (int)safe_rint
-            ((double)(positions_to_be_assigned - 1) * genrand_real(od));
-          --positions_to_be_assigned;
-          od->pel.scrambling_temp->pe[x] = od->pel.scrambling_order->pe
-            [start + od->mel.candidate_pos[random_index]];
-          ++x;
-          for (n = random_index; n < positions_to_be_assigned; ++n) {
-            od->mel.candidate_pos[n] = od->mel.candidate_pos[n + 1];
-          }
-        }
-      }
-      actual_len = fwrite(od->pel.scrambling_temp->pe,
-        sizeof(int), active_struct_num,
-        od->file[TEMP_SCRAMBLE]->handle);
-      if (actual_len != active_struct_num) {
-        return CANNOT_WRITE_TEMP_FILE;
+    positions_to_be_assigned = od->mel.bin_populations[k];
+    while (positions_to_be_assigned) {
+      random_index = (int)safe_rint
+        ((double)(positions_to_be_assigned - 1) * genrand_stream_real(&rs));
+      --positions_to_be_assigned;
+      od->pel.scrambling_temp->pe[x] = od->pel.scrambling_order->pe
+        [start + od->mel.candidate_pos[random_index]];
+      ++x;
+      for (n = random_index; n < positions_to_be_assigned; ++n) {
+        od->mel.candidate_pos[n] = od->mel.candidate_pos[n + 1];
       }
     }
+    start += od->mel.bin_populations[k];
   }
-  rewind(od->file[TEMP_SCRAMBLE]->handle);
-  
-  return 0;
 }
 
 
@@ -261,6 +267,7 @@ int scramble(O3Data *od, int pc_num)
   int x;
   int result;
   int scramble_run;
+  int parallel;
   int info;
   #if (!defined HAVE_LIBLAPACK_ATLAS) && (!defined HAVE_LIBSUNPERF)
   int lwork;
@@ -337,6 +344,12 @@ int scramble(O3Data *od, int pc_num)
   if (result) {
     return OUT_OF_MEMORY;
   }
+  /*
+  CV runs are carried out in parallel by local
+  threads or by connected worker processes
+  */
+  accept_workers(od);
+  parallel = ((od->n_proc > 1) || use_workers(od, SCRAMBLE_CV_MODEL));
   scramble_run = 0;
   if (od->scramble.print_runs) {
     tee_printf(od, "------------------------------------------------\n"
@@ -347,13 +360,13 @@ int scramble(O3Data *od, int pc_num)
   for (bins = od->scramble.max_bins;
     bins >= od->scramble.min_bins; --bins) {
     for (j = 0; j < od->scramble.scramblings; ++j) {
-      result = fill_y_matrix_scrambled(od);
+      result = fill_y_matrix_scrambled(od, scramble_run);
       if (result) {
         return result;
       }
       memset(od->mal.ave_press->base, 0, od->mal.ave_press->m
         * od->mal.ave_press->n * sizeof(double));
-      if (od->n_proc > 1) {
+      if (parallel) {
         result = parallel_cv(od, od->overall_active_x_vars,
           pc_num, PARALLEL_CV | SCRAMBLE_CV_MODEL,
           od->scramble.cv_type, od->scramble.groups,
@@ -551,6 +564,7 @@ int scramble(O3Data *od, int pc_num)
     double_mat_free(od->mal.large_e_mat_ave);
     od->mal.large_e_mat_ave = NULL;
   }
+  free_large_mat_sum(od);
   if (od->mel.bin_populations) {
     free(od->mel.bin_populations);
     od->mel.bin_populations = NULL;
@@ -559,7 +573,7 @@ int scramble(O3Data *od, int pc_num)
     free(od->mel.candidate_pos);
     od->mel.candidate_pos = NULL;
   }
-  if (od->n_proc > 1) {
+  if (parallel) {
     free_parallel_cv(od, od->mel.thread_info,
       SCRAMBLE_CV_MODEL, od->scramble.cv_type,
       od->scramble.runs);
@@ -46,15 +46,20 @@ E-mail: paolo.tosco@unito.it
 void set_field_attr(O3Data *od,
   int field_num, uint16_t attr, int onoff)
 {
+  uint16_t old_attr;
+  
+  
+  old_attr = od->mel.field_attr[field_num];
   if (onoff) {
     od->mel.field_attr[field_num] =
-      (uint16_t)(od->mel.
-      field_attr[field_num] | attr);
+      (uint16_t)(old_attr | attr);
   }
   else {
     od->mel.field_attr[field_num] =
-      (uint16_t)(od->mel.
-      field_attr[field_num] & (~attr));
+      (uint16_t)(old_attr & (~attr));
+  }
+  if ((od->mel.field_attr[field_num] ^ old_attr) & MODEL_ATTR_MASK) {
+    ++(od->attr_generation);
   }
   update_field_object_attr(od, SILENT);
 }
@@ -62,15 +67,20 @@ void set_field_attr(O3Data *od,
 
 void set_object_attr(O3Data *od, int object_num, uint16_t attr, int onoff)
 {
+  uint16_t old_attr;
+  
+  
+  old_attr = od->mel.object_attr[object_num];
   if (onoff) {
     od->mel.object_attr[object_num] =
-      (uint16_t)(od->mel.
-      object_attr[object_num] | attr);
+      (uint16_t)(old_attr | attr);
   }
   else {
     od->mel.object_attr[object_num] =
-      (uint16_t)(od->mel.
-      object_attr[object_num] & (~attr));
+      (uint16_t)(old_attr & (~attr));
+  }
+  if ((od->mel.object_attr[object_num] ^ old_attr) & MODEL_ATTR_MASK) {
+    ++(od->attr_generation);
   }
   update_field_object_attr(od, SILENT);
 }
@@ -79,29 +89,39 @@ void set_object_attr(O3Data *od, int object_num, uint16_t attr, int onoff)
 void set_x_var_attr(O3Data *od, int field_num,
   int x_var, uint16_t attr, int onoff)
 {
+  uint16_t old_attr;
+  
+  
+  old_attr = od->mel.x_var_attr[field_num][x_var];
   if (onoff) {
     od->mel.x_var_attr[field_num][x_var] =
-      (uint16_t)(od->mel.
-      x_var_attr[field_num][x_var] | attr);
+      (uint16_t)(old_attr | attr);
   }
   else {
     od->mel.x_var_attr[field_num][x_var] =
-      (uint16_t)(od->mel.
-      x_var_attr[field_num][x_var] & (~attr));
+      (uint16_t)(old_attr & (~attr));
+  }
+  if ((od->mel.x_var_attr[field_num][x_var] ^ old_attr) & MODEL_ATTR_MASK) {
+    ++(od->attr_generation);
   }
 }
 
 
 void set_y_var_attr(O3Data *od, int y_var, uint16_t attr, int onoff)
 {
+  uint16_t old_attr;
+  
+  
+  old_attr = od->mel.y_var_attr[y_var];
   if (onoff) {
     od->mel.y_var_attr[y_var] =
-      (uint16_t)(od->mel.
-      y_var_attr[y_var] | attr);
+      (uint16_t)(old_attr | attr);
   }
   else {
     od->mel.y_var_attr[y_var] =
-      (uint16_t)(od->mel.
-      y_var_attr[y_var] & (~attr));  
+      (uint16_t)(old_attr & (~attr));
+  }
+  if ((od->mel.y_var_attr[y_var] ^ old_attr) & MODEL_ATTR_MASK) {
+    ++(od->attr_generation);
   }
 }
@@ -127,6 +127,9 @@ int set_x_value(O3Data *od, int field_num,
   }
   od->mel.x_var_array
     [field_num][object_num][x_var] = float_value;
+  if (od->mel.journal_dirty) {
+    od->mel.journal_dirty[field_num] = 1;
+  }
   
   return 0;
 }
@@ -168,6 +171,61 @@ int set_x_value_unbuffered(O3Data *od, int field_num,
     od->mel.x_var_array
       [field_num][object_num][x_var] = float_value;
   }
+  if (od->mel.journal_dirty) {
+    od->mel.journal_dirty[field_num] = 1;
+  }
+  
+  return 0;
+}
+
+
+int set_x_z_plane_unbuffered(O3Data *od, int field_num,
+  int object_num, int z, float *z_plane)
+{
+  int place;
+  int plane_len;
+  int actual_len;
+  
+  
+  /*
+  store a whole z plane of object_num at once;
+  x varies fastest within the plane
+  */
+  plane_len = od->grid.nodes[0] * od->grid.nodes[1];
+  place = od->object_pagesize * object_num
+    + z * plane_len * sizeof(float);
+  if (od->save_ram) {
+    if (od->mel.mutex) {
+      #ifndef WIN32
+      pthread_mutex_lock(od->mel.mutex);
+      #else
+      WaitForSingleObject(*(od->mel.mutex), INFINITE);
+      #endif
+    }
+    actual_len = 0;
+    if (!fseek(od->file[TEMP_FIELD_DATA + field_num]->handle,
+      place, SEEK_SET)) {
+      actual_len = fwrite(z_plane, sizeof(float), plane_len,
+        od->file[TEMP_FIELD_DATA + field_num]->handle);
+    }
+    if (od->mel.mutex) {
+      #ifndef WIN32
+      pthread_mutex_unlock(od->mel.mutex);
+      #else
+      ReleaseMutex(*(od->mel.mutex));
+      #endif
+    }
+    if (actual_len != plane_len) {
+      return CANNOT_WRITE_TEMP_FILE;
+    }
+  }
+  else {
+    memcpy(&(od->mel.x_var_array[field_num][object_num]
+      [z * plane_len]), z_plane, plane_len * sizeof(float));
+  }
+  if (od->mel.journal_dirty) {
+    od->mel.journal_dirty[field_num] = 1;
+  }
   
   return 0;
 }
@@ -52,6 +52,7 @@ void set_field_weight(O3Data *od, double weight)
       od->mel.x_data[i].x_weight_coefficient = weight;
     }
   }
+  ++(od->attr_generation);
 }
 
 
@@ -66,6 +67,7 @@ int set_object_weight(O3Data *od, double weight, int list_type, int options)
   
 
   memset(buffer, 0, BUF_LEN);
+  ++(od->attr_generation);
   if (!(list_type & (1 << FROM_FILE))) {
     for (object_num = 0; object_num < od->object_num; ++object_num) {
       struct_num = od->al.mol_info[object_num]->struct_num;
@@ -127,4 +129,5 @@ void set_y_var_weight(O3Data *od, double weight)
   for (i = 0; i < od->y_vars; ++i) {
     od->mel.y_data[i].y_weight_coefficient = weight;
   }
+  ++(od->attr_generation);
 }
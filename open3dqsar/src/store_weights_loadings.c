@@ -58,9 +58,9 @@ int store_weights_loadings(O3Data *od)
     return CANNOT_WRITE_TEMP_FILE;
   }
   actual_len = fwrite(od->mal.x_weights->base,
-    sizeof(double), od->mal.e_mat->n * (od->pc_num + 1),
+    sizeof(double), od->mal.x_weights->m * (od->pc_num + 1),
     od->file[TEMP_WLS]->handle);
-  if (actual_len != (od->mal.e_mat->n * (od->pc_num + 1))) {
+  if (actual_len != (od->mal.x_weights->m * (od->pc_num + 1))) {
     return CANNOT_WRITE_TEMP_FILE;
   }
 
@@ -70,9 +70,9 @@ int store_weights_loadings(O3Data *od)
     return CANNOT_WRITE_TEMP_FILE;
   }
   actual_len = fwrite(od->mal.x_loadings->base,
-    sizeof(double), od->mal.e_mat->n * (od->pc_num + 1),
+    sizeof(double), od->mal.x_loadings->m * (od->pc_num + 1),
     od->file[TEMP_WLS]->handle);
-  if (actual_len != (od->mal.e_mat->n * (od->pc_num + 1))) {
+  if (actual_len != (od->mal.x_loadings->m * (od->pc_num + 1))) {
     return CANNOT_WRITE_TEMP_FILE;
   }
 
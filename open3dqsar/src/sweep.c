@@ -0,0 +1,570 @@
+/*
+
+sweep.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+SWEEP fits and cross-validates one PLS model for each
+combination of CUTOFF, ZERO, SDCUT and scaling settings
+in a grid. Combinations are enumerated with the last
+stage varying fastest, so that consecutive combinations
+share the longest possible prefix of preprocessing stages:
+field data and attributes are saved as they are before
+each stage (x values go to a temporary file when
+O3_SAVE_RAM is set), and only the stages which follow the first
+changed setting are carried out again. One CV with the
+largest number of PCs yields q2 for all smaller PC numbers
+as well. The dataset is put back as it was before the
+sweep when all combinations have been evaluated.
+*/
+int parse_sweep_list(O3Data *od, int stage, int type, char *list)
+{
+  char buffer[BUF_LEN];
+  char *token;
+  char *context = NULL;
+  int n;
+  int setting_type;
+  double level;
+  
+  
+  memset(buffer, 0, BUF_LEN);
+  strncpy(buffer, list, BUF_LEN - 1);
+  n = 0;
+  token = strtok_r(buffer, ",", &context);
+  while (token) {
+    while (isspace(*token)) {
+      ++token;
+    }
+    level = 0.0;
+    if (!strncasecmp(token, "none", 4)) {
+      setting_type = SWEEP_NONE;
+    }
+    else if (stage == SWEEP_SCALE) {
+      if (!strncasecmp(token, "auto", 4)) {
+        setting_type = AUTO_SCALE;
+      }
+      else if (!strncasecmp(token, "buw", 3)) {
+        setting_type = BUW_SCALE;
+      }
+      else {
+        return INVALID_LIST_RANGE;
+      }
+    }
+    else {
+      if (sscanf(token, "%lf", &level) != 1) {
+        return INVALID_LIST_RANGE;
+      }
+      setting_type = type;
+    }
+    od->sweep.type[stage] = (int *)realloc
+      (od->sweep.type[stage], (n + 1) * sizeof(int));
+    od->sweep.level[stage] = (double *)realloc
+      (od->sweep.level[stage], (n + 1) * sizeof(double));
+    if (!(od->sweep.type[stage] && od->sweep.level[stage])) {
+      return OUT_OF_MEMORY;
+    }
+    od->sweep.type[stage][n] = setting_type;
+    od->sweep.level[stage][n] = level;
+    ++n;
+    token = strtok_r(NULL, ",", &context);
+  }
+  if (!n) {
+    return INVALID_LIST_RANGE;
+  }
+  od->sweep.n_settings[stage] = n;
+  
+  return 0;
+}
+
+
+static size_t sweep_state_len(O3Data *od)
+{
+  int i;
+  int operate_fields;
+  
+  
+  for (i = 0, operate_fields = 0; i < od->field_num; ++i) {
+    if (get_field_attr(od, i, OPERATE_BIT)) {
+      ++operate_fields;
+    }
+  }
+  
+  return (size_t)operate_fields * (size_t)(od->object_num)
+    * (size_t)(od->x_vars);
+}
+
+
+static int save_sweep_state(O3Data *od, int state, int copy_values)
+{
+  int i;
+  int j;
+  size_t pos;
+  
+  
+  if (!(od->sweep.x_data[state])) {
+    od->sweep.x_data[state] = (XData *)malloc
+      (od->field_num * sizeof(XData));
+    if (!(od->sweep.x_data[state])) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  memcpy(od->sweep.x_data[state], od->mel.x_data,
+    od->field_num * sizeof(XData));
+  /*
+  stages which only change field attributes
+  (SDCUT, BUW) do not need a copy of x values
+  */
+  od->sweep.has_values[state] = copy_values;
+  if (!copy_values) {
+    if (od->sweep.x_values[state]) {
+      free(od->sweep.x_values[state]);
+      od->sweep.x_values[state] = NULL;
+    }
+    return 0;
+  }
+  /*
+  if field data are kept on disk, x values are
+  saved in a temporary file with one slot per state
+  */
+  if (od->save_ram) {
+    if ((!(od->file[TEMP_SWEEP]->handle))
+      && open_temp_file(od, od->file[TEMP_SWEEP], "sweep")) {
+      return CANNOT_WRITE_TEMP_FILE;
+    }
+    if (fseek(od->file[TEMP_SWEEP]->handle, (long)(state
+      * sweep_state_len(od) * sizeof(float)), SEEK_SET)) {
+      return CANNOT_WRITE_TEMP_FILE;
+    }
+  }
+  else if (!(od->sweep.x_values[state])) {
+    od->sweep.x_values[state] = (float *)malloc
+      (sweep_state_len(od) * sizeof(float));
+    if (!(od->sweep.x_values[state])) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  for (i = 0, pos = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, OPERATE_BIT)) {
+      continue;
+    }
+    if (od->save_ram && check_mmap(od, i)) {
+      return OUT_OF_MEMORY;
+    }
+    for (j = 0; j < od->object_num; ++j) {
+      if (od->save_ram) {
+        if (fwrite(od->mel.x_var_array[i][j], sizeof(float), od->x_vars,
+          od->file[TEMP_SWEEP]->handle) != (size_t)(od->x_vars)) {
+          return CANNOT_WRITE_TEMP_FILE;
+        }
+        continue;
+      }
+      memcpy(&(od->sweep.x_values[state][pos]),
+        od->mel.x_var_array[i][j], od->x_vars * sizeof(float));
+      pos += od->x_vars;
+    }
+  }
+  
+  return 0;
+}
+
+
+static int restore_sweep_state(O3Data *od, int state)
+{
+  int i;
+  int j;
+  int values_state;
+  size_t pos;
+  
+  
+  /*
+  x values are taken from the last state
+  before this one which changed them
+  */
+  values_state = state;
+  while (!(od->sweep.has_values[values_state])) {
+    --values_state;
+  }
+  if (od->save_ram && fseek(od->file[TEMP_SWEEP]->handle, (long)(values_state
+    * sweep_state_len(od) * sizeof(float)), SEEK_SET)) {
+    return CANNOT_READ_TEMP_FILE;
+  }
+  for (i = 0, pos = 0; i < od->field_num; ++i) {
+    if (!get_field_attr(od, i, OPERATE_BIT)) {
+      continue;
+    }
+    if (od->save_ram && check_mmap(od, i)) {
+      return OUT_OF_MEMORY;
+    }
+    for (j = 0; j < od->object_num; ++j) {
+      if (od->save_ram) {
+        if (fread(od->mel.x_var_array[i][j], sizeof(float), od->x_vars,
+          od->file[TEMP_SWEEP]->handle) != (size_t)(od->x_vars)) {
+          return CANNOT_READ_TEMP_FILE;
+        }
+        continue;
+      }
+      memcpy(od->mel.x_var_array[i][j],
+        &(od->sweep.x_values[values_state][pos]),
+        od->x_vars * sizeof(float));
+      pos += od->x_vars;
+    }
+  }
+  memcpy(od->mel.x_data, od->sweep.x_data[state],
+    od->field_num * sizeof(XData));
+  
+  return calc_active_vars(od, CV_MODEL);
+}
+
+
+static int apply_sweep_stage(O3Data *od, int stage, int setting)
+{
+  int type;
+  double level;
+  
+  
+  type = od->sweep.type[stage][setting];
+  level = od->sweep.level[stage][setting];
+  if (type == SWEEP_NONE) {
+    return 0;
+  }
+  switch (stage) {
+    case SWEEP_CUTOFF:
+    return cutoff(od, type, level);
+    
+    case SWEEP_ZERO:
+    return zero(od, type, level);
+    
+    case SWEEP_SDCUT:
+    return sdcut(od, level);
+  }
+  
+  return ((type == AUTO_SCALE) ? autoscale_field(od) : x_var_buw(od));
+}
+
+
+static int sweep_fit(O3Data *od, DoubleVec *r2, int *pc_num)
+{
+  int i;
+  int pc;
+  int result;
+  int precision;
+  int cv_type;
+  int groups;
+  int runs;
+  
+  
+  *pc_num = 0;
+  cv_type = od->sweep.cv_type;
+  groups = od->sweep.groups;
+  runs = od->sweep.runs;
+  result = calc_active_vars(od, CV_MODEL);
+  if (result) {
+    return result;
+  }
+  pc = od->sweep.pc_num;
+  if (pc > od->overall_active_x_vars) {
+    pc = od->overall_active_x_vars;
+  }
+  if (pc < 1) {
+    return 0;
+  }
+  /*
+  full model, as in PLS; it is always
+  computed in double precision
+  */
+  od->mal.press = double_mat_resize(od->mal.press, pc + 1, od->y_vars);
+  if (!(od->mal.press)) {
+    return OUT_OF_MEMORY;
+  }
+  memset(od->mal.press->base, 0,
+    od->mal.press->m * od->mal.press->n * sizeof(double));
+  result = alloc_pls(od, od->overall_active_x_vars, pc, FULL_MODEL);
+  if (!result) {
+    result = fill_x_matrix(od, FULL_MODEL, 0);
+  }
+  if (!result) {
+    result = fill_y_matrix(od);
+  }
+  if (result) {
+    return OUT_OF_MEMORY;
+  }
+  trim_mean_center_matrix(od, od->mal.large_e_mat, NULL,
+    &(od->mal.e_mat), &(od->vel.e_mat_ave),
+    FULL_MODEL, od->active_object_num);
+  trim_mean_center_matrix(od, od->mal.large_f_mat, NULL,
+    &(od->mal.f_mat), &(od->vel.f_mat_ave),
+    FULL_MODEL, od->active_object_num);
+  precision = od->pls_precision;
+  od->pls_precision = PLS_DOUBLE_PRECISION;
+  pls(od, pc, FULL_MODEL);
+  od->pls_precision = precision;
+  pc = od->pc_num;
+  for (i = 0; i <= pc; ++i) {
+    r2->ve[i] = od->vel.r2->ve[i];
+  }
+  /*
+  CV, as in the CV keyword but without printout
+  */
+  memset(od->mal.press->base, 0,
+    od->mal.press->m * od->mal.press->n * sizeof(double));
+  result = alloc_pls(od, od->overall_active_x_vars, pc, CV_MODEL);
+  if (!result) {
+    result = fill_x_matrix(od, CV_MODEL, 0);
+  }
+  if (!result) {
+    result = fill_y_matrix(od);
+  }
+  if (!result) {
+    result = alloc_cv_sdep(od, pc, runs);
+  }
+  if (!result) {
+    result = calc_large_mat_sum(od, od->mal.large_e_mat,
+      &(od->mal.large_e_mat_sum));
+  }
+  if (!result) {
+    result = calc_large_mat_sum(od, od->mal.large_f_mat,
+      &(od->mal.large_f_mat_sum));
+  }
+  if ((!result) && (od->pls_algorithm == KERNEL_PLS)) {
+    result = prepare_kernel_cv(od);
+  }
+  if (!result) {
+    prepare_implicit_cv(od);
+    prepare_sp_cv(od);
+  }
+  if (result) {
+    return OUT_OF_MEMORY;
+  }
+  set_random_seed(od, od->random_seed);
+  result = prepare_cv(od, pc, cv_type, groups, runs);
+  if (!result) {
+    result = alloc_cv_pred(od, pc, cv_type);
+  }
+  if (!result) {
+    accept_workers(od);
+    if ((od->n_proc > 1) || use_workers(od, CV_MODEL | SILENT_PLS)) {
+      result = parallel_cv(od, od->overall_active_x_vars, pc,
+        PARALLEL_CV | CV_MODEL | SILENT_PLS, cv_type, groups, runs);
+      free_parallel_cv(od, od->mel.thread_info, CV_MODEL, cv_type, runs);
+    }
+    else {
+      if ((!(od->cv_pred.active))
+        && open_temp_file(od, od->file[TEMP_PRED], "pred_y")) {
+        result = CANNOT_WRITE_TEMP_FILE;
+      }
+      else {
+        result = cv(od, pc, CV_MODEL | SILENT_PLS,
+          cv_type, groups, runs);
+        if (od->file[TEMP_PRED]->handle) {
+          fclose(od->file[TEMP_PRED]->handle);
+          od->file[TEMP_PRED]->handle = NULL;
+        }
+      }
+      if (cv_type == LEAVE_MANY_OUT) {
+        free_cv_groups(od, runs);
+      }
+    }
+  }
+  free_kernel_cv(od);
+  od->cv.implicit_cv = 0;
+  od->cv.sp_cv = 0;
+  free_large_mat_sum(od);
+  if (!result) {
+    *pc_num = pc;
+  }
+  
+  return result;
+}
+
+
+static void print_sweep_setting(O3Data *od, int stage, int setting)
+{
+  int type;
+  
+  
+  type = od->sweep.type[stage][setting];
+  if (type == SWEEP_NONE) {
+    tee_printf(od, "%10s", "-");
+  }
+  else if (stage == SWEEP_SCALE) {
+    tee_printf(od, "%10s", ((type == AUTO_SCALE) ? "AUTO" : "BUW"));
+  }
+  else {
+    tee_printf(od, "%10.4lf", od->sweep.level[stage][setting]);
+  }
+}
+
+
+int sweep(O3Data *od)
+{
+  int i;
+  int n;
+  int stage;
+  int first_stage;
+  int conf;
+  int pc_num;
+  int result;
+  int best_conf = 0;
+  int best_pc = 0;
+  int setting[SWEEP_STAGES];
+  double best_q2 = 0.0;
+  DoubleVec *r2;
+  
+  
+  r2 = double_vec_alloc(od->sweep.pc_num + 1);
+  if (!r2) {
+    return OUT_OF_MEMORY;
+  }
+  /*
+  the journal is told about changes to field data by
+  set_x_value(); since the dataset will be put back as
+  it was, its dirty flags are saved now and restored later
+  */
+  if (od->mel.journal_dirty) {
+    od->sweep.journal_dirty = (unsigned char *)malloc(od->field_num);
+    if (!(od->sweep.journal_dirty)) {
+      double_vec_free(r2);
+      return OUT_OF_MEMORY;
+    }
+    memcpy(od->sweep.journal_dirty, od->mel.journal_dirty, od->field_num);
+  }
+  tee_printf(od, "%6s%10s%10s%10s%10s%10s%4s%12s%12s%12s\n",
+    "Conf", "CUTOFF", "ZERO", "SDCUT", "Scaling",
+    "Active x", "PC", "r2", "q2", "SDEP");
+  tee_printf(od, "--------------------------------------------------"
+    "----------------------------------------------\n");
+  tee_flush(od);
+  od->quiet = 1;
+  result = save_sweep_state(od, 0, 1);
+  memset(setting, 0, SWEEP_STAGES * sizeof(int));
+  first_stage = 0;
+  conf = 0;
+  while (!result) {
+    if (conf) {
+      result = restore_sweep_state(od, first_stage);
+    }
+    for (stage = first_stage; (!result) && (stage < SWEEP_STAGES); ++stage) {
+      result = apply_sweep_stage(od, stage, setting[stage]);
+      /*
+      the data as they are after the last stage
+      are never needed again
+      */
+      if ((!result) && (stage < (SWEEP_STAGES - 1))) {
+        result = save_sweep_state(od, stage + 1,
+          ((stage <= SWEEP_ZERO)
+          && (od->sweep.type[stage][setting[stage]] != SWEEP_NONE)));
+      }
+    }
+    if (!result) {
+      result = sweep_fit(od, r2, &pc_num);
+    }
+    if (result) {
+      break;
+    }
+    ++conf;
+    od->quiet = 0;
+    for (i = 1; i <= (pc_num ? pc_num : 1); ++i) {
+      tee_printf(od, "%6d", conf);
+      for (n = 0; n < SWEEP_STAGES; ++n) {
+        print_sweep_setting(od, n, setting[n]);
+      }
+      tee_printf(od, "%10d", od->overall_active_x_vars);
+      if (!pc_num) {
+        tee_printf(od, "%4s%12s%12s%12s\n", "-", "-", "-", "-");
+        continue;
+      }
+      tee_printf(od, "%4d%12.4lf%12.4lf%12.4lf\n", i, r2->ve[i],
+        od->vel.q2->ve[i], od->vel.ave_sdep->ve[i]);
+      if ((!best_conf) || (od->vel.q2->ve[i] > best_q2)) {
+        best_conf = conf;
+        best_pc = i;
+        best_q2 = od->vel.q2->ve[i];
+      }
+    }
+    tee_flush(od);
+    od->quiet = 1;
+    /*
+    move on to the next combination; the first stage whose
+    setting changes is the first one to be carried out again
+    */
+    for (stage = SWEEP_STAGES - 1; stage >= 0; --stage) {
+      ++setting[stage];
+      if (setting[stage] < od->sweep.n_settings[stage]) {
+        break;
+      }
+      setting[stage] = 0;
+    }
+    if (stage < 0) {
+      break;
+    }
+    first_stage = stage;
+  }
+  /*
+  put back the dataset as it was before the sweep
+  */
+  if (od->sweep.x_data[0] && od->sweep.has_values[0]) {
+    n = restore_sweep_state(od, 0);
+    if (!result) {
+      result = n;
+    }
+  }
+  od->quiet = 0;
+  if (od->sweep.journal_dirty) {
+    memcpy(od->mel.journal_dirty, od->sweep.journal_dirty, od->field_num);
+  }
+  if ((!result) && best_conf) {
+    tee_printf(od, "\nThe highest q2 (%.4lf) was obtained with "
+      "configuration %d and %d PC%s.\n\n", best_q2, best_conf,
+      best_pc, ((best_pc > 1) ? "s" : ""));
+  }
+  if (od->file[TEMP_SWEEP]->handle) {
+    fclose(od->file[TEMP_SWEEP]->handle);
+    od->file[TEMP_SWEEP]->handle = NULL;
+    remove(od->file[TEMP_SWEEP]->name);
+    memset(od->file[TEMP_SWEEP]->name, 0, BUF_LEN);
+  }
+  double_vec_free(r2);
+  free_sweep(od);
+  
+  return result;
+}
@@ -0,0 +1,258 @@
+/*
+
+task_queue.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+
+static double seconds_since(struct timeval *start)
+{
+  struct timeval now;
+  struct timeval from;
+  struct timeval elapsed;
+  
+  
+  /*
+  timeval_subtract() may modify its last argument,
+  so work on a copy of the starting time
+  */
+  memcpy(&from, start, sizeof(struct timeval));
+  gettimeofday(&now, NULL);
+  if (timeval_subtract(&elapsed, &now, &from)) {
+    return 0.0;
+  }
+  
+  return (double)(elapsed.tv_sec)
+    + (double)(elapsed.tv_usec) / (double)1.0e06;
+}
+
+
+/*
+tasks (CV runs, FFD design rows) are handed out one at a
+time to whichever thread asks first, so that threads which
+happen to get cheaper tasks keep on working instead of waiting
+for the others to complete a fixed share; the thread which ran
+each task and the position of that task in the sequence run by
+that thread are recorded, so that per-thread temporary files
+can be read back in task order
+*/
+int init_task_queue(O3Data *od, ThreadInfo **thread_info,
+  int n_threads, int n_tasks)
+{
+  int i;
+  TaskQueue *queue;
+  
+  
+  queue = &(od->queue);
+  queue->thread_num = alloc_int_array(queue->thread_num, n_tasks + 1);
+  queue->slot = alloc_int_array(queue->slot, n_tasks + 1);
+  queue->done = alloc_int_array(queue->done, n_tasks + 1);
+  queue->requeued = alloc_int_array(queue->requeued, n_tasks + 1);
+  if (!(queue->thread_num) || !(queue->slot)
+    || !(queue->done) || !(queue->requeued)) {
+    return OUT_OF_MEMORY;
+  }
+  queue->n_tasks = n_tasks;
+  queue->next_task = 0;
+  queue->stop_task = n_tasks;
+  queue->done_tasks = 0;
+  queue->n_requeued = 0;
+  #ifndef WIN32
+  pthread_mutex_init(&(queue->mutex), NULL);
+  #else
+  if (!(queue->mutex = CreateMutex(NULL, FALSE, NULL))) {
+    return CANNOT_CREATE_THREAD;
+  }
+  #endif
+  for (i = 0; i < n_threads; ++i) {
+    thread_info[i]->queue = queue;
+    thread_info[i]->n_calc = 0;
+    thread_info[i]->busy_time = 0.0;
+  }
+  gettimeofday(&(queue->start), NULL);
+  
+  return 0;
+}
+
+
+/*
+returns the next task to be run by this thread,
+or -1 when all tasks have been handed out
+(or no more tasks are needed); tasks given back
+by requeue_task() are handed out first
+*/
+int get_next_task(ThreadInfo *ti)
+{
+  int task;
+  TaskQueue *queue;
+  
+  
+  queue = ti->queue;
+  #ifndef WIN32
+  pthread_mutex_lock(&(queue->mutex));
+  #else
+  WaitForSingleObject(queue->mutex, INFINITE);
+  #endif
+  task = queue->stop_task;
+  while (queue->n_requeued && (task >= queue->stop_task)) {
+    --(queue->n_requeued);
+    task = queue->requeued[queue->n_requeued];
+  }
+  if (task >= queue->stop_task) {
+    task = queue->next_task;
+    if (task < queue->stop_task) {
+      ++(queue->next_task);
+    }
+  }
+  if (task < queue->stop_task) {
+    queue->thread_num[task] = ti->thread_num;
+    queue->slot[task] = ti->n_calc;
+  }
+  #ifndef WIN32
+  pthread_mutex_unlock(&(queue->mutex));
+  #else
+  ReleaseMutex(queue->mutex);
+  #endif
+  if (task < queue->stop_task) {
+    ++(ti->n_calc);
+    return task;
+  }
+  ti->busy_time = seconds_since(&(queue->start));
+  
+  return -1;
+}
+
+
+/*
+gives back a task which this thread could not carry
+out (e.g., because the worker process it was sent to
+was lost), so that another thread may pick it up
+*/
+void requeue_task(ThreadInfo *ti, int task)
+{
+  TaskQueue *queue;
+  
+  
+  queue = ti->queue;
+  #ifndef WIN32
+  pthread_mutex_lock(&(queue->mutex));
+  #else
+  WaitForSingleObject(queue->mutex, INFINITE);
+  #endif
+  queue->requeued[queue->n_requeued] = task;
+  ++(queue->n_requeued);
+  #ifndef WIN32
+  pthread_mutex_unlock(&(queue->mutex));
+  #else
+  ReleaseMutex(queue->mutex);
+  #endif
+  --(ti->n_calc);
+}
+
+
+/*
+to be called by LMO threads with runs=AUTO after each
+run; runs are checked for convergence in run order as soon
+as all of the previous ones are complete, and no further
+runs are handed out once the first converged sequence is
+found, so its length does not depend on the number of
+threads; the surplus runs which were already being carried
+out are discarded
+*/
+void complete_task(ThreadInfo *ti, int task)
+{
+  TaskQueue *queue;
+  
+  
+  queue = ti->queue;
+  #ifndef WIN32
+  pthread_mutex_lock(&(queue->mutex));
+  #else
+  WaitForSingleObject(queue->mutex, INFINITE);
+  #endif
+  queue->done[task] = 1;
+  while ((queue->done_tasks < queue->stop_task)
+    && queue->done[queue->done_tasks]) {
+    ++(queue->done_tasks);
+    if (check_lmo_convergence(&(ti->od),
+      queue->done_tasks, ti->pc_num)) {
+      queue->stop_task = queue->done_tasks;
+    }
+  }
+  #ifndef WIN32
+  pthread_mutex_unlock(&(queue->mutex));
+  #else
+  ReleaseMutex(queue->mutex);
+  #endif
+}
+
+
+/*
+to be called once all threads have been joined
+*/
+void close_task_queue(O3Data *od, ThreadInfo **thread_info, int n_threads)
+{
+  int i;
+  double total_time;
+  
+  
+  total_time = seconds_since(&(od->queue.start));
+  #ifndef WIN32
+  pthread_mutex_destroy(&(od->queue.mutex));
+  #else
+  CloseHandle(od->queue.mutex);
+  #endif
+  if (!(od->debug)) {
+    return;
+  }
+  tee_printf(od, "\n%6s%12s%12s%12s\n", "Thread", "Tasks", "Busy (s)", "Idle (s)");
+  tee_printf(od, "------------------------------------------\n");
+  for (i = 0; i < n_threads; ++i) {
+    tee_printf(od, "%6d%12d%12.4lf%12.4lf\n", i + 1,
+      thread_info[i]->n_calc, thread_info[i]->busy_time,
+      total_time - thread_info[i]->busy_time);
+  }
+  tee_printf(od, "\n");
+  tee_flush(od);
+}
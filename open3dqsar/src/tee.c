@@ -88,7 +88,14 @@ void tee_printf(O3Data *od, char *fmt, ...)
 {
   int i;
   FILE *out_stream[2];
-  
+
+  /*
+  SWEEP runs preprocessing and PLS functions on
+  the user's behalf without their usual printout
+  */
+  if (od->quiet) {
+    return;
+  }
   out_stream[0] =  ((od->prompt || (!(od->out))) ? stdout : NULL);
   out_stream[1] = od->out;
   va_list arg;
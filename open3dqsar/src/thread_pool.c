@@ -0,0 +1,261 @@
+/*
+
+thread_pool.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+
+/*
+worker threads are started the first time they are needed
+and then kept parked on a condition variable until the next
+job is posted; each job runs the supplied thread function
+once on each of the first n_jobs ThreadInfo structures,
+exactly as if a new thread had been created for each of them
+*/
+#ifndef WIN32
+static void *thread_pool_worker(void *pointer)
+#else
+static DWORD thread_pool_worker(void *pointer)
+#endif
+{
+  ThreadPoolWorker *worker;
+  ThreadPool *pool;
+  
+  
+  worker = (ThreadPoolWorker *)pointer;
+  pool = worker->pool;
+  #ifndef WIN32
+  pthread_mutex_lock(&(pool->mutex));
+  #else
+  EnterCriticalSection(&(pool->mutex));
+  #endif
+  while (1) {
+    while ((!(pool->quit)) && (pool->generation == worker->generation)) {
+      #ifndef WIN32
+      pthread_cond_wait(&(pool->wake), &(pool->mutex));
+      #else
+      SleepConditionVariableCS(&(pool->wake), &(pool->mutex), INFINITE);
+      #endif
+    }
+    if (pool->quit) {
+      break;
+    }
+    worker->generation = pool->generation;
+    if (worker->num >= pool->n_jobs) {
+      continue;
+    }
+    #ifndef WIN32
+    pthread_mutex_unlock(&(pool->mutex));
+    ((void *(*)(void *))(pool->job))
+      ((void *)(pool->thread_info[worker->num]));
+    pthread_mutex_lock(&(pool->mutex));
+    #else
+    LeaveCriticalSection(&(pool->mutex));
+    ((LPTHREAD_START_ROUTINE)(pool->job))
+      ((void *)(pool->thread_info[worker->num]));
+    EnterCriticalSection(&(pool->mutex));
+    #endif
+    --(pool->pending);
+    if (!(pool->pending)) {
+      #ifndef WIN32
+      pthread_cond_signal(&(pool->done));
+      #else
+      WakeConditionVariable(&(pool->done));
+      #endif
+    }
+  }
+  #ifndef WIN32
+  pthread_mutex_unlock(&(pool->mutex));
+  
+  return NULL;
+  #else
+  LeaveCriticalSection(&(pool->mutex));
+  
+  return 0;
+  #endif
+}
+
+
+/*
+the pool is shared by od and by the ThreadInfo copies of od,
+hence it is allocated by alloc_threads() before they are filled
+*/
+int alloc_thread_pool(O3Data *od)
+{
+  ThreadPool *pool;
+  
+  
+  if (od->pool) {
+    return 0;
+  }
+  pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+  if (!pool) {
+    return OUT_OF_MEMORY;
+  }
+  #ifndef WIN32
+  pthread_mutex_init(&(pool->mutex), NULL);
+  pthread_cond_init(&(pool->wake), NULL);
+  pthread_cond_init(&(pool->done), NULL);
+  #else
+  InitializeCriticalSection(&(pool->mutex));
+  InitializeConditionVariable(&(pool->wake));
+  InitializeConditionVariable(&(pool->done));
+  #endif
+  od->pool = pool;
+  
+  return 0;
+}
+
+
+/*
+runs job on od->mel.thread_info[0 .. n_threads - 1]
+and returns when all of them have completed; while the
+job runs, the BLAS library is restricted to its share
+of the CPUs, which is given back to serial code afterwards.
+Only one job may run at a time, so a job cannot in turn
+post a job to the pool
+*/
+int run_thread_pool(O3Data *od, void *job, int n_threads)
+{
+  int result = 0;
+  ThreadPool *pool;
+  ThreadPoolWorker *worker;
+  
+  
+  pool = od->pool;
+  #ifndef WIN32
+  pthread_mutex_lock(&(pool->mutex));
+  #else
+  EnterCriticalSection(&(pool->mutex));
+  #endif
+  if (pool->pending) {
+    od->error_code = EBUSY;
+    result = CANNOT_CREATE_THREAD;
+  }
+  while ((!result) && (pool->n_workers < n_threads)) {
+    worker = &(pool->worker[pool->n_workers]);
+    worker->num = pool->n_workers;
+    worker->generation = pool->generation;
+    worker->pool = pool;
+    #ifndef WIN32
+    if (pthread_create(&(pool->thread_id[pool->n_workers]), NULL,
+      thread_pool_worker, (void *)worker)) {
+      result = CANNOT_CREATE_THREAD;
+    }
+    #else
+    if (!(pool->thread_handle[pool->n_workers] = CreateThread(NULL, 0,
+      (LPTHREAD_START_ROUTINE)thread_pool_worker,
+      (void *)worker, 0, NULL))) {
+      result = CANNOT_CREATE_THREAD;
+    }
+    #endif
+    if (!result) {
+      ++(pool->n_workers);
+    }
+  }
+  if (!result) {
+    set_blas_threads(od, n_threads);
+    pool->job = job;
+    pool->thread_info = od->mel.thread_info;
+    pool->n_jobs = n_threads;
+    pool->pending = n_threads;
+    ++(pool->generation);
+    #ifndef WIN32
+    pthread_cond_broadcast(&(pool->wake));
+    while (pool->pending) {
+      pthread_cond_wait(&(pool->done), &(pool->mutex));
+    }
+    #else
+    WakeAllConditionVariable(&(pool->wake));
+    while (pool->pending) {
+      SleepConditionVariableCS(&(pool->done), &(pool->mutex), INFINITE);
+    }
+    #endif
+    set_blas_threads(od, 1);
+  }
+  #ifndef WIN32
+  pthread_mutex_unlock(&(pool->mutex));
+  #else
+  LeaveCriticalSection(&(pool->mutex));
+  #endif
+  
+  return result;
+}
+
+
+void free_thread_pool(O3Data *od)
+{
+  int i;
+  ThreadPool *pool;
+  
+  
+  pool = od->pool;
+  if (!pool) {
+    return;
+  }
+  #ifndef WIN32
+  pthread_mutex_lock(&(pool->mutex));
+  pool->quit = 1;
+  pthread_cond_broadcast(&(pool->wake));
+  pthread_mutex_unlock(&(pool->mutex));
+  for (i = 0; i < pool->n_workers; ++i) {
+    pthread_join(pool->thread_id[i], NULL);
+  }
+  pthread_cond_destroy(&(pool->wake));
+  pthread_cond_destroy(&(pool->done));
+  pthread_mutex_destroy(&(pool->mutex));
+  #else
+  EnterCriticalSection(&(pool->mutex));
+  pool->quit = 1;
+  WakeAllConditionVariable(&(pool->wake));
+  LeaveCriticalSection(&(pool->mutex));
+  for (i = 0; i < pool->n_workers; ++i) {
+    WaitForSingleObject(pool->thread_handle[i], INFINITE);
+    CloseHandle(pool->thread_handle[i]);
+  }
+  DeleteCriticalSection(&(pool->mutex));
+  #endif
+  free(pool);
+  od->pool = NULL;
+}
@@ -42,17 +42,13 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
-void trim_mean_center_matrix(O3Data *od, DoubleMat *large_mat, DoubleMat **mat,
-  DoubleVec **mat_ave, int model_type, int active_object_num)
+void trim_mean_center_matrix(O3Data *od, DoubleMat *large_mat, DoubleMat *large_mat_sum,
+  DoubleMat **mat, DoubleVec **mat_ave, int model_type, int active_object_num)
 {
+  int i;
   int y;
   int x;
-  int real_y;
-  int n;
   int object_num;
-  int struct_num;
-  int conf_num;
-  int n_conf;
   double value;
   double sumweight = 0.0;
   
@@ -67,73 +63,51 @@ void trim_mean_center_matrix(O3Data *od, DoubleMat *large_mat, DoubleMat **mat,
   *mat_ave = double_vec_resize(*mat_ave, (*mat)->n);
   memset((*mat_ave)->ve, 0, (*mat_ave)->size * sizeof(double));
   /*
+  if it is a CV model some compounds shall be left out:
+  averages are downdated from the full column sums
+  (if available) and training rows are then streamed
+  into the E matrix
+  */
+  if (model_type & (CV_MODEL | SCRAMBLE_CV_MODEL)) {
+    fill_fold_rows(od);
+    for (x = 0; x < large_mat->n; ++x) {
+      (*mat_ave)->ve[x] = calc_fold_column_ave
+        (od, large_mat, large_mat_sum, x);
+      for (i = 0; i < od->pel.fold_train_rows->size; ++i) {
+        value = M_PEEK(large_mat, od->pel.fold_train_rows->pe[i], x);
+        M_POKE(*mat, i, x, (MISSING(value)
+          ? 0.0 : (value - (*mat_ave)->ve[x]))
+          * od->vel.fold_train_sqrt_weight->ve[i]);
+      }
+    }
+    return;
+  }
+  /*
   copy values from large-E matrix,
   mean-center them and store them into the E matrix
   */
   for (x = 0; x < large_mat->n; ++x) {
-    n = 0;
-    object_num = 0;
-    y = 0;
     sumweight = 0.0;
-    while (object_num < od->object_num) {
-      struct_num = od->al.mol_info[object_num]->struct_num;
-      conf_num = 1;
-      /*
-      if it is a CV model some compounds shall be left out
-      */
-      if (model_type & (CV_MODEL | SCRAMBLE_CV_MODEL)) {
-        if (n < od->pel.out_structs->size) {
-          if (struct_num == od->pel.out_structs->pe[n]) {
-            ++n;
-            object_num += conf_num;
-            y += conf_num;
-            continue;
-          }
-        }
-      }
-      for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num) {
-        if (get_object_attr(od, object_num, ACTIVE_BIT)) {
-          value = M_PEEK(large_mat, y, x);
-          if (!MISSING(value)) {
-            (*mat_ave)->ve[x] += (value * od->mel.object_weight[object_num]);
-            sumweight += od->mel.object_weight[object_num];
-          }
-          ++y;
+    for (object_num = 0, y = 0; object_num < od->object_num; ++object_num) {
+      if (get_object_attr(od, object_num, ACTIVE_BIT)) {
+        value = M_PEEK(large_mat, y, x);
+        if (!MISSING(value)) {
+          (*mat_ave)->ve[x] += (value * od->mel.object_weight[object_num]);
+          sumweight += od->mel.object_weight[object_num];
         }
+        ++y;
       }
     }
     if (sumweight > 0.0) {
       (*mat_ave)->ve[x] /= sumweight;
     }
-    real_y = 0;
-    n = 0;
-    object_num = 0;
-    y = 0;
-    while (object_num < od->object_num) {
-      struct_num = od->al.mol_info[object_num]->struct_num;
-      conf_num = 1;
-      /*
-      if it is a CV model some compounds shall be left out
-      */
-      if (model_type & (CV_MODEL | SCRAMBLE_CV_MODEL)) {
-        if (n < od->pel.out_structs->size) {
-          if (struct_num == od->pel.out_structs->pe[n]) {
-            ++n;
-            object_num += conf_num;
-            y += conf_num;
-            continue;
-          }
-        }
-      }
-      for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num) {
-        if (get_object_attr(od, object_num, ACTIVE_BIT)) {
-          value = M_PEEK(large_mat, y, x);
-          M_POKE(*mat, real_y, x, (MISSING(value)
-            ? 0.0 : (value - (*mat_ave)->ve[x]))
-            * sqrt(od->mel.object_weight[object_num]));
-          ++real_y;
-          ++y;
-        }
+    for (object_num = 0, y = 0; object_num < od->object_num; ++object_num) {
+      if (get_object_attr(od, object_num, ACTIVE_BIT)) {
+        value = M_PEEK(large_mat, y, x);
+        M_POKE(*mat, y, x, (MISSING(value)
+          ? 0.0 : (value - (*mat_ave)->ve[x]))
+          * sqrt(od->mel.object_weight[object_num]));
+        ++y;
       }
     }
   }
@@ -143,17 +117,14 @@ void trim_mean_center_matrix(O3Data *od, DoubleMat *large_mat, DoubleMat **mat,
 void trim_mean_center_x_matrix_hp(O3Data *od, int model_type, int active_object_num, int run)
 {
   char sel_one_zero;
+  int i;
   int y;
   int x;
   int real_y;
   int real_x;
   int size_coeff;
-  int n;
-  int object_num;
-  int struct_num;
-  int conf_num;
-  int n_conf;
   double value;
+  double sqrt_weight;
   
   
   size_coeff = 1;
@@ -171,10 +142,12 @@ void trim_mean_center_x_matrix_hp(O3Data *od, int model_type, int active_object_
     active_object_num, od->mal.e_mat->n);
   /*
   copy values from large-E matrix,
-  mean-center them and store them into the E matrix
+  mean-center them and store them into the E matrix;
+  training rows for this fold are found only once
   */
+  fill_fold_rows(od);
   real_x = 0;
-  real_y = 0;
+  real_y = od->pel.fold_train_rows->size;
   sel_one_zero = '1';
   for (x = 0; x < (od->mal.large_e_mat->n / size_coeff); ++x) {
     if (model_type & (FFDSEL_FULL_MODEL | FFDSEL_CV_MODEL)) {
@@ -184,39 +157,21 @@ void trim_mean_center_x_matrix_hp(O3Data *od, int model_type, int active_object_
       sel_one_zero = od->mel.uvepls_included[x];
     }
     if (sel_one_zero == '1') {
-      real_y = 0;
-      n = 0;
-      object_num = 0;
-      y = 0;
-      while (object_num < od->object_num) {
-        struct_num = od->al.mol_info[object_num]->struct_num;
-        conf_num = 1;
-        if (n < od->pel.out_structs->size) {
-          if (struct_num == od->pel.out_structs->pe[n]) {
-            ++n;
-            object_num += conf_num;
-            y += conf_num;
-            continue;
-          }
-        }
-        for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num) {
-          if (get_object_attr(od, object_num, ACTIVE_BIT)) {
-            value = M_PEEK(od->mal.large_e_mat, y, x);
-            M_POKE(od->mal.e_mat, real_y, real_x, (MISSING(value)
-              ? 0.0 : (value - M_PEEK(od->mal.large_e_mat_ave, run, x))
-              * sqrt(od->mel.object_weight[object_num])));
-            if ((model_type & UVEPLS_CV_MODEL) && (!(od->uvepls.ive))) {
-              value = M_PEEK(od->mal.large_e_mat, y,
-                x + od->mal.large_e_mat->n / 2);
-              M_POKE(od->mal.e_mat, real_y,
-                real_x + od->mal.e_mat->n / 2, (MISSING(value)
-                ? 0.0 : (value - M_PEEK(od->mal.large_e_mat_ave, run,
-                x + od->mal.large_e_mat->n / 2))
-                * sqrt(od->mel.object_weight[object_num])));
-            }
-            ++real_y;
-            ++y;
-          }
+      for (i = 0; i < real_y; ++i) {
+        y = od->pel.fold_train_rows->pe[i];
+        sqrt_weight = od->vel.fold_train_sqrt_weight->ve[i];
+        value = M_PEEK(od->mal.large_e_mat, y, x);
+        M_POKE(od->mal.e_mat, i, real_x, (MISSING(value)
+          ? 0.0 : (value - M_PEEK(od->mal.large_e_mat_ave, run, x))
+          * sqrt_weight));
+        if ((model_type & UVEPLS_CV_MODEL) && (!(od->uvepls.ive))) {
+          value = M_PEEK(od->mal.large_e_mat, y,
+            x + od->mal.large_e_mat->n / 2);
+          M_POKE(od->mal.e_mat, i,
+            real_x + od->mal.e_mat->n / 2, (MISSING(value)
+            ? 0.0 : (value - M_PEEK(od->mal.large_e_mat_ave, run,
+            x + od->mal.large_e_mat->n / 2))
+            * sqrt_weight));
         }
       }
       ++real_x;
@@ -246,15 +201,8 @@ void trim_mean_center_x_matrix_hp(O3Data *od, int model_type, int active_object_
 
 void trim_mean_center_y_matrix_hp(O3Data *od, int active_object_num, int run)
 {
-  int y;
+  int i;
   int x;
-  int real_y;
-  int n;
-  int object_num;
-  int struct_num;
-  int conf_num;
-  int n_conf;
-  double value;
   
   
   /*
@@ -266,32 +214,13 @@ void trim_mean_center_y_matrix_hp(O3Data *od, int active_object_num, int run)
   copy values from large-F matrix,
   mean-center them and store them into the F matrix
   */
+  fill_fold_rows(od);
   for (x = 0; x < od->mal.large_f_mat->n; ++x) {
-    real_y = 0;
-    n = 0;
-    object_num = 0;
-    y = 0;
-    while (object_num < od->object_num) {
-      struct_num = od->al.mol_info[object_num]->struct_num;
-      conf_num = 1;
-      if (n < od->pel.out_structs->size) {
-        if (struct_num == od->pel.out_structs->pe[n]) {
-          ++n;
-          object_num += conf_num;
-          y += conf_num;
-          continue;
-        }
-      }
-      for (n_conf = 0; n_conf < conf_num; ++n_conf, ++object_num) {
-        if (get_object_attr(od, object_num, ACTIVE_BIT)) {
-          value = M_PEEK(od->mal.large_f_mat, y, x);
-          M_POKE(od->mal.f_mat, real_y, x,
-            (value - M_PEEK(od->mal.large_f_mat_ave, run, x))
-            * sqrt(od->mel.object_weight[object_num]));
-          ++real_y;
-          ++y;
-        }
-      }
+    for (i = 0; i < od->pel.fold_train_rows->size; ++i) {
+      M_POKE(od->mal.f_mat, i, x,
+        (M_PEEK(od->mal.large_f_mat, od->pel.fold_train_rows->pe[i], x)
+        - M_PEEK(od->mal.large_f_mat_ave, run, x))
+        * od->vel.fold_train_sqrt_weight->ve[i]);
     }
   }
 }
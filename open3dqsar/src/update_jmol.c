@@ -42,14 +42,6 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 #include <include/proc_env.h>
 #include <include/prog_exe_info.h>
-#ifndef WIN32
-#ifndef INVALID_SOCKET
-#define INVALID_SOCKET  -1
-#endif
-#ifndef SOCKET_ERROR
-#define SOCKET_ERROR  -1
-#endif
-#endif
 
 
 int send_jmol_command(O3Data *od, char *command)
@@ -121,7 +113,6 @@ int update_jmol(O3Data *od)
   int n;
   int found;
   int error = 0;
-  int attempts;
   FileDescriptor temp_jmol_fd;
   ProgExeInfo prog_exe_info;
 
@@ -131,27 +122,23 @@ int update_jmol(O3Data *od)
     return 0;
   }
   if (!(od->jmol.jmol_pid)) {
-    while ((!error) && (od->jmol.port < JMOL_LAST_PORT)) {
-      od->jmol.sock = socket(AF_INET, SOCK_STREAM, 0);
-      if (od->jmol.sock == INVALID_SOCKET) {
-        return 0;
-      }
-      memset(&(od->jmol.sockaddr), 0, sizeof(od->jmol.sockaddr));
-      od->jmol.sockaddr.sin_family = AF_INET;
-      od->jmol.sockaddr.sin_addr.s_addr = inet_addr(LOCALHOST_IP);
+    /*
+    look for a port nobody is listening on
+    */
+    memset(&(od->jmol.sockaddr), 0, sizeof(od->jmol.sockaddr));
+    od->jmol.sockaddr.sin_family = AF_INET;
+    od->jmol.sockaddr.sin_addr.s_addr = inet_addr(LOCALHOST_IP);
+    while (od->jmol.port < JMOL_LAST_PORT) {
       od->jmol.sockaddr.sin_port = htons(od->jmol.port);
-      error = connect(od->jmol.sock, (struct sockaddr *)&(od->jmol.sockaddr),
-        sizeof(od->jmol.sockaddr));
-      if (!error) {
-        ++(od->jmol.port);
-        #ifdef WIN32
-        closesocket(od->jmol.sock);
-        #else
-        close(od->jmol.sock);
-        #endif
+      od->jmol.sock = connect_socket((struct sockaddr *)&(od->jmol.sockaddr),
+        sizeof(od->jmol.sockaddr), 1);
+      if (od->jmol.sock == INVALID_SOCKET) {
+        break;
       }
+      close_socket(od->jmol.sock);
+      ++(od->jmol.port);
     }
-    if (!error) {
+    if (od->jmol.port >= JMOL_LAST_PORT) {
       return 0;
     }
     memset(&prog_exe_info, 0, sizeof(ProgExeInfo));
@@ -166,20 +153,9 @@ int update_jmol(O3Data *od)
       od->jmol.jmol_exe, od->jmol.port);
     ext_program_exe(&prog_exe_info, &error);
     od->jmol.jmol_pid = 1;
-    error = -1;
-    attempts = 0;
-    while (error && (attempts < MAX_ATTEMPTS_JMOL)) {
-      error = connect(od->jmol.sock, (struct sockaddr *)&(od->jmol.sockaddr),
-        sizeof(od->jmol.sockaddr));
-      if (error == -1) {
-        #ifndef WIN32
-        usleep(1000 * MS_SLEEP_BEFORE_RETRY);
-        #else
-        Sleep(MS_SLEEP_BEFORE_RETRY);
-        #endif
-        ++attempts;
-      }
-    }
+    od->jmol.sock = connect_socket((struct sockaddr *)&(od->jmol.sockaddr),
+      sizeof(od->jmol.sockaddr), MAX_ATTEMPTS_JMOL);
+    error = (od->jmol.sock == INVALID_SOCKET);
   }
   if (error) {
     return 0;
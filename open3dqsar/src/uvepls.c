@@ -42,30 +42,38 @@ E-mail: paolo.tosco@unito.it
 #include <include/o3header.h>
 
 
+/*
+in parallel runs, coefficients of each CV model are stored in
+the temporary file of the thread which ran that CV run, in the
+order in which that thread picked its runs from the task queue;
+cv_run is translated into a position within that file
+*/
+static FILE *get_cv_coeff_file(O3Data *od, int *cv_run)
+{
+  int task;
+  
+  
+  if (od->n_proc == 1) {
+    return od->file[TEMP_CV_COEFF]->handle;
+  }
+  task = *cv_run / od->uvepls.groups;
+  *cv_run = od->queue.slot[task] * od->uvepls.groups
+    + *cv_run % od->uvepls.groups;
+  
+  return od->mel.thread_info[od->queue.thread_num[task]]
+    ->temp_cv_coeff.handle;
+}
+
+
 int get_cv_coeff(O3Data *od, int cv_run,
   int y, int x, double *cv_coeff, int save_ram)
 {
-  int i;
   int actual_len;
-  ThreadInfo **thread_info;
   FILE *file;
   
   
   if (save_ram) {
-    if (od->n_proc > 1) {
-      thread_info = od->mel.thread_info;
-      i = 0;
-      while((cv_run - thread_info[i]->n_calc
-          * od->uvepls.groups) >= 0) {
-        cv_run -= thread_info[i]->n_calc
-          * od->uvepls.groups;
-        ++i;
-      }
-      file = thread_info[i]->temp_cv_coeff.handle;
-    }
-    else {
-      file = od->file[TEMP_CV_COEFF]->handle;
-    }
+    file = get_cv_coeff_file(od, &cv_run);
     fseek(file, (od->mal.b_coefficients->m
       * (y + cv_run * od->y_vars) + x)
       * sizeof(double), SEEK_SET);
@@ -473,19 +481,9 @@ int uvepls(O3Data *od, int pc_num)
       for (k = 0; k < od->y_vars; ++k) {
         for (j = 0; j < od->cv.overall_cv_runs; ++j) {
           if (od->uvepls.save_ram) {
-            if (od->n_proc > 1) {
-              n = 0;
-              cv_run = j;
-              while((cv_run - thread_info[n]->n_calc) >= 0) {
-                cv_run -= thread_info[n]->n_calc;
-                ++n;
-              }
-              file = thread_info[n]->temp_cv_coeff.handle;
-            }
-            else {
-              file = od->file[TEMP_CV_COEFF]->handle;
-            }
-            fseek(file, (b_coefficients->m * (k + j * od->y_vars))
+            cv_run = j;
+            file = get_cv_coeff_file(od, &cv_run);
+            fseek(file, (b_coefficients->m * (k + cv_run * od->y_vars))
               * sizeof(double), SEEK_SET);
             actual_len = fread(&M_PEEK(b_coefficients, 0, k),
               sizeof(double), b_coefficients->m, file);
@@ -639,10 +637,10 @@ int uvepls(O3Data *od, int pc_num)
       instead of q2
       */
       if (od->uvepls.ive_external_sdep) {
-        trim_mean_center_matrix(od, od->mal.large_e_mat,
+        trim_mean_center_matrix(od, od->mal.large_e_mat, NULL,
           &(od->mal.e_mat), &(od->vel.e_mat_ave),
           UVEPLS_FULL_MODEL, od->active_object_num);
-        trim_mean_center_matrix(od, od->mal.large_f_mat,
+        trim_mean_center_matrix(od, od->mal.large_f_mat, NULL,
           &(od->mal.f_mat), &(od->vel.f_mat_ave),
           UVEPLS_FULL_MODEL, od->active_object_num);
         pls(od, pc_num, UVEPLS_FULL_MODEL);
@@ -814,6 +812,7 @@ int uvepls(O3Data *od, int pc_num)
     double_mat_free(od->mal.large_e_mat_ave);
     od->mal.large_e_mat_ave = NULL;
   }
+  free_large_mat_sum(od);
   if (od->mal.large_f_mat_ave) {
     double_mat_free(od->mal.large_f_mat_ave);
     od->mal.large_f_mat_ave = NULL;
@@ -70,3 +70,11 @@ int xyz_to_var(O3Data *od, VarCoord *varcoord)
     * od->grid.nodes[1] + (int)(varcoord->node[1])
     * od->grid.nodes[0] + (int)(varcoord->node[0]));
 }
+
+
+int newgrid_xyz_to_var(O3Data *od, VarCoord *varcoord)
+{
+  return ((int)(varcoord->node[2]) * od->newgrid.nodes[0]
+    * od->newgrid.nodes[1] + (int)(varcoord->node[1])
+    * od->newgrid.nodes[0] + (int)(varcoord->node[0]));
+}
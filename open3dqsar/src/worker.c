@@ -0,0 +1,141 @@
+/*
+
+worker.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+worker mode (--worker ADDRESS): connect to the main
+process and carry out the tasks it sends until the
+connection is closed; jobs and tasks are described in
+worker_job.c
+*/
+int run_worker(O3Data *od, char *address)
+{
+  int task;
+  int type;
+  int result;
+  WorkerBuffer buf;
+  WorkerBuffer swap;
+  ThreadInfo *ti;
+  
+  
+  result = connect_worker(od, address);
+  if (result) {
+    return result;
+  }
+  /*
+  tasks are carried out one at a time, so
+  BLAS may use all the CPUs of this worker
+  */
+  set_blas_threads(od, 1);
+  memset(&buf, 0, sizeof(WorkerBuffer));
+  ti = NULL;
+  while (1) {
+    result = recv_worker_msg(&(od->workers), 0, &type, &buf,
+      WORKER_MAX_JOB_LEN);
+    if (result) {
+      /*
+      the connection being closed by the
+      main process is a normal exit
+      */
+      if (result == WORKER_CONNECTION_ERROR) {
+        result = 0;
+      }
+      break;
+    }
+    if (type == WORKER_JOB) {
+      /*
+      the job is kept in od->workers.job
+      */
+      memcpy(&swap, &(od->workers.job), sizeof(WorkerBuffer));
+      memcpy(&(od->workers.job), &buf, sizeof(WorkerBuffer));
+      memcpy(&buf, &swap, sizeof(WorkerBuffer));
+      result = unpack_worker_job(od);
+      if (result) {
+        break;
+      }
+      ti = od->mel.thread_info[0];
+    }
+    else if ((type == WORKER_TASK) && ti) {
+      result = unpack_worker_task(ti, &task, &buf);
+      if (result) {
+        break;
+      }
+      ti->out_of_memory = 0;
+      ti->cannot_write_temp_file = 0;
+      if (od->workers.job_type == WORKER_FFDSEL_JOB) {
+        ffdsel_task(ti, task);
+      }
+      else if (od->workers.cv_type == LEAVE_MANY_OUT) {
+        lmo_cv_task(ti, task);
+      }
+      else if (od->workers.cv_type == LEAVE_TWO_OUT) {
+        lto_cv_task(ti, task);
+      }
+      else {
+        loo_cv_task(ti, task);
+      }
+      result = pack_worker_result(ti, task, &buf);
+      if (!result) {
+        result = send_worker_msg(&(od->workers), 0, WORKER_RESULT, &buf);
+      }
+      if (result) {
+        break;
+      }
+    }
+    else {
+      result = WORKER_CONNECTION_ERROR;
+      break;
+    }
+  }
+  /*
+  LMO groups of the last job are not
+  freed by free_mem(), so do it here
+  */
+  free_cv_groups(od, od->cv.runs);
+  if (buf.data) {
+    free(buf.data);
+  }
+  
+  return result;
+}
@@ -0,0 +1,711 @@
+/*
+
+worker_job.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+the job sent to workers holds everything which is needed
+to carry out CV runs or FFD design rows on their own: the
+mean-centered training data (large E and F matrices with
+their column sums and per-run averages), object weights,
+attributes and structure numbers, the left-out structures
+for LOO/LTO runs and the random generator state from which
+LMO groups are drawn (see fill_group_composition())
+*/
+static int put_int(WorkerBuffer *buf, int value)
+{
+  return put_worker_data(buf, &value, sizeof(int));
+}
+
+
+static int put_int_array(WorkerBuffer *buf, int *array, int n)
+{
+  if (put_int(buf, n)) {
+    return OUT_OF_MEMORY;
+  }
+  if (n && put_worker_data(buf, array, n * sizeof(int))) {
+    return OUT_OF_MEMORY;
+  }
+  
+  return 0;
+}
+
+
+static int get_int_array(WorkerBuffer *buf, int **array, int min_places)
+{
+  int n;
+  
+  
+  if (get_worker_data(buf, &n, sizeof(int)) || (n < 0)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  *array = alloc_int_array(*array, ((n > min_places) ? n : min_places));
+  if (!(*array)) {
+    return OUT_OF_MEMORY;
+  }
+  
+  return (n ? get_worker_data(buf, *array, n * sizeof(int)) : 0);
+}
+
+
+/*
+matrices are sent column by column, since
+their leading dimension may exceed their length
+*/
+static int put_double_mat(WorkerBuffer *buf, DoubleMat *mat)
+{
+  int j;
+  
+  
+  if (put_int(buf, (mat ? 1 : 0))) {
+    return OUT_OF_MEMORY;
+  }
+  if (!mat) {
+    return 0;
+  }
+  if (put_int(buf, mat->m) || put_int(buf, mat->n)) {
+    return OUT_OF_MEMORY;
+  }
+  for (j = 0; j < mat->n; ++j) {
+    if (mat->m && put_worker_data(buf, &M_PEEK(mat, 0, j),
+      mat->m * sizeof(double))) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  
+  return 0;
+}
+
+
+static int get_double_mat(WorkerBuffer *buf, DoubleMat **mat)
+{
+  int j;
+  int m;
+  int n;
+  int present;
+  
+  
+  if (get_worker_data(buf, &present, sizeof(int))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  if (!present) {
+    if (*mat) {
+      double_mat_free(*mat);
+      *mat = NULL;
+    }
+    return 0;
+  }
+  if (get_worker_data(buf, &m, sizeof(int))
+    || get_worker_data(buf, &n, sizeof(int))
+    || (m < 0) || (n < 0)
+    || (((size_t)m * n * sizeof(double)) > (buf->len - buf->pos))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  *mat = double_mat_resize(*mat, m, n);
+  if (!(*mat)) {
+    return OUT_OF_MEMORY;
+  }
+  for (j = 0; j < n; ++j) {
+    if (m && get_worker_data(buf, &M_PEEK(*mat, 0, j), m * sizeof(double))) {
+      return WORKER_CONNECTION_ERROR;
+    }
+  }
+  
+  return 0;
+}
+
+
+/*
+to be called before fill_thread_info(), so that the threads
+which talk to the workers find the job ready to be sent
+*/
+int pack_worker_job(O3Data *od, int x_vars, int model_type,
+  int cv_type, int pc_num, int groups, int runs, int n_tasks)
+{
+  int i;
+  int n;
+  int result;
+  int scalar[24];
+  double dscalar[2];
+  WorkerBuffer *buf;
+  
+  
+  buf = &(od->workers.job);
+  buf->len = 0;
+  buf->pos = 0;
+  od->workers.job_type = ((model_type & FFDSEL_CV_MODEL)
+    ? WORKER_FFDSEL_JOB : WORKER_CV_JOB);
+  od->workers.cv_type = cv_type;
+  od->workers.n_tasks = n_tasks;
+  scalar[0] = od->workers.job_type;
+  scalar[1] = model_type;
+  scalar[2] = cv_type;
+  scalar[3] = x_vars;
+  scalar[4] = pc_num;
+  scalar[5] = groups;
+  scalar[6] = runs;
+  scalar[7] = n_tasks;
+  scalar[8] = od->object_num;
+  scalar[9] = od->active_object_num;
+  scalar[10] = od->y_vars;
+  scalar[11] = od->grid.struct_num;
+  scalar[12] = od->pls_algorithm;
+  scalar[13] = od->pls_precision;
+  scalar[14] = od->pls_y_mode;
+  scalar[15] = od->pls_incremental;
+  scalar[16] = od->cv.overall_cv_runs;
+  scalar[17] = od->cv.num_predictions;
+  scalar[18] = od->cv.active_struct_num;
+  scalar[19] = od->cv.auto_runs;
+  scalar[20] = od->ffdsel.cv_type;
+  scalar[21] = od->ffdsel.groups;
+  scalar[22] = od->ffdsel.runs;
+  scalar[23] = od->ffdsel.ffdsel_included_vars;
+  dscalar[0] = od->cv.tss;
+  dscalar[1] = od->cv.runs_tolerance;
+  if (put_worker_data(buf, scalar, sizeof(scalar))
+    || put_worker_data(buf, dscalar, sizeof(dscalar))
+    || put_worker_data(buf, &(od->cv.group_stream), sizeof(RandomStream))
+    || put_worker_data(buf, od->mel.object_attr,
+    od->object_num * sizeof(uint16_t))
+    || put_worker_data(buf, od->mel.object_weight,
+    od->object_num * sizeof(double))) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < od->object_num; ++i) {
+    if (put_int(buf, od->al.mol_info[i]->struct_num)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if (cv_type == LEAVE_MANY_OUT) {
+    if (put_int_array(buf, od->mel.struct_per_group, groups)
+      || put_int_array(buf, od->mel.active_struct_list,
+      od->cv.active_struct_num)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  n = 0;
+  if (!(model_type & FFDSEL_CV_MODEL)) {
+    if (cv_type == LEAVE_ONE_OUT) {
+      n = n_tasks;
+    }
+    else if (cv_type == LEAVE_TWO_OUT) {
+      n = n_tasks * 2;
+    }
+  }
+  result = put_int_array(buf, od->mel.struct_list, n);
+  if (!result) {
+    result = put_double_mat(buf, od->mal.large_e_mat);
+  }
+  if (!result) {
+    result = put_double_mat(buf, od->mal.large_e_mat_sum);
+  }
+  if (!result) {
+    result = put_double_mat(buf, od->mal.large_e_mat_ave);
+  }
+  if (!result) {
+    result = put_double_mat(buf, od->mal.large_f_mat);
+  }
+  if (!result) {
+    result = put_double_mat(buf, od->mal.large_f_mat_sum);
+  }
+  if (!result) {
+    result = put_double_mat(buf, od->mal.large_f_mat_ave);
+  }
+  
+  return result;
+}
+
+
+/*
+called by workers on receipt of a job; data structures
+are set up as parallel_cv() and ffdsel() do for their
+threads, then a single ThreadInfo is prepared which
+will carry out all the tasks of this job
+*/
+int unpack_worker_job(O3Data *od)
+{
+  int i;
+  int n;
+  int x_vars;
+  int model_type;
+  int cv_type;
+  int pc_num;
+  int groups;
+  int runs;
+  int n_tasks;
+  int result;
+  int scalar[24];
+  double dscalar[2];
+  WorkerBuffer *buf;
+  ThreadInfo *ti;
+  
+  
+  buf = &(od->workers.job);
+  free_cv_groups(od, od->cv.runs);
+  od->cv.runs = 0;
+  if (get_worker_data(buf, scalar, sizeof(scalar))
+    || get_worker_data(buf, dscalar, sizeof(dscalar))
+    || get_worker_data(buf, &(od->cv.group_stream), sizeof(RandomStream))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  od->workers.job_type = scalar[0];
+  model_type = scalar[1];
+  cv_type = scalar[2];
+  x_vars = scalar[3];
+  pc_num = scalar[4];
+  groups = scalar[5];
+  runs = scalar[6];
+  n_tasks = scalar[7];
+  if (((od->workers.job_type != WORKER_CV_JOB)
+    && (od->workers.job_type != WORKER_FFDSEL_JOB))
+    || ((cv_type != LEAVE_ONE_OUT) && (cv_type != LEAVE_TWO_OUT)
+    && (cv_type != LEAVE_MANY_OUT)) || (x_vars < 1) || (pc_num < 0)
+    || (n_tasks < 1) || (scalar[8] < 1) || (scalar[10] < 1)
+    || ((cv_type == LEAVE_MANY_OUT) && ((groups < 1) || (runs < 1)))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  od->workers.cv_type = cv_type;
+  od->workers.n_tasks = n_tasks;
+  od->object_num = scalar[8];
+  od->grid.object_num = scalar[8];
+  od->active_object_num = scalar[9];
+  od->y_vars = scalar[10];
+  od->grid.struct_num = scalar[11];
+  od->pls_algorithm = scalar[12];
+  od->pls_precision = scalar[13];
+  od->pls_y_mode = scalar[14];
+  od->pls_incremental = scalar[15];
+  od->cv.overall_cv_runs = scalar[16];
+  od->cv.num_predictions = scalar[17];
+  od->cv.active_struct_num = scalar[18];
+  od->cv.auto_runs = scalar[19];
+  od->ffdsel.cv_type = scalar[20];
+  od->ffdsel.groups = scalar[21];
+  od->ffdsel.runs = scalar[22];
+  od->ffdsel.ffdsel_included_vars = scalar[23];
+  od->cv.tss = dscalar[0];
+  od->cv.runs_tolerance = dscalar[1];
+  od->cv.groups = groups;
+  od->cv.kernel_cv = 0;
+  od->cv.sp_cv = 0;
+  od->uvepls.ive = 0;
+  od->gram.valid = 0;
+  result = alloc_cv_sdep(od, pc_num, ((runs > 1) ? runs : 1));
+  if (result) {
+    return result;
+  }
+  od->mel.object_attr = (uint16_t *)realloc(od->mel.object_attr,
+    od->object_num * sizeof(uint16_t));
+  od->mel.object_weight = (double *)realloc(od->mel.object_weight,
+    od->object_num * sizeof(double));
+  if (od->al.mol_info) {
+    free_array(od->al.mol_info);
+  }
+  od->al.mol_info = (MolInfo **)alloc_array(od->object_num, sizeof(MolInfo));
+  if ((!(od->mel.object_attr)) || (!(od->mel.object_weight))
+    || (!(od->al.mol_info))) {
+    return OUT_OF_MEMORY;
+  }
+  if (get_worker_data(buf, od->mel.object_attr,
+    od->object_num * sizeof(uint16_t))
+    || get_worker_data(buf, od->mel.object_weight,
+    od->object_num * sizeof(double))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  for (i = 0; i < od->object_num; ++i) {
+    if (get_worker_data(buf, &(od->al.mol_info[i]->struct_num),
+      sizeof(int))) {
+      return WORKER_CONNECTION_ERROR;
+    }
+  }
+  if (cv_type == LEAVE_MANY_OUT) {
+    /*
+    LMO groups are drawn by each worker as they are
+    needed, exactly as the main process would do
+    */
+    od->cimal.group_composition_list =
+      (IntMat **)malloc(runs * sizeof(IntMat *));
+    if (!(od->cimal.group_composition_list)) {
+      return OUT_OF_MEMORY;
+    }
+    memset(od->cimal.group_composition_list, 0, runs * sizeof(IntMat *));
+    od->cv.runs = runs;
+    result = get_int_array(buf, &(od->mel.struct_per_group), groups);
+    if (!result) {
+      result = get_int_array(buf, &(od->mel.active_struct_list),
+        od->cv.active_struct_num);
+    }
+    if (result) {
+      return result;
+    }
+    od->mel.group_ready = alloc_int_array(NULL, runs);
+    if (!(od->mel.group_ready)) {
+      return OUT_OF_MEMORY;
+    }
+    for (i = 0; i < runs; ++i) {
+      od->cimal.group_composition_list[i] = alloc_int_matrix(NULL,
+        groups, od->cv.active_struct_num / groups + 1);
+      if (!(od->cimal.group_composition_list[i])) {
+        return OUT_OF_MEMORY;
+      }
+    }
+  }
+  result = get_int_array(buf, &(od->mel.struct_list), od->grid.struct_num);
+  if (!result) {
+    result = get_double_mat(buf, &(od->mal.large_e_mat));
+  }
+  if (!result) {
+    result = get_double_mat(buf, &(od->mal.large_e_mat_sum));
+  }
+  if (!result) {
+    result = get_double_mat(buf, &(od->mal.large_e_mat_ave));
+  }
+  if (!result) {
+    result = get_double_mat(buf, &(od->mal.large_f_mat));
+  }
+  if (!result) {
+    result = get_double_mat(buf, &(od->mal.large_f_mat_sum));
+  }
+  if (!result) {
+    result = get_double_mat(buf, &(od->mal.large_f_mat_ave));
+  }
+  if (result) {
+    return result;
+  }
+  if ((!(od->mal.large_e_mat)) || (!(od->mal.large_f_mat))
+    || (buf->pos != buf->len)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  if (alloc_pls(od, x_vars, pc_num, model_type)) {
+    return OUT_OF_MEMORY;
+  }
+  od->mal.press = double_mat_resize(od->mal.press, pc_num + 1, od->y_vars);
+  od->mal.task_press = double_mat_resize(od->mal.task_press,
+    (pc_num + 1) * od->y_vars, n_tasks);
+  if ((!(od->mal.press)) || (!(od->mal.task_press))) {
+    return OUT_OF_MEMORY;
+  }
+  memset(od->mal.press->base, 0,
+    od->mal.press->m * od->mal.press->n * sizeof(double));
+  od->cv_pred.active = 0;
+  if (model_type & (CV_MODEL | SILENT_PLS)) {
+    od->save_ram = 0;
+    if (alloc_cv_pred(od, pc_num, cv_type)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if (od->workers.job_type == WORKER_FFDSEL_JOB) {
+    od->vel.best_sdep = double_vec_resize(od->vel.best_sdep, n_tasks);
+    od->mel.ffdsel_included = (char *)realloc(od->mel.ffdsel_included,
+      od->ffdsel.ffdsel_included_vars);
+    if ((!(od->vel.best_sdep)) || (!(od->mel.ffdsel_included))) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if (alloc_threads(od)) {
+    return OUT_OF_MEMORY;
+  }
+  n = fill_thread_info(od, 1);
+  ti = od->mel.thread_info[0];
+  ti->pc_num = pc_num;
+  ti->groups = groups;
+  ti->model_type = model_type;
+  
+  return (n ? 0 : OUT_OF_MEMORY);
+}
+
+
+int pack_worker_task(ThreadInfo *ti, int task, WorkerBuffer *buf)
+{
+  buf->len = 0;
+  buf->pos = 0;
+  if (put_int(buf, task)) {
+    return OUT_OF_MEMORY;
+  }
+  if (ti->od.workers.job_type == WORKER_FFDSEL_JOB) {
+    /*
+    the variables included in this design row
+    */
+    prepare_design_model(&(ti->od), task);
+    if (put_worker_data(buf, ti->od.mel.ffdsel_included,
+      ti->od.ffdsel.ffdsel_included_vars)) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  
+  return 0;
+}
+
+
+int unpack_worker_task(ThreadInfo *ti, int *task, WorkerBuffer *buf)
+{
+  if (get_worker_data(buf, task, sizeof(int))
+    || (*task < 0) || (*task >= ti->od.workers.n_tasks)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  if (ti->od.workers.job_type == WORKER_FFDSEL_JOB) {
+    if (get_worker_data(buf, ti->od.mel.ffdsel_included,
+      ti->od.ffdsel.ffdsel_included_vars)) {
+      return WORKER_CONNECTION_ERROR;
+    }
+  }
+  
+  return ((buf->pos == buf->len) ? 0 : WORKER_CONNECTION_ERROR);
+}
+
+
+/*
+CV blocks of predictions belonging to a task: one for LOO
+and LTO runs, one for each group for LMO runs
+*/
+static void get_task_blocks(ThreadInfo *ti, int task, int *first, int *n)
+{
+  if (ti->od.workers.cv_type == LEAVE_MANY_OUT) {
+    *first = task * ti->groups;
+    *n = ti->groups;
+  }
+  else {
+    *first = task;
+    *n = 1;
+  }
+}
+
+
+/*
+the result of a CV task is made of its column of task_press,
+its row of sdep_mat (LMO only) and its blocks of the CV
+prediction store (if predictions are needed); the result
+of a FFD design row is the best SDEP of its model
+*/
+int pack_worker_result(ThreadInfo *ti, int task, WorkerBuffer *buf)
+{
+  int i;
+  int b;
+  int k;
+  int x;
+  int first;
+  int n_blocks;
+  int slot;
+  int status;
+  CVPredStore *store;
+  
+  
+  buf->len = 0;
+  buf->pos = 0;
+  status = ((ti->out_of_memory || ti->cannot_write_temp_file) ? 1 : 0);
+  if (put_int(buf, status) || put_int(buf, task)
+    || put_int(buf, ti->od.pc_num)) {
+    return OUT_OF_MEMORY;
+  }
+  if (ti->od.workers.job_type == WORKER_FFDSEL_JOB) {
+    return put_worker_data(buf, &(ti->od.vel.best_sdep->ve[task]),
+      sizeof(double));
+  }
+  if (put_int(buf, ti->od.mal.task_press->m)) {
+    return OUT_OF_MEMORY;
+  }
+  for (i = 0; i < ti->od.mal.task_press->m; ++i) {
+    if (put_worker_data(buf, &M_PEEK(ti->od.mal.task_press, i, task),
+      sizeof(double))) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  if (ti->od.workers.cv_type == LEAVE_MANY_OUT) {
+    for (i = 0; i <= ti->od.pc_num; ++i) {
+      if (put_worker_data(buf, &M_PEEK(ti->od.mal.sdep_mat, task, i),
+        sizeof(double))) {
+        return OUT_OF_MEMORY;
+      }
+    }
+  }
+  /*
+  predictions are only kept for CV models,
+  as in pred_y_values()
+  */
+  store = &(ti->od.cv_pred);
+  if (!((ti->model_type & (CV_MODEL | SILENT_PLS)) && store->active)) {
+    return 0;
+  }
+  get_task_blocks(ti, task, &first, &n_blocks);
+  for (b = first; b < (first + n_blocks); ++b) {
+    if (put_int(buf, store->block_len[b])
+      || put_int(buf, store->block_pc[b])) {
+      return OUT_OF_MEMORY;
+    }
+    for (k = 0; k < store->block_len[b]; ++k) {
+      slot = b * store->block_size + k;
+      if (put_int(buf, store->object_list[slot])) {
+        return OUT_OF_MEMORY;
+      }
+      for (x = 0; x < store->y_vars; ++x) {
+        if (put_worker_data(buf, &CV_PRED_VALUE(store, slot, x, 0),
+          (store->block_pc[b] + 1) * sizeof(double))) {
+          return OUT_OF_MEMORY;
+        }
+      }
+    }
+  }
+  
+  return 0;
+}
+
+
+/*
+the longest result pack_worker_result() may send for a
+task of the current job; longer messages are turned down
+by the main process without being read
+*/
+size_t max_worker_result_len(ThreadInfo *ti)
+{
+  int first;
+  int n_blocks;
+  size_t len;
+  CVPredStore *store;
+  
+  
+  len = 3 * sizeof(int);
+  if (ti->od.workers.job_type == WORKER_FFDSEL_JOB) {
+    return len + sizeof(double);
+  }
+  len += sizeof(int) + ti->od.mal.task_press->m * sizeof(double);
+  if (ti->od.workers.cv_type == LEAVE_MANY_OUT) {
+    len += (ti->pc_num + 1) * sizeof(double);
+  }
+  store = &(ti->od.cv_pred);
+  if ((ti->model_type & (CV_MODEL | SILENT_PLS)) && store->active) {
+    get_task_blocks(ti, 0, &first, &n_blocks);
+    len += (size_t)n_blocks * (2 * sizeof(int)
+      + (size_t)(store->block_size) * (sizeof(int)
+      + (size_t)(store->y_vars) * (store->pc_num + 1) * sizeof(double)));
+  }
+  
+  return len;
+}
+
+
+/*
+called by the main process; everything is checked before
+being stored, and any inconsistency is dealt with as a lost
+connection, so that the task is carried out again
+*/
+int unpack_worker_result(ThreadInfo *ti, int task, WorkerBuffer *buf)
+{
+  int i;
+  int b;
+  int k;
+  int x;
+  int first;
+  int n_blocks;
+  int slot;
+  int n;
+  int pc_num;
+  int status;
+  int result_task;
+  CVPredStore *store;
+  
+  
+  if (get_worker_data(buf, &status, sizeof(int))
+    || get_worker_data(buf, &result_task, sizeof(int))
+    || get_worker_data(buf, &pc_num, sizeof(int))
+    || status || (result_task != task)
+    || (pc_num < 0) || (pc_num > ti->pc_num)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  ti->od.pc_num = pc_num;
+  if (ti->od.workers.job_type == WORKER_FFDSEL_JOB) {
+    if (get_worker_data(buf, &(ti->od.vel.best_sdep->ve[task]),
+      sizeof(double))) {
+      return WORKER_CONNECTION_ERROR;
+    }
+    return ((buf->pos == buf->len) ? 0 : WORKER_CONNECTION_ERROR);
+  }
+  if (get_worker_data(buf, &n, sizeof(int))
+    || (n != ti->od.mal.task_press->m)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  for (i = 0; i < n; ++i) {
+    if (get_worker_data(buf, &M_PEEK(ti->od.mal.task_press, i, task),
+      sizeof(double))) {
+      return WORKER_CONNECTION_ERROR;
+    }
+  }
+  if (ti->od.workers.cv_type == LEAVE_MANY_OUT) {
+    for (i = 0; i <= pc_num; ++i) {
+      if (get_worker_data(buf, &M_PEEK(ti->od.mal.sdep_mat, task, i),
+        sizeof(double))) {
+        return WORKER_CONNECTION_ERROR;
+      }
+    }
+  }
+  store = &(ti->od.cv_pred);
+  if ((ti->model_type & (CV_MODEL | SILENT_PLS)) && store->active) {
+    get_task_blocks(ti, task, &first, &n_blocks);
+    for (b = first; b < (first + n_blocks); ++b) {
+      if (get_worker_data(buf, &(store->block_len[b]), sizeof(int))
+        || get_worker_data(buf, &(store->block_pc[b]), sizeof(int))
+        || (store->block_len[b] < 0)
+        || (store->block_len[b] > store->block_size)
+        || (store->block_pc[b] < 0)
+        || (store->block_pc[b] > store->pc_num)) {
+        return WORKER_CONNECTION_ERROR;
+      }
+      for (k = 0; k < store->block_len[b]; ++k) {
+        slot = b * store->block_size + k;
+        if (get_worker_data(buf, &(store->object_list[slot]), sizeof(int))
+          || (store->object_list[slot] < 0)
+          || (store->object_list[slot] >= store->object_num)) {
+          return WORKER_CONNECTION_ERROR;
+        }
+        for (x = 0; x < store->y_vars; ++x) {
+          if (get_worker_data(buf, &CV_PRED_VALUE(store, slot, x, 0),
+            (store->block_pc[b] + 1) * sizeof(double))) {
+            return WORKER_CONNECTION_ERROR;
+          }
+        }
+      }
+    }
+  }
+  
+  return ((buf->pos == buf->len) ? 0 : WORKER_CONNECTION_ERROR);
+}
@@ -0,0 +1,185 @@
+/*
+
+worker_proxy.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+
+
+/*
+tasks are handed over to worker processes only when all
+the data they need can be shipped to them; UVE-PLS keeps
+its threads across IVE iterations and kernel CV relies on
+a kernel matrix which is computed once, so they are always
+carried out by local threads, as well as nested CV and
+CV runs whose predictions are stored in temporary files
+(save_ram). Workers which connected in the meantime are
+only counted once the caller has accepted them through
+accept_workers()
+*/
+int use_workers(O3Data *od, int model_type)
+{
+  if ((!(od->workers.address[0])) || (od->workers.n_workers < 1)) {
+    return 0;
+  }
+  if ((model_type & (UVEPLS_CV_MODEL | UVEPLS_FULL_MODEL))
+    || od->cv.kernel_cv || od->cv.nested || (!(od->mal.large_e_mat))
+    || (!(od->mal.large_f_mat))) {
+    return 0;
+  }
+  if ((model_type & (CV_MODEL | SILENT_PLS)) && (!(od->cv_pred.active))) {
+    return 0;
+  }
+  if ((model_type & FFDSEL_CV_MODEL)
+    && (od->ffdsel.cv_type == EXTERNAL_PREDICTION)) {
+    return 0;
+  }
+  
+  return 1;
+}
+
+
+/*
+each of these threads talks to one worker: the job is sent
+first, then tasks are fetched from the shared queue and
+sent one at a time; should the connection be lost, the task
+is put back into the queue for someone else to carry out
+*/
+#ifndef WIN32
+void *worker_proxy_thread(void *pointer)
+#else
+DWORD worker_proxy_thread(void *pointer)
+#endif
+{
+  int task;
+  int type;
+  WorkerBuffer buf;
+  ThreadInfo *ti;
+
+
+  ti = (ThreadInfo *)pointer;
+  memset(&buf, 0, sizeof(WorkerBuffer));
+  ti->worker_lost = 0;
+  if (send_worker_msg(&(ti->od.workers), ti->thread_num,
+    WORKER_JOB, &(ti->od.workers.job))) {
+    ti->worker_lost = 1;
+  }
+  while ((!(ti->worker_lost)) && ((task = get_next_task(ti)) != -1)) {
+    if (pack_worker_task(ti, task, &buf)
+      || send_worker_msg(&(ti->od.workers), ti->thread_num,
+      WORKER_TASK, &buf)
+      || recv_worker_msg(&(ti->od.workers), ti->thread_num, &type, &buf,
+      max_worker_result_len(ti))
+      || (type != WORKER_RESULT)
+      || unpack_worker_result(ti, task, &buf)) {
+      requeue_task(ti, task);
+      ti->worker_lost = 1;
+      break;
+    }
+    if ((ti->od.workers.job_type == WORKER_CV_JOB)
+      && (ti->od.workers.cv_type == LEAVE_MANY_OUT)
+      && ti->od.cv.auto_runs) {
+      complete_task(ti, task);
+    }
+  }
+  if (buf.data) {
+    free(buf.data);
+  }
+  #ifndef WIN32
+  return pointer;
+  #else
+  return 0;
+  #endif
+}
+
+
+/*
+to be called after run_thread_pool() and before
+close_task_queue(); tasks left behind by lost workers
+are carried out locally by thread 0, which works on
+the main PLS workspace, then lost workers are dropped
+*/
+int finish_worker_tasks(O3Data *od, void *job, int n_threads)
+{
+  int i;
+  int n_lost;
+  int result;
+  ThreadInfo **ti;
+  
+  
+  ti = od->mel.thread_info;
+  result = 0;
+  n_lost = 0;
+  for (i = 0; i < n_threads; ++i) {
+    if (ti[i]->worker_lost) {
+      ++n_lost;
+    }
+  }
+  if (!n_lost) {
+    return 0;
+  }
+  if (od->queue.n_requeued) {
+    result = run_thread_pool(od, job, 1);
+  }
+  if (!(ti[0]->n_calc)) {
+    /*
+    the number of PCs is taken from thread 0
+    */
+    for (i = 1; i < n_threads; ++i) {
+      if (ti[i]->n_calc) {
+        ti[0]->od.pc_num = ti[i]->od.pc_num;
+        break;
+      }
+    }
+  }
+  for (i = n_threads - 1; i >= 0; --i) {
+    if (ti[i]->worker_lost) {
+      drop_worker(od, i);
+      ti[i]->worker_lost = 0;
+    }
+  }
+  tee_printf(od, "Lost connection to %d worker%s; "
+    "%d worker%s still connected\n\n", n_lost,
+    ((n_lost > 1) ? "s" : ""), od->workers.n_workers,
+    ((od->workers.n_workers == 1) ? "" : "s"));
+  tee_flush(od);
+  
+  return result;
+}
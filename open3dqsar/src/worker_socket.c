@@ -0,0 +1,781 @@
+/*
+
+worker_socket.c
+
+is part of
+
+Open3DQSAR
+----------
+
+An open-source software aimed at high-throughput
+chemometric analysis of molecular interaction fields
+
+Copyright (C) 2009-2018 Paolo Tosco, Thomas Balle
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+For further information, please contact:
+
+Paolo Tosco, PhD
+Dipartimento di Scienza e Tecnologia del Farmaco
+Universita' degli Studi di Torino
+Via Pietro Giuria, 9
+10125 Torino (Italy)
+Phone:  +39 011 670 7680
+Mobile: +39 348 553 7206
+Fax:    +39 011 670 7687
+E-mail: paolo.tosco@unito.it
+
+*/
+
+
+#include <include/o3header.h>
+#include <include/prog_exe_info.h>
+#ifndef WIN32
+#include <netdb.h>
+#include <sys/un.h>
+#include <netinet/tcp.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL  0
+#endif
+#else
+#include <ws2tcpip.h>
+#define MSG_NOSIGNAL  0
+#endif
+
+
+/*
+messages exchanged between the main process and its
+workers are made of a header holding message type and
+payload length, followed by the payload itself; numbers
+travel in native binary format, so the first message
+exchanged in each direction (HELLO) makes sure that both
+ends agree on type sizes and byte order
+*/
+#define WORKER_CHUNK_SIZE  (1 << 20)
+
+
+typedef struct WorkerHello WorkerHello;
+struct WorkerHello {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size[4];
+  uint64_t byte_order;
+};
+
+
+static void fill_worker_hello(WorkerHello *hello)
+{
+  memset(hello, 0, sizeof(WorkerHello));
+  hello->magic = WORKER_MAGIC;
+  hello->version = WORKER_PROTOCOL_VERSION;
+  hello->size[0] = (uint32_t)sizeof(int);
+  hello->size[1] = (uint32_t)sizeof(long);
+  hello->size[2] = (uint32_t)sizeof(double);
+  hello->size[3] = (uint32_t)sizeof(size_t);
+  hello->byte_order = (uint64_t)0x0102030405060708ULL;
+}
+
+
+static int is_unix_socket_address(char *address)
+{
+  #ifndef WIN32
+  return (strchr(address, '/') ? 1 : 0);
+  #else
+  return 0;
+  #endif
+}
+
+
+/*
+addresses may be:
+- a path to a Unix domain socket (anything containing a slash)
+- LOCAL, i.e. an arbitrary free port on the loopback interface
+- PORT, i.e. that port on the loopback interface
+- HOST:PORT, where HOST may be a name, an IPv4 address
+  or an IPv6 address enclosed in square brackets
+*/
+static int get_worker_sockaddr(char *address, int passive,
+  struct sockaddr_storage *sa, socklen_t *sa_len)
+{
+  char host[BUF_LEN];
+  char *port;
+  char *ptr;
+  int len;
+  struct addrinfo hints;
+  struct addrinfo *res = NULL;
+  #ifndef WIN32
+  struct sockaddr_un *sa_un;
+  #endif
+  
+  
+  memset(sa, 0, sizeof(struct sockaddr_storage));
+  memset(host, 0, BUF_LEN);
+  #ifndef WIN32
+  if (is_unix_socket_address(address)) {
+    sa_un = (struct sockaddr_un *)sa;
+    if (strlen(address) >= sizeof(sa_un->sun_path)) {
+      return WORKER_CONNECTION_ERROR;
+    }
+    sa_un->sun_family = AF_UNIX;
+    strcpy(sa_un->sun_path, address);
+    *sa_len = (socklen_t)sizeof(struct sockaddr_un);
+    return 0;
+  }
+  #endif
+  if (!strcasecmp(address, "local")) {
+    strcpy(host, LOCALHOST_IP);
+    port = "0";
+  }
+  else if ((ptr = strrchr(address, ':'))) {
+    len = (int)(ptr - address);
+    if ((len >= 2) && (address[0] == '[') && (address[len - 1] == ']')) {
+      ++address;
+      len -= 2;
+    }
+    if ((!len) || (len >= BUF_LEN)) {
+      return WORKER_CONNECTION_ERROR;
+    }
+    strncpy(host, address, len);
+    port = ptr + 1;
+  }
+  else {
+    strcpy(host, LOCALHOST_IP);
+    port = address;
+  }
+  if ((!port[0]) || (strspn(port, "0123456789") != strlen(port))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  memset(&hints, 0, sizeof(struct addrinfo));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = (passive ? AI_PASSIVE : 0);
+  if (getaddrinfo(host, port, &hints, &res) || (!res)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  memcpy(sa, res->ai_addr, res->ai_addrlen);
+  *sa_len = (socklen_t)(res->ai_addrlen);
+  freeaddrinfo(res);
+  
+  return 0;
+}
+
+
+static void set_socket_blocking(SOCKET sock, int blocking)
+{
+  #ifndef WIN32
+  int flags;
+  
+  
+  flags = fcntl(sock, F_GETFL, 0);
+  if (flags != -1) {
+    fcntl(sock, F_SETFL, (blocking
+      ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK)));
+  }
+  #else
+  u_long non_blocking;
+  
+  
+  non_blocking = (blocking ? 0 : 1);
+  ioctlsocket(sock, FIONBIO, &non_blocking);
+  #endif
+}
+
+
+/*
+a timeout is only set while shaking hands, so that a peer
+which is not an Open3DQSAR worker cannot hang the main
+process; afterwards, tasks may take as long as they need
+*/
+static void set_socket_timeout(SOCKET sock, int seconds)
+{
+  #ifndef WIN32
+  struct timeval tv;
+  
+  
+  tv.tv_sec = seconds;
+  tv.tv_usec = 0;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO,
+    (char *)&tv, sizeof(struct timeval));
+  #else
+  DWORD ms;
+  
+  
+  ms = (DWORD)seconds * 1000;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO,
+    (char *)&ms, sizeof(DWORD));
+  #endif
+}
+
+
+static void set_socket_options(SOCKET sock, int family)
+{
+  int on = 1;
+  
+  
+  setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (char *)&on, sizeof(int));
+  #ifdef SO_NOSIGPIPE
+  setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (char *)&on, sizeof(int));
+  #endif
+  if (family != AF_UNIX) {
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&on, sizeof(int));
+  }
+  #ifdef WIN32
+  SetHandleInformation((HANDLE)sock, HANDLE_FLAG_INHERIT, 0);
+  #endif
+}
+
+
+static int send_all(SOCKET sock, char *data, size_t len)
+{
+  int n;
+  int chunk;
+  
+  
+  while (len) {
+    chunk = (int)((len < WORKER_CHUNK_SIZE) ? len : WORKER_CHUNK_SIZE);
+    n = send(sock, data, chunk, MSG_NOSIGNAL);
+    if (n == SOCKET_ERROR) {
+      #ifndef WIN32
+      if (errno == EINTR) {
+        continue;
+      }
+      #endif
+      return WORKER_CONNECTION_ERROR;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+  
+  return 0;
+}
+
+
+static int recv_all(SOCKET sock, char *data, size_t len)
+{
+  int n;
+  int chunk;
+  
+  
+  while (len) {
+    chunk = (int)((len < WORKER_CHUNK_SIZE) ? len : WORKER_CHUNK_SIZE);
+    n = recv(sock, data, chunk, 0);
+    if (n == SOCKET_ERROR) {
+      #ifndef WIN32
+      if (errno == EINTR) {
+        continue;
+      }
+      #endif
+      return WORKER_CONNECTION_ERROR;
+    }
+    /*
+    the peer closed the connection
+    */
+    if (!n) {
+      return WORKER_CONNECTION_ERROR;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+  
+  return 0;
+}
+
+
+int put_worker_data(WorkerBuffer *buf, void *data, size_t len)
+{
+  char *new_data;
+  size_t max_len;
+  
+  
+  if ((buf->len + len) > buf->max_len) {
+    max_len = (buf->max_len ? buf->max_len : LARGE_BUF_LEN);
+    while (max_len < (buf->len + len)) {
+      max_len *= 2;
+    }
+    new_data = (char *)realloc(buf->data, max_len);
+    if (!new_data) {
+      return OUT_OF_MEMORY;
+    }
+    buf->data = new_data;
+    buf->max_len = max_len;
+  }
+  memcpy(&(buf->data[buf->len]), data, len);
+  buf->len += len;
+  
+  return 0;
+}
+
+
+int get_worker_data(WorkerBuffer *buf, void *data, size_t len)
+{
+  if ((buf->pos + len) > buf->len) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  memcpy(data, &(buf->data[buf->pos]), len);
+  buf->pos += len;
+  
+  return 0;
+}
+
+
+int send_worker_msg(WorkerInfo *workers, int n, int type, WorkerBuffer *buf)
+{
+  uint64_t header[2];
+  
+  
+  header[0] = (uint64_t)type;
+  header[1] = (uint64_t)(buf ? buf->len : 0);
+  if (send_all(workers->sock[n], (char *)header, sizeof(header))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  if (buf && buf->len && send_all(workers->sock[n], buf->data, buf->len)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  
+  return 0;
+}
+
+
+/*
+the payload is read into buf, which is grown as needed;
+buf->pos is reset, so that it can be parsed with
+get_worker_data(). Payloads longer than max_len, i.e.
+than the largest message the caller expects, are turned
+down before anything is allocated
+*/
+int recv_worker_msg(WorkerInfo *workers, int n, int *type,
+  WorkerBuffer *buf, size_t max_len)
+{
+  char *new_data;
+  uint64_t header[2];
+  
+  
+  if (recv_all(workers->sock[n], (char *)header, sizeof(header))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  if ((header[0] < WORKER_HELLO) || (header[0] > WORKER_RESULT)
+    || (header[1] > (uint64_t)max_len)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  *type = (int)header[0];
+  if ((size_t)header[1] > buf->max_len) {
+    new_data = (char *)realloc(buf->data, (size_t)header[1]);
+    if (!new_data) {
+      return OUT_OF_MEMORY;
+    }
+    buf->data = new_data;
+    buf->max_len = (size_t)header[1];
+  }
+  buf->len = (size_t)header[1];
+  buf->pos = 0;
+  if (buf->len && recv_all(workers->sock[n], buf->data, buf->len)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  
+  return 0;
+}
+
+
+/*
+both ends send their HELLO, then check the one they got;
+the header of the peer's HELLO is checked before its
+payload is read, so a peer with a different byte order or
+a different protocol is turned down without hanging
+*/
+static int shake_hands_worker(WorkerInfo *workers, int n)
+{
+  uint64_t header[2];
+  WorkerHello hello;
+  WorkerHello peer_hello;
+  
+  
+  fill_worker_hello(&hello);
+  header[0] = (uint64_t)WORKER_HELLO;
+  header[1] = (uint64_t)sizeof(WorkerHello);
+  if (send_all(workers->sock[n], (char *)header, sizeof(header))
+    || send_all(workers->sock[n], (char *)&hello, sizeof(WorkerHello))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  if (recv_all(workers->sock[n], (char *)header, sizeof(header))
+    || (header[0] != (uint64_t)WORKER_HELLO)
+    || (header[1] != (uint64_t)sizeof(WorkerHello))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  if (recv_all(workers->sock[n], (char *)&peer_hello, sizeof(WorkerHello))
+    || memcmp(&hello, &peer_hello, sizeof(WorkerHello))) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  
+  return 0;
+}
+
+
+/*
+opens the socket the workers connect to; with a LOCAL
+address, the port picked by the system is written back
+into od->workers.address, so that it can be passed
+to the workers
+*/
+int listen_workers(O3Data *od, char *address)
+{
+  char host[BUF_LEN];
+  char port[TITLE_LEN];
+  int on = 1;
+  SOCKET sock;
+  socklen_t sa_len;
+  struct sockaddr_storage sa;
+  
+  
+  if (get_worker_sockaddr(address, 1, &sa, &sa_len)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  sock = socket(sa.ss_family, SOCK_STREAM, 0);
+  if (sock == INVALID_SOCKET) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  #ifdef WIN32
+  SetHandleInformation((HANDLE)sock, HANDLE_FLAG_INHERIT, 0);
+  #endif
+  if (sa.ss_family != AF_UNIX) {
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(int));
+  }
+  else {
+    remove(address);
+  }
+  if (bind(sock, (struct sockaddr *)&sa, sa_len)
+    || listen(sock, MAX_WORKERS)) {
+    close_socket(sock);
+    return WORKER_CONNECTION_ERROR;
+  }
+  set_socket_blocking(sock, 0);
+  od->workers.listen_sock = sock;
+  strncpy(od->workers.address, address, BUF_LEN - 1);
+  if (!strcasecmp(address, "local")) {
+    sa_len = (socklen_t)sizeof(struct sockaddr_storage);
+    memset(host, 0, BUF_LEN);
+    memset(port, 0, TITLE_LEN);
+    if (getsockname(sock, (struct sockaddr *)&sa, &sa_len)
+      || getnameinfo((struct sockaddr *)&sa, sa_len, host, BUF_LEN,
+      port, TITLE_LEN, NI_NUMERICHOST | NI_NUMERICSERV)) {
+      close_socket(sock);
+      od->workers.listen_sock = INVALID_SOCKET;
+      return WORKER_CONNECTION_ERROR;
+    }
+    snprintf(od->workers.address, BUF_LEN,
+      ((sa.ss_family == AF_INET6) ? "[%s]:%s" : "%s:%s"), host, port);
+  }
+  
+  return 0;
+}
+
+
+/*
+accepts the workers which connected since the last call
+without waiting for new ones; connections which fail
+the handshake are closed. Returns the number of workers
+which are currently connected
+*/
+int accept_workers(O3Data *od)
+{
+  SOCKET sock;
+  WorkerInfo *workers;
+  struct sockaddr_storage sa;
+  socklen_t sa_len;
+  
+  
+  workers = &(od->workers);
+  if ((!(workers->address[0])) || (workers->listen_sock == INVALID_SOCKET)) {
+    return workers->n_workers;
+  }
+  while (workers->n_workers < MAX_WORKERS) {
+    sa_len = (socklen_t)sizeof(struct sockaddr_storage);
+    sock = accept(workers->listen_sock, (struct sockaddr *)&sa, &sa_len);
+    if (sock == INVALID_SOCKET) {
+      break;
+    }
+    set_socket_blocking(sock, 1);
+    set_socket_options(sock, sa.ss_family);
+    set_socket_timeout(sock, WORKER_HANDSHAKE_TIMEOUT);
+    workers->sock[workers->n_workers] = sock;
+    if (shake_hands_worker(workers, workers->n_workers)) {
+      close_socket(sock);
+      continue;
+    }
+    set_socket_timeout(sock, 0);
+    ++(workers->n_workers);
+  }
+  
+  return workers->n_workers;
+}
+
+
+/*
+connects a new stream socket to sa, which may be still
+not listening: up to max_attempts connections are tried,
+MS_SLEEP_BEFORE_RETRY ms apart, each on a new socket since
+a socket whose connect() failed cannot be portably reused.
+Returns INVALID_SOCKET if none succeeded; also used by
+update_jmol() to talk to Jmol
+*/
+SOCKET connect_socket(struct sockaddr *sa, int sa_len, int max_attempts)
+{
+  int attempts;
+  SOCKET sock;
+  
+  
+  for (attempts = 0; attempts < max_attempts; ++attempts) {
+    if (attempts) {
+      #ifndef WIN32
+      usleep(1000 * MS_SLEEP_BEFORE_RETRY);
+      #else
+      Sleep(MS_SLEEP_BEFORE_RETRY);
+      #endif
+    }
+    sock = socket(sa->sa_family, SOCK_STREAM, 0);
+    if (sock == INVALID_SOCKET) {
+      break;
+    }
+    if (!connect(sock, sa, sa_len)) {
+      return sock;
+    }
+    close_socket(sock);
+  }
+  
+  return INVALID_SOCKET;
+}
+
+
+/*
+used by worker processes to connect to the main process;
+the main process may not be listening yet, so connection
+is attempted a number of times before giving up
+*/
+int connect_worker(O3Data *od, char *address)
+{
+  SOCKET sock;
+  socklen_t sa_len;
+  struct sockaddr_storage sa;
+  
+  
+  if (get_worker_sockaddr(address, 0, &sa, &sa_len)) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  sock = connect_socket((struct sockaddr *)&sa,
+    (int)sa_len, MAX_ATTEMPTS_WORKER);
+  if (sock == INVALID_SOCKET) {
+    return WORKER_CONNECTION_ERROR;
+  }
+  /*
+  the main process may take a while to accept
+  this connection, so no timeout is set here
+  */
+  set_socket_options(sock, sa.ss_family);
+  od->workers.sock[0] = sock;
+  od->workers.n_workers = 1;
+  if (shake_hands_worker(&(od->workers), 0)) {
+    close_socket(sock);
+    od->workers.n_workers = 0;
+    return WORKER_CONNECTION_ERROR;
+  }
+  
+  return 0;
+}
+
+
+/*
+starts n local workers, each of them using an even share
+of the CPUs available to the main process, then waits
+for them to connect; returns the number of workers
+which could be started
+*/
+int spawn_workers(O3Data *od, int n)
+{
+  char n_cpus[TITLE_LEN];
+  char *old_n_cpus = NULL;
+  char *env_value;
+  int i;
+  int dead;
+  int error;
+  int attempts;
+  int first_spawned;
+  int n_connected;
+  ProgExeInfo prog_exe_info;
+  #ifndef WIN32
+  int status;
+  pid_t pid;
+  #else
+  char env_string[TITLE_LEN + 16];
+  #endif
+  
+  
+  if ((env_value = getenv("O3_N_CPUS"))) {
+    if (!(old_n_cpus = strdup(env_value))) {
+      return OUT_OF_MEMORY;
+    }
+  }
+  sprintf(n_cpus, "%d", ((od->n_proc / n) ? od->n_proc / n : 1));
+  #ifndef WIN32
+  setenv("O3_N_CPUS", n_cpus, 1);
+  #else
+  sprintf(env_string, "O3_N_CPUS=%s", n_cpus);
+  _putenv(env_string);
+  #endif
+  first_spawned = od->workers.n_spawned;
+  n_connected = od->workers.n_workers;
+  for (i = 0; (i < n) && (od->workers.n_spawned < MAX_WORKERS); ++i) {
+    memset(&prog_exe_info, 0, sizeof(ProgExeInfo));
+    prog_exe_info.exedir = od->temp_dir;
+    prog_exe_info.sep_proc_grp = 1;
+    snprintf(prog_exe_info.command_line, BUF_LEN,
+      "\"%s\" --worker \"%s\"", od->workers.exe, od->workers.address);
+    error = 0;
+    #ifndef WIN32
+    pid = ext_program_exe(&prog_exe_info, &error);
+    if (error || (pid <= 0)) {
+      break;
+    }
+    od->workers.pid[od->workers.n_spawned] = pid;
+    #else
+    ext_program_exe(&prog_exe_info, &error);
+    if (error) {
+      break;
+    }
+    CloseHandle(prog_exe_info.proc_info.hThread);
+    if (prog_exe_info.des) {
+      CloseHandle(prog_exe_info.des);
+    }
+    if (prog_exe_info.out) {
+      CloseHandle(prog_exe_info.out);
+    }
+    if (prog_exe_info.log) {
+      CloseHandle(prog_exe_info.log);
+    }
+    od->workers.process[od->workers.n_spawned] =
+      prog_exe_info.proc_info.hProcess;
+    #endif
+    ++(od->workers.n_spawned);
+  }
+  #ifndef WIN32
+  if (old_n_cpus) {
+    setenv("O3_N_CPUS", old_n_cpus, 1);
+  }
+  else {
+    unsetenv("O3_N_CPUS");
+  }
+  #else
+  sprintf(env_string, "O3_N_CPUS=%s", (old_n_cpus ? old_n_cpus : ""));
+  _putenv(env_string);
+  #endif
+  if (old_n_cpus) {
+    free(old_n_cpus);
+  }
+  n = od->workers.n_spawned - first_spawned;
+  /*
+  wait until all workers have connected, or
+  have exited (e.g., because they failed to start)
+  */
+  attempts = 0;
+  dead = 0;
+  while ((accept_workers(od) - n_connected + dead) < n) {
+    if (attempts >= MAX_ATTEMPTS_WORKER) {
+      break;
+    }
+    for (i = first_spawned, dead = 0; i < od->workers.n_spawned; ++i) {
+      #ifndef WIN32
+      if (!(od->workers.pid[i])) {
+        ++dead;
+      }
+      else if (waitpid(od->workers.pid[i], &status, WNOHANG)
+        == od->workers.pid[i]) {
+        od->workers.pid[i] = 0;
+        ++dead;
+      }
+      #else
+      if (WaitForSingleObject(od->workers.process[i], 0) == WAIT_OBJECT_0) {
+        ++dead;
+      }
+      #endif
+    }
+    #ifndef WIN32
+    usleep(1000 * MS_SLEEP_BEFORE_RETRY);
+    #else
+    Sleep(MS_SLEEP_BEFORE_RETRY);
+    #endif
+    ++attempts;
+  }
+  
+  return od->workers.n_workers - n_connected;
+}
+
+
+/*
+closes the connection with the n-th worker, e.g. because
+it was lost during a job; the following ones are shifted
+down one place
+*/
+void drop_worker(O3Data *od, int n)
+{
+  int i;
+  
+  
+  close_socket(od->workers.sock[n]);
+  for (i = n + 1; i < od->workers.n_workers; ++i) {
+    od->workers.sock[i - 1] = od->workers.sock[i];
+  }
+  --(od->workers.n_workers);
+}
+
+
+/*
+closing connections makes workers exit, but spawned
+workers are also terminated explicitly, in case they
+are stuck in the middle of a task
+*/
+void close_workers(O3Data *od)
+{
+  int i;
+  #ifndef WIN32
+  int status;
+  #endif
+  
+  
+  while (od->workers.n_workers) {
+    drop_worker(od, od->workers.n_workers - 1);
+  }
+  if (od->workers.address[0]) {
+    close_socket(od->workers.listen_sock);
+    if (is_unix_socket_address(od->workers.address)) {
+      remove(od->workers.address);
+    }
+  }
+  for (i = 0; i < od->workers.n_spawned; ++i) {
+    #ifndef WIN32
+    if (od->workers.pid[i]) {
+      kill(od->workers.pid[i], SIGTERM);
+      waitpid(od->workers.pid[i], &status, 0);
+      od->workers.pid[i] = 0;
+    }
+    #else
+    TerminateProcess(od->workers.process[i], 0);
+    CloseHandle(od->workers.process[i]);
+    #endif
+  }
+  od->workers.n_spawned = 0;
+  memset(od->workers.address, 0, BUF_LEN);
+  if (od->workers.job.data) {
+    free(od->workers.job.data);
+  }
+  memset(&(od->workers.job), 0, sizeof(WorkerBuffer));
+}
@@ -16,6 +16,15 @@ ref_e2.sdf \
 sample_input_MM.inp"
 INPUT_FILE=sample_input_MM.inp
 OUTPUT_FILE=sample_input_MM.out
+GRID_ASCII_INPUT_FILE=grid_ascii.inp
+CV_INPUT_FILE=cv_threads.inp
+WORKERS_INPUT_FILE=workers.inp
+ALGORITHM_INPUT_FILE=algorithm.inp
+MULTI_Y_INPUT_FILE=multi_y.inp
+SWEEP_INPUT_FILE=sweep.inp
+OUT_OF_CORE_INPUT_FILE=out_of_core.inp
+JOURNAL_INPUT_FILE=journal.inp
+INCREMENTAL_INPUT_FILE=incremental.inp
 TEST_RESULTS=test_results
 REFERENCE_RESULTS=reference_results
 OPEN3DTOOL=open3dqsar
@@ -48,6 +57,31 @@ get_predicted_val()
 }
 
 
+# Get the output of a given tool, leaving out timings
+get_tool_val()
+{
+  sed -n "/ - ${1} tool was invoked/,/ - ${1} tool succeeded/p" \
+    | grep -v 'Elapsed time'
+}
+
+
+# Get the CV tables, leaving out timings
+get_cv_val()
+{
+  get_tool_val CV
+}
+
+
+# Get the CV predictions of dependent variable ${2}
+# from command ${1}
+get_cv_pred_val()
+{
+  sed -n "/BGN COMMAND #00.${1} /,/END COMMAND #00.${1} /p" \
+    | awk -v y=${2} '/^Predicted values for dependent variable/ \
+    { found = ($6 == y); next } found && /^$/ { found = 0 } found'
+}
+
+
 # Save the folder where the user originally was
 old_cwd=$PWD
 # Catch all premature death signals
@@ -96,6 +130,352 @@ Please check $cwd/${TEST_RESULTS}/${OUTPUT_FILE}
 eof
   clean_exit 1
 fi
+# Import GRID_ASCII files holding values with exponents,
+# more than 15 significant digits and denormals; the dataset
+# must be identical to the one obtained from the same files
+# by the strtod()-based parser of previous versions
+for object in 1 2; do
+  awk -v object=${object} 'BEGIN {
+    n = split("1.5e-3 -2.5E+02 3.14159265358979323846 " \
+      "-0.000000000000000000012345678901234567 1.0e-40 2.5e-310 " \
+      "4.9e-324 123456789012345678901234567890 6.02214076e23 " \
+      "-7.0000000000000000000000001 1e+38 0.1 9.999999999999999999e-1 " \
+      ".5 -0. 1.17549435082228750797e-38 +2.2250738585072014e-308", \
+      value, " ");
+    i = 0;
+    for (z = 23; z <= 47; z += 2) {
+      for (y = 24; y <= 44; y += 2) {
+        for (x = 12; x <= 34; x += 2) {
+          printf "%d.0 %d.0 %d.0 %s\n", x, y, z,
+            value[(i * 7 + object) % n + 1];
+          ++i;
+        }
+      }
+    }
+  }' > grid_ascii_${object}.txt
+done
+cat > ${GRID_ASCII_INPUT_FILE} << eof
+import type=sdf file=ref_e2.sdf
+remove_object object_list=3-56
+box step=2.0
+import type=grid_ascii file=grid_ascii_%d.txt
+save file=grid_ascii.dat
+load file=../${REFERENCE_RESULTS}/grid_ascii.dat
+save file=grid_ascii_ref.dat
+eof
+${OPEN3DTOOL} -i ${GRID_ASCII_INPUT_FILE} -o grid_ascii.out
+if (! cmp >&/dev/null grid_ascii_ref.dat grid_ascii.dat); then
+  cat << eof
+Values imported from GRID_ASCII files differ from reference ones
+Please check $cwd/${TEST_RESULTS}/grid_ascii.out
+eof
+  clean_exit 1
+fi
+# Cross-validate on a single thread and then on 4 threads,
+# whatever the number of CPUs; PRESS is merged in a fixed
+# order, so results (including the SDEP of nested CV,
+# whose outer runs are spread among threads) must be identical
+for n_cpus in 1 4; do
+  cat > ${CV_INPUT_FILE} << eof
+env n_cpus=${n_cpus}
+load file=binding_after_srd.dat
+pls pc=5
+cv pc=5 type=loo
+cv pc=5 type=lto
+cv pc=5 type=lmo groups=5 runs=20
+cv pc=5 type=nested groups=5 runs=20 inner_groups=4
+eof
+  ${OPEN3DTOOL} -i ${CV_INPUT_FILE} -o cv_threads_${n_cpus}.out
+done
+get_cv_val < cv_threads_1.out > $temp_ref
+get_cv_val < cv_threads_4.out > $temp_test
+if (! diff >&/dev/null $temp_ref $temp_test) \
+  || (! grep >&/dev/null "LMO CV" < $temp_test) \
+  || (! grep >&/dev/null "Nested SDEP" < $temp_test); then
+  cat << eof
+Parallel CV results differ from single-thread ones
+Please compare $cwd/${TEST_RESULTS}/cv_threads_1.out
+and $cwd/${TEST_RESULTS}/cv_threads_4.out
+eof
+  clean_exit 1
+fi
+# Build PLS and CV models through NIPALS, IMPLICIT and KERNEL,
+# on a single thread and on 4 threads; the shared X matrix of
+# implicit CV and the kernel matrix of kernel CV must yield
+# the same tables as plain NIPALS
+for algorithm in nipals implicit kernel; do
+  for n_cpus in 1 4; do
+    cat > ${ALGORITHM_INPUT_FILE} << eof
+env n_cpus=${n_cpus}
+load file=binding_after_srd.dat
+pls pc=5 algorithm=${algorithm}
+cv pc=5 type=loo algorithm=${algorithm}
+cv pc=5 type=lmo groups=5 runs=20 algorithm=${algorithm}
+eof
+    ${OPEN3DTOOL} -i ${ALGORITHM_INPUT_FILE} \
+      -o algorithm_${algorithm}_${n_cpus}.out
+    get_tool_val PLS < algorithm_${algorithm}_${n_cpus}.out \
+      | grep -v '^> ' > algorithm_${algorithm}_${n_cpus}.txt
+    get_cv_val < algorithm_${algorithm}_${n_cpus}.out \
+      | grep -v '^> ' >> algorithm_${algorithm}_${n_cpus}.txt
+    if (! diff >&/dev/null algorithm_nipals_1.txt \
+      algorithm_${algorithm}_${n_cpus}.txt) \
+      || (! grep >&/dev/null "LMO CV" \
+      < algorithm_${algorithm}_${n_cpus}.txt); then
+      cat << eof
+PLS/CV results obtained with algorithm=${algorithm} on ${n_cpus} threads
+differ from serial NIPALS ones
+Please compare $cwd/${TEST_RESULTS}/algorithm_nipals_1.out
+and $cwd/${TEST_RESULTS}/algorithm_${algorithm}_${n_cpus}.out
+eof
+      clean_exit 1
+    fi
+  done
+done
+# Build a Y block of three dependent variables; PLS1 CV must
+# give the same predictions as separate single-y CV runs, and
+# the default PLS2 CV, which works on X'Y, must give the same
+# tables as the classic NIPALS loop run by algorithm=IMPLICIT
+awk 'NR == 1 { print "affinity shifted inverted"; next }
+  { printf "%.3f %.3f %.3f\n", $1, 0.5 * $1 + 0.3 * (NR % 7),
+  10.0 - $1 + 0.2 * (NR % 5) }' \
+  < binding_data_36_compounds.txt > multi_y.txt
+for y in pls1 1 2 3; do
+  if [ $y = pls1 ]; then
+    y_file=multi_y.txt
+    y_mode="y_mode=pls1"
+  else
+    awk -v y=${y} '{ print $y }' < multi_y.txt > multi_y_${y}.txt
+    y_file=multi_y_${y}.txt
+    y_mode=""
+  fi
+  cat > ${MULTI_Y_INPUT_FILE} << eof
+load file=binding_after_srd.dat
+import type=dependent file=${y_file}
+pls pc=5
+cv pc=5 type=loo ${y_mode}
+cv pc=5 type=lmo groups=5 runs=20 ${y_mode}
+eof
+  ${OPEN3DTOOL} -i ${MULTI_Y_INPUT_FILE} -o multi_y_${y}.out
+done
+for y in 1 2 3; do
+  for cmd in 0004 0005; do
+    get_cv_pred_val $cmd $y < multi_y_pls1.out > $temp_ref
+    get_cv_pred_val $cmd 1 < multi_y_${y}.out > $temp_test
+    if (! diff >&/dev/null $temp_ref $temp_test) \
+      || [ ! -s $temp_test ]; then
+      cat << eof
+PLS1 CV predictions for dependent variable ${y} differ
+from those of a single-y CV run
+Please compare $cwd/${TEST_RESULTS}/multi_y_pls1.out
+and $cwd/${TEST_RESULTS}/multi_y_${y}.out
+eof
+      clean_exit 1
+    fi
+  done
+done
+for algorithm in implicit nipals; do
+  for n_cpus in 1 4; do
+    cat > ${MULTI_Y_INPUT_FILE} << eof
+env n_cpus=${n_cpus}
+load file=binding_after_srd.dat
+import type=dependent file=multi_y.txt
+pls pc=5
+cv pc=5 type=loo algorithm=${algorithm}
+cv pc=5 type=lmo groups=5 runs=20 algorithm=${algorithm}
+eof
+    ${OPEN3DTOOL} -i ${MULTI_Y_INPUT_FILE} \
+      -o multi_y_${algorithm}_${n_cpus}.out
+    get_cv_val < multi_y_${algorithm}_${n_cpus}.out \
+      | grep -v '^> ' > multi_y_${algorithm}_${n_cpus}.txt
+    if (! diff >&/dev/null multi_y_implicit_1.txt \
+      multi_y_${algorithm}_${n_cpus}.txt) \
+      || (! grep >&/dev/null "LMO CV" \
+      < multi_y_${algorithm}_${n_cpus}.txt); then
+      cat << eof
+PLS2 CV results for multiple dependent variables obtained with
+algorithm=${algorithm} on ${n_cpus} threads differ from classic NIPALS ones
+Please compare $cwd/${TEST_RESULTS}/multi_y_implicit_1.out
+and $cwd/${TEST_RESULTS}/multi_y_${algorithm}_${n_cpus}.out
+eof
+      clean_exit 1
+    fi
+  done
+done
+# Run CV and FFDSEL locally, then through 2 worker
+# processes; results must be identical
+for workers in none local; do
+  if [ $workers = local ]; then
+    spawn="spawn=2"
+  else
+    spawn=""
+  fi
+  cat > ${WORKERS_INPUT_FILE} << eof
+env workers=${workers} ${spawn}
+load file=binding_after_srd.dat
+pls pc=5
+cv pc=5 type=loo
+cv pc=5 type=lmo groups=5 runs=20
+ffdsel pc=5 type=lmo runs=20 percent_dummies=20 use_srd_groups=no combination_variable_ratio=1.0 fold_over=no
+eof
+  ${OPEN3DTOOL} -i ${WORKERS_INPUT_FILE} -o workers_${workers}.out
+done
+for tool in CV FFDSEL; do
+  get_tool_val $tool < workers_none.out > $temp_ref
+  get_tool_val $tool < workers_local.out > $temp_test
+  if (! diff >&/dev/null $temp_ref $temp_test) \
+    || (! grep >&/dev/null "$tool tool succeeded" < $temp_test) \
+    || (! grep >&/dev/null "2 worker processes connected" \
+    < workers_local.out); then
+    cat << eof
+$tool results obtained through worker processes
+differ from local ones
+Please compare $cwd/${TEST_RESULTS}/workers_none.out
+and $cwd/${TEST_RESULTS}/workers_local.out
+eof
+    clean_exit 1
+  fi
+done
+# Run PLS and CV before and after a 2x2 SWEEP, keeping
+# field data in memory and then on disk; the dataset must
+# be restored after SWEEP, and SWEEP results must not
+# depend on where field data are kept
+cat > ${SWEEP_INPUT_FILE} << eof
+load file=binding.dat
+pls pc=5
+cv pc=5 type=loo
+sweep cutoff=none,5 scaling=none,buw pc=5 type=loo
+pls pc=5
+cv pc=5 type=loo
+eof
+for save_ram in no yes; do
+  O3_SAVE_RAM=${save_ram} ${OPEN3DTOOL} -i ${SWEEP_INPUT_FILE} \
+    -o sweep_${save_ram}.out
+  get_tool_val SWEEP < sweep_${save_ram}.out > sweep_${save_ram}.txt
+  for cmd in 2 5; do
+    sed -n "/BGN COMMAND #00.000${cmd} /,/END COMMAND #00.000$((cmd + 1)) /p" \
+      < sweep_${save_ram}.out | grep -v -e 'Elapsed time' -e 'COMMAND #' \
+      > sweep_${save_ram}_${cmd}.txt
+  done
+  if (! diff >&/dev/null sweep_${save_ram}_2.txt sweep_${save_ram}_5.txt) \
+    || (! grep >&/dev/null "LOO CV" < sweep_${save_ram}_5.txt) \
+    || (! diff >&/dev/null sweep_no.txt sweep_${save_ram}.txt) \
+    || (! grep >&/dev/null "SWEEP tool succeeded" \
+    < sweep_${save_ram}.txt); then
+    cat << eof
+The dataset was not restored after SWEEP, or SWEEP results
+depend on O3_SAVE_RAM
+Please check $cwd/${TEST_RESULTS}/sweep_${save_ram}.out
+eof
+    clean_exit 1
+  fi
+done
+# Build the same PLS model through the kernel algorithm and
+# out-of-core, streaming X in several blocks from memory
+# and then from disk; exported coefficients must be identical
+cat > ${OUT_OF_CORE_INPUT_FILE} << eof
+load file=binding.dat
+pls pc=5 algorithm=kernel
+export type=coefficients pc=5 format=xyz file=kernel
+pls pc=5 out_of_core=yes memory=0.05
+export type=coefficients pc=5 format=xyz file=out_of_core
+eof
+for save_ram in no yes; do
+  O3_SAVE_RAM=${save_ram} ${OPEN3DTOOL} -i ${OUT_OF_CORE_INPUT_FILE} \
+    -o out_of_core_${save_ram}.out
+  for field in 01 02; do
+    if (! cmp >&/dev/null kernel_fld-${field}_y-01.agrd \
+      out_of_core_fld-${field}_y-01.agrd) \
+      || (! grep >&/dev/null "are streamed in blocks" \
+      < out_of_core_${save_ram}.out); then
+      cat << eof
+Coefficients of the out-of-core PLS model differ from those
+of the kernel PLS model
+Please check $cwd/${TEST_RESULTS}/out_of_core_${save_ram}.out
+eof
+      clean_exit 1
+    fi
+  done
+  rm -f kernel_fld-*.agrd out_of_core_fld-*.agrd
+done
+# Save incrementally twice, then fully; loading the
+# journaled file must give the same models as loading
+# the full one, also after the last journal record
+# was torn by an interrupted save
+cat > ${JOURNAL_INPUT_FILE} << eof
+load file=binding.dat
+save file=journal.dat mode=incremental
+zero type=all level=0.05
+set id_list=7,10,15,25,37,40,42,46,55 attribute=testset
+sdcut level=2.0
+save file=journal.dat mode=incremental
+save file=full.dat
+scale_x_vars type=buw
+save file=journal.dat mode=incremental
+eof
+${OPEN3DTOOL} -i ${JOURNAL_INPUT_FILE} -o journal_save.out
+journal_len=`wc -c < journal.dat.jnl`
+head -c $((journal_len - 100)) journal.dat.jnl > journal_torn.jnl
+mv journal_torn.jnl journal.dat.jnl
+for dat in full journal; do
+  cat > ${JOURNAL_INPUT_FILE} << eof
+load file=${dat}.dat
+pls pc=5
+cv pc=5 type=loo
+eof
+  ${OPEN3DTOOL} -i ${JOURNAL_INPUT_FILE} -o journal_${dat}.out
+done
+for dat in full journal; do
+  get_tool_val PLS < journal_${dat}.out > journal_${dat}.txt
+  get_cv_val < journal_${dat}.out >> journal_${dat}.txt
+done
+if (! grep >&/dev/null "Record 2 was appended" < journal_save.out) \
+  || (! grep >&/dev/null "Journal record 1 was replayed" \
+  < journal_journal.out) \
+  || (! diff >&/dev/null journal_full.txt journal_journal.txt) \
+  || (! grep >&/dev/null "LOO CV" < journal_journal.txt); then
+  cat << eof
+Data loaded from an incremental save differ from a full save
+Please compare $cwd/${TEST_RESULTS}/journal_full.out
+and $cwd/${TEST_RESULTS}/journal_journal.out
+eof
+  clean_exit 1
+fi
+# Build PLS and CV models, then exclude objects, change
+# variables and remove objects, rebuilding them after each
+# change; models updated incrementally must be identical to
+# those built from scratch
+for incremental in no yes; do
+  cat > ${INCREMENTAL_INPUT_FILE} << eof
+load file=binding.dat
+pls pc=5 incremental=${incremental}
+cv pc=5 type=loo incremental=${incremental}
+set id_list=7,10,15 attribute=excluded
+sdcut level=2.0
+pls pc=5 incremental=${incremental}
+cv pc=5 type=loo incremental=${incremental}
+remove_object object_list=20-22
+pls pc=5 incremental=${incremental}
+cv pc=5 type=lmo groups=5 runs=20 incremental=${incremental}
+eof
+  ${OPEN3DTOOL} -i ${INCREMENTAL_INPUT_FILE} \
+    -o incremental_${incremental}.out
+  for tool in PLS CV; do
+    get_tool_val $tool < incremental_${incremental}.out \
+      | grep -v -e '^> ' -e 'Incremental update' -e '^$'
+  done > incremental_${incremental}.txt
+done
+if (! diff >&/dev/null incremental_no.txt incremental_yes.txt) \
+  || (! grep >&/dev/null "LMO CV" < incremental_yes.txt) \
+  || (! grep >&/dev/null "^Incremental update: [1-9]" \
+  < incremental_yes.out); then
+  cat << eof
+Incrementally updated PLS/CV models differ from those built from scratch
+Please compare $cwd/${TEST_RESULTS}/incremental_no.out
+and $cwd/${TEST_RESULTS}/incremental_yes.out
+eof
+  clean_exit 1
+fi
 # The test was OK, remove the test folder and exit
 cat << eof
 Test completed successfully